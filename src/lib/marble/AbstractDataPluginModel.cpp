@@ -20,6 +20,8 @@
 #include <QVariant>
 #include <QAbstractListModel>
 #include <QMetaProperty>
+#include <QRect>
+#include <QSet>
 
 // Marble
 #include "MarbleDebug.h"
@@ -30,6 +32,8 @@
 #include "HttpDownloadManager.h"
 #include "MarbleModel.h"
 #include "MarbleDirs.h"
+#include "TileCoordsPyramid.h"
+#include "TileId.h"
 #include "ViewportParams.h"
 
 #include <cmath>
@@ -51,6 +55,9 @@ const qreal boxComparisonFactor = 16.0;
 // Separator to separate the id of the item from the file type
 const QChar fileIdSeparator = QLatin1Char('_');
 
+// Tile level the items are bucketed at for looking up the ones in the viewport
+const int itemIndexLevel = 8;
+
 class FavoritesModel;
 
 class AbstractDataPluginModelPrivate
@@ -67,6 +74,13 @@ public:
 
     void updateFavoriteItems();
 
+    void addToIndex( AbstractDataPluginItem *item );
+    void removeFromIndex( AbstractDataPluginItem *item );
+    QList<AbstractDataPluginItem*> itemsInBox( const GeoDataLatLonBox &box ) const;
+
+    bool isLastViewport( const ViewportParams *viewport ) const;
+    void setLastViewport( const ViewportParams *viewport );
+
     AbstractDataPluginModel *m_parent;
     const QString m_name;
     const MarbleModel *const m_marbleModel;
@@ -78,6 +92,16 @@ public:
     QList<AbstractDataPluginItem*> m_itemSet;
     QHash<QString, AbstractDataPluginItem*> m_downloadingItems;
     QList<AbstractDataPluginItem*> m_displayedItems;
+    QHash<TileId, QList<AbstractDataPluginItem*> > m_tiledItems;
+    QHash<AbstractDataPluginItem*, TileId> m_itemTiles;
+    // m_displayedItems stays valid until the viewport or the items change
+    bool m_displayedItemsValid;
+    Projection m_lastProjection;
+    qreal m_lastCenterLongitude;
+    qreal m_lastCenterLatitude;
+    qreal m_lastHeading;
+    int m_lastRadius;
+    QSize m_lastSize;
     QTimer m_downloadTimer;
     quint32 m_descriptionFileNumber;
     QHash<QString, QVariant> m_itemSettings;
@@ -122,6 +146,12 @@ AbstractDataPluginModelPrivate::AbstractDataPluginModelPrivate( const QString& n
       m_lastNumber( 0 ),
       m_downloadedNumber( 0 ),
       m_currentPlanetId( marbleModel->planetId() ),
+      m_displayedItemsValid( false ),
+      m_lastProjection( Spherical ),
+      m_lastCenterLongitude( 0.0 ),
+      m_lastCenterLatitude( 0.0 ),
+      m_lastHeading( 0.0 ),
+      m_lastRadius( 0 ),
       m_downloadTimer( m_parent ),
       m_descriptionFileNumber( 0 ),
       m_itemSettings(),
@@ -161,6 +191,103 @@ void AbstractDataPluginModelPrivate::updateFavoriteItems()
     }
 }
 
+void AbstractDataPluginModelPrivate::addToIndex( AbstractDataPluginItem *item )
+{
+    TileId const key = TileId::fromCoordinates( item->coordinate(), itemIndexLevel );
+    m_tiledItems[key].append( item );
+    m_itemTiles.insert( item, key );
+}
+
+void AbstractDataPluginModelPrivate::removeFromIndex( AbstractDataPluginItem *item )
+{
+    QHash<AbstractDataPluginItem*, TileId>::iterator const i = m_itemTiles.find( item );
+    if ( i == m_itemTiles.end() ) {
+        return;
+    }
+
+    QHash<TileId, QList<AbstractDataPluginItem*> >::iterator const tile = m_tiledItems.find( *i );
+    if ( tile != m_tiledItems.end() ) {
+        tile->removeOne( item );
+        if ( tile->isEmpty() ) {
+            m_tiledItems.erase( tile );
+        }
+    }
+    m_itemTiles.erase( i );
+}
+
+QList<AbstractDataPluginItem*> AbstractDataPluginModelPrivate::itemsInBox( const GeoDataLatLonBox &box ) const
+{
+    if ( box.west() > box.east() ) {
+        // Handle boxes crossing the IDL by splitting it into two separate boxes
+        GeoDataLatLonBox left;
+        left.setWest( -M_PI );
+        left.setEast( box.east() );
+        left.setNorth( box.north() );
+        left.setSouth( box.south() );
+
+        GeoDataLatLonBox right;
+        right.setWest( box.west() );
+        right.setEast( M_PI );
+        right.setNorth( box.north() );
+        right.setSouth( box.south() );
+
+        return itemsInBox( left ) + itemsInBox( right );
+    }
+
+    QList<AbstractDataPluginItem*> result;
+    QRect rect;
+    qreal north, south, east, west;
+    box.boundaries( north, south, east, west );
+    TileId key;
+
+    key = TileId::fromCoordinates( GeoDataCoordinates(west, north, 0), itemIndexLevel );
+    rect.setLeft( key.x() );
+    rect.setTop( key.y() );
+
+    key = TileId::fromCoordinates( GeoDataCoordinates(east, south, 0), itemIndexLevel );
+    rect.setRight( key.x() );
+    rect.setBottom( key.y() );
+
+    // Zoomed out, the viewport covers more tiles than there are tiles with items
+    if ( qint64( rect.width() ) * rect.height() > m_tiledItems.size() ) {
+        QHash<TileId, QList<AbstractDataPluginItem*> >::const_iterator i = m_tiledItems.constBegin();
+        QHash<TileId, QList<AbstractDataPluginItem*> >::const_iterator const end = m_tiledItems.constEnd();
+        for (; i != end; ++i ) {
+            if ( rect.contains( i.key().x(), i.key().y() ) ) {
+                result += i.value();
+            }
+        }
+    } else {
+        for ( int x = rect.left(); x <= rect.right(); ++x ) {
+            for ( int y = rect.top(); y <= rect.bottom(); ++y ) {
+                result += m_tiledItems.value( TileId( 0, itemIndexLevel, x, y ) );
+            }
+        }
+    }
+
+    return result;
+}
+
+bool AbstractDataPluginModelPrivate::isLastViewport( const ViewportParams *viewport ) const
+{
+    return m_lastProjection == viewport->projection()
+            && m_lastCenterLongitude == viewport->centerLongitude()
+            && m_lastCenterLatitude == viewport->centerLatitude()
+            && m_lastHeading == viewport->heading()
+            && m_lastRadius == viewport->radius()
+            && m_lastSize == viewport->size();
+}
+
+void AbstractDataPluginModelPrivate::setLastViewport( const ViewportParams *viewport )
+{
+    m_lastProjection = viewport->projection();
+    m_lastCenterLongitude = viewport->centerLongitude();
+    m_lastCenterLatitude = viewport->centerLatitude();
+    m_lastHeading = viewport->heading();
+    m_lastRadius = viewport->radius();
+    m_lastSize = viewport->size();
+}
+
 void AbstractDataPluginModel::themeChanged()
 {
     if ( d->m_currentPlanetId != d->m_marbleModel->planetId() ) {
@@ -282,13 +409,21 @@ const MarbleModel *AbstractDataPluginModel::marbleModel() const
 QList<AbstractDataPluginItem*> AbstractDataPluginModel::items( const ViewportParams *viewport,
                                                                qint32 number )
 {
+    if ( d->m_displayedItemsValid && d->m_lastNumber == number && d->isLastViewport( viewport ) ) {
+        return d->m_displayedItems;
+    }
+
     GeoDataLatLonAltBox currentBox = viewport->viewLatLonAltBox();
     QList<AbstractDataPluginItem*> list;
     
     Q_ASSERT( !d->m_displayedItems.contains( 0 ) && "Null item in m_displayedItems. Please report a bug to marble-devel@kde.org" );
     Q_ASSERT( !d->m_itemSet.contains( 0 ) && "Null item in m_itemSet. Please report a bug to marble-devel@kde.org" );
 
-    QList<AbstractDataPluginItem*> candidates = d->m_displayedItems + d->m_itemSet;
+    // Items outside of the viewport can't be shown, only look at the ones in its tiles
+    QList<AbstractDataPluginItem*> itemsInView = d->itemsInBox( currentBox );
+    std::sort( itemsInView.begin(), itemsInView.end(), lessThanByPointer );
+
+    QList<AbstractDataPluginItem*> candidates = d->m_displayedItems + itemsInView;
 
     if ( d->m_needsSorting ) {
         // Both the candidates list and the list of all items need to be sorted
@@ -300,10 +435,17 @@ QList<AbstractDataPluginItem*> AbstractDataPluginModel::items( const ViewportPar
     QList<AbstractDataPluginItem*>::const_iterator i = candidates.constBegin();
     QList<AbstractDataPluginItem*>::const_iterator end = candidates.constEnd();
 
+    QSet<AbstractDataPluginItem*> const displayedItems = d->m_displayedItems.toSet();
+    QSet<AbstractDataPluginItem*> listedItems;
+    // Items may become initialized without telling the model, e.g. once their
+    // image got downloaded, so a list that skipped some must not be reused
+    bool skippedUninitialized = false;
+
     // Items that are already shown have the highest priority
     for (; i != end && list.size() < number; ++i ) {
         // Only show items that are initialized
         if( !(*i)->initialized() ) {
+            skippedUninitialized = true;
             continue;
         }
 
@@ -317,13 +459,13 @@ QList<AbstractDataPluginItem*> AbstractDataPluginModel::items( const ViewportPar
             continue;
         }
 
-        if ( list.contains( *i ) ) {
+        if ( listedItems.contains( *i ) ) {
             continue;
         }
 
         // If the item was added initially at a nearer position, they don't have priority,
         // because we zoomed out since then.
-        bool const alreadyDisplayed = d->m_displayedItems.contains( *i );
+        bool const alreadyDisplayed = displayedItems.contains( *i );
         if ( !alreadyDisplayed || (*i)->addedAngularResolution() >= viewport->angularResolution() || (*i)->isSticky() ) {
             bool collides = false;
             int const length = list.length();
@@ -338,6 +480,7 @@ QList<AbstractDataPluginItem*> AbstractDataPluginModel::items( const ViewportPar
 
             if ( !collides ) {
                 list.append( *i );
+                listedItems.insert( *i );
                 (*i)->setSettings( d->m_itemSettings );
 
                 // We want to save the angular resolution of the first time the item got added.
@@ -352,6 +495,8 @@ QList<AbstractDataPluginItem*> AbstractDataPluginModel::items( const ViewportPar
     d->m_lastBox = currentBox;
     d->m_lastNumber = number;
     d->m_displayedItems = list;
+    d->m_displayedItemsValid = !skippedUninitialized;
+    d->setLastViewport( viewport );
     return list;
 }
 
@@ -432,9 +577,17 @@ void AbstractDataPluginModel::addItemsToList( const QList<AbstractDataPluginItem
                                                                   lessThanByPointer );
         // Insert the item on the right position in the list
         d->m_itemSet.insert( i, item );
+        d->addToIndex( item );
+        d->m_displayedItemsValid = false;
 
         connect( item, SIGNAL(stickyChanged()), this, SLOT(scheduleItemSort()) );
         connect( item, SIGNAL(destroyed(QObject*)), this, SLOT(removeItem(QObject*)) );
+        // Items may get their coordinates only with the data downloaded for them
+        connect( item, &AbstractDataPluginItem::updated, this, [this, item]() {
+            d->removeFromIndex( item );
+            d->addToIndex( item );
+            d->m_displayedItemsValid = false;
+        } );
         connect( item, SIGNAL(updated()), this, SIGNAL(itemsUpdated()) );
         connect( item, SIGNAL(favoriteChanged(QString,bool)), this,
                  SLOT(favoriteItemChanged(QString,bool)) );
@@ -483,6 +636,7 @@ void AbstractDataPluginModel::setFavoriteItemsOnly( bool favoriteOnly )
 {
     if ( isFavoriteItemsOnly() != favoriteOnly ) {
         d->m_favoriteItemsOnly = favoriteOnly;
+        d->m_displayedItemsValid = false;
         d->updateFavoriteItems();
         emit favoriteItemsOnlyChanged();
     }
@@ -521,6 +675,7 @@ void AbstractDataPluginModel::favoriteItemChanged( const QString& id, bool isFav
 void AbstractDataPluginModel::scheduleItemSort()
 {
     d->m_needsSorting = true;
+    d->m_displayedItemsValid = false;
 }
 
 QString AbstractDataPluginModelPrivate::generateFilename(const QString &id, const QString &type)
@@ -556,7 +711,10 @@ bool AbstractDataPluginModel::itemExists( const QString& id ) const
 
 void AbstractDataPluginModel::setItemSettings(const QHash<QString, QVariant> &itemSettings)
 {
-    d->m_itemSettings = itemSettings;
+    if ( d->m_itemSettings != itemSettings ) {
+        d->m_itemSettings = itemSettings;
+        d->m_displayedItemsValid = false;
+    }
 }
 
 void AbstractDataPluginModel::handleChangedViewport()
@@ -629,6 +787,8 @@ void AbstractDataPluginModel::processFinishedJob( const QString& relativeUrlStri
             
             (*i)->addDownloadedFile( d->generateFilepath( itemId, fileType ),
                                      fileType );
+            // The item may be initialized now without emitting updated()
+            d->m_displayedItemsValid = false;
 
             d->m_downloadingItems.erase( i );
         }
@@ -637,8 +797,12 @@ void AbstractDataPluginModel::processFinishedJob( const QString& relativeUrlStri
 
 void AbstractDataPluginModel::removeItem( QObject *item )
 {
-    AbstractDataPluginItem * pluginItem = qobject_cast<AbstractDataPluginItem*>( item );
+    // Only a QObject is left of the item when it is destroyed, just its address is used
+    AbstractDataPluginItem * pluginItem = static_cast<AbstractDataPluginItem*>( item );
     d->m_itemSet.removeAll( pluginItem );
+    d->m_displayedItems.removeAll( pluginItem );
+    d->removeFromIndex( pluginItem );
+    d->m_displayedItemsValid = false;
     QHash<QString, AbstractDataPluginItem *>::iterator i;
     for( i = d->m_downloadingItems.begin(); i != d->m_downloadingItems.end(); ++i ) {
         if( *i == pluginItem ) {
@@ -656,6 +820,9 @@ void AbstractDataPluginModel::clear()
         (*iter)->deleteLater();
     }
     d->m_itemSet.clear();
+    d->m_tiledItems.clear();
+    d->m_itemTiles.clear();
+    d->m_displayedItemsValid = false;
     d->m_lastBox = GeoDataLatLonAltBox();
     d->m_downloadedBox = GeoDataLatLonAltBox();
     d->m_downloadedNumber = 0;
@@ -12,6 +12,10 @@
 
 #include "ClipPainter.h"
 
+#include <QPair>
+#include <QPolygonF>
+#include <QVector>
+
 #include <cmath>
 
 #include "MarbleDebug.h"
@@ -20,6 +24,76 @@
 namespace Marble
 {
 
+/**
+ * The pieces a polygon is clipped into, kept in one flat array of points
+ * with the offset and size of each piece. Reused from call to call so that
+ * clipping does not allocate once the buffers have grown large enough.
+ */
+class ClippedPolygons
+{
+public:
+    ClippedPolygons() :
+        m_pieceStart( 0 )
+    {
+    }
+
+    void clear()
+    {
+        m_points.clear();
+        m_pieces.clear();
+        m_pieceStart = 0;
+    }
+
+    // Appends a point to the current piece
+    ClippedPolygons &operator<<( const QPointF &point )
+    {
+        m_points << point;
+        return *this;
+    }
+
+    // Drops the points of the current piece and starts a new one
+    void startPiece()
+    {
+        m_pieceStart = m_points.size();
+    }
+
+    // Adds the current piece as it is now to the result
+    void addPiece()
+    {
+        m_pieces << qMakePair( m_pieceStart, m_points.size() - m_pieceStart );
+    }
+
+    bool isPieceEmpty() const
+    {
+        return m_points.size() == m_pieceStart;
+    }
+
+    int size() const
+    {
+        return m_pieces.size();
+    }
+
+    const QPointF *points( int piece ) const
+    {
+        return m_points.constData() + m_pieces.at( piece ).first;
+    }
+
+    int pointCount( int piece ) const
+    {
+        return m_pieces.at( piece ).second;
+    }
+
+    QPolygonF polygon( int piece ) const
+    {
+        return QPolygonF( m_points.mid( m_pieces.at( piece ).first, m_pieces.at( piece ).second ) );
+    }
+
+private:
+    QVector<QPointF> m_points;
+    QVector<QPair<int, int> > m_pieces;
+    int m_pieceStart;
+};
+
 class ClipPainterPrivate
 {
  public:
@@ -54,25 +128,17 @@ class ClipPainterPrivate
 
     inline void initClipRect();
 
+    // Clips into m_clippedPolyObjects
     inline void clipPolyObject ( const QPolygonF & sourcePolygon, 
-                                 QVector<QPolygonF> & clippedPolyObjects,
                                  bool isClosed );
 
-    inline void clipMultiple( QPolygonF & clippedPolyObject,
-                              QVector<QPolygonF> & clippedPolyObjects,
-                              bool isClosed );
-    inline void clipOnce( QPolygonF & clippedPolyObject,
-                              QVector<QPolygonF> & clippedPolyObjects,
-                              bool isClosed );
-    inline void clipOnceCorner( QPolygonF & clippedPolyObject,
-                                QVector<QPolygonF> & clippedPolyObjects,
-                                const QPointF& corner,
-                                const QPointF& point,
-                                bool isClosed ) const;
-    inline void clipOnceEdge(   QPolygonF & clippedPolyObject,
-                                QVector<QPolygonF> & clippedPolyObjects,
+    inline void clipMultiple( bool isClosed );
+    inline void clipOnce( bool isClosed );
+    inline void clipOnceCorner( const QPointF& corner,
                                 const QPointF& point,
-                                bool isClosed ) const;
+                                bool isClosed );
+    inline void clipOnceEdge(   const QPointF& point,
+                                bool isClosed );
 
 
     void labelPosition(const QPolygonF &polygon, QVector<QPointF> &labelNodes,
@@ -87,6 +153,8 @@ class ClipPainterPrivate
 
     void debugDrawNodes( const QPolygonF & );
 
+    ClippedPolygons m_clippedPolyObjects;
+
     qreal m_labelAreaMargin;
 
     int m_debugPenBatchColor;
@@ -140,13 +208,14 @@ void ClipPainter::drawPolygon ( const QPolygonF & polygon,
 {
     if ( d->m_doClip ) {	
         d->initClipRect();
-        QVector<QPolygonF> clippedPolyObjects;
+        d->m_clippedPolyObjects.clear();
 
-        d->clipPolyObject( polygon, clippedPolyObjects, true );
+        d->clipPolyObject( polygon, true );
 
-        for( const QPolygonF & clippedPolyObject: clippedPolyObjects ) { 
-            if ( clippedPolyObject.size() > 2 ) {
-                // mDebug() << "Size: " << clippedPolyObject.size();
+        const ClippedPolygons & clippedPolyObjects = d->m_clippedPolyObjects;
+        for ( int i = 0; i < clippedPolyObjects.size(); ++i ) {
+            if ( clippedPolyObjects.pointCount( i ) > 2 ) {
+                // mDebug() << "Size: " << clippedPolyObjects.pointCount( i );
                 if (d->m_debugPolygonsLevel) {
                     QBrush brush = QPainter::brush();
                     QBrush originalBrush = brush;
@@ -155,14 +224,14 @@ void ClipPainter::drawPolygon ( const QPolygonF & polygon,
                     brush.setColor(color);
                     QPainter::setBrush(brush);
 
-                    QPainter::drawPolygon ( clippedPolyObject, fillRule );
+                    QPainter::drawPolygon ( clippedPolyObjects.points( i ), clippedPolyObjects.pointCount( i ), fillRule );
 
                     QPainter::setBrush(originalBrush);
 
-                    d->debugDrawNodes( clippedPolyObject );
+                    d->debugDrawNodes( clippedPolyObjects.polygon( i ) );
                 }
                 else {
-                    QPainter::drawPolygon ( clippedPolyObject, fillRule );
+                    QPainter::drawPolygon ( clippedPolyObjects.points( i ), clippedPolyObjects.pointCount( i ), fillRule );
                 }
             }
         }
@@ -192,12 +261,13 @@ void ClipPainter::drawPolyline( const QPolygonF & polygon )
 {
     if ( d->m_doClip ) {
         d->initClipRect();
-        QVector<QPolygonF> clippedPolyObjects;
+        d->m_clippedPolyObjects.clear();
 
-        d->clipPolyObject( polygon, clippedPolyObjects, false );
+        d->clipPolyObject( polygon, false );
 
-        for( const QPolygonF & clippedPolyObject: clippedPolyObjects ) { 
-            if ( clippedPolyObject.size() > 1 ) {
+        const ClippedPolygons & clippedPolyObjects = d->m_clippedPolyObjects;
+        for ( int i = 0; i < clippedPolyObjects.size(); ++i ) {
+            if ( clippedPolyObjects.pointCount( i ) > 1 ) {
                 if (d->m_debugPolygonsLevel) {
                     QPen pen = QPainter::pen();
                     QPen originalPen = pen;
@@ -206,14 +276,14 @@ void ClipPainter::drawPolyline( const QPolygonF & polygon )
                     pen.setColor(color);
                     QPainter::setPen(pen);
 
-                    QPainter::drawPolyline ( clippedPolyObject );
+                    QPainter::drawPolyline ( clippedPolyObjects.points( i ), clippedPolyObjects.pointCount( i ) );
 
                     QPainter::setPen(originalPen);
 
-                    d->debugDrawNodes( clippedPolyObject );
+                    d->debugDrawNodes( clippedPolyObjects.polygon( i ) );
                 }
                 else {
-                    QPainter::drawPolyline ( clippedPolyObject );
+                    QPainter::drawPolyline ( clippedPolyObjects.points( i ), clippedPolyObjects.pointCount( i ) );
                 }
             }
         }
@@ -244,11 +314,12 @@ void ClipPainter::drawPolyline(const QPolygonF & polygon, QVector<QPointF>& labe
 {
     if ( d->m_doClip ) {
         d->initClipRect();
-        QVector<QPolygonF> clippedPolyObjects;
+        d->m_clippedPolyObjects.clear();
 
-        d->clipPolyObject( polygon, clippedPolyObjects, false );
+        d->clipPolyObject( polygon, false );
 
-        for( const QPolygonF & clippedPolyObject: clippedPolyObjects ) { 
+        const ClippedPolygons & clippedPolyObjects = d->m_clippedPolyObjects;
+        for ( int i = 0; i < clippedPolyObjects.size(); ++i ) {
             if (d->m_debugPolygonsLevel) {
                 QPen pen = QPainter::pen();
                 QPen originalPen = pen;
@@ -257,14 +328,14 @@ void ClipPainter::drawPolyline(const QPolygonF & polygon, QVector<QPointF>& labe
                 pen.setColor(color);
                 QPainter::setPen(pen);
 
-                QPainter::drawPolyline ( clippedPolyObject );
+                QPainter::drawPolyline ( clippedPolyObjects.points( i ), clippedPolyObjects.pointCount( i ) );
 
                 QPainter::setPen(originalPen);
 
-                d->debugDrawNodes( clippedPolyObject );
+                d->debugDrawNodes( clippedPolyObjects.polygon( i ) );
             }
             else {
-                QPainter::drawPolyline ( clippedPolyObject );
+                QPainter::drawPolyline ( clippedPolyObjects.points( i ), clippedPolyObjects.pointCount( i ) );
             }
         }
     }
@@ -549,14 +620,13 @@ int ClipPainterPrivate::sector( const QPointF & point ) const
 }
 
 void ClipPainterPrivate::clipPolyObject ( const QPolygonF & polygon, 
-                                          QVector<QPolygonF> & clippedPolyObjects,
                                           bool isClosed )
 {
     //	mDebug() << "ClipPainter enabled." ;
 
     // Only create a new polyObject as soon as we know for sure that 
     // the current point is on the screen. 
-    QPolygonF clippedPolyObject = QPolygonF();
+    m_clippedPolyObjects.startPiece();
 
     const QVector<QPointF>::const_iterator  itStartPoint = polygon.constBegin();
     const QVector<QPointF>::const_iterator  itEndPoint   = polygon.constEnd();
@@ -595,14 +665,14 @@ void ClipPainterPrivate::clipPolyObject ( const QPolygonF & polygon,
                 // screen but not both. Hence we only need to clip once and require
                 // only one interpolation for both cases.
 
-                clipOnce( clippedPolyObject, clippedPolyObjects, isClosed );
+                clipOnce( isClosed );
             }
             else {
                 // This case mostly deals with lines that reach from one
                 // sector that is located off screen to another one that
                 // is located off screen. In this situation the line 
                 // can get clipped once, twice, or not at all.
-                clipMultiple( clippedPolyObject, clippedPolyObjects, isClosed );
+                clipMultiple( isClosed );
             }
 
             m_previousSector = m_currentSector;
@@ -611,7 +681,7 @@ void ClipPainterPrivate::clipPolyObject ( const QPolygonF & polygon,
         // If the current point is onscreen, just add it to our final polygon.
         if ( m_currentSector == 4 ) {
 
-            clippedPolyObject << m_currentPoint;
+            m_clippedPolyObjects << m_currentPoint;
 #ifdef MARBLE_DEBUG
             ++(m_debugNodeCount);
 #endif
@@ -633,18 +703,15 @@ void ClipPainterPrivate::clipPolyObject ( const QPolygonF & polygon,
         }
     }
 
-    // Only add the pointer if there's node data available.
-    if ( !clippedPolyObject.isEmpty() ) {
-        clippedPolyObjects << clippedPolyObject;
+    // Only add the piece if there's node data available.
+    if ( !m_clippedPolyObjects.isPieceEmpty() ) {
+        m_clippedPolyObjects.addPiece();
     }
 }
 
 
-void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
-                                       QVector<QPolygonF> & clippedPolyObjects,
-                                       bool isClosed )
+void ClipPainterPrivate::clipMultiple( bool isClosed )
 {
-    Q_UNUSED( clippedPolyObjects )
     Q_UNUSED( isClosed )
 
     // Take care of adding nodes in the image corners if the iterator 
@@ -660,14 +727,14 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointRight.y() > m_top ) {
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
             } else {
-                clippedPolyObject << QPointF( m_right, m_top );
+                m_clippedPolyObjects << QPointF( m_right, m_top );
             }
             if ( pointTop.x() >= m_left && pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
             if ( pointLeft.y() > m_top ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
         }
         else if ( m_previousSector == 7 ) {
             QPointF pointBottom = clipBottom( m, m_previousPoint );
@@ -675,14 +742,14 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointBottom.x() > m_left ) {
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
             } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
+                m_clippedPolyObjects << QPointF( m_left, m_bottom );
             }
             if ( pointLeft.y() >= m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
             if ( pointTop.x() > m_left )
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
         }
         else if ( m_previousSector == 8 ) {
             QPointF pointBottom = clipBottom( m, m_previousPoint );
@@ -691,21 +758,21 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointBottom.x() > m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
             if ( pointRight.y() > m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
             if ( pointTop.x() > m_left && pointTop.x() < m_right ) 
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
             if ( pointLeft.y() > m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
    
             if ( pointBottom.x() <= m_left && pointLeft.y() >= m_bottom )
-                clippedPolyObject << QPointF( m_left, m_bottom );
+                m_clippedPolyObjects << QPointF( m_left, m_bottom );
             if ( pointTop.x() >= m_right && pointRight.y() <= m_top )
-                clippedPolyObject << QPointF( m_right, m_top );
+                m_clippedPolyObjects << QPointF( m_right, m_top );
         }
 
-        clippedPolyObject << QPointF( m_left, m_top );
+        m_clippedPolyObjects << QPointF( m_left, m_top );
         break;
 
     case 1:
@@ -714,24 +781,24 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointTop = clipTop( m, m_currentPoint );
 
             if ( pointLeft.y() > m_top ) {
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
             } else {
-                clippedPolyObject << QPointF( m_left, m_top );
+                m_clippedPolyObjects << QPointF( m_left, m_top );
             }
             if ( pointTop.x() > m_left )
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
         }
         else if ( m_previousSector == 5 ) {
             QPointF pointRight = clipRight( m, m_previousPoint );
             QPointF pointTop = clipTop( m, m_currentPoint );
 
             if ( pointRight.y() > m_top ) {
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
             } else {
-                clippedPolyObject << QPointF( m_right, m_top );
+                m_clippedPolyObjects << QPointF( m_right, m_top );
             }
             if ( pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
         }
         else if ( m_previousSector == 6 ) {
             QPointF pointBottom = clipBottom( m, m_previousPoint );
@@ -739,18 +806,18 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointTop = clipTop( m, m_currentPoint );
 
             if ( pointBottom.x() > m_left )
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
             if ( pointLeft.y() > m_top && pointLeft.y() <= m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
             if ( pointTop.x() > m_left ) {
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
             } else {
-                clippedPolyObject << QPointF( m_left, m_top );
+                m_clippedPolyObjects << QPointF( m_left, m_top );
             }
         }
         else if ( m_previousSector == 7 ) {
-            clippedPolyObject << clipBottom( m, m_previousPoint );
-            clippedPolyObject << clipTop( m, m_currentPoint );
+            m_clippedPolyObjects << clipBottom( m, m_previousPoint );
+            m_clippedPolyObjects << clipTop( m, m_currentPoint );
         }
         else if ( m_previousSector == 8 ) {
             QPointF pointBottom = clipBottom( m, m_previousPoint );
@@ -758,13 +825,13 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointTop = clipTop( m, m_currentPoint );
 
             if ( pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
             if ( pointRight.y() > m_top && pointRight.y() <= m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
             if ( pointTop.x() < m_right ) {
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
             } else {
-                clippedPolyObject << QPointF( m_right, m_top );
+                m_clippedPolyObjects << QPointF( m_right, m_top );
             }
         }
         break;
@@ -776,14 +843,14 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_currentPoint );
 
             if ( pointLeft.y() > m_top ) {
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
             } else {
-                clippedPolyObject << QPointF( m_left, m_top );
+                m_clippedPolyObjects << QPointF( m_left, m_top );
             }
             if ( pointTop.x() > m_left && pointTop.x() <= m_right )
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
             if ( pointRight.y() > m_top ) 
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
         }
         else if ( m_previousSector == 7 ) {
             QPointF pointBottom = clipBottom( m, m_previousPoint );
@@ -791,14 +858,14 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_currentPoint );
 
             if ( pointBottom.x() < m_right ) {
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
             } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
+                m_clippedPolyObjects << QPointF( m_right, m_bottom );
             }
             if ( pointRight.y() >= m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
             if ( pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
         }
         else if ( m_previousSector == 6 ) {
             QPointF pointBottom = clipBottom( m, m_previousPoint );
@@ -807,21 +874,21 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_previousPoint );
 
             if ( pointBottom.x() > m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
             if ( pointLeft.y() > m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
             if ( pointTop.x() > m_left && pointTop.x() < m_right ) 
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
             if ( pointRight.y() > m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
    
             if ( pointBottom.x() >= m_right && pointRight.y() >= m_bottom )
-                clippedPolyObject << QPointF( m_right, m_bottom );
+                m_clippedPolyObjects << QPointF( m_right, m_bottom );
             if ( pointTop.x() <= m_left && pointLeft.y() <= m_top )
-                clippedPolyObject << QPointF( m_left, m_top );
+                m_clippedPolyObjects << QPointF( m_left, m_top );
         }
 
-        clippedPolyObject << QPointF( m_right, m_top );
+        m_clippedPolyObjects << QPointF( m_right, m_top );
         break;
 
     case 3:
@@ -830,11 +897,11 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointBottom.x() > m_left )
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
             if ( pointLeft.y() < m_bottom ) {
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
             } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
+                m_clippedPolyObjects << QPointF( m_left, m_bottom );
             }
         }
         else if ( m_previousSector == 1 ) {
@@ -842,11 +909,11 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointTop.x() > m_left )
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
             if ( pointLeft.y() > m_top ) {
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
             } else {
-                clippedPolyObject << QPointF( m_left, m_top );
+                m_clippedPolyObjects << QPointF( m_left, m_top );
             }
         }
         else if ( m_previousSector == 8 ) {
@@ -855,18 +922,18 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
             if ( pointBottom.x() > m_left && pointBottom.x() <= m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
             if ( pointLeft.y() < m_bottom ) {
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
             } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
+                m_clippedPolyObjects << QPointF( m_left, m_bottom );
             }
         }
         else if ( m_previousSector == 5 ) {
-            clippedPolyObject << clipRight( m, m_previousPoint );
-            clippedPolyObject << clipLeft( m, m_currentPoint );
+            m_clippedPolyObjects << clipRight( m, m_previousPoint );
+            m_clippedPolyObjects << clipLeft( m, m_currentPoint );
         }
         else if ( m_previousSector == 2 ) {
             QPointF pointRight = clipRight( m, m_previousPoint );
@@ -874,13 +941,13 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointRight.y() > m_top ) 
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
             if ( pointTop.x() > m_left && pointTop.x() <= m_right )
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
             if ( pointLeft.y() > m_top ) {
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
             } else {
-                clippedPolyObject << QPointF( m_left, m_top );
+                m_clippedPolyObjects << QPointF( m_left, m_top );
             }
         }
         break;
@@ -891,11 +958,11 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_currentPoint );
 
             if ( pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
             if ( pointRight.y() < m_bottom ) {
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
             } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
+                m_clippedPolyObjects << QPointF( m_right, m_bottom );
             }
         }
         else if ( m_previousSector == 1 ) {
@@ -903,11 +970,11 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_currentPoint );
 
             if ( pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
             if ( pointRight.y() > m_top ) {
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
             } else {
-                clippedPolyObject << QPointF( m_right, m_top );
+                m_clippedPolyObjects << QPointF( m_right, m_top );
             }
         }
         else if ( m_previousSector == 6 ) {
@@ -916,18 +983,18 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_currentPoint );
 
             if ( pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
             if ( pointBottom.x() >= m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
             if ( pointRight.y() < m_bottom ) {
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
             } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
+                m_clippedPolyObjects << QPointF( m_right, m_bottom );
             }
         }
         else if ( m_previousSector == 3 ) {
-            clippedPolyObject << clipLeft( m, m_previousPoint );
-            clippedPolyObject << clipRight( m, m_currentPoint );
+            m_clippedPolyObjects << clipLeft( m, m_previousPoint );
+            m_clippedPolyObjects << clipRight( m, m_currentPoint );
         }
         else if ( m_previousSector == 0 ) {
             QPointF pointLeft = clipLeft( m, m_previousPoint );
@@ -935,13 +1002,13 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_currentPoint );
 
             if ( pointLeft.y() > m_top ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
             if ( pointTop.x() >= m_left && pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
             if ( pointRight.y() > m_top ) {
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
             } else {
-                clippedPolyObject << QPointF( m_right, m_top );
+                m_clippedPolyObjects << QPointF( m_right, m_top );
             }
         }
         break;
@@ -953,14 +1020,14 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointRight.y() < m_bottom ) {
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
             } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
+                m_clippedPolyObjects << QPointF( m_right, m_bottom );
             }
             if ( pointBottom.x() >= m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
             if ( pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
         }
         else if ( m_previousSector == 1 ) {
             QPointF pointTop = clipTop( m, m_previousPoint );
@@ -968,14 +1035,14 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointBottom = clipBottom( m, m_currentPoint );
 
             if ( pointTop.x() > m_left ) {
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
             } else {
-                clippedPolyObject << QPointF( m_left, m_top );
+                m_clippedPolyObjects << QPointF( m_left, m_top );
             }
             if ( pointLeft.y() > m_top && pointLeft.y() <= m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
             if ( pointBottom.x() > m_left )
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
         }
         else if ( m_previousSector == 2 ) {
             QPointF pointTop = clipTop( m, m_currentPoint );
@@ -984,21 +1051,21 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointLeft = clipLeft( m, m_currentPoint );
 
             if ( pointTop.x() > m_left && pointTop.x() < m_right ) 
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
             if ( pointRight.y() > m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
             if ( pointBottom.x() > m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
             if ( pointLeft.y() > m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
    
             if ( pointBottom.x() >= m_right && pointRight.y() >= m_bottom )
-                clippedPolyObject << QPointF( m_right, m_bottom );
+                m_clippedPolyObjects << QPointF( m_right, m_bottom );
             if ( pointTop.x() <= m_left && pointLeft.y() <= m_top )
-                clippedPolyObject << QPointF( m_left, m_top );
+                m_clippedPolyObjects << QPointF( m_left, m_top );
         }
 
-        clippedPolyObject << QPointF( m_left, m_bottom );
+        m_clippedPolyObjects << QPointF( m_left, m_bottom );
         break;
 
     case 7:
@@ -1007,24 +1074,24 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointBottom = clipBottom( m, m_currentPoint );
 
             if ( pointLeft.y() < m_bottom ) {
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
             } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
+                m_clippedPolyObjects << QPointF( m_left, m_bottom );
             }
             if ( pointBottom.x() > m_left )
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
         }
         else if ( m_previousSector == 5 ) {
             QPointF pointRight = clipRight( m, m_previousPoint );
             QPointF pointBottom = clipBottom( m, m_currentPoint );
 
             if ( pointRight.y() < m_bottom ) {
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
             } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
+                m_clippedPolyObjects << QPointF( m_right, m_bottom );
             }
             if ( pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
         }
         else if ( m_previousSector == 0 ) {
             QPointF pointTop = clipTop( m, m_previousPoint );
@@ -1032,18 +1099,18 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointBottom = clipBottom( m, m_currentPoint );
 
             if ( pointTop.x() > m_left )
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
             if ( pointLeft.y() >= m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
             if ( pointBottom.x() > m_left ) {
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
             } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
+                m_clippedPolyObjects << QPointF( m_left, m_bottom );
             }
         }
         else if ( m_previousSector == 1 ) {
-            clippedPolyObject << clipTop( m, m_previousPoint );
-            clippedPolyObject << clipBottom( m, m_currentPoint );
+            m_clippedPolyObjects << clipTop( m, m_previousPoint );
+            m_clippedPolyObjects << clipBottom( m, m_currentPoint );
         }
         else if ( m_previousSector == 2 ) {
             QPointF pointTop = clipTop( m, m_previousPoint );
@@ -1051,13 +1118,13 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointBottom = clipBottom( m, m_currentPoint );
 
             if ( pointTop.x() < m_right )
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
             if ( pointRight.y() >= m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
             if ( pointBottom.x() < m_right ) {
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
             } else {
-                clippedPolyObject << QPointF( m_right, m_bottom );
+                m_clippedPolyObjects << QPointF( m_right, m_bottom );
             }
         }
         break;
@@ -1069,14 +1136,14 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_currentPoint );
 
             if ( pointLeft.y() < m_bottom ) {
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
             } else {
-                clippedPolyObject << QPointF( m_left, m_bottom );
+                m_clippedPolyObjects << QPointF( m_left, m_bottom );
             }
             if ( pointBottom.x() > m_left && pointBottom.x() <= m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
             if ( pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
         }
         else if ( m_previousSector == 1 ) {
             QPointF pointTop = clipTop( m, m_previousPoint );
@@ -1084,14 +1151,14 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointBottom = clipBottom( m, m_currentPoint );
 
             if ( pointTop.x() < m_right ) {
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
             } else {
-                clippedPolyObject << QPointF( m_right, m_top );
+                m_clippedPolyObjects << QPointF( m_right, m_top );
             }
             if ( pointRight.y() > m_top && pointRight.y() <= m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
             if ( pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
         }
         else if ( m_previousSector == 0 ) {
             QPointF pointTop = clipTop( m, m_currentPoint );
@@ -1100,21 +1167,21 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
             QPointF pointRight = clipRight( m, m_previousPoint );
 
             if ( pointTop.x() > m_left && pointTop.x() < m_right ) 
-                clippedPolyObject << pointTop;
+                m_clippedPolyObjects << pointTop;
             if ( pointLeft.y() > m_top && pointLeft.y() < m_bottom ) 
-                clippedPolyObject << pointLeft;
+                m_clippedPolyObjects << pointLeft;
             if ( pointBottom.x() > m_left && pointBottom.x() < m_right )
-                clippedPolyObject << pointBottom;
+                m_clippedPolyObjects << pointBottom;
             if ( pointRight.y() > m_top && pointRight.y() < m_bottom ) 
-                clippedPolyObject << pointRight;
+                m_clippedPolyObjects << pointRight;
    
             if ( pointBottom.x() <= m_left && pointLeft.y() >= m_bottom )
-                clippedPolyObject << QPointF( m_left, m_bottom );
+                m_clippedPolyObjects << QPointF( m_left, m_bottom );
             if ( pointTop.x() >= m_right && pointRight.y() <= m_top )
-                clippedPolyObject << QPointF( m_right, m_top );
+                m_clippedPolyObjects << QPointF( m_right, m_top );
         }
 
-        clippedPolyObject << QPointF( m_right, m_bottom );
+        m_clippedPolyObjects << QPointF( m_right, m_bottom );
         break;
 
     default:
@@ -1122,50 +1189,43 @@ void ClipPainterPrivate::clipMultiple( QPolygonF & clippedPolyObject,
     }
 }
 
-void ClipPainterPrivate::clipOnceCorner( QPolygonF & clippedPolyObject,
-                                         QVector<QPolygonF> & clippedPolyObjects,
-                                         const QPointF& corner,
+void ClipPainterPrivate::clipOnceCorner( const QPointF& corner,
                                          const QPointF& point, 
-                                         bool isClosed ) const
+                                         bool isClosed )
 {
-    Q_UNUSED( clippedPolyObjects )
     Q_UNUSED( isClosed )
 
     if ( m_currentSector == 4) {
         // Appearing
-        clippedPolyObject << corner;
-        clippedPolyObject << point;
+        m_clippedPolyObjects << corner;
+        m_clippedPolyObjects << point;
     } else {
         // Disappearing
-        clippedPolyObject << point;
-        clippedPolyObject << corner;
+        m_clippedPolyObjects << point;
+        m_clippedPolyObjects << corner;
     }
 }
 
-void ClipPainterPrivate::clipOnceEdge( QPolygonF & clippedPolyObject,
-                                       QVector<QPolygonF> & clippedPolyObjects,
-                                       const QPointF& point,
-                                       bool isClosed ) const
+void ClipPainterPrivate::clipOnceEdge( const QPointF& point,
+                                       bool isClosed )
 {
     if ( m_currentSector == 4) {
         // Appearing
         if ( !isClosed ) {
-            clippedPolyObject = QPolygonF();
+            m_clippedPolyObjects.startPiece();
         }
-        clippedPolyObject << point;
+        m_clippedPolyObjects << point;
     }
     else {
         // Disappearing
-        clippedPolyObject << point;
+        m_clippedPolyObjects << point;
         if ( !isClosed ) {
-            clippedPolyObjects << clippedPolyObject;           
+            m_clippedPolyObjects.addPiece();
         }
     }
 }
 
-void ClipPainterPrivate::clipOnce( QPolygonF & clippedPolyObject,
-                                   QVector<QPolygonF> & clippedPolyObjects,
-                                   bool isClosed )
+void ClipPainterPrivate::clipOnce( bool isClosed )
 {
     //	Interpolate border points (linear interpolation)
     QPointF point;
@@ -1183,44 +1243,44 @@ void ClipPainterPrivate::clipOnce( QPolygonF & clippedPolyObject,
         if ( point.x() < m_left ) {
             point = clipLeft( m, point );
         }
-        clipOnceCorner( clippedPolyObject, clippedPolyObjects, QPointF( m_left, m_top ), point, isClosed );
+        clipOnceCorner( QPointF( m_left, m_top ), point, isClosed );
         break;
     case 1: // top
         point = clipTop( m, m_previousPoint );
-        clipOnceEdge( clippedPolyObject, clippedPolyObjects, point, isClosed );
+        clipOnceEdge( point, isClosed );
         break;
     case 2: // topright
         point = clipTop( m, m_previousPoint );
         if ( point.x() > m_right ) {
             point = clipRight( m, point );
         }
-        clipOnceCorner( clippedPolyObject, clippedPolyObjects, QPointF( m_right, m_top ), point, isClosed );
+        clipOnceCorner( QPointF( m_right, m_top ), point, isClosed );
         break;
     case 3: // left
         point = clipLeft( m, m_previousPoint );
-        clipOnceEdge( clippedPolyObject, clippedPolyObjects, point, isClosed );
+        clipOnceEdge( point, isClosed );
         break;
     case 5: // right
         point = clipRight( m, m_previousPoint );
-        clipOnceEdge( clippedPolyObject, clippedPolyObjects, point, isClosed );
+        clipOnceEdge( point, isClosed );
         break;
     case 6: // bottomleft
         point = clipBottom( m, m_previousPoint );
         if ( point.x() < m_left ) {
             point = clipLeft( m, point );
         }
-        clipOnceCorner( clippedPolyObject, clippedPolyObjects, QPointF( m_left, m_bottom ), point, isClosed );
+        clipOnceCorner( QPointF( m_left, m_bottom ), point, isClosed );
         break;
     case 7: // bottom
         point = clipBottom( m, m_previousPoint );
-        clipOnceEdge( clippedPolyObject, clippedPolyObjects, point, isClosed );
+        clipOnceEdge( point, isClosed );
         break;
     case 8: // bottomright
         point = clipBottom( m, m_previousPoint );
         if ( point.x() > m_right ) {
             point = clipRight( m, point );
         }
-        clipOnceCorner( clippedPolyObject, clippedPolyObjects, QPointF( m_right, m_bottom ), point, isClosed );
+        clipOnceCorner( QPointF( m_right, m_bottom ), point, isClosed );
         break;
     default:
         break;			
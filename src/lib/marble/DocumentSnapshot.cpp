@@ -0,0 +1,1024 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "DocumentSnapshot.h"
+
+#include "GeoDataArena.h"
+#include "GeoDataData.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataFolder.h"
+#include "GeoDataLatLonAltBox.h"
+#include "GeoDataLinearRing.h"
+#include "GeoDataLineString.h"
+#include "GeoDataMultiGeometry.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPoint.h"
+#include "GeoDataPolygon.h"
+#include "GeoDataRegion.h"
+#include "GeoDataSnippet.h"
+#include "GeoDataStyle.h"
+#include "GeoDataStyleMap.h"
+#include "GeoDataIconStyle.h"
+#include "GeoDataLabelStyle.h"
+#include "GeoDataLineStyle.h"
+#include "GeoDataPolyStyle.h"
+#include "GeoDataBalloonStyle.h"
+#include "GeoDataListStyle.h"
+#include "GeoDataTimeSpan.h"
+#include "GeoDataTimeStamp.h"
+#include "MarbleDebug.h"
+#include "MarbleDirs.h"
+#include "osm/OsmPlacemarkData.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSaveFile>
+#include <QSet>
+#include <QVector>
+
+namespace Marble
+{
+
+namespace {
+
+const quint32 SnapshotMagicNumber = 0x4d534e50; // "MSNP"
+const qint32 SnapshotVersion = 5;
+const qint64 MinimumSourceSize = 64 * 1024;
+
+enum RecordType {
+    EndRecord = 0,
+    FolderRecord,
+    PlacemarkRecord
+};
+
+enum GeometryType {
+    NoGeometry = 0,
+    PointGeometry,
+    LineStringGeometry,
+    LinearRingGeometry,
+    PolygonGeometry,
+    MultiGeometryGeometry
+};
+
+struct SnapshotHeader
+{
+    SnapshotHeader() :
+        magic( 0 ),
+        version( 0 ),
+        littleEndian( 0 ),
+        unsupported( 0 ),
+        sourceSize( -1 ),
+        sourceModified( -1 ),
+        north( 0.0 ),
+        south( 0.0 ),
+        east( 0.0 ),
+        west( 0.0 )
+    {}
+
+    static SnapshotHeader forSource( const QFileInfo &source )
+    {
+        SnapshotHeader header;
+        header.magic = SnapshotMagicNumber;
+        header.version = SnapshotVersion;
+        header.littleEndian = Q_BYTE_ORDER == Q_LITTLE_ENDIAN ? 1 : 0;
+        header.sourceSize = source.size();
+        header.sourceModified = source.lastModified().toMSecsSinceEpoch();
+        return header;
+    }
+
+    /**
+     * Compares the source the snapshots were taken from, not their content
+     */
+    bool operator==( const SnapshotHeader &other ) const
+    {
+        return magic == other.magic && version == other.version
+            && littleEndian == other.littleEndian
+            && sourceSize == other.sourceSize
+            && sourceModified == other.sourceModified;
+    }
+
+    quint32 magic;
+    qint32 version;
+    quint8 littleEndian;
+    // The document of the source is not supported, the snapshot has no content
+    quint8 unsupported;
+    qint64 sourceSize;
+    qint64 sourceModified;
+    // Bounds of the document in radians, all zero if it has none
+    double north;
+    double south;
+    double east;
+    double west;
+};
+
+QDataStream &operator<<( QDataStream &stream, const SnapshotHeader &header )
+{
+    stream << header.magic << header.version << header.littleEndian << header.unsupported
+           << header.sourceSize << header.sourceModified
+           << header.north << header.south << header.east << header.west;
+    return stream;
+}
+
+QDataStream &operator>>( QDataStream &stream, SnapshotHeader &header )
+{
+    stream >> header.magic >> header.version >> header.littleEndian >> header.unsupported
+           >> header.sourceSize >> header.sourceModified
+           >> header.north >> header.south >> header.east >> header.west;
+    return stream;
+}
+
+void setupStream( QDataStream &stream )
+{
+    stream.setVersion( QDataStream::Qt_5_6 );
+    stream.setByteOrder( QDataStream::LittleEndian );
+    stream.setFloatingPointPrecision( QDataStream::DoublePrecision );
+}
+
+/**
+ * Reads the header of the snapshot of the given source file.
+ * @return false if there is no snapshot or it was taken from another version of the source
+ */
+bool readCurrentHeader( const QString &snapshotFileName, const QString &sourceFileName, SnapshotHeader &header )
+{
+    QFile file( snapshotFileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return false;
+    }
+
+    QDataStream stream( &file );
+    setupStream( stream );
+    stream >> header;
+    return stream.status() == QDataStream::Ok && header == SnapshotHeader::forSource( QFileInfo( sourceFileName ) );
+}
+
+class SnapshotWriter
+{
+public:
+    SnapshotWriter();
+
+    bool writeDocument( const GeoDataDocument *document );
+
+    void write( QIODevice *device, const SnapshotHeader &header ) const;
+
+private:
+    void writeString( const QString &string );
+    bool writeFeatureProperties( const GeoDataFeature *feature );
+    bool writeStyle( const GeoDataStyle &style );
+    bool writeContainer( const GeoDataContainer *container );
+    void writeOsmData( const OsmPlacemarkData &osmData );
+    bool writeGeometry( const GeoDataGeometry *geometry );
+    void writeCoordinates( const GeoDataLineString &lineString );
+
+    QHash<QString, quint32> m_stringIndex;
+    QVector<QString> m_strings;
+    QByteArray m_records;
+    QDataStream m_stream;
+};
+
+class SnapshotReader
+{
+public:
+    explicit SnapshotReader( QIODevice *device );
+
+    bool readHeader( SnapshotHeader &header );
+
+    GeoDataDocument *readDocument();
+
+private:
+    QString readString();
+    void readFeatureProperties( GeoDataFeature *feature );
+    GeoDataStyle::Ptr readStyle();
+    bool readContainer( GeoDataContainer *container );
+    void readOsmData( OsmPlacemarkData &osmData );
+    GeoDataGeometry *readGeometry();
+    bool readCoordinates( GeoDataLineString &lineString );
+
+    QIODevice *const m_device;
+    QDataStream m_stream;
+    QVector<QString> m_strings;
+};
+
+SnapshotWriter::SnapshotWriter() :
+    m_stream( &m_records, QIODevice::WriteOnly )
+{
+    setupStream( m_stream );
+}
+
+void SnapshotWriter::write( QIODevice *device, const SnapshotHeader &header ) const
+{
+    QDataStream stream( device );
+    setupStream( stream );
+    stream << header;
+    stream << quint32( m_strings.size() );
+    for ( const QString &string: m_strings ) {
+        stream << string;
+    }
+    device->write( m_records );
+}
+
+void SnapshotWriter::writeString( const QString &string )
+{
+    QHash<QString, quint32>::const_iterator iter = m_stringIndex.constFind( string );
+    if ( iter == m_stringIndex.constEnd() ) {
+        iter = m_stringIndex.insert( string, m_strings.size() );
+        m_strings.push_back( string );
+    }
+    m_stream << iter.value();
+}
+
+bool SnapshotWriter::writeDocument( const GeoDataDocument *document )
+{
+    if ( !writeFeatureProperties( document ) ) {
+        return false;
+    }
+
+    writeString( document->baseUri() );
+
+    const QList<GeoDataStyle::ConstPtr> styles = document->styles();
+    m_stream << quint32( styles.size() );
+    for ( const GeoDataStyle::ConstPtr &style: styles ) {
+        if ( !writeStyle( *style ) ) {
+            return false;
+        }
+    }
+
+    const QList<GeoDataStyleMap> styleMaps = document->styleMaps();
+    m_stream << quint32( styleMaps.size() );
+    for ( const GeoDataStyleMap &styleMap: styleMaps ) {
+        writeString( styleMap.id() );
+        m_stream << quint32( styleMap.size() );
+        for ( GeoDataStyleMap::const_iterator iter = styleMap.constBegin(); iter != styleMap.constEnd(); ++iter ) {
+            writeString( iter.key() );
+            writeString( iter.value() );
+        }
+    }
+
+    return writeContainer( document );
+}
+
+bool SnapshotWriter::writeFeatureProperties( const GeoDataFeature *feature )
+{
+    if ( feature->abstractView()
+         || feature->timeSpan().isValid()
+         || feature->timeStamp().when().isValid()
+         || !( feature->region() == GeoDataRegion() )
+         || !feature->extendedData().schemaDataList().isEmpty() ) {
+        return false;
+    }
+
+    writeString( feature->id() );
+    writeString( feature->name() );
+    writeString( feature->description() );
+    writeString( feature->styleUrl() );
+    writeString( feature->role() );
+    writeString( feature->address() );
+    writeString( feature->phoneNumber() );
+    writeString( feature->snippet().text() );
+    m_stream << qint32( feature->snippet().maxLines() );
+    m_stream << feature->descriptionIsCDATA() << feature->isVisible();
+    m_stream << qint32( feature->zoomLevel() ) << feature->popularity();
+
+    const GeoDataExtendedData &extendedData = feature->extendedData();
+    m_stream << quint32( extendedData.size() );
+    QHash<QString, GeoDataData>::const_iterator iter = extendedData.constBegin();
+    for ( ; iter != extendedData.constEnd(); ++iter ) {
+        writeString( iter.value().name() );
+        writeString( iter.value().displayName() );
+        m_stream << iter.value().value();
+    }
+
+    const QSharedPointer<const GeoDataStyle> style = feature->customStyle();
+    m_stream << bool( style );
+    return !style || writeStyle( *style );
+}
+
+bool SnapshotWriter::writeStyle( const GeoDataStyle &style )
+{
+    if ( style.listStyle() != GeoDataListStyle() ) {
+        return false;
+    }
+
+    writeString( style.id() );
+
+    const GeoDataIconStyle &iconStyle = style.iconStyle();
+    GeoDataHotSpot::Units xunits;
+    GeoDataHotSpot::Units yunits;
+    const QPointF hotSpot = iconStyle.hotSpot( xunits, yunits );
+    m_stream << iconStyle.color() << qint32( iconStyle.colorMode() );
+    writeString( iconStyle.iconPath() );
+    m_stream << iconStyle.scale() << qint32( iconStyle.heading() ) << iconStyle.size();
+    m_stream << hotSpot << qint32( xunits ) << qint32( yunits );
+
+    const GeoDataLabelStyle &labelStyle = style.labelStyle();
+    m_stream << labelStyle.color() << qint32( labelStyle.colorMode() );
+    m_stream << labelStyle.scale() << qint32( labelStyle.alignment() ) << labelStyle.font() << labelStyle.glow();
+
+    const GeoDataLineStyle &lineStyle = style.lineStyle();
+    m_stream << lineStyle.color() << qint32( lineStyle.colorMode() );
+    m_stream << lineStyle.width() << lineStyle.physicalWidth() << lineStyle.cosmeticOutline();
+    m_stream << qint32( lineStyle.capStyle() ) << qint32( lineStyle.penStyle() ) << lineStyle.background();
+    m_stream << lineStyle.dashPattern();
+
+    const GeoDataPolyStyle &polyStyle = style.polyStyle();
+    m_stream << polyStyle.color() << qint32( polyStyle.colorMode() );
+    m_stream << polyStyle.fill() << polyStyle.outline() << qint32( polyStyle.brushStyle() ) << polyStyle.colorIndex();
+    writeString( polyStyle.texturePath() );
+
+    const GeoDataBalloonStyle &balloonStyle = style.balloonStyle();
+    m_stream << balloonStyle.color() << qint32( balloonStyle.colorMode() );
+    m_stream << balloonStyle.backgroundColor() << balloonStyle.textColor() << qint32( balloonStyle.displayMode() );
+    writeString( balloonStyle.text() );
+
+    return true;
+}
+
+bool SnapshotWriter::writeContainer( const GeoDataContainer *container )
+{
+    for ( const GeoDataFeature *feature: container->featureList() ) {
+        if ( const GeoDataFolder *folder = geodata_cast<GeoDataFolder>( feature ) ) {
+            m_stream << quint8( FolderRecord );
+            if ( !writeFeatureProperties( folder ) || !writeContainer( folder ) ) {
+                return false;
+            }
+        } else if ( const GeoDataPlacemark *placemark = geodata_cast<GeoDataPlacemark>( feature ) ) {
+            m_stream << quint8( PlacemarkRecord );
+            if ( !writeFeatureProperties( placemark ) ) {
+                return false;
+            }
+            writeString( placemark->countryCode() );
+            writeString( placemark->state() );
+            m_stream << placemark->area() << placemark->population();
+            m_stream << qint32( placemark->visualCategory() ) << placemark->hasOsmData();
+            if ( placemark->hasOsmData() ) {
+                writeOsmData( placemark->osmData() );
+            }
+            if ( !writeGeometry( placemark->geometry() ) ) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    m_stream << quint8( EndRecord );
+    return true;
+}
+
+void SnapshotWriter::writeOsmData( const OsmPlacemarkData &osmData )
+{
+    m_stream << osmData.id();
+
+    quint32 tagCount = 0;
+    for ( auto iter = osmData.tagsBegin(); iter != osmData.tagsEnd(); ++iter ) {
+        ++tagCount;
+    }
+    m_stream << tagCount;
+    for ( auto iter = osmData.tagsBegin(); iter != osmData.tagsEnd(); ++iter ) {
+        writeString( iter.key() );
+        writeString( iter.value() );
+    }
+
+    quint32 nodeCount = 0;
+    for ( auto iter = osmData.nodeReferencesBegin(); iter != osmData.nodeReferencesEnd(); ++iter ) {
+        ++nodeCount;
+    }
+    m_stream << nodeCount;
+    for ( auto iter = osmData.nodeReferencesBegin(); iter != osmData.nodeReferencesEnd(); ++iter ) {
+        writeOsmData( iter.value() );
+    }
+
+    quint32 memberCount = 0;
+    for ( auto iter = osmData.memberReferencesBegin(); iter != osmData.memberReferencesEnd(); ++iter ) {
+        ++memberCount;
+    }
+    m_stream << memberCount;
+    for ( auto iter = osmData.memberReferencesBegin(); iter != osmData.memberReferencesEnd(); ++iter ) {
+        m_stream << qint32( iter.key() );
+        writeOsmData( iter.value() );
+    }
+
+    quint32 relationCount = 0;
+    for ( auto iter = osmData.relationReferencesBegin(); iter != osmData.relationReferencesEnd(); ++iter ) {
+        ++relationCount;
+    }
+    m_stream << relationCount;
+    for ( auto iter = osmData.relationReferencesBegin(); iter != osmData.relationReferencesEnd(); ++iter ) {
+        m_stream << iter.key().id << quint8( iter.key().type );
+        writeString( iter.value() );
+    }
+}
+
+bool SnapshotWriter::writeGeometry( const GeoDataGeometry *geometry )
+{
+    if ( !geometry ) {
+        m_stream << quint8( NoGeometry );
+        return true;
+    }
+
+    if ( const GeoDataPoint *point = geodata_cast<GeoDataPoint>( geometry ) ) {
+        m_stream << quint8( PointGeometry );
+        m_stream << qint32( geometry->altitudeMode() ) << geometry->extrude();
+        GeoDataLineString lineString;
+        lineString << point->coordinates();
+        writeCoordinates( lineString );
+    } else if ( const GeoDataLinearRing *ring = geodata_cast<GeoDataLinearRing>( geometry ) ) {
+        m_stream << quint8( LinearRingGeometry );
+        m_stream << qint32( geometry->altitudeMode() ) << geometry->extrude();
+        m_stream << qint32( ring->tessellationFlags() );
+        writeCoordinates( *ring );
+    } else if ( const GeoDataLineString *lineString = geodata_cast<GeoDataLineString>( geometry ) ) {
+        m_stream << quint8( LineStringGeometry );
+        m_stream << qint32( geometry->altitudeMode() ) << geometry->extrude();
+        m_stream << qint32( lineString->tessellationFlags() );
+        writeCoordinates( *lineString );
+    } else if ( const GeoDataPolygon *polygon = geodata_cast<GeoDataPolygon>( geometry ) ) {
+        m_stream << quint8( PolygonGeometry );
+        m_stream << qint32( geometry->altitudeMode() ) << geometry->extrude();
+        m_stream << qint32( polygon->tessellationFlags() );
+        writeCoordinates( polygon->outerBoundary() );
+        m_stream << quint32( polygon->innerBoundaries().size() );
+        for ( const GeoDataLinearRing &innerBoundary: polygon->innerBoundaries() ) {
+            writeCoordinates( innerBoundary );
+        }
+    } else if ( const GeoDataMultiGeometry *multiGeometry = geodata_cast<GeoDataMultiGeometry>( geometry ) ) {
+        m_stream << quint8( MultiGeometryGeometry );
+        m_stream << qint32( geometry->altitudeMode() ) << geometry->extrude();
+        m_stream << quint32( multiGeometry->size() );
+        for ( int i = 0; i < multiGeometry->size(); ++i ) {
+            if ( !writeGeometry( &multiGeometry->at( i ) ) ) {
+                return false;
+            }
+        }
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+void SnapshotWriter::writeCoordinates( const GeoDataLineString &lineString )
+{
+    QVector<double> values;
+    values.reserve( 3 * lineString.size() );
+    for ( const GeoDataCoordinates &coordinates: lineString ) {
+        values << coordinates.longitude() << coordinates.latitude() << coordinates.altitude();
+    }
+
+    // Coordinates are stored in host byte order and copied back in one go
+    m_stream << quint32( lineString.size() );
+    m_stream.writeRawData( reinterpret_cast<const char*>( values.constData() ), values.size() * sizeof( double ) );
+}
+
+SnapshotReader::SnapshotReader( QIODevice *device ) :
+    m_device( device ),
+    m_stream( device )
+{
+    setupStream( m_stream );
+}
+
+bool SnapshotReader::readHeader( SnapshotHeader &header )
+{
+    m_stream >> header;
+    return m_stream.status() == QDataStream::Ok;
+}
+
+QString SnapshotReader::readString()
+{
+    quint32 index;
+    m_stream >> index;
+    if ( index < quint32( m_strings.size() ) ) {
+        return m_strings[index];
+    }
+
+    m_stream.setStatus( QDataStream::ReadCorruptData );
+    return QString();
+}
+
+GeoDataDocument *SnapshotReader::readDocument()
+{
+    quint32 stringCount;
+    m_stream >> stringCount;
+    // Each string needs at least four bytes for its length
+    if ( m_stream.status() != QDataStream::Ok || qint64( stringCount ) * 4 > m_device->bytesAvailable() ) {
+        return nullptr;
+    }
+    m_strings.resize( stringCount );
+    for ( quint32 i = 0; i < stringCount; ++i ) {
+        m_stream >> m_strings[i];
+    }
+
+    GeoDataDocument *document = new GeoDataDocument;
+    readFeatureProperties( document );
+    document->setBaseUri( readString() );
+
+    quint32 styleCount;
+    m_stream >> styleCount;
+    for ( quint32 i = 0; i < styleCount && m_stream.status() == QDataStream::Ok; ++i ) {
+        document->addStyle( readStyle() );
+    }
+
+    quint32 styleMapCount;
+    m_stream >> styleMapCount;
+    for ( quint32 i = 0; i < styleMapCount && m_stream.status() == QDataStream::Ok; ++i ) {
+        GeoDataStyleMap styleMap;
+        styleMap.setId( readString() );
+        quint32 size;
+        m_stream >> size;
+        for ( quint32 j = 0; j < size && m_stream.status() == QDataStream::Ok; ++j ) {
+            const QString key = readString();
+            styleMap.insert( key, readString() );
+        }
+        document->addStyleMap( styleMap );
+    }
+
+    if ( !readContainer( document ) || m_stream.status() != QDataStream::Ok ) {
+        delete document;
+        return nullptr;
+    }
+
+    return document;
+}
+
+void SnapshotReader::readFeatureProperties( GeoDataFeature *feature )
+{
+    feature->setId( readString() );
+    feature->setName( readString() );
+    feature->setDescription( readString() );
+    feature->setStyleUrl( readString() );
+    feature->setRole( readString() );
+    feature->setAddress( readString() );
+    feature->setPhoneNumber( readString() );
+    const QString snippet = readString();
+    qint32 maxLines;
+    m_stream >> maxLines;
+    if ( !snippet.isEmpty() || maxLines != 0 ) {
+        feature->setSnippet( GeoDataSnippet( snippet, maxLines ) );
+    }
+
+    bool cdata;
+    bool visible;
+    qint32 zoomLevel;
+    qint64 popularity;
+    m_stream >> cdata >> visible >> zoomLevel >> popularity;
+    feature->setDescriptionCDATA( cdata );
+    feature->setVisible( visible );
+    feature->setZoomLevel( zoomLevel );
+    feature->setPopularity( popularity );
+
+    quint32 dataCount;
+    m_stream >> dataCount;
+    for ( quint32 i = 0; i < dataCount && m_stream.status() == QDataStream::Ok; ++i ) {
+        GeoDataData data;
+        data.setName( readString() );
+        data.setDisplayName( readString() );
+        QVariant value;
+        m_stream >> value;
+        data.setValue( value );
+        feature->extendedData().addValue( data );
+    }
+
+    bool hasStyle;
+    m_stream >> hasStyle;
+    if ( hasStyle ) {
+        feature->setStyle( readStyle() );
+    }
+}
+
+GeoDataStyle::Ptr SnapshotReader::readStyle()
+{
+    GeoDataStyle::Ptr style( new GeoDataStyle );
+    style->setId( readString() );
+
+    QColor color;
+    qint32 colorMode;
+    qint32 value;
+    float scale;
+
+    GeoDataIconStyle &iconStyle = style->iconStyle();
+    m_stream >> color >> colorMode;
+    iconStyle.setColor( color );
+    iconStyle.setColorMode( GeoDataColorStyle::ColorMode( colorMode ) );
+    const QString iconPath = readString();
+    if ( !iconPath.isEmpty() ) {
+        iconStyle.setIconPath( iconPath );
+    }
+    QSize size;
+    m_stream >> scale >> value >> size;
+    iconStyle.setScale( scale );
+    iconStyle.setHeading( value );
+    if ( size.isValid() ) {
+        iconStyle.setSize( size );
+    }
+    QPointF hotSpot;
+    qint32 xunits;
+    qint32 yunits;
+    m_stream >> hotSpot >> xunits >> yunits;
+    iconStyle.setHotSpot( hotSpot, GeoDataHotSpot::Units( xunits ), GeoDataHotSpot::Units( yunits ) );
+
+    GeoDataLabelStyle &labelStyle = style->labelStyle();
+    QFont font;
+    bool glow;
+    m_stream >> color >> colorMode >> scale >> value >> font >> glow;
+    labelStyle.setColor( color );
+    labelStyle.setColorMode( GeoDataColorStyle::ColorMode( colorMode ) );
+    labelStyle.setScale( scale );
+    labelStyle.setAlignment( GeoDataLabelStyle::Alignment( value ) );
+    labelStyle.setFont( font );
+    labelStyle.setGlow( glow );
+
+    GeoDataLineStyle &lineStyle = style->lineStyle();
+    float width;
+    float physicalWidth;
+    bool cosmeticOutline;
+    qint32 capStyle;
+    qint32 penStyle;
+    bool background;
+    QVector<qreal> dashPattern;
+    m_stream >> color >> colorMode >> width >> physicalWidth >> cosmeticOutline;
+    m_stream >> capStyle >> penStyle >> background >> dashPattern;
+    lineStyle.setColor( color );
+    lineStyle.setColorMode( GeoDataColorStyle::ColorMode( colorMode ) );
+    lineStyle.setWidth( width );
+    lineStyle.setPhysicalWidth( physicalWidth );
+    lineStyle.setCosmeticOutline( cosmeticOutline );
+    lineStyle.setCapStyle( Qt::PenCapStyle( capStyle ) );
+    lineStyle.setPenStyle( Qt::PenStyle( penStyle ) );
+    lineStyle.setBackground( background );
+    lineStyle.setDashPattern( dashPattern );
+
+    GeoDataPolyStyle &polyStyle = style->polyStyle();
+    bool fill;
+    bool outline;
+    quint8 colorIndex;
+    m_stream >> color >> colorMode >> fill >> outline >> value >> colorIndex;
+    polyStyle.setColor( color );
+    polyStyle.setColorMode( GeoDataColorStyle::ColorMode( colorMode ) );
+    polyStyle.setFill( fill );
+    polyStyle.setOutline( outline );
+    polyStyle.setBrushStyle( Qt::BrushStyle( value ) );
+    polyStyle.setColorIndex( colorIndex );
+    const QString texturePath = readString();
+    if ( !texturePath.isEmpty() ) {
+        polyStyle.setTexturePath( texturePath );
+    }
+
+    GeoDataBalloonStyle &balloonStyle = style->balloonStyle();
+    QColor backgroundColor;
+    QColor textColor;
+    m_stream >> color >> colorMode >> backgroundColor >> textColor >> value;
+    balloonStyle.setColor( color );
+    balloonStyle.setColorMode( GeoDataColorStyle::ColorMode( colorMode ) );
+    balloonStyle.setBackgroundColor( backgroundColor );
+    balloonStyle.setTextColor( textColor );
+    balloonStyle.setDisplayMode( GeoDataBalloonStyle::DisplayMode( value ) );
+    balloonStyle.setText( readString() );
+
+    return style;
+}
+
+bool SnapshotReader::readContainer( GeoDataContainer *container )
+{
+    while ( m_stream.status() == QDataStream::Ok ) {
+        quint8 type;
+        m_stream >> type;
+        switch ( type ) {
+        case EndRecord:
+            return true;
+        case FolderRecord: {
+            GeoDataFolder *folder = new GeoDataFolder;
+            container->append( folder );
+            readFeatureProperties( folder );
+            if ( !readContainer( folder ) ) {
+                return false;
+            }
+            break;
+        }
+        case PlacemarkRecord: {
+            GeoDataPlacemark *placemark = new GeoDataPlacemark;
+            container->append( placemark );
+            readFeatureProperties( placemark );
+            placemark->setCountryCode( readString() );
+            placemark->setState( readString() );
+            qreal area;
+            qint64 population;
+            m_stream >> area >> population;
+            placemark->setArea( area );
+            placemark->setPopulation( population );
+            qint32 visualCategory;
+            bool hasOsmData;
+            m_stream >> visualCategory >> hasOsmData;
+            placemark->setVisualCategory( GeoDataPlacemark::GeoDataVisualCategory( visualCategory ) );
+            if ( hasOsmData ) {
+                readOsmData( placemark->osmData() );
+            }
+            GeoDataGeometry *geometry = readGeometry();
+            if ( m_stream.status() != QDataStream::Ok ) {
+                delete geometry;
+                return false;
+            }
+            if ( geometry ) {
+                placemark->setGeometry( geometry );
+            }
+            break;
+        }
+        default:
+            m_stream.setStatus( QDataStream::ReadCorruptData );
+            return false;
+        }
+    }
+
+    return false;
+}
+
+void SnapshotReader::readOsmData( OsmPlacemarkData &osmData )
+{
+    qint64 id;
+    m_stream >> id;
+    osmData.setId( id );
+
+    quint32 tagCount;
+    m_stream >> tagCount;
+    for ( quint32 i = 0; i < tagCount && m_stream.status() == QDataStream::Ok; ++i ) {
+        const QString key = readString();
+        osmData.addTag( key, readString() );
+    }
+
+    quint32 nodeCount;
+    m_stream >> nodeCount;
+    for ( quint32 i = 0; i < nodeCount && m_stream.status() == QDataStream::Ok; ++i ) {
+        OsmPlacemarkData node;
+        readOsmData( node );
+        osmData.addNodeReference( i, node );
+    }
+
+    quint32 memberCount;
+    m_stream >> memberCount;
+    for ( quint32 i = 0; i < memberCount && m_stream.status() == QDataStream::Ok; ++i ) {
+        qint32 key;
+        m_stream >> key;
+        OsmPlacemarkData member;
+        readOsmData( member );
+        osmData.addMemberReference( key, member );
+    }
+
+    quint32 relationCount;
+    m_stream >> relationCount;
+    for ( quint32 i = 0; i < relationCount && m_stream.status() == QDataStream::Ok; ++i ) {
+        qint64 relationId;
+        quint8 type;
+        m_stream >> relationId >> type;
+        if ( type > quint8( OsmType::Relation ) ) {
+            m_stream.setStatus( QDataStream::ReadCorruptData );
+            return;
+        }
+        osmData.addRelation( relationId, OsmType( type ), readString() );
+    }
+}
+
+GeoDataGeometry *SnapshotReader::readGeometry()
+{
+    quint8 type;
+    m_stream >> type;
+    if ( type == NoGeometry || m_stream.status() != QDataStream::Ok ) {
+        return nullptr;
+    }
+
+    qint32 altitudeMode;
+    bool extrude;
+    m_stream >> altitudeMode >> extrude;
+
+    GeoDataGeometry *geometry = nullptr;
+    qint32 tessellationFlags;
+    switch ( type ) {
+    case PointGeometry: {
+        GeoDataLineString coordinates;
+        readCoordinates( coordinates );
+        GeoDataPoint *point = new GeoDataPoint;
+        if ( !coordinates.isEmpty() ) {
+            point->setCoordinates( coordinates.first() );
+        }
+        geometry = point;
+        break;
+    }
+    case LineStringGeometry: {
+        m_stream >> tessellationFlags;
+        GeoDataLineString *lineString = new GeoDataLineString( TessellationFlags( tessellationFlags ) );
+        readCoordinates( *lineString );
+        geometry = lineString;
+        break;
+    }
+    case LinearRingGeometry: {
+        m_stream >> tessellationFlags;
+        GeoDataLinearRing *ring = new GeoDataLinearRing( TessellationFlags( tessellationFlags ) );
+        readCoordinates( *ring );
+        geometry = ring;
+        break;
+    }
+    case PolygonGeometry: {
+        m_stream >> tessellationFlags;
+        GeoDataPolygon *polygon = new GeoDataPolygon( TessellationFlags( tessellationFlags ) );
+        readCoordinates( polygon->outerBoundary() );
+        quint32 innerBoundaries;
+        m_stream >> innerBoundaries;
+        for ( quint32 i = 0; i < innerBoundaries && m_stream.status() == QDataStream::Ok; ++i ) {
+            GeoDataLinearRing innerBoundary;
+            readCoordinates( innerBoundary );
+            polygon->appendInnerBoundary( innerBoundary );
+        }
+        geometry = polygon;
+        break;
+    }
+    case MultiGeometryGeometry: {
+        GeoDataMultiGeometry *multiGeometry = new GeoDataMultiGeometry;
+        quint32 count;
+        m_stream >> count;
+        for ( quint32 i = 0; i < count && m_stream.status() == QDataStream::Ok; ++i ) {
+            if ( GeoDataGeometry *child = readGeometry() ) {
+                multiGeometry->append( child );
+            }
+        }
+        geometry = multiGeometry;
+        break;
+    }
+    default:
+        m_stream.setStatus( QDataStream::ReadCorruptData );
+        return nullptr;
+    }
+
+    geometry->setAltitudeMode( AltitudeMode( altitudeMode ) );
+    geometry->setExtrude( extrude );
+    return geometry;
+}
+
+bool SnapshotReader::readCoordinates( GeoDataLineString &lineString )
+{
+    quint32 count;
+    m_stream >> count;
+    qint64 const bytes = qint64( count ) * 3 * sizeof( double );
+    if ( m_stream.status() != QDataStream::Ok || bytes > m_device->bytesAvailable() ) {
+        m_stream.setStatus( QDataStream::ReadCorruptData );
+        return false;
+    }
+
+    QVector<double> values( 3 * count );
+    m_stream.readRawData( reinterpret_cast<char*>( values.data() ), bytes );
+    lineString.reserve( count );
+    for ( quint32 i = 0; i < count; ++i ) {
+        lineString.append( GeoDataCoordinates( values[3*i], values[3*i+1], values[3*i+2] ) );
+    }
+
+    return true;
+}
+
+}
+
+QString DocumentSnapshot::snapshotPath( const QString &sourceFileName )
+{
+    const QByteArray key = QFileInfo( sourceFileName ).absoluteFilePath().toUtf8();
+    const QString hash = QString::fromLatin1( QCryptographicHash::hash( key, QCryptographicHash::Sha1 ).toHex() );
+    return MarbleDirs::localPath() + QLatin1String( "/cache/snapshots/" ) + hash + QLatin1String( ".snapshot" );
+}
+
+bool DocumentSnapshot::isCacheable( const QString &sourceFileName )
+{
+    const QFileInfo fileInfo( sourceFileName );
+    const QString suffix = fileInfo.suffix().toLower();
+    if ( !fileInfo.isFile() || fileInfo.size() < MinimumSourceSize
+         || suffix == QLatin1String( "snapshot" ) || suffix == QLatin1String( "cache" ) ) {
+        return false;
+    }
+
+    SnapshotHeader header;
+    return !readCurrentHeader( snapshotPath( sourceFileName ), sourceFileName, header ) || !header.unsupported;
+}
+
+bool DocumentSnapshot::bounds( const QString &sourceFileName, GeoDataLatLonBox &bounds )
+{
+    SnapshotHeader header;
+    if ( !readCurrentHeader( snapshotPath( sourceFileName ), sourceFileName, header )
+         || ( header.north == 0.0 && header.south == 0.0 && header.east == 0.0 && header.west == 0.0 ) ) {
+        return false;
+    }
+
+    bounds = GeoDataLatLonBox( header.north, header.south, header.east, header.west );
+    return true;
+}
+
+bool DocumentSnapshot::isUpToDate( const QString &sourceFileName )
+{
+    SnapshotHeader header;
+    return readCurrentHeader( snapshotPath( sourceFileName ), sourceFileName, header ) && !header.unsupported;
+}
+
+GeoDataDocument *DocumentSnapshot::load( const QString &sourceFileName, DocumentRole role )
+{
+    QFile file( snapshotPath( sourceFileName ) );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return nullptr;
+    }
+
+    // Read from the memory mapped file if possible, avoiding a copy of the whole snapshot
+    QByteArray data;
+    uchar *const mapped = file.map( 0, file.size() );
+    if ( mapped ) {
+        data = QByteArray::fromRawData( reinterpret_cast<const char*>( mapped ), file.size() );
+    } else {
+        data = file.readAll();
+    }
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::ReadOnly );
+
+    SnapshotReader reader( &buffer );
+    SnapshotHeader header;
+    if ( !reader.readHeader( header ) || !( header == SnapshotHeader::forSource( QFileInfo( sourceFileName ) ) )
+         || header.unsupported ) {
+        return nullptr;
+    }
+
+    GeoDataDocument *document = nullptr;
+    {
+        // The document is deleted as a whole later on, so its features and
+        // geometries can share an arena. Temporaries of the reader live on the stack.
+        GeoDataArena::Scope arenaScope;
+        document = reader.readDocument();
+    }
+    if ( !document ) {
+        mDebug() << "Discarding corrupt snapshot of" << sourceFileName;
+        file.remove();
+        return nullptr;
+    }
+
+    document->setFileName( sourceFileName );
+    document->setDocumentRole( role );
+    return document;
+}
+
+bool DocumentSnapshot::save( const QString &sourceFileName, const GeoDataDocument *document )
+{
+    // Several parsing tasks may finish the same file at the same time
+    static QMutex savingMutex;
+    static QSet<QString> savingFiles;
+
+    const QString fileName = snapshotPath( sourceFileName );
+    {
+        QMutexLocker locker( &savingMutex );
+        if ( savingFiles.contains( fileName ) ) {
+            return true;
+        }
+        SnapshotHeader header;
+        if ( readCurrentHeader( fileName, sourceFileName, header ) ) {
+            return !header.unsupported;
+        }
+        savingFiles.insert( fileName );
+    }
+
+    SnapshotHeader header = SnapshotHeader::forSource( QFileInfo( sourceFileName ) );
+    const GeoDataLatLonAltBox box = document ? document->latLonAltBox() : GeoDataLatLonAltBox();
+    if ( !box.isEmpty() ) {
+        header.north = box.north();
+        header.south = box.south();
+        header.east = box.east();
+        header.west = box.west();
+    }
+    SnapshotWriter writer;
+    const bool supported = document && writer.writeDocument( document );
+    if ( !supported ) {
+        // Remember it, so that the document is neither serialized nor loaded again
+        mDebug() << "Document" << sourceFileName << "contains data not supported by snapshots";
+        header.unsupported = 1;
+    }
+
+    bool result = false;
+    QDir().mkpath( QFileInfo( fileName ).path() );
+    QSaveFile file( fileName );
+    if ( file.open( QIODevice::WriteOnly ) ) {
+        if ( supported ) {
+            writer.write( &file, header );
+        } else {
+            QDataStream stream( &file );
+            setupStream( stream );
+            stream << header;
+        }
+        result = file.commit() && supported;
+    } else {
+        mDebug() << "Cannot write snapshot" << fileName;
+    }
+
+    QMutexLocker locker( &savingMutex );
+    savingFiles.remove( fileName );
+    return result;
+}
+
+}
@@ -0,0 +1,93 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_DOCUMENTSNAPSHOT_H
+#define MARBLE_DOCUMENTSNAPSHOT_H
+
+#include "marble_export.h"
+#include "GeoDataDocument.h"
+
+#include <QString>
+
+namespace Marble
+{
+
+class GeoDataLatLonBox;
+
+/**
+ * @brief Binary snapshots of parsed documents for fast reloading
+ *
+ * After a KML, GPX, OSM or other file has been parsed, a snapshot of the
+ * resulting document can be stored in the local cache directory. The next time
+ * the same file is opened, the document is restored from the memory mapped
+ * snapshot instead of being parsed again. A snapshot is only used as long as
+ * size and modification time of the source file match the ones recorded in it.
+ * The bounds of the document are recorded as well, see bounds().
+ *
+ * Strings are stored once in a string table and shared between all features
+ * referencing them, coordinates are stored as packed arrays of doubles.
+ *
+ * Only documents consisting of folders and placemarks with point, line string,
+ * linear ring, polygon and multi geometries are supported. The OSM data and the
+ * visual category of placemarks are kept. save() refuses to
+ * write a snapshot for anything else, so that no information gets lost, and
+ * leaves a marker without content instead. Such a source is not considered
+ * cacheable until it is modified, so it is neither serialized nor looked up again.
+ *
+ * Loading decodes the whole document from the memory mapped snapshot at once.
+ */
+class MARBLE_EXPORT DocumentSnapshot
+{
+public:
+    /**
+     * Path of the snapshot file for the given source file in the local cache
+     */
+    static QString snapshotPath( const QString &sourceFileName );
+
+    /**
+     * Returns true if there is a snapshot with content for the given source
+     * file and the source file was not modified since the snapshot was taken.
+     */
+    static bool isUpToDate( const QString &sourceFileName );
+
+    /**
+     * Reads the bounds of the document of the given source file from the
+     * header of its snapshot, without restoring the document.
+     * @return false if there is no up to date snapshot or the document has no bounds
+     */
+    static bool bounds( const QString &sourceFileName, GeoDataLatLonBox &bounds );
+
+    /**
+     * Restores the document of the given source file from its snapshot.
+     * @return the document, or a null pointer if there is no up to date snapshot
+     */
+    static GeoDataDocument *load( const QString &sourceFileName, DocumentRole role = UnknownDocument );
+
+    /**
+     * Stores a snapshot of a document parsed from the given source file. The
+     * snapshot is written to a temporary file first and then moved into place.
+     * Nothing is written if there is an up to date snapshot already or another
+     * thread is writing one. For documents containing unsupported data only
+     * the marker is written.
+     * @return false if the document contains unsupported data or the snapshot
+     * could not be written
+     */
+    static bool save( const QString &sourceFileName, const GeoDataDocument *document );
+
+    /**
+     * Returns true if it is worth taking a snapshot for the given source file.
+     * Small files parse fast enough and are not cached, neither are snapshots,
+     * files of the legacy placemark cache format or files whose document was
+     * found to contain data not supported by snapshots.
+     */
+    static bool isCacheable( const QString &sourceFileName );
+};
+
+}
+
+#endif
@@ -9,12 +9,14 @@
 //
 
 #include "ElevationModel.h"
+#include "GeoDataCoordinates.h"
 #include "GeoSceneHead.h"
 #include "GeoSceneLayer.h"
 #include "GeoSceneMap.h"
 #include "GeoSceneDocument.h"
 #include "GeoSceneTextureTileDataset.h"
 #include "HttpDownloadManager.h"
+#include "MarbleGlobal.h"
 #include "Tile.h"
 #include "TileLoader.h"
 #include "TileLoaderHelper.h"
@@ -24,12 +26,38 @@
 #include "PluginManager.h"
 
 #include <QCache>
+#include <QHash>
 #include <QImage>
+#include <QPair>
+#include <QtConcurrentMap>
 #include <qmath.h>
 
+#include <limits>
+
 namespace Marble
 {
 
+namespace {
+    // invalidElevationData as stored in the signed 16 bits of a height
+    const qint16 noElevationData = std::numeric_limits<qint16>::min();
+
+    // Interpolating a few thousand heights is not worth spreading over threads
+    const int batchSize = 4096;
+
+    // Tiles held by heights() at once, about 0.9 MB each
+    const int maximumBatchTiles = 32;
+
+    /**
+     * An elevation tile decoded into its heights in meters, row by row.
+     */
+    struct ElevationTile
+    {
+        int width = 0;
+        int height = 0;
+        QVector<qint16> heights;
+    };
+}
+
 class ElevationModelPrivate
 {
 public:
@@ -37,9 +65,14 @@ public:
         : q( _q ),
           m_tileLoader( downloadManager, pluginManager ),
           m_textureLayer( nullptr ),
-          m_srtmTheme(nullptr)
+          m_srtmTheme(nullptr),
+          m_tileZoomLevel( 0 ),
+          m_tileWidth( 0 ),
+          m_tileHeight( 0 ),
+          m_numTilesX( 0 ),
+          m_numTilesY( 0 )
     {
-        m_cache.setMaxCost( 10 ); //keep 10 tiles in memory (~17MB)
+        m_cache.setMaxCost( 20 ); //keep 20 tiles in memory (~17MB)
 
         m_srtmTheme = MapThemeManager::loadMapTheme( "earth/srtm2/srtm2.dgml" );
         if ( !m_srtmTheme ) {
@@ -62,6 +95,17 @@ public:
 
         m_textureLayer = dynamic_cast<GeoSceneTextureTileDataset*>( sceneLayer->datasets().first() );
         Q_ASSERT( m_textureLayer );
+
+        m_tileZoomLevel = TileLoader::maximumTileLevel( *m_textureLayer );
+        Q_ASSERT( m_tileZoomLevel == 9 );
+
+        m_tileWidth = m_textureLayer->tileSize().width();
+        m_tileHeight = m_textureLayer->tileSize().height();
+
+        m_numTilesX = TileLoaderHelper::levelToColumn( m_textureLayer->levelZeroColumns(), m_tileZoomLevel );
+        m_numTilesY = TileLoaderHelper::levelToRow( m_textureLayer->levelZeroRows(), m_tileZoomLevel );
+        Q_ASSERT( m_numTilesX > 0 );
+        Q_ASSERT( m_numTilesY > 0 );
     }
 
     ~ElevationModelPrivate()
@@ -71,55 +115,96 @@ public:
 
     void tileCompleted( const TileId & tileId, const QImage &image )
     {
-        m_cache.insert( tileId, new QImage( image ) );
+        m_cache.insert( tileId, new ElevationTile( decodeTile( image ) ) );
         emit q->updateAvailable();
     }
 
+    static ElevationTile decodeTile( const QImage &image );
+    const ElevationTile *tile( const TileId &id );
+
+    void textureCoordinates( qreal lon, qreal lat, qreal &textureX, qreal &textureY ) const;
+    TileId tileId( int x, int y ) const;
+
+    template<class TileLookup>
+    qreal interpolate( qreal lon, qreal lat, const TileLookup &lookup ) const;
+
 public:
     ElevationModel *q;
 
     TileLoader m_tileLoader;
     const GeoSceneTextureTileDataset *m_textureLayer;
-    QCache<TileId, const QImage> m_cache;
+    QCache<TileId, const ElevationTile> m_cache;
     GeoSceneDocument *m_srtmTheme;
+
+    int m_tileZoomLevel;
+    int m_tileWidth;
+    int m_tileHeight;
+    int m_numTilesX;
+    int m_numTilesY;
 };
 
-ElevationModel::ElevationModel( HttpDownloadManager *downloadManager, PluginManager* pluginManager, QObject *parent ) :
-    QObject( parent ),
-    d( new ElevationModelPrivate( this, downloadManager, pluginManager ) )
+ElevationTile ElevationModelPrivate::decodeTile( const QImage &image )
 {
-    connect( &d->m_tileLoader, SIGNAL(tileCompleted(TileId,QImage)),
-             this, SLOT(tileCompleted(TileId,QImage)) );
-}
+    ElevationTile tile;
+    if ( image.isNull() ) {
+        return tile;
+    }
 
-ElevationModel::~ElevationModel()
-{
-    delete d;
-}
+    // The height is kept in the lower 16 bits of each pixel, as a signed value
+    const QImage argbImage = image.format() == QImage::Format_ARGB32 || image.format() == QImage::Format_RGB32
+                           ? image
+                           : image.convertToFormat( QImage::Format_ARGB32 );
 
+    tile.width = argbImage.width();
+    tile.height = argbImage.height();
+    tile.heights.resize( tile.width * tile.height );
 
-qreal ElevationModel::height( qreal lon, qreal lat ) const
+    qint16 *heights = tile.heights.data();
+    for ( int y = 0; y < tile.height; ++y ) {
+        const QRgb *line = reinterpret_cast<const QRgb *>( argbImage.constScanLine( y ) );
+        for ( int x = 0; x < tile.width; ++x ) {
+            *heights++ = static_cast<qint16>( line[x] & 0xffff );
+        }
+    }
+
+    return tile;
+}
+
+const ElevationTile *ElevationModelPrivate::tile( const TileId &id )
 {
-    if ( !d->m_textureLayer ) {
-        return invalidElevationData;
+    const ElevationTile *cached = m_cache[id];
+    if ( cached ) {
+        return cached;
     }
 
-    const int tileZoomLevel = TileLoader::maximumTileLevel( *( d->m_textureLayer ) );
-    Q_ASSERT( tileZoomLevel == 9 );
+    // Only valid until the next tile is inserted, which may evict this one
+    const ElevationTile *result = new ElevationTile( decodeTile( m_tileLoader.loadTileImage( m_textureLayer, id, DownloadBrowse ) ) );
+    m_cache.insert( id, result );
+    return result;
+}
 
-    const int width = d->m_textureLayer->tileSize().width();
-    const int height = d->m_textureLayer->tileSize().height();
+void ElevationModelPrivate::textureCoordinates( qreal lon, qreal lat, qreal &textureX, qreal &textureY ) const
+{
+    textureX = 180 + lon;
+    textureX *= m_numTilesX * m_tileWidth / 360;
 
-    const int numTilesX = TileLoaderHelper::levelToColumn( d->m_textureLayer->levelZeroColumns(), tileZoomLevel );
-    const int numTilesY = TileLoaderHelper::levelToRow( d->m_textureLayer->levelZeroRows(), tileZoomLevel );
-    Q_ASSERT( numTilesX > 0 );
-    Q_ASSERT( numTilesY > 0 );
+    textureY = 90 - lat;
+    textureY *= m_numTilesY * m_tileHeight / 180;
+}
 
-    qreal textureX = 180 + lon;
-    textureX *= numTilesX * width / 360;
+TileId ElevationModelPrivate::tileId( int x, int y ) const
+{
+    return TileId( 0, m_tileZoomLevel,
+                   ( x % ( m_numTilesX * m_tileWidth ) ) / m_tileWidth,
+                   ( y % ( m_numTilesY * m_tileHeight ) ) / m_tileHeight );
+}
 
-    qreal textureY = 90 - lat;
-    textureY *= numTilesY * height / 180;
+template<class TileLookup>
+qreal ElevationModelPrivate::interpolate( qreal lon, qreal lat, const TileLookup &lookup ) const
+{
+    qreal textureX;
+    qreal textureY;
+    textureCoordinates( lon, lat, textureX, textureY );
 
     qreal ret = 0;
     bool hasHeight = false;
@@ -129,36 +214,26 @@ qreal ElevationModel::height( qreal lon, qreal lat ) const
         const int x = static_cast<int>( textureX + ( i % 2 ) );
         const int y = static_cast<int>( textureY + ( i / 2 ) );
 
-        //mDebug() << "x" << x << ( x / width );
-        //mDebug() << "y" << y << ( y / height );
-
-        const TileId id( 0, tileZoomLevel, ( x % ( numTilesX * width ) ) / width, ( y % ( numTilesY * height ) ) / height );
-        //mDebug() << "LAT" << lat << "LON" << lon << "tile" << ( x % ( numTilesX * width ) ) / width << ( y % ( numTilesY * height ) ) / height;
-
-        const QImage *image = d->m_cache[id];
-        if ( image == nullptr ) {
-            image = new QImage( d->m_tileLoader.loadTileImage( d->m_textureLayer, id, DownloadBrowse ) );
-            d->m_cache.insert( id, image );
-        }
-        Q_ASSERT( image );
-        Q_ASSERT( !image->isNull() );
-        Q_ASSERT( width == image->width() );
-        Q_ASSERT( height == image->height() );
+        // A pointer, copying the tile would touch the shared reference count of its heights
+        const ElevationTile *tile = lookup( tileId( x, y ) );
 
         const qreal dx = ( textureX > ( qreal )x ) ? textureX - ( qreal )x : ( qreal )x - textureX;
         const qreal dy = ( textureY > ( qreal )y ) ? textureY - ( qreal )y : ( qreal )y - textureY;
 
         Q_ASSERT( 0 <= dx && dx <= 1 );
         Q_ASSERT( 0 <= dy && dy <= 1 );
-        unsigned int pixel = image->pixel( x % width, y % height ) & 0xffff; // 16 valid bits
-        short int elevation = (short int) pixel; // and signed type, so just cast it
-        //mDebug() << "(1-dx)" << (1-dx) << "(1-dy)" << (1-dy);
-        if ( pixel != invalidElevationData ) { //no data?
-            //mDebug() << "got at x" << x % width << "y" << y % height << "a height of" << pixel << "** RGB" << qRed(pixel) << qGreen(pixel) << qBlue(pixel);
+
+        qint16 elevation = noElevationData;
+        if ( tile && !tile->heights.isEmpty() ) {
+            Q_ASSERT( m_tileWidth == tile->width );
+            Q_ASSERT( m_tileHeight == tile->height );
+            elevation = tile->heights.at( ( y % m_tileHeight ) * tile->width + x % m_tileWidth );
+        }
+
+        if ( elevation != noElevationData ) {
             ret += ( qreal )elevation * ( 1 - dx ) * ( 1 - dy );
             hasHeight = true;
         } else {
-            //mDebug() << "no data at" <<  x % width << "y" << y % height;
             noData += ( 1 - dx ) * ( 1 - dy );
         }
     }
@@ -167,26 +242,124 @@ qreal ElevationModel::height( qreal lon, qreal lat ) const
         ret = invalidElevationData; //no data
     } else {
         if ( noData ) {
-            //mDebug() << "NO DATA" << noData;
             ret += ( ret / ( 1 - noData ) ) * noData;
         }
     }
 
-    //mDebug() << ">>>" << lat << lon << "returning an elevation of" << ret;
     return ret;
 }
 
+ElevationModel::ElevationModel( HttpDownloadManager *downloadManager, PluginManager* pluginManager, QObject *parent ) :
+    QObject( parent ),
+    d( new ElevationModelPrivate( this, downloadManager, pluginManager ) )
+{
+    connect( &d->m_tileLoader, SIGNAL(tileCompleted(TileId,QImage)),
+             this, SLOT(tileCompleted(TileId,QImage)) );
+}
+
+ElevationModel::~ElevationModel()
+{
+    delete d;
+}
+
+
+qreal ElevationModel::height( qreal lon, qreal lat ) const
+{
+    if ( !d->m_textureLayer ) {
+        return invalidElevationData;
+    }
+
+    return d->interpolate( lon, lat, [this]( const TileId &id ) {
+        return d->tile( id );
+    } );
+}
+
+QVector<qreal> ElevationModel::heights( const QVector<GeoDataCoordinates> &coordinates ) const
+{
+    QVector<qreal> result( coordinates.size(), invalidElevationData );
+    if ( !d->m_textureLayer ) {
+        return result;
+    }
+
+    qreal *const heights = result.data();
+    QHash<TileId, ElevationTile> tiles;
+    auto const lookup = [&tiles]( const TileId &id ) -> const ElevationTile * {
+        auto const iter = tiles.constFind( id );
+        return iter != tiles.constEnd() ? &iter.value() : nullptr;
+    };
+
+    // Interpolates the points from begin to end with the tiles loaded so far
+    auto const interpolatePoints = [&]( int begin, int end ) {
+        auto const interpolateRange = [&]( const QPair<int, int> &range ) {
+            for ( int i = range.first; i < range.second; ++i ) {
+                const GeoDataCoordinates &point = coordinates.at( i );
+                heights[i] = d->interpolate( point.longitude( GeoDataCoordinates::Degree ),
+                                             point.latitude( GeoDataCoordinates::Degree ),
+                                             lookup );
+            }
+        };
+
+        if ( end - begin <= batchSize ) {
+            interpolateRange( qMakePair( begin, end ) );
+            return;
+        }
+
+        QVector<QPair<int, int> > ranges;
+        ranges.reserve( ( end - begin ) / batchSize + 1 );
+        for ( int rangeBegin = begin; rangeBegin < end; rangeBegin += batchSize ) {
+            ranges << qMakePair( rangeBegin, qMin( rangeBegin + batchSize, end ) );
+        }
+        QtConcurrent::blockingMap( ranges, interpolateRange );
+    };
+
+    // Load the tiles needed in this thread, as the tile loader and the cache
+    // are not thread safe. Once the tiles held would exceed the limit, the
+    // points so far are interpolated and their tiles are dropped.
+    int begin = 0;
+    for ( int i = 0; i < coordinates.size(); ++i ) {
+        const GeoDataCoordinates &point = coordinates.at( i );
+        qreal textureX;
+        qreal textureY;
+        d->textureCoordinates( point.longitude( GeoDataCoordinates::Degree ),
+                               point.latitude( GeoDataCoordinates::Degree ),
+                               textureX, textureY );
+
+        TileId ids[4];
+        int missing = 0;
+        for ( int j = 0; j < 4; ++j ) {
+            ids[j] = d->tileId( static_cast<int>( textureX + ( j % 2 ) ),
+                                static_cast<int>( textureY + ( j / 2 ) ) );
+            if ( !tiles.contains( ids[j] ) ) {
+                ++missing;
+            }
+        }
+        if ( missing == 0 ) {
+            continue;
+        }
+
+        if ( tiles.size() + missing > maximumBatchTiles ) {
+            interpolatePoints( begin, i );
+            tiles.clear();
+            begin = i;
+        }
+        for ( const TileId &id: ids ) {
+            if ( !tiles.contains( id ) ) {
+                tiles.insert( id, *d->tile( id ) );
+            }
+        }
+    }
+    interpolatePoints( begin, coordinates.size() );
+
+    return result;
+}
+
 QVector<GeoDataCoordinates> ElevationModel::heightProfile( qreal fromLon, qreal fromLat, qreal toLon, qreal toLat ) const
 {
     if ( !d->m_textureLayer ) {
         return QVector<GeoDataCoordinates>();
     }
 
-    const int tileZoomLevel = TileLoader::maximumTileLevel( *( d->m_textureLayer ) );
-    const int width = d->m_textureLayer->tileSize().width();
-    const int numTilesX = TileLoaderHelper::levelToColumn( d->m_textureLayer->levelZeroColumns(), tileZoomLevel );
-
-    qreal distPerPixel = ( qreal )360 / ( width * numTilesX );
+    qreal distPerPixel = ( qreal )360 / ( d->m_tileWidth * d->m_numTilesX );
     //mDebug() << "heightProfile" << fromLat << fromLon << toLat << toLon << "distPerPixel" << distPerPixel;
 
     qreal lat = fromLat;
@@ -197,13 +370,10 @@ QVector<GeoDataCoordinates> ElevationModel::heightProfile( qreal fromLon, qreal
     //mDebug() << "fromLon" << fromLon << "fromLat" << fromLat;
     //mDebug() << "diff lon" << ( fromLon - toLon ) << "diff lat" << ( fromLat - toLat );
     //mDebug() << "dirLon" << QString::number(dirLon) << "dirLat" << QString::number(dirLat) << "k" << k;
-    QVector<GeoDataCoordinates> ret;
+    QVector<GeoDataCoordinates> points;
     while ( lat*dirLat <= toLat*dirLat && lon*dirLon <= toLon * dirLon ) {
         //mDebug() << lat << lon;
-        qreal h = height( lon, lat );
-        if ( h < 32000 ) {
-            ret << GeoDataCoordinates( lon, lat, h, GeoDataCoordinates::Degree );
-        }
+        points << GeoDataCoordinates( lon, lat, 0, GeoDataCoordinates::Degree );
         if ( k < 0.5 ) {
             //mDebug() << "lon(x) += distPerPixel";
             lat += distPerPixel * k * dirLat;
@@ -214,6 +384,17 @@ QVector<GeoDataCoordinates> ElevationModel::heightProfile( qreal fromLon, qreal
             lon += distPerPixel / k * dirLon;
         }
     }
+
+    const QVector<qreal> pointHeights = heights( points );
+    QVector<GeoDataCoordinates> ret;
+    ret.reserve( points.size() );
+    for ( int i = 0; i < points.size(); ++i ) {
+        if ( pointHeights[i] < 32000 ) {
+            GeoDataCoordinates point = points[i];
+            point.setAltitude( pointHeights[i] );
+            ret << point;
+        }
+    }
     //mDebug() << ret;
     return ret;
 }
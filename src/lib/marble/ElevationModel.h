@@ -15,6 +15,7 @@
 #include "marble_export.h"
 
 #include <QObject>
+#include <QVector>
 
 class QImage;
 
@@ -39,6 +40,15 @@ public:
     ~ElevationModel() override;
 
     qreal height( qreal lon, qreal lat ) const;
+
+    /**
+     * Returns the heights at all @p coordinates in one go, invalidElevationData
+     * where there is no data. Neighboring coordinates share their elevation
+     * tiles, which are only looked up once, and the interpolation runs in
+     * parallel for large batches, so prefer this over calling height() in a loop.
+     **/
+    QVector<qreal> heights( const QVector<GeoDataCoordinates> &coordinates ) const;
+
     QVector<GeoDataCoordinates> heightProfile( qreal fromLon, qreal fromLat, qreal toLon, qreal toLat ) const;
 
 Q_SIGNALS:
@@ -91,7 +91,7 @@ void EquirectScanlineTextureMapper::mapTexture( GeoPainter *painter,
         mapTexture( viewport, tileZoomLevel, painter->mapQuality() );
 
         if ( texColorizer ) {
-            texColorizer->colorize( &m_canvasImage, viewport, painter->mapQuality() );
+            texColorizer->colorize( &m_canvasImage, viewport, painter->mapQuality(), &m_threadPool );
         }
 
         m_repaintNeeded = false;
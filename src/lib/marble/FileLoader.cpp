@@ -53,7 +53,8 @@ public:
         m_document(nullptr),
         m_renderOrder(renderOrder),
         m_documentRole(role),
-        m_recenter(recenter)
+        m_recenter(recenter),
+        m_reported(false)
     {
         if( m_style ) {
             m_styleMap->setId(QStringLiteral("default-map"));
@@ -70,7 +71,8 @@ public:
         m_styleMap(nullptr),
         m_document(nullptr),
         m_documentRole(role),
-        m_recenter(false)
+        m_recenter(false),
+        m_reported(false)
     {
     }
 
@@ -85,6 +87,7 @@ public:
     static int areaPopIdx( qreal area );
 
     void documentParsed( GeoDataDocument *doc, const QString& error);
+    void parsingFinished();
 
     FileLoader *q;
     ParsingRunnerManager m_runner;
@@ -98,6 +101,7 @@ public:
     int m_renderOrder;
     DocumentRole m_documentRole;
     bool m_recenter;
+    bool m_reported;
 };
 
 FileLoader::FileLoader( QObject* parent, const PluginManager *pluginManager, bool recenter, const QString& file,
@@ -134,49 +138,66 @@ QString FileLoader::error() const
     return d->m_error;
 }
 
-void FileLoader::run()
+void FileLoader::setThreadPool( QThreadPool *threadPool )
 {
-    if ( d->m_contents.isEmpty() ) {
-        QString defaultSourceName;
-
-        mDebug() << "starting parser for" << d->m_filepath;
+    d->m_runner.setThreadPool( threadPool );
+}
 
-        QFileInfo fileinfo( d->m_filepath );
-        QString path = fileinfo.path();
-        if (path == QLatin1String(".")) path.clear();
-        QString name = fileinfo.completeBaseName();
-        QString suffix = fileinfo.suffix();
+QString FileLoader::sourceFileName() const
+{
+    if ( !d->m_contents.isEmpty() ) {
+        return QString();
+    }
 
-        // determine source, cache names
-        if ( fileinfo.isAbsolute() ) {
-            // We got an _absolute_ path now: e.g. "/patrick.kml"
-            defaultSourceName = path + QLatin1Char('/') + name + QLatin1Char('.') + suffix;
-        }
-        else if ( d->m_filepath.contains( '/' ) ) {
-            // _relative_ path: "maps/mars/viking/patrick.kml"
-            defaultSourceName = MarbleDirs::path(path + QLatin1Char('/') + name + QLatin1Char('.') + suffix);
-            if ( !QFile::exists( defaultSourceName ) ) {
-                defaultSourceName = MarbleDirs::path(path + QLatin1Char('/') + name + QLatin1String(".cache"));
-            }
+    QFileInfo fileinfo( d->m_filepath );
+    QString path = fileinfo.path();
+    if (path == QLatin1String(".")) path.clear();
+    QString name = fileinfo.completeBaseName();
+    QString suffix = fileinfo.suffix();
+
+    // determine source, cache names
+    QString defaultSourceName;
+    if ( fileinfo.isAbsolute() ) {
+        // We got an _absolute_ path now: e.g. "/patrick.kml"
+        defaultSourceName = path + QLatin1Char('/') + name + QLatin1Char('.') + suffix;
+    }
+    else if ( d->m_filepath.contains( '/' ) ) {
+        // _relative_ path: "maps/mars/viking/patrick.kml"
+        defaultSourceName = MarbleDirs::path(path + QLatin1Char('/') + name + QLatin1Char('.') + suffix);
+        if ( !QFile::exists( defaultSourceName ) ) {
+            defaultSourceName = MarbleDirs::path(path + QLatin1Char('/') + name + QLatin1String(".cache"));
         }
-        else {
-            // _standard_ shared placemarks: "placemarks/patrick.kml"
-            defaultSourceName = MarbleDirs::path(QLatin1String("placemarks/") + path + name + QLatin1Char('.') + suffix);
-            if ( !QFile::exists( defaultSourceName ) ) {
-                defaultSourceName = MarbleDirs::path(QLatin1String("placemarks/") + path + name + QLatin1String(".cache"));
-            }
+    }
+    else {
+        // _standard_ shared placemarks: "placemarks/patrick.kml"
+        defaultSourceName = MarbleDirs::path(QLatin1String("placemarks/") + path + name + QLatin1Char('.') + suffix);
+        if ( !QFile::exists( defaultSourceName ) ) {
+            defaultSourceName = MarbleDirs::path(QLatin1String("placemarks/") + path + name + QLatin1String(".cache"));
         }
+    }
+    return defaultSourceName;
+}
+
+void FileLoader::run()
+{
+    if ( d->m_contents.isEmpty() ) {
+        mDebug() << "starting parser for" << d->m_filepath;
 
+        const QString defaultSourceName = sourceFileName();
         if ( QFile::exists( defaultSourceName ) ) {
             mDebug() << "No recent Default Placemark Cache File available!";
 
             // use runners: pnt, gpx, osm
             connect( &d->m_runner, SIGNAL(parsingFinished(GeoDataDocument*,QString)),
                     this, SLOT(documentParsed(GeoDataDocument*,QString)) );
+            connect( &d->m_runner, SIGNAL(parsingFinished()),
+                    this, SLOT(parsingFinished()) );
             d->m_runner.parseFile( defaultSourceName, d->m_documentRole );
         }
         else {
-            mDebug() << "No Default Placemark Source File for " << name;
+            mDebug() << "No Default Placemark Source File for " << d->m_filepath;
+            d->m_reported = true;
+            emit loaderFinished( this );
         }
     // content is not empty, we load from data
     } else {
@@ -217,6 +238,7 @@ bool FileLoader::recenter() const
 
 void FileLoaderPrivate::documentParsed( GeoDataDocument* doc, const QString& error )
 {
+    m_reported = true;
     m_error = error;
     if ( doc ) {
         m_document = doc;
@@ -240,6 +262,16 @@ void FileLoaderPrivate::documentParsed( GeoDataDocument* doc, const QString& err
     emit q->loaderFinished( q );
 }
 
+void FileLoaderPrivate::parsingFinished()
+{
+    // None of the runners delivered a document or an error. Report it anyway,
+    // otherwise the file manager would wait for this loader forever.
+    if ( !m_reported ) {
+        m_reported = true;
+        emit q->loaderFinished( q );
+    }
+}
+
 void FileLoaderPrivate::createFilterProperties( GeoDataContainer *container )
 {
     const QString styleUrl = QLatin1Char('#') + m_styleMap->id();
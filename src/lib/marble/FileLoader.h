@@ -15,6 +15,7 @@
 #include <QThread>
 
 class QString;
+class QThreadPool;
 
 namespace Marble
 {
@@ -35,15 +36,27 @@ class FileLoader : public QThread
         void run() override;
         bool recenter() const;
         QString path() const;
+
+        /**
+         * The file the document is parsed from, resolved against the Marble
+         * data directories. Empty if the document is created from data.
+         */
+        QString sourceFileName() const;
         GeoDataDocument *document();
         QString error() const;
 
+        /**
+         * Parse the file in the given thread pool, see ParsingRunnerManager::setThreadPool()
+         */
+        void setThreadPool( QThreadPool *threadPool );
+
     Q_SIGNALS:
         void loaderFinished( FileLoader* );
         void newGeoDataDocumentAdded( GeoDataDocument* );
 
 private:
         Q_PRIVATE_SLOT ( d, void documentParsed( GeoDataDocument *, QString) )
+        Q_PRIVATE_SLOT ( d, void parsingFinished() )
 
         friend class FileLoaderPrivate;
 
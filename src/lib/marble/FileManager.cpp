@@ -13,7 +13,10 @@
 
 #include <QFileInfo>
 #include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
 
+#include "DocumentSnapshot.h"
 #include "FileLoader.h"
 #include "MarbleDebug.h"
 #include "MarbleModel.h"
@@ -30,23 +33,34 @@ namespace Marble
 class FileManagerPrivate
 {
 public:
+    struct LoaderTiming
+    {
+        QElapsedTimer timer;
+        qint64 queueTime;
+    };
+
     FileManagerPrivate( GeoDataTreeModel *treeModel, const PluginManager *pluginManager, FileManager* parent ) :
         q( parent ),
         m_treeModel( treeModel ),
         m_pluginManager( pluginManager )
     {
+        m_threadPool.setMaxThreadCount( qMax( 2, QThread::idealThreadCount() ) );
     }
 
     ~FileManagerPrivate()
     {
+        qDeleteAll( m_queuedLoaders );
         for ( FileLoader *loader: m_loaderList ) {
             if ( loader ) {
                 loader->wait();
             }
         }
+        m_threadPool.waitForDone();
     }
 
     void appendLoader( FileLoader *loader );
+    void startLoaders();
+    int loadPriority( const FileLoader *loader ) const;
     void closeFile( const QString &key );
     void cleanupLoader( FileLoader *loader );
 
@@ -55,9 +69,14 @@ public:
     const PluginManager *const m_pluginManager;
 
     QList<FileLoader*> m_loaderList;
+    QList<FileLoader*> m_queuedLoaders;
+    QHash<const FileLoader*, LoaderTiming> m_loaderTimings;
     QHash < QString, GeoDataDocument* > m_fileItemHash;
+    QHash<QString, GeoDataLatLonBox> m_knownBounds;
+    GeoDataLatLonBox m_viewport;
     GeoDataLatLonBox m_latLonBox;
     QElapsedTimer m_timer;
+    QThreadPool m_threadPool;
 };
 }
 
@@ -84,10 +103,25 @@ void FileManager::addFile( const QString& filepath, const QString& property, con
             return;  // currently loading
     }
 
+    for ( const FileLoader *loader: d->m_queuedLoaders ) {
+        if ( loader->path() == filepath )
+            return;  // waiting to be loaded
+    }
+
     mDebug() << "adding container:" << filepath;
-    mDebug() << "Starting placemark loading timer";
-    d->m_timer.start();
+    if ( d->m_loaderList.isEmpty() && d->m_queuedLoaders.isEmpty() ) {
+        mDebug() << "Starting placemark loading timer";
+        d->m_timer.start();
+    }
     FileLoader* loader = new FileLoader( this, d->m_pluginManager, recenter, filepath, property, style, role, renderOrder );
+    if ( !d->m_knownBounds.contains( filepath ) ) {
+        // Snapshots record the bounds of their document, so that files can be
+        // prioritized before they are loaded for the first time
+        GeoDataLatLonBox bounds;
+        if ( DocumentSnapshot::bounds( loader->sourceFileName(), bounds ) ) {
+            d->m_knownBounds.insert( filepath, bounds );
+        }
+    }
     d->appendLoader( loader );
 }
 
@@ -102,18 +136,69 @@ void FileManagerPrivate::appendLoader( FileLoader *loader )
     QObject::connect( loader, SIGNAL(loaderFinished(FileLoader*)),
              q, SLOT(cleanupLoader(FileLoader*)) );
 
-    m_loaderList.append( loader );
-    loader->start();
+    loader->setThreadPool( &m_threadPool );
+    m_loaderTimings[loader].timer.start();
+    m_queuedLoaders.append( loader );
+    startLoaders();
+}
+
+int FileManagerPrivate::loadPriority( const FileLoader *loader ) const
+{
+    // Lower values are loaded first: files covering the viewport, then files
+    // of unknown location, then files known to be outside of the viewport.
+    // Bounds come from earlier loads of the same file or from its snapshot,
+    // files are not parsed just to find out where they are
+    const QHash<QString, GeoDataLatLonBox>::const_iterator bounds = m_knownBounds.constFind( loader->path() );
+    if ( bounds == m_knownBounds.constEnd() || m_viewport.isEmpty() ) {
+        return 1;
+    }
+
+    return bounds->intersects( m_viewport ) ? 0 : 2;
+}
+
+void FileManagerPrivate::startLoaders()
+{
+    // Every loader spreads its parsing tasks over the thread pool, keeping
+    // the number of running loaders bounded limits the memory held by
+    // documents parsed but not yet added to the tree model
+    while ( !m_queuedLoaders.isEmpty() && m_loaderList.size() < m_threadPool.maxThreadCount() ) {
+        int next = 0;
+        int nextPriority = loadPriority( m_queuedLoaders.first() );
+        for ( int i = 1; i < m_queuedLoaders.size() && nextPriority > 0; ++i ) {
+            const int priority = loadPriority( m_queuedLoaders.at( i ) );
+            if ( priority < nextPriority ) {
+                next = i;
+                nextPriority = priority;
+            }
+        }
+
+        FileLoader *loader = m_queuedLoaders.takeAt( next );
+        LoaderTiming &timing = m_loaderTimings[loader];
+        timing.queueTime = timing.timer.restart();
+        m_loaderList.append( loader );
+        loader->start();
+    }
 }
 
 void FileManager::removeFile( const QString& key )
 {
+    for ( FileLoader *loader: d->m_queuedLoaders ) {
+        if ( loader->path() == key ) {
+            d->m_queuedLoaders.removeAll( loader );
+            d->m_loaderTimings.remove( loader );
+            delete loader;
+            return;
+        }
+    }
+
     for ( FileLoader *loader: d->m_loaderList ) {
         if ( loader->path() == key ) {
             disconnect( loader, nullptr, this, nullptr );
             loader->wait();
             d->m_loaderList.removeAll( loader );
+            d->m_loaderTimings.remove( loader );
             delete loader->document();
+            d->startLoaders();
             return;
         }
     }
@@ -164,33 +249,56 @@ GeoDataDocument * FileManager::at( const QString &key )
 
 int FileManager::pendingFiles() const
 {
-    return d->m_loaderList.size();
+    return d->m_loaderList.size() + d->m_queuedLoaders.size();
+}
+
+int FileManager::maximumConcurrentFiles() const
+{
+    return d->m_threadPool.maxThreadCount();
+}
+
+void FileManager::setViewport( const GeoDataLatLonAltBox &viewport )
+{
+    d->m_viewport = viewport;
 }
 
 void FileManagerPrivate::cleanupLoader( FileLoader* loader )
 {
+    if ( !m_loaderList.removeAll( loader ) ) {
+        return; // already removed by removeFile()
+    }
+
+    // The loader thread only starts the parsing tasks and returns right away
+    loader->wait();
+
+    const LoaderTiming timing = m_loaderTimings.take( loader );
+    const qint64 loadTime = timing.timer.elapsed();
+    mDebug() << "Loaded" << loader->path() << "in" << loadTime << "ms after waiting" << timing.queueTime << "ms";
+    emit q->fileLoadTime( loader->path(), timing.queueTime, loadTime );
+
     GeoDataDocument *doc = loader->document();
-    m_loaderList.removeAll( loader );
-    if ( loader->isFinished() ) {
-        if ( doc ) {
-            if ( doc->name().isEmpty() && !doc->fileName().isEmpty() )
-            {
-                QFileInfo file( doc->fileName() );
-                doc->setName( file.baseName() );
-            }
-            m_treeModel->addDocument( doc );
-            m_fileItemHash.insert( loader->path(), doc );
-            emit q->fileAdded( loader->path() );
-            if( loader->recenter() ) {
-                m_latLonBox |= doc->latLonAltBox();
-            }
+    if ( doc ) {
+        if ( doc->name().isEmpty() && !doc->fileName().isEmpty() )
+        {
+            QFileInfo file( doc->fileName() );
+            doc->setName( file.baseName() );
         }
-        if ( !loader->error().isEmpty() ) {
-            qWarning() << "Failed to parse" << loader->path() << loader->error();
-            emit q->fileError(loader->path(), loader->error());
+        m_treeModel->addDocument( doc );
+        m_fileItemHash.insert( loader->path(), doc );
+        m_knownBounds.insert( loader->path(), doc->latLonAltBox() );
+        emit q->fileAdded( loader->path() );
+        if( loader->recenter() ) {
+            m_latLonBox |= doc->latLonAltBox();
         }
-        delete loader;
     }
+    if ( !loader->error().isEmpty() ) {
+        qWarning() << "Failed to parse" << loader->path() << loader->error();
+        emit q->fileError(loader->path(), loader->error());
+    }
+    delete loader;
+
+    startLoaders();
+
     if ( m_loaderList.isEmpty()  )
     {
         mDebug() << "Finished loading all placemarks " << m_timer.elapsed();
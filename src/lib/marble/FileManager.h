@@ -24,6 +24,7 @@ namespace Marble
 class FileManagerPrivate;
 class FileLoader;
 class GeoDataLatLonBox;
+class GeoDataLatLonAltBox;
 class GeoDataTreeModel;
 class PluginManager;
 
@@ -77,12 +78,36 @@ class MARBLE_EXPORT FileManager : public QObject
     /** Returns the number of files being opened at the moment */
     int pendingFiles() const;
 
+    /**
+     * Returns the maximum number of files parsed concurrently. Further files
+     * are queued until one of the running loaders has finished.
+     */
+    int maximumConcurrentFiles() const;
+
+ public Q_SLOTS:
+    /**
+     * Sets the region currently shown on the map. Queued files known to
+     * cover it are loaded before the remaining ones. The bounds of a file are
+     * known once it has been loaded or if there is a snapshot of it, see
+     * DocumentSnapshot::bounds(); other files are loaded in the order they
+     * were added.
+     */
+    void setViewport( const GeoDataLatLonAltBox &viewport );
+
  Q_SIGNALS:
     void fileAdded( const QString &key );
     void fileRemoved( const QString &key );
     void centeredDocument( const GeoDataLatLonBox& );
     void fileError(const QString &key, const QString& error);
 
+    /**
+     * Emitted for each file whose loading completed.
+     * @param key the file name as passed to addFile()
+     * @param queueTime milliseconds the file waited for a free loader
+     * @param loadTime milliseconds spent loading and parsing the file
+     */
+    void fileLoadTime( const QString &key, qint64 queueTime, qint64 loadTime );
+
  private:
 
     Q_PRIVATE_SLOT( d, void cleanupLoader( FileLoader *loader ) )
@@ -25,6 +25,7 @@
 #include "GeoDataLinearRing.h"
 #include "GeoDataPoint.h"
 #include "GeoDataPolygon.h"
+#include "ScreenPolygonPool.h"
 
 #include "ViewportParams.h"
 #include "AbstractProjection.h"
@@ -591,7 +592,7 @@ void GeoPainter::drawPolyline ( const GeoDataLineString & lineString,
                           labelPositionFlags,
                           labelColor);
 
-    qDeleteAll( polygons );
+    ScreenPolygonPool::release( polygons );
 }
 
 void GeoPainter::drawLabelsForPolygons( const QVector<QPolygonF*> &polygons,
@@ -724,7 +725,7 @@ void GeoPainter::drawPolyline(const GeoDataLineString& lineString)
         ClipPainter::drawPolyline(*itPolygon);
     }
 
-    qDeleteAll(polygons);
+    ScreenPolygonPool::release( polygons );
 }
 
 
@@ -751,7 +752,7 @@ QRegion GeoPainter::regionFromPolyline ( const GeoDataLineString & lineString,
         painterPath.addPolygon( *itPolygon );
     }
 
-    qDeleteAll( polygons );
+    ScreenPolygonPool::release( polygons );
 
     QPainterPathStroker stroker;
     stroker.setWidth( strokeWidth );
@@ -782,7 +783,7 @@ void GeoPainter::drawPolygon ( const GeoDataLinearRing & linearRing,
         ClipPainter::drawPolygon( *itPolygon, fillRule );
     }
 
-    qDeleteAll( polygons );
+    ScreenPolygonPool::release( polygons );
 }
 
 
@@ -823,7 +824,7 @@ QRegion GeoPainter::regionFromPolygon ( const GeoDataLinearRing & linearRing,
         regions = QRegion( painterPath.toFillPolygon().toPolygon() );
     }
 
-    qDeleteAll( polygons );
+    ScreenPolygonPool::release( polygons );
 
     return regions;
 }
@@ -893,7 +894,7 @@ void GeoPainter::drawPolygon ( const GeoDataPolygon & polygon,
                 ClipPainter::drawPolyline( *innerPolygon );
             }
 
-            qDeleteAll(fillPolygons);
+            ScreenPolygonPool::release( fillPolygons );
         }
     }
 
@@ -901,8 +902,8 @@ void GeoPainter::drawPolygon ( const GeoDataPolygon & polygon,
         drawPolygon( polygon.outerBoundary(), fillRule );
     }
 
-    qDeleteAll(outerPolygons);
-    qDeleteAll(innerPolygons);
+    ScreenPolygonPool::release( outerPolygons );
+    ScreenPolygonPool::release( innerPolygons );
 }
 
 QVector<QPolygonF*> GeoPainter::createFillPolygons( const QVector<QPolygonF*> & outerPolygons,
@@ -912,7 +913,7 @@ QVector<QPolygonF*> GeoPainter::createFillPolygons( const QVector<QPolygonF*> &
     fillPolygons.reserve(outerPolygons.size());
 
     for( const QPolygonF* outerPolygon: outerPolygons ) {
-        QPolygonF* fillPolygon = new QPolygonF;
+        QPolygonF* fillPolygon = ScreenPolygonPool::create();
         *fillPolygon << *outerPolygon;
         *fillPolygon << outerPolygon->first();
 
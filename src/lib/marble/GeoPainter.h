@@ -316,7 +316,8 @@ class MARBLE_EXPORT GeoPainter : public ClipPainter
     In general drawPolyline() should be used instead. However
     in situations where the same linestring is supposed to be
     drawn multiple times it's a good idea to cache the
-    screen polygons using this method.
+    screen polygons using this method. Hand the polygons to
+    ScreenPolygonPool::release() once they are no longer needed.
 
     \see GeoDataLineString
 */
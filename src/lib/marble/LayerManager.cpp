@@ -21,6 +21,7 @@
 #include "GeoPainter.h"
 #include "RenderPlugin.h"
 #include "LayerInterface.h"
+#include "MarbleTrace.h"
 #include "RenderState.h"
 
 #include <QElapsedTimer>
@@ -44,6 +45,7 @@ class Q_DECL_HIDDEN LayerManager::Private
     QList<LayerInterface *> m_internalLayers;
 
     RenderState m_renderState;
+    QVector<LayerStatistics> m_layerStatistics;
 
     bool m_showBackground;
     bool m_showRuntimeTrace;
@@ -124,6 +126,7 @@ QList<AbstractDataPluginItem *> LayerManager::whichItemAt( const QPoint& curpos
 void LayerManager::renderLayers( GeoPainter *painter, ViewportParams *viewport )
 {
     d->m_renderState = RenderState(QStringLiteral("Marble"));
+    d->m_layerStatistics.clear();
     const QTime totalTime = QTime::currentTime();
 
     QStringList renderPositions;
@@ -154,7 +157,13 @@ void LayerManager::renderLayers( GeoPainter *painter, ViewportParams *viewport )
             if ( renderPlugin && renderPlugin->renderPosition().contains( renderPosition ) ) {
                 if ( renderPlugin->enabled() && renderPlugin->visible() ) {
                     if ( !renderPlugin->isInitialized() ) {
-                        renderPlugin->initialize();
+                        QElapsedTimer initTime;
+                        initTime.start();
+                        {
+                            MarbleTraceScope traceScope( MarbleTrace::internedName( renderPlugin->nameId() ), "plugin" );
+                            renderPlugin->initialize();
+                        }
+                        mDebug() << "Initializing" << renderPlugin->nameId() << "took" << initTime.elapsed() << "ms";
                         emit renderPluginInitialized( renderPlugin );
                     }
                     layers.push_back( renderPlugin );
@@ -179,9 +188,24 @@ void LayerManager::renderLayers( GeoPainter *painter, ViewportParams *viewport )
         QElapsedTimer timer;
         for( auto *layer: layers ) {
             timer.start();
+            const qint64 traceStart = MarbleTrace::isEnabled() ? MarbleTrace::timestamp() : -1;
             layer->render( painter, viewport, renderPosition, nullptr );
-            d->m_renderState.addChild( layer->renderState() );
-            traceList.append( QString("%2 ms %3").arg( timer.elapsed(),3 ).arg( layer->runtimeTrace() ) );
+            const qint64 elapsed = timer.nsecsElapsed();
+            const RenderState layerState = layer->renderState();
+            d->m_renderState.addChild( layerState );
+
+            LayerStatistics statistics;
+            statistics.name = layerState.name().isEmpty() ? layer->runtimeTrace() : layerState.name();
+            statistics.renderPosition = renderPosition;
+            statistics.renderTime = elapsed / 1.0e6;
+            if ( traceStart >= 0 ) {
+                MarbleTrace::addEvent( MarbleTrace::internedName( statistics.name ), "layer", traceStart, elapsed );
+            }
+            d->m_layerStatistics.append( statistics );
+
+            if ( d->m_showRuntimeTrace ) {
+                traceList.append( QString("%2 ms %3").arg( elapsed / 1000000, 3 ).arg( layer->runtimeTrace() ) );
+            }
         }
     }
 
@@ -241,6 +265,11 @@ RenderState LayerManager::renderState() const
     return d->m_renderState;
 }
 
+QVector<LayerStatistics> LayerManager::layerStatistics() const
+{
+    return d->m_layerStatistics;
+}
+
 }
 
 #include "moc_LayerManager.cpp"
@@ -17,6 +17,8 @@
 #include <QObject>
 #include <QRegion>
 
+#include "MarbleTrace.h"
+
 class QPoint;
 class QString;
 
@@ -77,6 +79,11 @@ class LayerManager : public QObject
 
     RenderState renderState() const;
 
+    /**
+     * @brief Returns the time spent in each layer during the last call of renderLayers()
+     */
+    QVector<LayerStatistics> layerStatistics() const;
+
  Q_SIGNALS:
     /**
      * @brief Signal that a render item has been initialized
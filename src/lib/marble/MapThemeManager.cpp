@@ -14,10 +14,15 @@
 #include "MapThemeManager.h"
 
 // Qt
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
 #include <QFileSystemWatcher>
+#include <QHash>
+#include <QImage>
+#include <QSaveFile>
 #include <QScopedPointer>
 #include <QString>
 #include <QStringList>
@@ -48,11 +53,47 @@ namespace
 {
     static const QString mapDirName = "maps";
     static const int columnRelativePath = 1;
+
+    const quint32 mapThemeIndexMagicNumber = 0x4d544858; // "MTHX"
+    const qint32 mapThemeIndexVersion = 1;
 }
 
 namespace Marble
 {
 
+/**
+ * What the map theme model shows of a map theme, kept in an index on disk so
+ * that the .dgml files and preview images need not be read on every start.
+ */
+struct MapThemeIndexEntry
+{
+    QString dgmlPath;
+    QDateTime dgmlModified;
+    qint64 dgmlSize;
+    QString iconPath;
+    QDateTime iconModified;
+    bool visible;
+    QString name;
+    QString description;
+    QImage icon;
+};
+
+QDataStream &operator<<( QDataStream &stream, const MapThemeIndexEntry &entry )
+{
+    stream << entry.dgmlPath << entry.dgmlModified << entry.dgmlSize
+           << entry.iconPath << entry.iconModified << entry.visible
+           << entry.name << entry.description << entry.icon;
+    return stream;
+}
+
+QDataStream &operator>>( QDataStream &stream, MapThemeIndexEntry &entry )
+{
+    stream >> entry.dgmlPath >> entry.dgmlModified >> entry.dgmlSize
+           >> entry.iconPath >> entry.iconModified >> entry.visible
+           >> entry.name >> entry.description >> entry.icon;
+    return stream;
+}
+
 class Q_DECL_HIDDEN MapThemeManager::Private
 {
 public:
@@ -93,7 +134,17 @@ public:
     /**
      * @brief Helper method for updateMapThemeModel().
      */
-    static QList<QStandardItem *> createMapThemeRow( const QString& mapThemeID );
+    QList<QStandardItem *> createMapThemeRow( const QString& mapThemeID );
+
+    /**
+     * @brief Returns the index entry of the map theme, reading the .dgml file
+     *        only if it changed since the entry was created.
+     */
+    const MapThemeIndexEntry &mapThemeIndexEntry( const QString& mapThemeID );
+
+    static QString mapThemeIndexPath();
+    void loadMapThemeIndex();
+    void saveMapThemeIndex();
 
     /**
      * @brief Deletes any directory with its contents.
@@ -107,6 +158,9 @@ public:
     QStandardItemModel m_celestialList;
     QFileSystemWatcher m_fileSystemWatcher;
     bool m_isInitialized;
+    QHash<QString, MapThemeIndexEntry> m_mapThemeIndex;
+    bool m_mapThemeIndexLoaded;
+    bool m_mapThemeIndexChanged;
 
 private:
     /**
@@ -121,7 +175,9 @@ MapThemeManager::Private::Private( MapThemeManager *parent )
       m_mapThemeModel( 0, 3 ),
       m_celestialList(),
       m_fileSystemWatcher(),
-      m_isInitialized( false )
+      m_isInitialized( false ),
+      m_mapThemeIndexLoaded( false ),
+      m_mapThemeIndexChanged( false )
 {
 }
 
@@ -352,51 +408,145 @@ QList<QStandardItem *> MapThemeManager::Private::createMapThemeRow( QString cons
 {
     QList<QStandardItem *> itemList;
 
+    const MapThemeIndexEntry &entry = mapThemeIndexEntry( mapThemeID );
+    if ( !entry.visible ) {
+        return itemList;
+    }
+
+    QIcon mapThemeIcon =  QIcon( QPixmap::fromImage( entry.icon ) );
+
+    QString name = entry.name;
+    const QString translatedDescription = QCoreApplication::translate("DGML", entry.description.toUtf8().constData());
+    const QString toolTip = QLatin1String("<span style=\" max-width: 150 px;\"> ") + translatedDescription + QLatin1String(" </span>");
+
+    QStandardItem *item = new QStandardItem( name );
+    item->setData(QCoreApplication::translate("DGML", name.toUtf8().constData()), Qt::DisplayRole);
+    item->setData( mapThemeIcon, Qt::DecorationRole );
+    item->setData(toolTip, Qt::ToolTipRole);
+    item->setData( mapThemeID, Qt::UserRole + 1 );
+    item->setData(translatedDescription, Qt::UserRole + 2);
+
+    itemList << item;
+
+    return itemList;
+}
+
+const MapThemeIndexEntry &MapThemeManager::Private::mapThemeIndexEntry( const QString& mapThemeID )
+{
+    const QString dgmlPath = MarbleDirs::path( mapDirName + QLatin1Char('/') + mapThemeID );
+    const QFileInfo dgmlInfo( dgmlPath );
+
+    QHash<QString, MapThemeIndexEntry>::const_iterator const cached = m_mapThemeIndex.constFind( mapThemeID );
+    if ( cached != m_mapThemeIndex.constEnd()
+         && cached->dgmlPath == dgmlPath
+         && cached->dgmlModified == dgmlInfo.lastModified()
+         && cached->dgmlSize == dgmlInfo.size()
+         && cached->iconModified == QFileInfo( cached->iconPath ).lastModified() ) {
+        return *cached;
+    }
+
+    m_mapThemeIndexChanged = true;
+
+    MapThemeIndexEntry &entry = m_mapThemeIndex[mapThemeID];
+    entry = MapThemeIndexEntry();
+    entry.dgmlPath = dgmlPath;
+    entry.dgmlModified = dgmlInfo.lastModified();
+    entry.dgmlSize = dgmlInfo.size();
+    entry.visible = false;
+
+    // Broken themes are kept as invisible entries, so they are not read again either
     QScopedPointer<GeoSceneDocument> mapTheme( loadMapThemeFile( mapThemeID ) );
     if ( !mapTheme || !mapTheme->head()->visible() ) {
-        return itemList;
+        return entry;
     }
 
-    QPixmap themeIconPixmap;
+    entry.visible = true;
+    entry.name = mapTheme->head()->name();
+    entry.description = mapTheme->head()->description();
 
     QString relativePath = mapDirName + QLatin1Char('/')
         + mapTheme->head()->target() + QLatin1Char('/') + mapTheme->head()->theme() + QLatin1Char('/')
         + mapTheme->head()->icon()->pixmap();
-    themeIconPixmap.load( MarbleDirs::path( relativePath ) );
+    // A preview added later on is noticed by its modification time becoming valid
+    entry.iconPath = MarbleDirs::path( relativePath );
+    entry.iconModified = QFileInfo( entry.iconPath ).lastModified();
+    QImage themeIcon( entry.iconPath );
 
-    if ( themeIconPixmap.isNull() ) {
+    if ( themeIcon.isNull() ) {
         relativePath = "svg/application-x-marble-gray.png";
-        themeIconPixmap.load( MarbleDirs::path( relativePath ) );
+        themeIcon.load( MarbleDirs::path( relativePath ) );
     }
     else {
         // Make sure we don't keep excessively large previews in memory
         // TODO: Scale the icon down to the default icon size in MarbleSelectView.
         //       For now maxIconSize already equals what's expected by the listview.
         QSize maxIconSize( 136, 136 );
-        if ( themeIconPixmap.size() != maxIconSize ) {
+        if ( themeIcon.size() != maxIconSize ) {
             mDebug() << "Smooth scaling theme icon";
-            themeIconPixmap = themeIconPixmap.scaled( maxIconSize,
-                                                      Qt::KeepAspectRatio,
-                                                      Qt::SmoothTransformation );
+            themeIcon = themeIcon.scaled( maxIconSize,
+                                          Qt::KeepAspectRatio,
+                                          Qt::SmoothTransformation );
         }
     }
+    entry.icon = themeIcon;
 
-    QIcon mapThemeIcon =  QIcon( themeIconPixmap );
+    return entry;
+}
 
-    QString name = mapTheme->head()->name();
-    const QString translatedDescription = QCoreApplication::translate("DGML", mapTheme->head()->description().toUtf8().constData());
-    const QString toolTip = QLatin1String("<span style=\" max-width: 150 px;\"> ") + translatedDescription + QLatin1String(" </span>");
+QString MapThemeManager::Private::mapThemeIndexPath()
+{
+    return MarbleDirs::localPath() + QLatin1String( "/cache/mapthemes.index" );
+}
 
-    QStandardItem *item = new QStandardItem( name );
-    item->setData(QCoreApplication::translate("DGML", name.toUtf8().constData()), Qt::DisplayRole);
-    item->setData( mapThemeIcon, Qt::DecorationRole );
-    item->setData(toolTip, Qt::ToolTipRole);
-    item->setData( mapThemeID, Qt::UserRole + 1 );
-    item->setData(translatedDescription, Qt::UserRole + 2);
+void MapThemeManager::Private::loadMapThemeIndex()
+{
+    m_mapThemeIndexLoaded = true;
 
-    itemList << item;
+    QFile file( mapThemeIndexPath() );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return;
+    }
 
-    return itemList;
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_5_6 );
+
+    quint32 magic;
+    qint32 version;
+    stream >> magic >> version;
+    if ( magic != mapThemeIndexMagicNumber || version != mapThemeIndexVersion ) {
+        return;
+    }
+
+    QHash<QString, MapThemeIndexEntry> index;
+    stream >> index;
+    if ( stream.status() != QDataStream::Ok ) {
+        mDebug() << "Ignoring corrupt map theme index" << file.fileName();
+        return;
+    }
+
+    m_mapThemeIndex = index;
+}
+
+void MapThemeManager::Private::saveMapThemeIndex()
+{
+    if ( !m_mapThemeIndexChanged ) {
+        return;
+    }
+    m_mapThemeIndexChanged = false;
+
+    const QString path = mapThemeIndexPath();
+    QDir().mkpath( QFileInfo( path ).path() );
+
+    QSaveFile file( path );
+    if ( !file.open( QIODevice::WriteOnly ) ) {
+        mDebug() << "Cannot write map theme index" << path;
+        return;
+    }
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_5_6 );
+    stream << mapThemeIndexMagicNumber << mapThemeIndexVersion << m_mapThemeIndex;
+    file.commit();
 }
 
 void MapThemeManager::Private::updateMapThemeModel()
@@ -406,6 +556,10 @@ void MapThemeManager::Private::updateMapThemeModel()
 
     m_mapThemeModel.setHeaderData(0, Qt::Horizontal, QObject::tr("Name"));
 
+    if ( !m_mapThemeIndexLoaded ) {
+        loadMapThemeIndex();
+    }
+
     QStringList stringlist = findMapThemes();
     QStringListIterator it( stringlist );
 
@@ -418,6 +572,19 @@ void MapThemeManager::Private::updateMapThemeModel()
         }
     }
 
+    // Forget about themes that have been removed
+    const int indexSize = m_mapThemeIndex.size();
+    QHash<QString, MapThemeIndexEntry>::iterator entry = m_mapThemeIndex.begin();
+    while ( entry != m_mapThemeIndex.end() ) {
+        if ( stringlist.contains( entry.key() ) ) {
+            ++entry;
+        } else {
+            entry = m_mapThemeIndex.erase( entry );
+        }
+    }
+    m_mapThemeIndexChanged = m_mapThemeIndexChanged || m_mapThemeIndex.size() != indexSize;
+    saveMapThemeIndex();
+
     for ( const QString &mapThemeId: stringlist ) {
         const QString celestialBodyId = mapThemeId.section(QLatin1Char('/'), 0, 0);
         QString celestialBodyName = PlanetFactory::localizedName( celestialBodyId );
@@ -489,6 +656,7 @@ void MapThemeManager::Private::fileChanged( const QString& path )
         if ( !newMapThemeRow.empty() ) {
             m_mapThemeModel.insertRow( insertAtRow, newMapThemeRow );
         }
+        saveMapThemeIndex();
     }
 
     emit q->themesChanged();
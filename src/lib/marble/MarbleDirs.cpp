@@ -43,6 +43,8 @@ namespace
     QString runTimeMarbleDataPath;
 
     QString runTimeMarblePluginPath;
+
+    QString runTimeMarbleLocalPath;
 }
 
 MarbleDirs::MarbleDirs()
@@ -236,6 +238,10 @@ QString MarbleDirs::pluginSystemPath()
 
 QString MarbleDirs::localPath() 
 {
+    if (!runTimeMarbleLocalPath.isEmpty()) {
+        return runTimeMarbleLocalPath;
+    }
+
 #ifndef Q_OS_WIN
     QString dataHome = getenv( "XDG_DATA_HOME" );
     if( dataHome.isEmpty() )
@@ -332,6 +338,17 @@ void MarbleDirs::setMarblePluginPath( const QString& adaptedPath )
     runTimeMarblePluginPath = adaptedPath;
 }
 
+void MarbleDirs::setMarbleLocalPath( const QString& adaptedPath )
+{
+    if ( !QDir::root().exists( adaptedPath ) )
+    {
+        qWarning() << QString( "Invalid MarbleLocalPath \"%1\". Using \"%2\" instead." ).arg( adaptedPath, localPath() );
+        return;
+    }
+
+    runTimeMarbleLocalPath = adaptedPath;
+}
+
 
 void MarbleDirs::debug()
 {
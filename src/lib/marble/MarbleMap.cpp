@@ -59,6 +59,7 @@
 #include "MarbleDebug.h"
 #include "MarbleDirs.h"
 #include "MarbleModel.h"
+#include "MarbleTrace.h"
 #include "PluginManager.h"
 #include "RenderPlugin.h"
 #include "StyleBuilder.h"
@@ -124,6 +125,8 @@ public:
 
     void setDocument( const QString& key );
 
+    void removeDocument( const QString& key );
+
     void updateTileLevel();
 
     void addPlugins();
@@ -159,6 +162,7 @@ public:
     bool m_isLockedToSubSolarPoint;
     bool m_isSubSolarPointIconVisible;
     RenderState m_renderState;
+    FrameStatistics m_frameStatistics;
 };
 
 MarbleMapPrivate::MarbleMapPrivate( MarbleMap *parent, MarbleModel *model ) :
@@ -193,6 +197,10 @@ MarbleMapPrivate::MarbleMapPrivate( MarbleMap *parent, MarbleModel *model ) :
                       parent, SLOT(updateMapTheme()) );
     QObject::connect( m_model->fileManager(), SIGNAL(fileAdded(QString)),
                       parent, SLOT(setDocument(QString)) );
+    QObject::connect( m_model->fileManager(), SIGNAL(fileRemoved(QString)),
+                      parent, SLOT(removeDocument(QString)) );
+    QObject::connect( parent, SIGNAL(visibleLatLonAltBoxChanged(GeoDataLatLonAltBox)),
+                      m_model->fileManager(), SLOT(setViewport(GeoDataLatLonAltBox)) );
 
 
     QObject::connect( &m_placemarkLayer, SIGNAL(repaintNeeded()),
@@ -825,6 +833,14 @@ void MarbleMapPrivate::setDocument( const QString& key )
     }
 }
 
+void MarbleMapPrivate::removeDocument( const QString& key )
+{
+    // The document is deleted right after, the coast mask must not use it anymore
+    if ( const GeoDataDocument *doc = m_model->fileManager()->at( key ) ) {
+        m_textureLayer.removeDocument( doc );
+    }
+}
+
 void MarbleMapPrivate::updateTileLevel()
 {
     auto const tileZoomLevel = q->tileZoomLevel();
@@ -854,6 +870,7 @@ void MarbleMap::paint( GeoPainter &painter, const QRect &dirtyRect )
         return;
     }
 
+    MarbleTraceScope traceScope( "Frame", "render" );
     QElapsedTimer t;
     t.start();
 
@@ -873,6 +890,10 @@ void MarbleMap::paint( GeoPainter &painter, const QRect &dirtyRect )
         fpsPainter.paint( &painter );
     }
 
+    ++d->m_frameStatistics.frame;
+    d->m_frameStatistics.renderTime = t.nsecsElapsed() / 1.0e6;
+    d->m_frameStatistics.layers = d->m_layerManager.layerStatistics();
+
     const qreal fps = 1000.0 / (qreal)( t.elapsed() );
     emit framesPerSecond( fps );
 }
@@ -1452,6 +1473,11 @@ RenderState MarbleMap::renderState() const
     return d->m_layerManager.renderState();
 }
 
+FrameStatistics MarbleMap::frameStatistics() const
+{
+    return d->m_frameStatistics;
+}
+
 QString MarbleMap::addTextureLayer(GeoSceneTextureTileDataset *texture)
 {
     return textureLayer()->addTextureLayer(texture);
@@ -25,6 +25,7 @@
 #include "marble_export.h"
 #include "GeoDataCoordinates.h"       // In geodata/data/
 #include "GeoDataRelation.h"
+#include "MarbleTrace.h"
 
 // Qt
 #include <QObject>
@@ -428,6 +429,12 @@ class MARBLE_EXPORT MarbleMap : public QObject
 
     RenderState renderState() const;
 
+    /**
+     * @brief Returns how long it took to render the last frame and each of its layers
+     * @see MarbleTrace
+     */
+    FrameStatistics frameStatistics() const;
+
     /**
      * @since 0.26.0
      */
@@ -794,6 +801,7 @@ class MARBLE_EXPORT MarbleMap : public QObject
     Q_PRIVATE_SLOT( d, void updateMapTheme() )
     Q_PRIVATE_SLOT( d, void updateProperty( const QString &, bool ) )
     Q_PRIVATE_SLOT( d, void setDocument(QString) )
+    Q_PRIVATE_SLOT( d, void removeDocument(QString) )
     Q_PRIVATE_SLOT( d, void updateTileLevel() )
     Q_PRIVATE_SLOT(d, void addPlugins())
 
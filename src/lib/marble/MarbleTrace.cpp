@@ -0,0 +1,194 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "MarbleTrace.h"
+
+#include "MarbleDebug.h"
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+
+namespace Marble
+{
+
+namespace {
+
+struct TraceEvent
+{
+    const char *name;
+    const char *category;
+    qint64 start;
+    qint64 duration;
+    int thread;
+};
+
+// Roughly the events of a few minutes of panning around
+const int traceCapacity = 65536;
+
+QAtomicInt traceEnabled( qEnvironmentVariableIsSet( "MARBLE_TRACE" ) ? 1 : 0 );
+QAtomicInt threadCount( 0 );
+thread_local int traceThread = 0;
+
+class TraceBuffer
+{
+public:
+    TraceBuffer() :
+        m_events( traceCapacity ),
+        m_next( 0 ),
+        m_size( 0 )
+    {
+    }
+
+    ~TraceBuffer();
+
+    QByteArray chromeTrace();
+    bool saveChromeTrace( const QString &fileName );
+
+    QMutex m_mutex;
+    QVector<TraceEvent> m_events;
+    int m_next;
+    int m_size;
+    QHash<QString, QByteArray> m_names;
+};
+
+TraceBuffer::~TraceBuffer()
+{
+    const QString fileName = QString::fromLocal8Bit( qgetenv( "MARBLE_TRACE" ) );
+    if ( !fileName.isEmpty() ) {
+        saveChromeTrace( fileName );
+    }
+}
+
+QByteArray TraceBuffer::chromeTrace()
+{
+    QVector<TraceEvent> events;
+    {
+        QMutexLocker locker( &m_mutex );
+        events.reserve( m_size );
+        const int first = ( m_next - m_size + traceCapacity ) % traceCapacity;
+        for ( int i = 0; i < m_size; ++i ) {
+            events << m_events[( first + i ) % traceCapacity];
+        }
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray traceEvents;
+    for ( const TraceEvent &event: events ) {
+        QJsonObject object;
+        object.insert( QStringLiteral( "name" ), QString::fromUtf8( event.name ) );
+        object.insert( QStringLiteral( "cat" ), QString::fromUtf8( event.category ) );
+        object.insert( QStringLiteral( "ph" ), QStringLiteral( "X" ) );
+        object.insert( QStringLiteral( "ts" ), event.start / 1000.0 );
+        object.insert( QStringLiteral( "dur" ), event.duration / 1000.0 );
+        object.insert( QStringLiteral( "pid" ), pid );
+        object.insert( QStringLiteral( "tid" ), event.thread );
+        traceEvents.append( object );
+    }
+
+    QJsonObject trace;
+    trace.insert( QStringLiteral( "traceEvents" ), traceEvents );
+    trace.insert( QStringLiteral( "displayTimeUnit" ), QStringLiteral( "ms" ) );
+    return QJsonDocument( trace ).toJson( QJsonDocument::Compact );
+}
+
+bool TraceBuffer::saveChromeTrace( const QString &fileName )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) ) {
+        mDebug() << "Cannot write trace to" << fileName << file.errorString();
+        return false;
+    }
+    return file.write( chromeTrace() ) >= 0;
+}
+
+Q_GLOBAL_STATIC( TraceBuffer, traceBuffer )
+
+}
+
+bool MarbleTrace::isEnabled()
+{
+    return traceEnabled.loadAcquire();
+}
+
+void MarbleTrace::setEnabled( bool enabled )
+{
+    traceEnabled.storeRelease( enabled ? 1 : 0 );
+}
+
+void MarbleTrace::clear()
+{
+    TraceBuffer *const buffer = traceBuffer();
+    if ( !buffer ) {
+        return;
+    }
+    QMutexLocker locker( &buffer->m_mutex );
+    buffer->m_next = 0;
+    buffer->m_size = 0;
+}
+
+QByteArray MarbleTrace::chromeTrace()
+{
+    TraceBuffer *const buffer = traceBuffer();
+    return buffer ? buffer->chromeTrace() : QByteArray();
+}
+
+bool MarbleTrace::saveChromeTrace( const QString &fileName )
+{
+    TraceBuffer *const buffer = traceBuffer();
+    return buffer && buffer->saveChromeTrace( fileName );
+}
+
+qint64 MarbleTrace::timestamp()
+{
+    static const QElapsedTimer timer = [] {
+        QElapsedTimer result;
+        result.start();
+        return result;
+    }();
+    return timer.nsecsElapsed();
+}
+
+void MarbleTrace::addEvent( const char *name, const char *category, qint64 start, qint64 duration )
+{
+    if ( !traceThread ) {
+        traceThread = threadCount.fetchAndAddRelaxed( 1 ) + 1;
+    }
+
+    const TraceEvent event = { name, category, start, duration, traceThread };
+    TraceBuffer *const buffer = traceBuffer();
+    if ( !buffer ) {
+        return;
+    }
+    QMutexLocker locker( &buffer->m_mutex );
+    buffer->m_events[buffer->m_next] = event;
+    buffer->m_next = ( buffer->m_next + 1 ) % traceCapacity;
+    buffer->m_size = qMin( buffer->m_size + 1, traceCapacity );
+}
+
+const char *MarbleTrace::internedName( const QString &name )
+{
+    TraceBuffer *const buffer = traceBuffer();
+    if ( !buffer ) {
+        return "";
+    }
+    QMutexLocker locker( &buffer->m_mutex );
+    QByteArray &interned = buffer->m_names[name];
+    if ( interned.isEmpty() ) {
+        interned = name.toUtf8();
+    }
+    return interned.constData();
+}
+
+}
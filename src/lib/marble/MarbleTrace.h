@@ -0,0 +1,131 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_MARBLETRACE_H
+#define MARBLE_MARBLETRACE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "marble_export.h"
+
+namespace Marble
+{
+
+/**
+ * @brief Time spent in one layer while rendering a frame
+ */
+struct LayerStatistics
+{
+    /** Name of the layer as reported in its render state */
+    QString name;
+    QString renderPosition;
+    /** Time spent in the layer's render method, in milliseconds */
+    qreal renderTime = 0.0;
+};
+
+/**
+ * @brief Timing of the last frame rendered by a MarbleMap
+ */
+struct FrameStatistics
+{
+    /** Number of the frame, counting up from 1 */
+    quint64 frame = 0;
+    /** Time spent to render the whole frame, in milliseconds */
+    qreal renderTime = 0.0;
+    /** The layers in the order they were rendered */
+    QVector<LayerStatistics> layers;
+};
+
+/**
+ * @brief Records trace events for performance analysis
+ *
+ * Texture mapping, tile loading, file parsing, placemark layout and the
+ * rendering of each layer are instrumented with trace events. Recording is
+ * off by default and costs no more than a check of a flag then. Once enabled,
+ * events are collected in a ring buffer holding the most recent ones, which
+ * can be exported in the Chrome trace event format understood by
+ * chrome://tracing and the Perfetto UI.
+ *
+ * Set the environment variable MARBLE_TRACE to a file name to start recording
+ * right away and export the trace to that file when the application quits.
+ */
+class MARBLE_EXPORT MarbleTrace
+{
+public:
+    static bool isEnabled();
+    static void setEnabled( bool enabled );
+
+    /**
+     * Discards all recorded events.
+     */
+    static void clear();
+
+    /**
+     * Returns the recorded events in the Chrome trace event JSON format.
+     */
+    static QByteArray chromeTrace();
+
+    /**
+     * Writes the recorded events in the Chrome trace event JSON format to @p fileName.
+     */
+    static bool saveChromeTrace( const QString &fileName );
+
+    /**
+     * Nanoseconds since an arbitrary point in time, the time base of all events.
+     */
+    static qint64 timestamp();
+
+    /**
+     * Records an event that started at @p start and lasted @p duration nanoseconds.
+     * @p name and @p category must stay valid, use string literals or internedName().
+     */
+    static void addEvent( const char *name, const char *category, qint64 start, qint64 duration );
+
+    /**
+     * Returns a pointer to a copy of @p name that stays valid for the lifetime of the
+     * application. Meant for names of layers and the like, not for arbitrary strings.
+     */
+    static const char *internedName( const QString &name );
+};
+
+/**
+ * @brief Records a trace event lasting from construction to destruction
+ *
+ * @code
+ *   MarbleTraceScope traceScope( "TextureMapping", "render" );
+ * @endcode
+ */
+class MARBLE_EXPORT MarbleTraceScope
+{
+public:
+    MarbleTraceScope( const char *name, const char *category ) :
+        m_name( name ),
+        m_category( category ),
+        m_start( MarbleTrace::isEnabled() ? MarbleTrace::timestamp() : -1 )
+    {
+    }
+
+    ~MarbleTraceScope()
+    {
+        if ( m_start >= 0 ) {
+            MarbleTrace::addEvent( m_name, m_category, m_start, MarbleTrace::timestamp() - m_start );
+        }
+    }
+
+private:
+    Q_DISABLE_COPY( MarbleTraceScope )
+    const char *const m_name;
+    const char *const m_category;
+    const qint64 m_start;
+};
+
+}
+
+#endif
@@ -60,10 +60,17 @@
 #include <qplatformdefs.h>
 #include <qendian.h>
 #include <QDebug>
+#include <QAtomicInt>
+#include <QBuffer>
 #include <QDir>
+#include <QHash>
+#include <QVector>
+#include <QtConcurrentMap>
 
 #include <zlib.h>
 
+#include <climits>
+
 #if defined(Q_OS_WIN)
 #  undef S_IFREG
 #  define S_IFREG 0100000
@@ -261,6 +268,72 @@ static int deflate (Bytef *dest, ulong *destLen, const Bytef *source, ulong sour
     return err;
 }
 
+// Contents larger than this are compressed in independent chunks on all cores
+static const int deflateChunkSize = 1024 * 1024;
+
+static bool deflateChunk(QByteArray *dest, const char *source, int sourceLen, bool last)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    int err = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    if (err != Z_OK)
+        return false;
+
+    // a sync flush adds an empty stored block of at most 10 bytes
+    dest->resize(deflateBound(&stream, sourceLen) + 16);
+    stream.next_in = (Bytef*)source;
+    stream.avail_in = (uInt)sourceLen;
+    stream.next_out = (Bytef*)dest->data();
+    stream.avail_out = (uInt)dest->size();
+
+    // All but the last chunk end on a byte boundary without the final block
+    // flag, so the raw deflate streams of the chunks can be concatenated
+    err = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+    bool const ok = last ? err == Z_STREAM_END : err == Z_OK && stream.avail_in == 0 && stream.avail_out > 0;
+    dest->resize(stream.total_out);
+    deflateEnd(&stream);
+    return ok;
+}
+
+static bool deflateParallel(QByteArray *dest, uint *crc_32, const QByteArray &contents)
+{
+    int const chunkCount = (contents.length() + deflateChunkSize - 1) / deflateChunkSize;
+    QVector<QByteArray> chunks(chunkCount);
+    QVector<uint> crcs(chunkCount);
+    QVector<int> indices(chunkCount);
+    for (int i = 0; i < chunkCount; ++i)
+        indices[i] = i;
+
+    QByteArray *const chunkData = chunks.data();
+    uint *const crcData = crcs.data();
+    QAtomicInt failed(0);
+    QtConcurrent::blockingMap(indices, [&](int i) {
+        const char *source = contents.constData() + i * deflateChunkSize;
+        int const length = qMin(deflateChunkSize, contents.length() - i * deflateChunkSize);
+        if (!deflateChunk(chunkData + i, source, length, i == chunkCount - 1))
+            failed.storeRelease(1);
+        crcData[i] = ::crc32(::crc32(0, nullptr, 0), (const uchar *)source, length);
+    });
+    if (failed.loadAcquire())
+        return false;
+
+    int size = 0;
+    for (const QByteArray &chunk : chunks)
+        size += chunk.size();
+    dest->clear();
+    dest->reserve(size);
+    *crc_32 = crcs.first();
+    for (int i = 0; i < chunkCount; ++i) {
+        dest->append(chunks.at(i));
+        if (i > 0) {
+            int const length = qMin(deflateChunkSize, contents.length() - i * deflateChunkSize);
+            *crc_32 = ::crc32_combine(*crc_32, crcs.at(i), length);
+        }
+    }
+    return true;
+}
+
 static QFile::Permissions modeToPermissions(quint32 mode)
 {
     QFile::Permissions ret;
@@ -445,19 +518,135 @@ void QZipPrivate::fillFileInfo(int index, MarbleZipReader::FileInfo &fileInfo) c
     fileInfo.lastModified = readMSDosDate(header.h.last_mod_file);
 }
 
+struct EntryLocation
+{
+    qint64 offset;
+    qint64 compressedSize;
+    qint64 size;
+    int method;
+};
+
 class MarbleZipReaderPrivate : public QZipPrivate
 {
 public:
     MarbleZipReaderPrivate(QIODevice *device, bool ownDev)
-        : QZipPrivate(device, ownDev), status(MarbleZipReader::NoError)
+        : QZipPrivate(device, ownDev), status(MarbleZipReader::NoError),
+        mappedData(nullptr), mappedSize(0)
     {
     }
 
     void scanFiles();
+    bool locateEntry(const QString &fileName, EntryLocation &entry);
+    void unmap();
 
     MarbleZipReader::Status status;
+    QHash<QString, int> fileIndex;
+    uchar *mappedData;
+    qint64 mappedSize;
 };
 
+/*
+  Inflates a deflated entry while it is read, either straight from the mapped
+  archive or in small chunks from the archive device.
+*/
+class MarbleZipEntryDevice : public QIODevice
+{
+public:
+    MarbleZipEntryDevice(const uchar *mappedData, QIODevice *device, const EntryLocation &entry)
+        : m_mappedData(mappedData), m_device(device), m_offset(entry.offset),
+        m_remaining(entry.compressedSize), m_size(entry.size), m_finished(false)
+    {
+        m_stream.next_in = nullptr;
+        m_stream.avail_in = 0;
+        m_stream.zalloc = (alloc_func)nullptr;
+        m_stream.zfree = (free_func)nullptr;
+        m_stream.opaque = (voidpf)nullptr;
+        m_initialized = inflateInit2(&m_stream, -MAX_WBITS) == Z_OK;
+        m_finished = !m_initialized;
+    }
+
+    ~MarbleZipEntryDevice() override
+    {
+        if (m_initialized)
+            inflateEnd(&m_stream);
+    }
+
+    bool isSequential() const override
+    {
+        return true;
+    }
+
+    qint64 bytesAvailable() const override
+    {
+        const qint64 pending = m_finished ? 0 : qMax<qint64>(1, m_size - qint64(m_stream.total_out));
+        return pending + QIODevice::bytesAvailable();
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+
+    qint64 writeData(const char *, qint64) override
+    {
+        return -1;
+    }
+
+private:
+    z_stream m_stream;
+    const uchar *m_mappedData;
+    QIODevice *m_device;
+    qint64 m_offset;
+    qint64 m_remaining;
+    qint64 m_size;
+    QByteArray m_input;
+    bool m_initialized;
+    bool m_finished;
+};
+
+qint64 MarbleZipEntryDevice::readData(char *data, qint64 maxSize)
+{
+    if (m_finished)
+        return -1;
+
+    m_stream.next_out = (Bytef *)data;
+    m_stream.avail_out = (uInt)qMin<qint64>(maxSize, 1 << 30);
+    while (m_stream.avail_out > 0) {
+        if (m_stream.avail_in == 0 && m_remaining > 0) {
+            if (m_mappedData) {
+                m_stream.next_in = (Bytef *)m_mappedData + m_offset;
+                m_stream.avail_in = (uInt)qMin<qint64>(m_remaining, 1 << 30);
+            } else {
+                m_device->seek(m_offset);
+                m_input = m_device->read(qMin<qint64>(m_remaining, 64 * 1024));
+                if (m_input.isEmpty()) {
+                    m_remaining = 0;
+                    continue;
+                }
+                m_stream.next_in = (Bytef *)m_input.data();
+                m_stream.avail_in = (uInt)m_input.size();
+            }
+            m_offset += m_stream.avail_in;
+            m_remaining -= m_stream.avail_in;
+        }
+
+        const int err = ::inflate(&m_stream, Z_NO_FLUSH);
+        if (err == Z_STREAM_END) {
+            m_finished = true;
+            break;
+        }
+        if (err != Z_OK) {
+            m_finished = true;
+            const bool truncated = err == Z_BUF_ERROR && m_stream.avail_in == 0 && m_remaining == 0;
+            setErrorString(truncated ? QStringLiteral("Unexpected end of compressed data")
+                                     : QStringLiteral("Compressed data is corrupted"));
+            qWarning() << "QZip:" << errorString();
+            break;
+        }
+    }
+
+    const qint64 produced = (char *)m_stream.next_out - data;
+    return produced > 0 || !m_finished ? produced : -1;
+}
+
 class MarbleZipWriterPrivate : public QZipPrivate
 {
 public:
@@ -510,6 +699,14 @@ void MarbleZipReaderPrivate::scanFiles()
     }
 
     dirtyFileTree = false;
+    fileIndex.clear();
+    if (QFile *file = qobject_cast<QFile *>(device)) {
+        // Entries are read straight from the mapping if the platform allows it
+        unmap();
+        mappedSize = file->size();
+        mappedData = mappedSize > 0 ? file->map(0, mappedSize) : nullptr;
+    }
+
     uchar tmp[4];
     device->read((char *)tmp, 4);
     if (readUInt(tmp) != 0x04034b50) {
@@ -581,6 +778,57 @@ void MarbleZipReaderPrivate::scanFiles()
         ZDEBUG("found file '%s'", header.file_name.data());
         fileHeaders.append(header);
     }
+
+    // the first of several entries with the same name wins, as in a linear search
+    fileIndex.reserve(fileHeaders.size());
+    for (int j = fileHeaders.size() - 1; j >= 0; --j)
+        fileIndex.insert(QString::fromLocal8Bit(fileHeaders.at(j).file_name), j);
+}
+
+bool MarbleZipReaderPrivate::locateEntry(const QString &fileName, EntryLocation &entry)
+{
+    scanFiles();
+    const int index = fileIndex.value(fileName, -1);
+    if (index < 0)
+        return false;
+
+    const FileHeader &header = fileHeaders.at(index);
+    entry.compressedSize = readUInt(header.h.compressed_size);
+    entry.size = readUInt(header.h.uncompressed_size);
+    const qint64 start = readUInt(header.h.offset_local_header);
+
+    LocalFileHeader lh;
+    if (mappedData) {
+        if (start + qint64(sizeof(LocalFileHeader)) > mappedSize) {
+            qWarning() << "QZip: local header beyond the end of the archive";
+            return false;
+        }
+        memcpy(&lh, mappedData + start, sizeof(LocalFileHeader));
+    } else {
+        device->seek(start);
+        if (device->read((char *)&lh, sizeof(LocalFileHeader)) != qint64(sizeof(LocalFileHeader)))
+            return false;
+    }
+    entry.offset = start + sizeof(LocalFileHeader) + readUShort(lh.file_name_length) + readUShort(lh.extra_field_length);
+    entry.method = readUShort(lh.compression_method);
+
+    if (mappedData && entry.offset + entry.compressedSize > mappedSize) {
+        qWarning() << "QZip: entry data beyond the end of the archive";
+        return false;
+    }
+    return true;
+}
+
+void MarbleZipReaderPrivate::unmap()
+{
+    if (mappedData) {
+        // closing the file already removed its mappings
+        QFile *file = qobject_cast<QFile *>(device);
+        if (file && file->isOpen())
+            file->unmap(mappedData);
+        mappedData = nullptr;
+        mappedSize = 0;
+    }
 }
 
 void MarbleZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const QByteArray &contents/*, QFile::Permissions permissions, QZip::Method m*/)
@@ -616,7 +864,13 @@ void MarbleZipWriterPrivate::addEntry(EntryType type, const QString &fileName, c
     writeUInt(header.h.uncompressed_size, contents.length());
     writeMSDosDate(header.h.last_mod_file, QDateTime::currentDateTime());
     QByteArray data = contents;
-    if (compression == MarbleZipWriter::AlwaysCompress) {
+    uint crc_32 = ::crc32(0, nullptr, 0);
+    bool hasCrc = false;
+    if (compression == MarbleZipWriter::AlwaysCompress && contents.length() > deflateChunkSize
+            && deflateParallel(&data, &crc_32, contents)) {
+        writeUShort(header.h.compression_method, 8);
+        hasCrc = true;
+    } else if (compression == MarbleZipWriter::AlwaysCompress) {
         writeUShort(header.h.compression_method, 8);
 
        ulong len = contents.length();
@@ -643,8 +897,8 @@ void MarbleZipWriterPrivate::addEntry(EntryType type, const QString &fileName, c
     }
 // TODO add a check if data.length() > contents.length().  Then try to store the original and revert the compression method to be uncompressed
     writeUInt(header.h.compressed_size, data.length());
-    uint crc_32 = ::crc32(0, nullptr, 0);
-    crc_32 = ::crc32(crc_32, (const uchar *)contents.constData(), contents.length());
+    if (!hasCrc)
+        crc_32 = ::crc32(crc_32, (const uchar *)contents.constData(), contents.length());
     writeUInt(header.h.crc_32, crc_32);
 
     header.file_name = fileName.toLocal8Bit();
@@ -862,48 +1116,36 @@ MarbleZipReader::FileInfo MarbleZipReader::entryInfoAt(int index) const
 */
 QByteArray MarbleZipReader::fileData(const QString &fileName) const
 {
-    d->scanFiles();
-    int i;
-    for (i = 0; i < d->fileHeaders.size(); ++i) {
-        if (QString::fromLocal8Bit(d->fileHeaders.at(i).file_name) == fileName)
-            break;
-    }
-    if (i == d->fileHeaders.size())
+    EntryLocation entry;
+    if (!d->locateEntry(fileName, entry))
         return QByteArray();
 
-    FileHeader header = d->fileHeaders.at(i);
-
-    int compressed_size = readUInt(header.h.compressed_size);
-    int uncompressed_size = readUInt(header.h.uncompressed_size);
-    int start = readUInt(header.h.offset_local_header);
-    //qDebug("uncompressing file %d: local header at %d", i, start);
-
-    d->device->seek(start);
-    LocalFileHeader lh;
-    d->device->read((char *)&lh, sizeof(LocalFileHeader));
-    uint skip = readUShort(lh.file_name_length) + readUShort(lh.extra_field_length);
-    d->device->seek(d->device->pos() + skip);
-
-    int compression_method = readUShort(lh.compression_method);
-    //qDebug("file=%s: compressed_size=%d, uncompressed_size=%d", fileName.toLocal8Bit().data(), compressed_size, uncompressed_size);
+    QByteArray compressed;
+    const uchar *source;
+    if (d->mappedData) {
+        source = d->mappedData + entry.offset;
+    } else {
+        d->device->seek(entry.offset);
+        compressed = d->device->read(entry.compressedSize);
+        entry.compressedSize = compressed.size();
+        source = (const uchar *)compressed.constData();
+    }
 
-    //qDebug("file at %lld", d->device->pos());
-    QByteArray compressed = d->device->read(compressed_size);
-    if (compression_method == 0) {
+    if (entry.method == 0) {
         // no compression
-        compressed.truncate(uncompressed_size);
-        return compressed;
-    } else if (compression_method == 8) {
+        if (!d->mappedData) {
+            compressed.truncate(entry.size);
+            return compressed;
+        }
+        return QByteArray((const char *)source, qMin(entry.compressedSize, entry.size));
+    } else if (entry.method == 8) {
         // Deflate
-        //qDebug("compressed=%d", compressed.size());
-        compressed.truncate(compressed_size);
         QByteArray baunzip;
-        ulong len = qMax(uncompressed_size,  1);
+        ulong len = qMax<qint64>(entry.size, 1);
         int res;
         do {
             baunzip.resize(len);
-            res = inflate((uchar*)baunzip.data(), &len,
-                          (uchar*)compressed.constData(), compressed_size);
+            res = inflate((uchar*)baunzip.data(), &len, source, entry.compressedSize);
 
             switch (res) {
             case Z_OK:
@@ -927,6 +1169,43 @@ QByteArray MarbleZipReader::fileData(const QString &fileName) const
     return QByteArray();
 }
 
+/*!
+    Returns a device reading the contents of \a fileName in the zip archive, or
+    nullptr if there is no such file. The caller takes ownership of the device.
+
+    Deflated entries are inflated while they are read, so only a small part of
+    the uncompressed contents is held in memory at a time. When the archive is
+    a local file it is memory mapped and stored entries are read in place
+    without being copied. The device must not be used once the reader is
+    closed or destroyed.
+*/
+QIODevice *MarbleZipReader::fileDevice(const QString &fileName) const
+{
+    EntryLocation entry;
+    if (!d->locateEntry(fileName, entry))
+        return nullptr;
+
+    QIODevice *result;
+    if (entry.method == 0) {
+        const int size = qMin<qint64>(qMin(entry.compressedSize, entry.size), INT_MAX);
+        QBuffer *buffer = new QBuffer;
+        if (d->mappedData) {
+            buffer->setData(QByteArray::fromRawData((const char *)d->mappedData + entry.offset, size));
+        } else {
+            d->device->seek(entry.offset);
+            buffer->setData(d->device->read(size));
+        }
+        result = buffer;
+    } else if (entry.method == 8) {
+        result = new MarbleZipEntryDevice(d->mappedData, d->device, entry);
+    } else {
+        qWarning() << "QZip: Unknown compression method";
+        return nullptr;
+    }
+    result->open(QIODevice::ReadOnly);
+    return result;
+}
+
 /*!
     Extracts the full contents of the zip file into \a destinationDir on
     the local filesystem.
@@ -1009,6 +1288,7 @@ MarbleZipReader::Status MarbleZipReader::status() const
 */
 void MarbleZipReader::close()
 {
+    d->unmap();
     d->device->close();
 }
 
@@ -34,6 +34,8 @@
 
 #include "GeoDataCoordinates.h"
 
+#include <QCache>
+#include <QMutex>
 #include <QPointer>
 #include <QPainter>
 #include <QPainterPath>
@@ -45,12 +47,36 @@ class Q_DECL_HIDDEN MergedLayerDecorator::Private
 public:
     Private( TileLoader *tileLoader, const SunLocator *sunLocator );
 
+    /**
+     * The texture tiles of a stacked tile which do not depend on the position of
+     * the sun, merged into one image. Ground overlays are included if all tiles
+     * are independent of the sun.
+     */
+    struct MergedTile
+    {
+        QImage image;
+        QVector<QSharedPointer<TextureTile> > tiles;
+    };
+
+    enum Daylight {
+        Day,
+        Night,
+        Twilight
+    };
+
     static int maxDivisor( int maximum, int fullLength );
+    static int sunIndependentTileCount( const QVector<QSharedPointer<TextureTile> > &tiles );
 
     StackedTile *createTile( const QVector<QSharedPointer<TextureTile> > &tiles ) const;
+    void mergeTiles( QImage *resultImage, const QVector<QSharedPointer<TextureTile> > &tiles,
+                     int begin, int end, bool withConversion ) const;
+    QVector<QSharedPointer<TextureTile> > cachedTiles( const TileId &stackedTileId,
+                                                       const QVector<const GeoSceneTextureTileDataset *> &textureLayers ) const;
+    void clearMergedTiles();
 
     void renderGroundOverlays( QImage *tileImage, const QVector<QSharedPointer<TextureTile> > &tiles ) const;
     void paintSunShading( QImage *tileImage, const TileId &id ) const;
+    Daylight daylight( const TileId &id, const QSize &tileSize, qreal sunLon, qreal sunLat ) const;
     void paintTileId( QImage *tileImage, const TileId &id ) const;
 
     void detectMaxTileLevel();
@@ -68,6 +94,13 @@ public:
     bool m_showSunShading;
     bool m_showCityLights;
     bool m_showTileId;
+    // The sun position all tiles are shaded for, in degrees
+    qreal m_sunLon;
+    qreal m_sunLat;
+
+    // Lets a change of the sun position reuse the merged texture tiles
+    mutable QMutex m_mergedTilesMutex;
+    mutable QCache<TileId, MergedTile> m_mergedTiles;
 };
 
 MergedLayerDecorator::Private::Private( TileLoader *tileLoader, const SunLocator *sunLocator ) :
@@ -81,7 +114,10 @@ MergedLayerDecorator::Private::Private( TileLoader *tileLoader, const SunLocator
     m_levelZeroRows( 0 ),
     m_showSunShading( false ),
     m_showCityLights( false ),
-    m_showTileId( false )
+    m_showTileId( false ),
+    m_sunLon( sunLocator->getLon() ),
+    m_sunLat( sunLocator->getLat() ),
+    m_mergedTiles( 32 * 1024 * 1024 )
 {
 }
 
@@ -107,6 +143,7 @@ void MergedLayerDecorator::setTextureLayers( const QVector<const GeoSceneTexture
     }
 
     d->m_textureLayers = textureLayers;
+    d->clearMergedTiles();
 
     d->detectMaxTileLevel();
 }
@@ -114,6 +151,7 @@ void MergedLayerDecorator::setTextureLayers( const QVector<const GeoSceneTexture
 void MergedLayerDecorator::updateGroundOverlays(const QList<const GeoDataGroundOverlay *> &groundOverlays )
 {
     d->m_groundOverlays = groundOverlays;
+    d->clearMergedTiles();
 }
 
 
@@ -172,7 +210,60 @@ StackedTile *MergedLayerDecorator::Private::createTile( const QVector<QSharedPoi
     // if there are more than one active texture layers, we have to convert the
     // result tile into QImage::Format_ARGB32_Premultiplied to make blending possible
     const bool withConversion = tiles.count() > 1 || m_showSunShading || m_showTileId || !m_groundOverlays.isEmpty();
-    for ( const QSharedPointer<TextureTile> &tile: tiles ) {
+
+    // The tiles below the first one shaded by the sun are merged once and then
+    // kept, so that a moving sun only requires to redo the shading.
+    const int sunIndependentCount = sunIndependentTileCount( tiles );
+    const bool sunDependent = sunIndependentCount < tiles.count() || ( m_showSunShading && !m_showCityLights );
+
+    bool merged = false;
+    if ( sunDependent ) {
+        QMutexLocker locker( &m_mergedTilesMutex );
+        const MergedTile *const mergedTile = m_mergedTiles.object( id );
+        if ( mergedTile && mergedTile->tiles == tiles.mid( 0, sunIndependentCount ) ) {
+            resultImage = mergedTile->image;
+            merged = true;
+        }
+    }
+
+    if ( !merged ) {
+        mergeTiles( &resultImage, tiles, 0, sunIndependentCount, withConversion );
+
+        if ( sunIndependentCount == tiles.count() ) {
+            renderGroundOverlays( &resultImage, tiles );
+        }
+
+        if ( sunDependent ) {
+            MergedTile *const mergedTile = new MergedTile;
+            mergedTile->image = resultImage;
+            mergedTile->tiles = tiles.mid( 0, sunIndependentCount );
+
+            QMutexLocker locker( &m_mergedTilesMutex );
+            m_mergedTiles.insert( id, mergedTile, resultImage.byteCount() );
+        }
+    }
+
+    if ( sunIndependentCount < tiles.count() ) {
+        mergeTiles( &resultImage, tiles, sunIndependentCount, tiles.count(), withConversion );
+        renderGroundOverlays( &resultImage, tiles );
+    }
+
+    if ( m_showSunShading && !m_showCityLights ) {
+        paintSunShading( &resultImage, id );
+    }
+
+    if ( m_showTileId ) {
+        paintTileId( &resultImage, id );
+    }
+
+    return new StackedTile( id, resultImage, tiles );
+}
+
+void MergedLayerDecorator::Private::mergeTiles( QImage *resultImage, const QVector<QSharedPointer<TextureTile> > &tiles,
+                                                int begin, int end, bool withConversion ) const
+{
+    for ( int i = begin; i < end; ++i ) {
+        const QSharedPointer<TextureTile> &tile = tiles.at( i );
 
         // Image blending. If there are several images in the same tile (like clouds
         // or hillshading images over the map) blend them all into only one image
@@ -182,33 +273,53 @@ StackedTile *MergedLayerDecorator::Private::createTile( const QVector<QSharedPoi
 
             mDebug() << Q_FUNC_INFO << "blending";
 
-            if ( resultImage.isNull() ) {
-                resultImage = QImage( tile->image()->size(), QImage::Format_ARGB32_Premultiplied );
+            if ( resultImage->isNull() ) {
+                *resultImage = QImage( tile->image()->size(), QImage::Format_ARGB32_Premultiplied );
             }
 
-            blending->blend( &resultImage, tile.data() );
+            blending->blend( resultImage, tile.data() );
         }
         else {
             mDebug() << Q_FUNC_INFO << "no blending defined => copying top over bottom image";
             if ( withConversion ) {
-                resultImage = tile->image()->convertToFormat( QImage::Format_ARGB32_Premultiplied );
+                *resultImage = tile->image()->convertToFormat( QImage::Format_ARGB32_Premultiplied );
             } else {
-                resultImage = tile->image()->copy();
+                *resultImage = tile->image()->copy();
             }
         }
     }
+}
 
-    renderGroundOverlays( &resultImage, tiles );
-
-    if ( m_showSunShading && !m_showCityLights ) {
-        paintSunShading( &resultImage, id );
+QVector<QSharedPointer<TextureTile> > MergedLayerDecorator::Private::cachedTiles( const TileId &stackedTileId,
+                                                                                  const QVector<const GeoSceneTextureTileDataset *> &textureLayers ) const
+{
+    QMutexLocker locker( &m_mergedTilesMutex );
+    const MergedTile *const mergedTile = m_mergedTiles.object( stackedTileId );
+    if ( !mergedTile || mergedTile->tiles.count() > textureLayers.count() ) {
+        return QVector<QSharedPointer<TextureTile> >();
     }
 
-    if ( m_showTileId ) {
-        paintTileId( &resultImage, id );
+    for ( int i = 0; i < mergedTile->tiles.count(); ++i ) {
+        const GeoSceneTextureTileDataset *const layer = textureLayers.at( i );
+        const TextureTile *const tile = mergedTile->tiles.at( i ).data();
+        const TileId tileId( layer->sourceDir(), stackedTileId.zoomLevel(),
+                             stackedTileId.x(), stackedTileId.y() );
+        if ( !( tile->id() == tileId ) || tile->blending() != m_blendingFactory.findBlending( layer->blending() ) ) {
+            return QVector<QSharedPointer<TextureTile> >();
+        }
+        // Scaled placeholders and expired tiles are loaded again to get them updated
+        if ( TileLoader::tileStatus( layer, tileId ) != TileLoader::Available ) {
+            return QVector<QSharedPointer<TextureTile> >();
+        }
     }
 
-    return new StackedTile( id, resultImage, tiles );
+    return mergedTile->tiles;
+}
+
+void MergedLayerDecorator::Private::clearMergedTiles()
+{
+    QMutexLocker locker( &m_mergedTilesMutex );
+    m_mergedTiles.clear();
 }
 
 void MergedLayerDecorator::Private::renderGroundOverlays( QImage *tileImage, const QVector<QSharedPointer<TextureTile> > &tiles ) const
@@ -236,8 +347,10 @@ void MergedLayerDecorator::Private::renderGroundOverlays( QImage *tileImage, con
         const qreal pixelToLat = tileLatLonBox.height() / tileImage->height();
         const qreal pixelToLon = tileLatLonBox.width() / tileImage->width();
 
-        const qreal latToPixel = overlay->icon().height() / overlayLatLonBox.height();
-        const qreal lonToPixel = overlay->icon().width() / overlayLatLonBox.width();
+        // Loaded on demand, so this has to happen before the threads start
+        const QImage icon = overlay->icon();
+        const qreal latToPixel = icon.height() / overlayLatLonBox.height();
+        const qreal lonToPixel = icon.width() / overlayLatLonBox.width();
 
         const qreal  global_height = tileImage->height()
                 * TileLoaderHelper::levelToRow( m_levelZeroRows, tileId.zoomLevel() );
@@ -247,63 +360,67 @@ void MergedLayerDecorator::Private::renderGroundOverlays( QImage *tileImage, con
         qreal latPixelPosition = rad2Pixel/2 * gdInv(tileLatLonBox.north());
         const bool isMercatorTileProjection = (m_textureLayers.at( 0 )->tileProjectionType() ==  GeoSceneAbstractTileProjection::Mercator);
 
-        for ( int y = 0; y < tileImage->height(); ++y ) {
-             QRgb *scanLine = ( QRgb* ) ( tileImage->scanLine( y ) );
+        Blending::blendRows( tileImage, [&]( int yTop, int yBottom ) {
+            for ( int y = yTop; y < yBottom; ++y ) {
+                 QRgb *scanLine = ( QRgb* ) ( tileImage->scanLine( y ) );
 
-             const qreal lat = isMercatorTileProjection
-                     ? gd(2 * (latPixelPosition - y) * pixel2Rad )
-                     : tileLatLonBox.north() - y * pixelToLat;
+                 const qreal lat = isMercatorTileProjection
+                         ? gd(2 * (latPixelPosition - y) * pixel2Rad )
+                         : tileLatLonBox.north() - y * pixelToLat;
 
-             for ( int x = 0; x < tileImage->width(); ++x, ++scanLine ) {
-                 qreal lon = GeoDataCoordinates::normalizeLon( tileLatLonBox.west() + x * pixelToLon );
+                 for ( int x = 0; x < tileImage->width(); ++x, ++scanLine ) {
+                     qreal lon = GeoDataCoordinates::normalizeLon( tileLatLonBox.west() + x * pixelToLon );
 
-                 GeoDataCoordinates coords(lon, lat);
-                 GeoDataCoordinates rotatedCoords(coords);
+                     GeoDataCoordinates coords(lon, lat);
+                     GeoDataCoordinates rotatedCoords(coords);
 
-                 if (overlay->latLonBox().rotation() != 0) {
-                    // Possible TODO: Make this faster by creating the axisMatrix beforehand
-                    // and just call Quaternion::rotateAroundAxis(const matrix &m) here.
-                    rotatedCoords = coords.rotateAround(overlayLatLonBox.center(), -overlay->latLonBox().rotation());
-                 }
+                     if (overlay->latLonBox().rotation() != 0) {
+                        // Possible TODO: Make this faster by creating the axisMatrix beforehand
+                        // and just call Quaternion::rotateAroundAxis(const matrix &m) here.
+                        rotatedCoords = coords.rotateAround(overlayLatLonBox.center(), -overlay->latLonBox().rotation());
+                     }
 
-                 // TODO: The rotated latLonBox is bigger. We need to take this into account.
-                 // (Currently the GroundOverlay sometimes gets clipped because of that)
-                 if ( overlay->latLonBox().contains( rotatedCoords ) ) {
-
-                     qreal px = GeoDataLatLonBox::width( rotatedCoords.longitude(), overlayLatLonBox.west() ) * lonToPixel;
-                     qreal py = (qreal)( overlay->icon().height() ) - ( GeoDataLatLonBox::height( rotatedCoords.latitude(), overlayLatLonBox.south() ) * latToPixel ) - 1;
-
-                     if ( px >= 0 && px < overlay->icon().width() && py >= 0 && py < overlay->icon().height() ) {
-                         int alpha = qAlpha( overlay->icon().pixel( px, py ) );
-                         if ( alpha != 0 )
-                         {
-                            QRgb result = ImageF::pixelF( overlay->icon(), px, py );
-
-                            if (alpha == 255)
-                            {
-                                *scanLine = result;
-                            }
-                            else
-                            {
-                                *scanLine = qRgb( ( alpha * qRed(result) + (255 - alpha) * qRed(*scanLine) ) / 255,
-                                            ( alpha * qGreen(result) + (255 - alpha) * qGreen(*scanLine) ) / 255,
-                                            ( alpha * qBlue(result) + (255 - alpha) * qBlue(*scanLine) ) / 255 );
-                            }
+                     // TODO: The rotated latLonBox is bigger. We need to take this into account.
+                     // (Currently the GroundOverlay sometimes gets clipped because of that)
+                     if ( overlay->latLonBox().contains( rotatedCoords ) ) {
+
+                         qreal px = GeoDataLatLonBox::width( rotatedCoords.longitude(), overlayLatLonBox.west() ) * lonToPixel;
+                         qreal py = (qreal)( icon.height() ) - ( GeoDataLatLonBox::height( rotatedCoords.latitude(), overlayLatLonBox.south() ) * latToPixel ) - 1;
+
+                         if ( px >= 0 && px < icon.width() && py >= 0 && py < icon.height() ) {
+                             int alpha = qAlpha( icon.pixel( px, py ) );
+                             if ( alpha != 0 )
+                             {
+                                QRgb result = ImageF::pixelF( icon, px, py );
+
+                                if (alpha == 255)
+                                {
+                                    *scanLine = result;
+                                }
+                                else
+                                {
+                                    *scanLine = qRgb( ( alpha * qRed(result) + (255 - alpha) * qRed(*scanLine) ) / 255,
+                                                ( alpha * qGreen(result) + (255 - alpha) * qGreen(*scanLine) ) / 255,
+                                                ( alpha * qBlue(result) + (255 - alpha) * qBlue(*scanLine) ) / 255 );
+                                }
+                             }
                          }
                      }
                  }
-             }
-        }
+            }
+        } );
     }
 }
 
 StackedTile *MergedLayerDecorator::loadTile( const TileId &stackedTileId )
 {
     const QVector<const GeoSceneTextureTileDataset *> textureLayers = d->findRelevantTextureLayers( stackedTileId );
-    QVector<QSharedPointer<TextureTile> > tiles;
+    // Tiles merged before are not loaded again
+    QVector<QSharedPointer<TextureTile> > tiles = d->cachedTiles( stackedTileId, textureLayers );
     tiles.reserve(textureLayers.size());
 
-    for ( const GeoSceneTextureTileDataset *layer: textureLayers ) {
+    for ( int i = tiles.size(); i < textureLayers.size(); ++i ) {
+        const GeoSceneTextureTileDataset *layer = textureLayers.at( i );
         const TileId tileId( layer->sourceDir(), stackedTileId.zoomLevel(),
                              stackedTileId.x(), stackedTileId.y() );
 
@@ -380,6 +497,40 @@ StackedTile *MergedLayerDecorator::updateTile( const StackedTile &stackedTile, c
     return d->createTile( tiles );
 }
 
+void MergedLayerDecorator::discardMergedTile( const TileId &stackedTileId )
+{
+    QMutexLocker locker( &d->m_mergedTilesMutex );
+    d->m_mergedTiles.remove( stackedTileId );
+}
+
+bool MergedLayerDecorator::sunShadingChanged( const StackedTile &stackedTile ) const
+{
+    const bool sunShading = ( d->m_showSunShading && !d->m_showCityLights )
+            || d->sunIndependentTileCount( stackedTile.tiles() ) < stackedTile.tiles().count();
+    if ( !sunShading ) {
+        return false;
+    }
+
+    const QSize tileSize = stackedTile.resultImage()->size();
+    const Private::Daylight shaded = d->daylight( stackedTile.id(), tileSize, d->m_sunLon, d->m_sunLat );
+    if ( shaded == Private::Twilight ) {
+        return true;
+    }
+
+    return shaded != d->daylight( stackedTile.id(), tileSize, d->m_sunLocator->getLon(), d->m_sunLocator->getLat() );
+}
+
+StackedTile *MergedLayerDecorator::updateSunShading( const StackedTile &stackedTile )
+{
+    return d->createTile( stackedTile.tiles() );
+}
+
+void MergedLayerDecorator::updateSunPosition()
+{
+    d->m_sunLon = d->m_sunLocator->getLon();
+    d->m_sunLat = d->m_sunLocator->getLat();
+}
+
 void MergedLayerDecorator::downloadStackedTile( const TileId &id, DownloadUsage usage )
 {
     const QVector<const GeoSceneTextureTileDataset *> textureLayers = d->findRelevantTextureLayers( id );
@@ -394,6 +545,8 @@ void MergedLayerDecorator::downloadStackedTile( const TileId &id, DownloadUsage
 void MergedLayerDecorator::setShowSunShading( bool show )
 {
     d->m_showSunShading = show;
+    d->clearMergedTiles();
+    updateSunPosition();
 }
 
 bool MergedLayerDecorator::showSunShading() const
@@ -404,6 +557,7 @@ bool MergedLayerDecorator::showSunShading() const
 void MergedLayerDecorator::setShowCityLights( bool show )
 {
     d->m_showCityLights = show;
+    d->clearMergedTiles();
 }
 
 bool MergedLayerDecorator::showCityLights() const
@@ -436,65 +590,118 @@ void MergedLayerDecorator::Private::paintSunShading( QImage *tileImage, const Ti
     const int n = maxDivisor( 30, tileWidth );
     const int ipRight = n * (int)( tileWidth / n );
 
-    for ( int cur_y = 0; cur_y < tileHeight; ++cur_y ) {
-        const qreal lat = lat_scale * ( id.y() * tileHeight + cur_y ) - 0.5*M_PI;
-        const qreal a = sin( (lat+DEG2RAD * m_sunLocator->getLat() )/2.0 );
-        const qreal c = cos(lat)*cos( -DEG2RAD * m_sunLocator->getLat() );
+    Blending::blendRows( tileImage, [&]( int yTop, int yBottom ) {
+        for ( int cur_y = yTop; cur_y < yBottom; ++cur_y ) {
+            const qreal lat = lat_scale * ( id.y() * tileHeight + cur_y ) - 0.5*M_PI;
+            const qreal a = sin( (lat+DEG2RAD * m_sunLocator->getLat() )/2.0 );
+            const qreal c = cos(lat)*cos( -DEG2RAD * m_sunLocator->getLat() );
 
-        QRgb* scanline = (QRgb*)tileImage->scanLine( cur_y );
+            QRgb* scanline = (QRgb*)tileImage->scanLine( cur_y );
 
-        qreal lastShade = -10.0;
+            qreal lastShade = -10.0;
 
-        int cur_x = 0;
+            int cur_x = 0;
 
-        while ( cur_x < tileWidth ) {
+            while ( cur_x < tileWidth ) {
 
-            const bool interpolate = ( cur_x != 0 && cur_x < ipRight && cur_x + n < tileWidth );
+                const bool interpolate = ( cur_x != 0 && cur_x < ipRight && cur_x + n < tileWidth );
 
-            qreal shade = 0;
+                qreal shade = 0;
 
-            if ( interpolate ) {
-                const int check = cur_x + n;
-                const qreal checklon   = lon_scale * ( id.x() * tileWidth + check );
-                shade = m_sunLocator->shading( checklon, a, c );
+                if ( interpolate ) {
+                    const int check = cur_x + n;
+                    const qreal checklon   = lon_scale * ( id.x() * tileWidth + check );
+                    shade = m_sunLocator->shading( checklon, a, c );
 
-                // if the shading didn't change across the interpolation
-                // interval move on and don't change anything.
-                if ( shade == lastShade && shade == 1.0 ) {
-                    scanline += n;
-                    cur_x += n;
-                    continue;
-                }
-                if ( shade == lastShade && shade == 0.0 ) {
-                    for ( int t = 0; t < n; ++t ) {
+                    // if the shading didn't change across the interpolation
+                    // interval move on and don't change anything.
+                    if ( shade == lastShade && shade == 1.0 ) {
+                        scanline += n;
+                        cur_x += n;
+                        continue;
+                    }
+                    if ( shade == lastShade && shade == 0.0 ) {
+                        for ( int t = 0; t < n; ++t ) {
+                            SunLocator::shadePixel(*scanline, shade);
+                            ++scanline;
+                        }
+                        cur_x += n;
+                        continue;
+                    }
+                    for ( int t = 0; t < n ; ++t ) {
+                        const qreal lon   = lon_scale * ( id.x() * tileWidth + cur_x );
+                        shade = m_sunLocator->shading( lon, a, c );
                         SunLocator::shadePixel(*scanline, shade);
                         ++scanline;
+                        ++cur_x;
                     }
-                    cur_x += n;
-                    continue;
-                }
-                for ( int t = 0; t < n ; ++t ) {
-                    const qreal lon   = lon_scale * ( id.x() * tileWidth + cur_x );
-                    shade = m_sunLocator->shading( lon, a, c );
-                    SunLocator::shadePixel(*scanline, shade);
-                    ++scanline;
-                    ++cur_x;
                 }
-            }
 
-            else {
-                // Make sure we don't exceed the image memory
-                if ( cur_x < tileWidth ) {
-                    const qreal lon   = lon_scale * ( id.x() * tileWidth + cur_x );
-                    shade = m_sunLocator->shading( lon, a, c );
-                    SunLocator::shadePixel(*scanline, shade);
-                    ++scanline;
-                    ++cur_x;
+                else {
+                    // Make sure we don't exceed the image memory
+                    if ( cur_x < tileWidth ) {
+                        const qreal lon   = lon_scale * ( id.x() * tileWidth + cur_x );
+                        shade = m_sunLocator->shading( lon, a, c );
+                        SunLocator::shadePixel(*scanline, shade);
+                        ++scanline;
+                        ++cur_x;
+                    }
                 }
+                lastShade = shade;
             }
-            lastShade = shade;
+        }
+    } );
+}
+
+MergedLayerDecorator::Private::Daylight MergedLayerDecorator::Private::daylight( const TileId &id, const QSize &tileSize, qreal sunLon, qreal sunLat ) const
+{
+    // Same geometry as in paintSunShading()
+    const qreal  global_width  = tileSize.width()
+            * TileLoaderHelper::levelToColumn( m_levelZeroColumns, id.zoomLevel() );
+    const qreal  global_height = tileSize.height()
+            * TileLoaderHelper::levelToRow( m_levelZeroRows, id.zoomLevel() );
+    const qreal lon_scale = 2*M_PI / global_width;
+    const qreal lat_scale = -M_PI / global_height;
+    const int tileHeight = tileSize.height();
+    const int tileWidth = tileSize.width();
+
+    // SunLocator::shading() measures the longitude from the current position of the
+    // sun, so the tile is moved by as much as the sun has moved since sunLon.
+    const qreal currentSunLon = DEG2RAD * m_sunLocator->getLon();
+    const qreal lonOffset = currentSunLon - DEG2RAD * sunLon;
+    const qreal west = lon_scale * ( id.x() * tileWidth ) + lonOffset;
+    const qreal east = lon_scale * ( id.x() * tileWidth + tileWidth - 1 ) + lonOffset;
+
+    // Within each row the shading is monotonic in the distance to the sun's
+    // meridian, so it is darkest and brightest at one of these longitudes.
+    QVector<qreal> lons;
+    lons << west << east;
+    for ( const qreal extreme: { currentSunLon, currentSunLon + M_PI } ) {
+        const qreal lon = extreme + 2*M_PI * ceil( ( west - extreme ) / ( 2*M_PI ) );
+        if ( lon <= east ) {
+            lons << lon;
+        }
+    }
+
+    bool day = true;
+    bool night = true;
+    for ( int cur_y = 0; cur_y < tileHeight && ( day || night ); ++cur_y ) {
+        const qreal lat = lat_scale * ( id.y() * tileHeight + cur_y ) - 0.5*M_PI;
+        const qreal a = sin( (lat+DEG2RAD * sunLat )/2.0 );
+        const qreal c = cos(lat)*cos( -DEG2RAD * sunLat );
+
+        for ( const qreal lon: lons ) {
+            const qreal shade = m_sunLocator->shading( lon, a, c );
+            day = day && shade == 1.0;
+            night = night && shade == 0.0;
         }
     }
+
+    if ( day ) {
+        return Day;
+    }
+
+    return night ? Night : Twilight;
 }
 
 void MergedLayerDecorator::Private::paintTileId( QImage *tileImage, const TileId &id ) const
@@ -595,6 +802,18 @@ QVector<const GeoSceneTextureTileDataset *> MergedLayerDecorator::Private::findR
     return result;
 }
 
+int MergedLayerDecorator::Private::sunIndependentTileCount( const QVector<QSharedPointer<TextureTile> > &tiles )
+{
+    for ( int i = 0; i < tiles.count(); ++i ) {
+        const Blending *const blending = tiles.at( i )->blending();
+        if ( blending && blending->dependsOnSun() ) {
+            return i;
+        }
+    }
+
+    return tiles.count();
+}
+
 // TODO: This should likely go into a math class in the future ...
 
 int MergedLayerDecorator::Private::maxDivisor( int maximum, int fullLength )
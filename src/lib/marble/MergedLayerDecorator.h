@@ -67,6 +67,29 @@ class MergedLayerDecorator
 
     StackedTile *updateTile( const StackedTile &stackedTile, const TileId &tileId, const QImage &tileImage );
 
+    /**
+     * Forgets the texture tiles kept merged for the stacked tile @p stackedTileId.
+     * Has to be called whenever one of its texture tiles changed.
+     */
+    void discardMergedTile( const TileId &stackedTileId );
+
+    /**
+     * Returns whether the sun shading of @p stackedTile differs between the sun
+     * position all tiles were shaded for and the current one. Tiles entirely on
+     * the day side or entirely on the night side at both positions stay the same.
+     */
+    bool sunShadingChanged( const StackedTile &stackedTile ) const;
+
+    /**
+     * Returns a copy of @p stackedTile shaded for the current sun position.
+     */
+    StackedTile *updateSunShading( const StackedTile &stackedTile );
+
+    /**
+     * Takes the current sun position as the one all tiles are shaded for.
+     */
+    void updateSunPosition();
+
     void downloadStackedTile( const TileId &id, DownloadUsage usage );
 
     void setShowSunShading( bool show );
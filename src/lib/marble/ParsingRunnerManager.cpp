@@ -43,13 +43,15 @@ public:
     QMutex m_parsingTasksMutex;
     int m_parsingTasks;
     GeoDataDocument *m_fileResult;
+    QThreadPool *m_threadPool;
 };
 
 ParsingRunnerManager::Private::Private( ParsingRunnerManager *parent, const PluginManager *pluginManager ) :
     q( parent ),
     m_pluginManager( pluginManager ),
     m_parsingTasks(0),
-    m_fileResult( nullptr )
+    m_fileResult( nullptr ),
+    m_threadPool( QThreadPool::globalInstance() )
 {
     qRegisterMetaType<GeoDataDocument*>( "GeoDataDocument*" );
 }
@@ -89,15 +91,26 @@ void ParsingRunnerManager::parseFile( const QString &fileName, DocumentRole role
     const QString suffix = fileInfo.suffix().toLower();
     const QString completeSuffix = fileInfo.completeSuffix().toLower();
 
+    // With an up to date snapshot a single task is enough, it only needs
+    // to parse the file itself if the snapshot turns out to be unusable
+    const bool useSnapshot = DocumentSnapshot::isCacheable( fileName );
+    const bool singleTask = useSnapshot && DocumentSnapshot::isUpToDate( fileName );
+
     d->m_parsingTasks = 0;
     for( const ParseRunnerPlugin *plugin: plugins ) {
         QStringList const extensions = plugin->fileExtensions();
+        if ( singleTask && extensions.isEmpty() ) {
+            continue;
+        }
         if ( extensions.isEmpty() || extensions.contains( suffix ) || extensions.contains( completeSuffix ) ) {
-            ParsingTask *task = new ParsingTask( plugin->newRunner(), this, fileName, role );
+            ParsingTask *task = new ParsingTask( plugin->newRunner(), this, fileName, role, useSnapshot );
             connect( task, SIGNAL(finished()), this, SLOT(cleanupParsingTask()) );
             mDebug() << "parse task " << plugin->nameId() << " " << (quintptr)task;
             ++d->m_parsingTasks;
-            QThreadPool::globalInstance()->start( task );
+            d->m_threadPool->start( task );
+            if ( singleTask ) {
+                break;
+            }
         }
     }
 
@@ -123,6 +136,11 @@ GeoDataDocument *ParsingRunnerManager::openFile( const QString &fileName, Docume
     return d->m_fileResult;
 }
 
+void ParsingRunnerManager::setThreadPool( QThreadPool *threadPool )
+{
+    d->m_threadPool = threadPool ? threadPool : QThreadPool::globalInstance();
+}
+
 void ParsingRunnerManager::Private::addParsingResult(GeoDataDocument *document, const QString &error)
 {
     if ( document || !error.isEmpty() ) {
@@ -19,6 +19,8 @@
 
 #include "GeoDataDocument.h"
 
+class QThreadPool;
+
 namespace Marble
 {
 
@@ -48,6 +50,12 @@ public:
     void parseFile( const QString &fileName, DocumentRole role = UserDocument );
     GeoDataDocument *openFile( const QString &fileName, DocumentRole role = UserDocument, int timeout = 30000 );
 
+    /**
+     * Run the parsing tasks in the given thread pool instead of the global one.
+     * The pool is not owned and must outlive all parsing tasks started.
+     */
+    void setThreadPool( QThreadPool *threadPool );
+
 Q_SIGNALS:
     /**
      * The file was parsed and potential error message
@@ -34,6 +34,7 @@
 #include "MarbleClock.h"
 #include "MarblePlacemarkModel.h"
 #include "MarbleDirs.h"
+#include "MarbleTrace.h"
 #include "ViewportParams.h"
 #include "TileId.h"
 #include "TileCoordsPyramid.h"
@@ -355,6 +356,7 @@ QSet<TileId> PlacemarkLayout::visibleTiles(const ViewportParams &viewport, int z
 
 QVector<VisiblePlacemark *> PlacemarkLayout::generateLayout( const ViewportParams *viewport, int tileLevel )
 {
+    MarbleTraceScope traceScope( "PlacemarkLayout", "layout" );
     m_runtimeTrace.clear();
     if ( m_placemarkModel->rowCount() <= 0 ) {
         clearCache();
@@ -14,13 +14,23 @@
 #include "PluginManager.h"
 
 // Qt
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
 #include <QPluginLoader>
 #include <QElapsedTimer>
+#include <QHash>
 #include <QMessageBox>
+#include <QMutex>
+#include <QSaveFile>
+#include <QSet>
+#include <QThread>
 
 // Local dir
 #include "MarbleDirs.h"
 #include "MarbleDebug.h"
+#include "MarbleGlobal.h"
+#include "MarbleTrace.h"
 #include "RenderPlugin.h"
 #include "PositionProviderPlugin.h"
 #include "ParseRunnerPlugin.h"
@@ -29,24 +39,76 @@
 #include "SearchRunnerPlugin.h"
 #include <config-marble.h>
 
+namespace
+{
+    const quint32 pluginIndexMagicNumber = 0x504c4758; // "PLGX"
+    const qint32 pluginIndexVersion = 1;
+}
+
 namespace Marble
 {
 
+/**
+ * The kinds of plugins a plugin library provides, kept in an index on disk so
+ * that only the libraries needed by the plugin lists asked for are loaded.
+ */
+struct PluginIndexEntry
+{
+    QDateTime modified;
+    qint64 size;
+    quint32 categories;
+};
+
+QDataStream &operator<<( QDataStream &stream, const PluginIndexEntry &entry )
+{
+    stream << entry.modified << entry.size << entry.categories;
+    return stream;
+}
+
+QDataStream &operator>>( QDataStream &stream, PluginIndexEntry &entry )
+{
+    stream >> entry.modified >> entry.size >> entry.categories;
+    return stream;
+}
+
 class PluginManagerPrivate
 {
  public:
+    enum PluginCategory {
+        RenderCategory = 0x1,
+        PositionProviderCategory = 0x2,
+        SearchRunnerCategory = 0x4,
+        ReverseGeocodingRunnerCategory = 0x8,
+        RoutingRunnerCategory = 0x10,
+        ParseRunnerCategory = 0x20
+    };
+
     PluginManagerPrivate(PluginManager* parent)
-            : m_pluginsLoaded(false),
+            : m_loadedCategories(0),
+              m_pluginIndexLoaded(false),
+              m_pluginIndexChanged(false),
               m_parent(parent)
     {
     }
 
     ~PluginManagerPrivate();
 
-    void loadPlugins();
-    bool addPlugin(QObject *obj, const QPluginLoader *loader);
-
-    bool m_pluginsLoaded;
+    void loadPlugins( quint32 categories );
+    quint32 loadPluginFiles( quint32 categories );
+    quint32 addPlugin(QObject *obj, const QPluginLoader *loader);
+    void emitPluginsChanged( quint32 categories );
+
+    static QString pluginIndexPath();
+    void loadPluginIndex();
+    void savePluginIndex();
+
+    // Plugin lists are asked for from parsing threads as well
+    QMutex m_mutex;
+    quint32 m_loadedCategories;
+    bool m_pluginIndexLoaded;
+    bool m_pluginIndexChanged;
+    QHash<QString, PluginIndexEntry> m_pluginIndex;
+    QSet<QString> m_processedFiles;
     QList<const RenderPlugin *> m_renderPluginTemplates;
     QList<const PositionProviderPlugin *> m_positionProviderPluginTemplates;
     QList<const SearchRunnerPlugin *> m_searchRunnerPlugins;
@@ -86,79 +148,103 @@ PluginManager::~PluginManager()
 
 QList<const RenderPlugin *> PluginManager::renderPlugins() const
 {
-    d->loadPlugins();
+    d->loadPlugins( PluginManagerPrivate::RenderCategory );
+    QMutexLocker locker( &d->m_mutex );
     return d->m_renderPluginTemplates;
 }
 
 void PluginManager::addRenderPlugin( const RenderPlugin *plugin )
 {
-    d->loadPlugins();
-    d->m_renderPluginTemplates << plugin;
+    d->loadPlugins( PluginManagerPrivate::RenderCategory );
+    {
+        QMutexLocker locker( &d->m_mutex );
+        d->m_renderPluginTemplates << plugin;
+    }
     emit renderPluginsChanged();
 }
 
 QList<const PositionProviderPlugin *> PluginManager::positionProviderPlugins() const
 {
-    d->loadPlugins();
+    d->loadPlugins( PluginManagerPrivate::PositionProviderCategory );
+    QMutexLocker locker( &d->m_mutex );
     return d->m_positionProviderPluginTemplates;
 }
 
 void PluginManager::addPositionProviderPlugin( const PositionProviderPlugin *plugin )
 {
-    d->loadPlugins();
-    d->m_positionProviderPluginTemplates << plugin;
+    d->loadPlugins( PluginManagerPrivate::PositionProviderCategory );
+    {
+        QMutexLocker locker( &d->m_mutex );
+        d->m_positionProviderPluginTemplates << plugin;
+    }
     emit positionProviderPluginsChanged();
 }
 
 QList<const SearchRunnerPlugin *> PluginManager::searchRunnerPlugins() const
 {
-    d->loadPlugins();
+    d->loadPlugins( PluginManagerPrivate::SearchRunnerCategory );
+    QMutexLocker locker( &d->m_mutex );
     return d->m_searchRunnerPlugins;
 }
 
 void PluginManager::addSearchRunnerPlugin( const SearchRunnerPlugin *plugin )
 {
-    d->loadPlugins();
-    d->m_searchRunnerPlugins << plugin;
+    d->loadPlugins( PluginManagerPrivate::SearchRunnerCategory );
+    {
+        QMutexLocker locker( &d->m_mutex );
+        d->m_searchRunnerPlugins << plugin;
+    }
     emit searchRunnerPluginsChanged();
 }
 
 QList<const ReverseGeocodingRunnerPlugin *> PluginManager::reverseGeocodingRunnerPlugins() const
 {
-    d->loadPlugins();
+    d->loadPlugins( PluginManagerPrivate::ReverseGeocodingRunnerCategory );
+    QMutexLocker locker( &d->m_mutex );
     return d->m_reverseGeocodingRunnerPlugins;
 }
 
 void PluginManager::addReverseGeocodingRunnerPlugin( const ReverseGeocodingRunnerPlugin *plugin )
 {
-    d->loadPlugins();
-    d->m_reverseGeocodingRunnerPlugins << plugin;
+    d->loadPlugins( PluginManagerPrivate::ReverseGeocodingRunnerCategory );
+    {
+        QMutexLocker locker( &d->m_mutex );
+        d->m_reverseGeocodingRunnerPlugins << plugin;
+    }
     emit reverseGeocodingRunnerPluginsChanged();
 }
 
 QList<RoutingRunnerPlugin *> PluginManager::routingRunnerPlugins() const
 {
-    d->loadPlugins();
+    d->loadPlugins( PluginManagerPrivate::RoutingRunnerCategory );
+    QMutexLocker locker( &d->m_mutex );
     return d->m_routingRunnerPlugins;
 }
 
 void PluginManager::addRoutingRunnerPlugin( RoutingRunnerPlugin *plugin )
 {
-    d->loadPlugins();
-    d->m_routingRunnerPlugins << plugin;
+    d->loadPlugins( PluginManagerPrivate::RoutingRunnerCategory );
+    {
+        QMutexLocker locker( &d->m_mutex );
+        d->m_routingRunnerPlugins << plugin;
+    }
     emit routingRunnerPluginsChanged();
 }
 
 QList<const ParseRunnerPlugin *> PluginManager::parsingRunnerPlugins() const
 {
-    d->loadPlugins();
+    d->loadPlugins( PluginManagerPrivate::ParseRunnerCategory );
+    QMutexLocker locker( &d->m_mutex );
     return d->m_parsingRunnerPlugins;
 }
 
 void PluginManager::addParseRunnerPlugin( const ParseRunnerPlugin *plugin )
 {
-    d->loadPlugins();
-    d->m_parsingRunnerPlugins << plugin;
+    d->loadPlugins( PluginManagerPrivate::ParseRunnerCategory );
+    {
+        QMutexLocker locker( &d->m_mutex );
+        d->m_parsingRunnerPlugins << plugin;
+    }
     emit parseRunnerPluginsChanged();
 }
 
@@ -189,51 +275,141 @@ bool appendPlugin( QObject * obj, const QPluginLoader *loader, QList<Plugin> &pl
     return false;
 }
 
-bool PluginManagerPrivate::addPlugin(QObject *obj, const QPluginLoader *loader)
+quint32 PluginManagerPrivate::addPlugin(QObject *obj, const QPluginLoader *loader)
 {
-    bool isPlugin = appendPlugin<RenderPluginInterface>
-                ( obj, loader, m_renderPluginTemplates );
-    isPlugin = isPlugin || appendPlugin<PositionProviderPluginInterface>
-                ( obj, loader, m_positionProviderPluginTemplates );
-    isPlugin = isPlugin || appendPlugin<SearchRunnerPlugin>
-                ( obj, loader, m_searchRunnerPlugins );
-    isPlugin = isPlugin || appendPlugin<ReverseGeocodingRunnerPlugin>
-                ( obj, loader, m_reverseGeocodingRunnerPlugins );
-    isPlugin = isPlugin || appendPlugin<RoutingRunnerPlugin>
-                ( obj, loader, m_routingRunnerPlugins );
-    isPlugin = isPlugin || appendPlugin<ParseRunnerPlugin>
-                ( obj, loader, m_parsingRunnerPlugins );
-    if ( !isPlugin ) {
+    quint32 categories = 0;
+    if ( appendPlugin<RenderPluginInterface>( obj, loader, m_renderPluginTemplates ) ) {
+        categories = RenderCategory;
+    } else if ( appendPlugin<PositionProviderPluginInterface>( obj, loader, m_positionProviderPluginTemplates ) ) {
+        categories = PositionProviderCategory;
+    } else if ( appendPlugin<SearchRunnerPlugin>( obj, loader, m_searchRunnerPlugins ) ) {
+        categories = SearchRunnerCategory;
+    } else if ( appendPlugin<ReverseGeocodingRunnerPlugin>( obj, loader, m_reverseGeocodingRunnerPlugins ) ) {
+        categories = ReverseGeocodingRunnerCategory;
+    } else if ( appendPlugin<RoutingRunnerPlugin>( obj, loader, m_routingRunnerPlugins ) ) {
+        categories = RoutingRunnerCategory;
+    } else if ( appendPlugin<ParseRunnerPlugin>( obj, loader, m_parsingRunnerPlugins ) ) {
+        categories = ParseRunnerCategory;
+    }
+    if ( !categories ) {
         qWarning() << "Ignoring the following plugin since it couldn't be loaded:" << (loader ? loader->fileName() : "<static>");
         mDebug() << "Plugin failure:" << (loader ? loader->fileName() : "<static>") << "is a plugin, but it does not implement the "
                 << "right interfaces or it was compiled against an old version of Marble. Ignoring it.";
     }
-    return isPlugin;
+    return categories;
 }
 
-void PluginManagerPrivate::loadPlugins()
+QString PluginManagerPrivate::pluginIndexPath()
 {
-    if (m_pluginsLoaded)
-    {
+    return MarbleDirs::localPath() + QLatin1String( "/cache/plugins.index" );
+}
+
+void PluginManagerPrivate::loadPluginIndex()
+{
+    m_pluginIndexLoaded = true;
+
+    QFile file( pluginIndexPath() );
+    if ( !file.open( QIODevice::ReadOnly ) ) {
+        return;
+    }
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_5_6 );
+
+    quint32 magic;
+    qint32 version;
+    quint32 marbleVersion;
+    stream >> magic >> version >> marbleVersion;
+    // Plugins built against another version of Marble may no longer load
+    if ( magic != pluginIndexMagicNumber || version != pluginIndexVersion || marbleVersion != MARBLE_VERSION ) {
+        return;
+    }
+
+    QHash<QString, PluginIndexEntry> index;
+    stream >> index;
+    if ( stream.status() != QDataStream::Ok ) {
+        mDebug() << "Ignoring corrupt plugin index" << file.fileName();
+        return;
+    }
+
+    m_pluginIndex = index;
+}
+
+void PluginManagerPrivate::savePluginIndex()
+{
+    if ( !m_pluginIndexChanged ) {
         return;
     }
+    m_pluginIndexChanged = false;
 
+    const QString path = pluginIndexPath();
+    QDir().mkpath( QFileInfo( path ).path() );
+
+    QSaveFile file( path );
+    if ( !file.open( QIODevice::WriteOnly ) ) {
+        mDebug() << "Cannot write plugin index" << path;
+        return;
+    }
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_5_6 );
+    stream << pluginIndexMagicNumber << pluginIndexVersion << quint32( MARBLE_VERSION ) << m_pluginIndex;
+    file.commit();
+}
+
+void PluginManagerPrivate::emitPluginsChanged( quint32 categories )
+{
+    if ( categories & RenderCategory ) {
+        emit m_parent->renderPluginsChanged();
+    }
+    if ( categories & PositionProviderCategory ) {
+        emit m_parent->positionProviderPluginsChanged();
+    }
+    if ( categories & SearchRunnerCategory ) {
+        emit m_parent->searchRunnerPluginsChanged();
+    }
+    if ( categories & ReverseGeocodingRunnerCategory ) {
+        emit m_parent->reverseGeocodingRunnerPluginsChanged();
+    }
+    if ( categories & RoutingRunnerCategory ) {
+        emit m_parent->routingRunnerPluginsChanged();
+    }
+    if ( categories & ParseRunnerCategory ) {
+        emit m_parent->parseRunnerPluginsChanged();
+    }
+}
+
+void PluginManagerPrivate::loadPlugins( quint32 categories )
+{
+    quint32 changedCategories = 0;
+    {
+        QMutexLocker locker( &m_mutex );
+        if ( ( m_loadedCategories & categories ) == categories ) {
+            return;
+        }
+        changedCategories = loadPluginFiles( categories );
+    }
+
+    // Outside of the lock, receivers may ask for the plugin lists again
+    emitPluginsChanged( changedCategories );
+}
+
+quint32 PluginManagerPrivate::loadPluginFiles( quint32 categories )
+{
     QElapsedTimer t;
     t.start();
     mDebug() << "Starting to load Plugins.";
 
-    QStringList pluginFileNameList = MarbleDirs::pluginEntryList( "", QDir::Files );
-
-    MarbleDirs::debug();
+    const bool firstLoad = !m_pluginIndexLoaded;
+    if ( firstLoad ) {
+        loadPluginIndex();
+        MarbleDirs::debug();
+    }
 
-    Q_ASSERT( m_renderPluginTemplates.isEmpty() );
-    Q_ASSERT( m_positionProviderPluginTemplates.isEmpty() );
-    Q_ASSERT( m_searchRunnerPlugins.isEmpty() );
-    Q_ASSERT( m_reverseGeocodingRunnerPlugins.isEmpty() );
-    Q_ASSERT( m_routingRunnerPlugins.isEmpty() );
-    Q_ASSERT( m_parsingRunnerPlugins.isEmpty() );
+    QStringList pluginFileNameList = MarbleDirs::pluginEntryList( "", QDir::Files );
 
     bool foundPlugin = false;
+    quint32 addedCategories = 0;
     for( const QString &fileName: pluginFileNameList ) {
         QString const baseName = QFileInfo(fileName).baseName();
         if (!m_whitelist.isEmpty() && !m_whitelist.contains(baseName)) {
@@ -255,32 +431,82 @@ void PluginManagerPrivate::loadPlugins()
             continue;
         }
 #endif
-        QPluginLoader* loader = new QPluginLoader( path, m_parent );
+        if ( m_processedFiles.contains( path ) ) {
+            if ( m_pluginIndex.value( path ).categories ) {
+                foundPlugin = true;
+            }
+            continue;
+        }
+
+        // Skip libraries known to provide none of the requested plugins
+        const QFileInfo fileInfo( path );
+        QHash<QString, PluginIndexEntry>::const_iterator const indexed = m_pluginIndex.constFind( path );
+        if ( indexed != m_pluginIndex.constEnd()
+             && indexed->modified == fileInfo.lastModified()
+             && indexed->size == fileInfo.size() ) {
+            if ( indexed->categories ) {
+                foundPlugin = true;
+            }
+            if ( !( indexed->categories & categories ) ) {
+                continue;
+            }
+        }
+
+        m_processedFiles << path;
+
+        const qint64 traceStart = MarbleTrace::isEnabled() ? MarbleTrace::timestamp() : -1;
+        QElapsedTimer loadTime;
+        loadTime.start();
+
+        // The loader may run in any thread, the plugins belong to the thread
+        // of the plugin manager
+        QPluginLoader* loader = new QPluginLoader( path );
 
         QObject * obj = loader->instance();
 
+        quint32 pluginCategories = 0;
         if ( obj ) {
-            bool isPlugin = addPlugin(obj, loader);
-            if (!isPlugin) {
+            pluginCategories = addPlugin(obj, loader);
+            if (!pluginCategories) {
                 delete loader;
             } else {
                 foundPlugin = true;
+                addedCategories |= pluginCategories;
+                if ( obj->thread() != m_parent->thread() ) {
+                    obj->moveToThread( m_parent->thread() );
+                }
+                loader->moveToThread( m_parent->thread() );
+                loader->setParent( m_parent );
             }
         } else {
             qWarning() << "Ignoring to load the following file since it doesn't look like a valid Marble plugin:" << path << endl
                        << "Reason:" << loader->errorString();
             delete loader;
         }
+
+        mDebug() << "Loading" << baseName << "took" << loadTime.elapsed() << "ms";
+        if ( traceStart >= 0 ) {
+            MarbleTrace::addEvent( MarbleTrace::internedName( baseName ), "plugin",
+                                   traceStart, MarbleTrace::timestamp() - traceStart );
+        }
+
+        PluginIndexEntry &entry = m_pluginIndex[path];
+        entry.modified = fileInfo.lastModified();
+        entry.size = fileInfo.size();
+        entry.categories = pluginCategories;
+        m_pluginIndexChanged = true;
     }
 
-    const auto staticPlugins = QPluginLoader::staticInstances();
-    for (auto obj : staticPlugins) {
-        if (addPlugin(obj, nullptr)) {
-            foundPlugin = true;
+    if ( firstLoad ) {
+        const auto staticPlugins = QPluginLoader::staticInstances();
+        for (auto obj : staticPlugins) {
+            if (addPlugin(obj, nullptr)) {
+                foundPlugin = true;
+            }
         }
     }
 
-    if ( !foundPlugin ) {
+    if ( !foundPlugin && firstLoad ) {
 #ifdef Q_OS_WIN
         QString pluginPaths = "Plugin Path: " + MarbleDirs::marblePluginPath();
         if ( MarbleDirs::marblePluginPath().isEmpty() )
@@ -298,9 +524,13 @@ void PluginManagerPrivate::loadPlugins()
 #endif
     }
 
-    m_pluginsLoaded = true;
+    m_loadedCategories |= categories;
+    savePluginIndex();
 
     mDebug() << Q_FUNC_INFO << "Time elapsed:" << t.elapsed() << "ms";
+
+    // The requested plugins are returned to the caller, others were found on the way
+    return addedCategories & ~categories;
 }
 
 #ifdef Q_OS_ANDROID
@@ -39,6 +39,10 @@ class ParseRunnerPlugin;
  * the objects, the PluginManager internally has a list of the plugins
  * which are owned by the PluginManager and destroyed by it.
  *
+ * The plugin lists may be asked for from any thread. Plugins are loaded on
+ * first use and belong to the thread of the PluginManager. Plugins found
+ * while loading those of another kind are announced by the corresponding
+ * changed signal.
  */
 
 class MARBLE_EXPORT PluginManager : public QObject
@@ -96,6 +96,16 @@ const GeoDataExtendedData RoutingRunner::routeData(qreal length, const QTime& du
     return result;
 }
 
+const GeoDataExtendedData RoutingRunner::routeData( qreal length, const QTime &duration, qint64 durationSeconds ) const
+{
+    GeoDataExtendedData result = routeData( length, duration );
+    GeoDataData secondsData;
+    secondsData.setName(QStringLiteral("durationSeconds"));
+    secondsData.setValue( durationSeconds );
+    result.addValue( secondsData );
+    return result;
+}
+
 }
 
 #include "moc_RoutingRunner.cpp"
@@ -51,6 +51,8 @@ protected:
     const QString lengthString( qreal length ) const;
     const QString durationString( const QTime &duration ) const;
     const GeoDataExtendedData routeData( qreal length, const QTime &duration ) const;
+    /** Like above, additionally keeps the duration in seconds as a QTime wraps at 24 hours */
+    const GeoDataExtendedData routeData( qreal length, const QTime &duration, qint64 durationSeconds ) const;
 };
 
 }
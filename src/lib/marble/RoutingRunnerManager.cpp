@@ -17,13 +17,20 @@
 #include "MarbleModel.h"
 #include "Planet.h"
 #include "GeoDataDocument.h"
+#include "GeoDataExtendedData.h"
+#include "GeoDataData.h"
+#include "GeoDataPlacemark.h"
 #include "PluginManager.h"
 #include "RoutingRunnerPlugin.h"
 #include "RunnerTask.h"
 #include "routing/RouteRequest.h"
 #include "routing/RoutingProfilesModel.h"
 
+#include <QAtomicInt>
+#include <QHash>
+#include <QThread>
 #include <QThreadPool>
+#include <QTime>
 #include <QTimer>
 
 namespace Marble
@@ -41,27 +48,52 @@ public:
     template<typename T>
     QList<T*> plugins( const QList<T*> &plugins ) const;
 
+    RoutingRunnerPlugin *batchPlugin( const RoutingProfile &profile ) const;
+
     void addRoutingResult( GeoDataDocument *route );
     void cleanupRoutingTask( RoutingTask *task );
 
+    void startBatch( const QVector<const RouteRequest*> &requests, const QVector<RouteRequest*> &ownedRequests );
+    QVector<GeoDataDocument*> searchRoutes( const QVector<const RouteRequest*> &requests,
+                                            const QVector<RouteRequest*> &ownedRequests, int timeout );
+    void addBatchRoutingResult( int generation, int index, GeoDataDocument *route );
+    void cleanupBatchRoutingTask( int generation );
+
+    static void copyRequests( const QVector<const RouteRequest*> &requests,
+                              QVector<const RouteRequest*> &batch, QVector<RouteRequest*> &copies );
+    static bool routeMetrics( const GeoDataDocument *route, qreal &length, qreal &duration );
+
     RoutingRunnerManager *const q;
     const MarbleModel *const m_marbleModel;
     const PluginManager *const m_pluginManager;
     QList<RoutingTask*> m_routingTasks;
     QVector<GeoDataDocument*> m_routingResult;
+    QVector<GeoDataDocument*> m_batchResult;
+    /// Incremented for each batch and on timeouts, tasks of older batches stop early
+    QAtomicInt m_batchGeneration;
+    QHash<int, int> m_pendingBatchTasks;
+    QHash<int, QVector<RouteRequest*> > m_batchRequests;
+    QThreadPool m_batchThreadPool;
 };
 
 RoutingRunnerManager::Private::Private( RoutingRunnerManager *parent, const MarbleModel *marbleModel ) :
     q( parent ),
     m_marbleModel( marbleModel ),
-    m_pluginManager( marbleModel->pluginManager() )
+    m_pluginManager( marbleModel->pluginManager() ),
+    m_batchGeneration( 0 )
 {
     qRegisterMetaType<GeoDataDocument*>( "GeoDataDocument*" );
+    m_batchThreadPool.setMaxThreadCount( qMax( 1, QThread::idealThreadCount() ) );
 }
 
 RoutingRunnerManager::Private::~Private()
 {
-    // nothing to do
+    // Running batch tasks still use the requests owned by the manager
+    m_batchGeneration.ref();
+    m_batchThreadPool.waitForDone();
+    for ( const QVector<RouteRequest*> &requests: m_batchRequests ) {
+        qDeleteAll( requests );
+    }
 }
 
 template<typename T>
@@ -88,6 +120,26 @@ QList<T*> RoutingRunnerManager::Private::plugins( const QList<T*> &plugins ) con
     return result;
 }
 
+RoutingRunnerPlugin *RoutingRunnerManager::Private::batchPlugin( const RoutingProfile &profile ) const
+{
+    RoutingRunnerPlugin *result = nullptr;
+    for( RoutingRunnerPlugin* plugin: plugins( m_pluginManager->routingRunnerPlugins() ) ) {
+        if ( !profile.name().isEmpty() && !profile.pluginSettings().contains( plugin->nameId() ) ) {
+            continue;
+        }
+
+        if ( plugin->canWorkOffline() ) {
+            return plugin;
+        }
+
+        if ( !result ) {
+            result = plugin;
+        }
+    }
+
+    return result;
+}
+
 void RoutingRunnerManager::Private::addRoutingResult( GeoDataDocument *route )
 {
     if ( route ) {
@@ -110,6 +162,132 @@ void RoutingRunnerManager::Private::cleanupRoutingTask( RoutingTask *task )
     }
 }
 
+void RoutingRunnerManager::Private::startBatch( const QVector<const RouteRequest*> &requests,
+                                                const QVector<RouteRequest*> &ownedRequests )
+{
+    const int generation = m_batchGeneration.fetchAndAddOrdered( 1 ) + 1;
+    m_batchResult.fill( nullptr, requests.size() );
+
+    RoutingRunnerPlugin *plugin = requests.isEmpty() ? nullptr : batchPlugin( requests.first()->routingProfile() );
+    if ( !plugin ) {
+        mDebug() << "No suitable routing plugin found, cannot retrieve routes";
+        qDeleteAll( ownedRequests );
+        emit q->batchRoutingFinished();
+        return;
+    }
+
+    // Use a few chunks per thread to balance out queries of differing cost
+    const int taskCount = qMin( requests.size(), 4 * m_batchThreadPool.maxThreadCount() );
+    const int chunkSize = ( requests.size() + taskCount - 1 ) / taskCount;
+    QList<BatchRoutingTask*> tasks;
+    for ( int first = 0; first < requests.size(); first += chunkSize ) {
+        BatchRoutingTask* task = new BatchRoutingTask( plugin->newRunner(), q, requests.mid( first, chunkSize ), first,
+                                                       generation, &m_batchGeneration );
+        QObject::connect( task, SIGNAL(finished(int)), q, SLOT(cleanupBatchRoutingTask(int)) );
+        tasks << task;
+    }
+
+    m_pendingBatchTasks.insert( generation, tasks.size() );
+    if ( !ownedRequests.isEmpty() ) {
+        m_batchRequests.insert( generation, ownedRequests );
+    }
+
+    mDebug() << "batch routing" << requests.size() << "requests with" << plugin->nameId()
+             << "in" << tasks.size() << "tasks";
+    for( BatchRoutingTask* task: tasks ) {
+        m_batchThreadPool.start( task );
+    }
+}
+
+QVector<GeoDataDocument*> RoutingRunnerManager::Private::searchRoutes( const QVector<const RouteRequest*> &requests,
+                                                                       const QVector<RouteRequest*> &ownedRequests,
+                                                                       int timeout )
+{
+    QEventLoop localEventLoop;
+    QTimer watchdog;
+    watchdog.setSingleShot(true);
+    QObject::connect( &watchdog, SIGNAL(timeout()),
+                      &localEventLoop, SLOT(quit()));
+    QObject::connect( q, SIGNAL(batchRoutingFinished()),
+                      &localEventLoop, SLOT(quit()), Qt::QueuedConnection );
+
+    watchdog.start( timeout );
+    startBatch( requests, ownedRequests );
+    localEventLoop.exec();
+
+    // Routes arriving after the timeout are deleted rather than handed out
+    m_batchGeneration.ref();
+    return m_batchResult;
+}
+
+void RoutingRunnerManager::Private::addBatchRoutingResult( int generation, int index, GeoDataDocument *route )
+{
+    if ( generation != m_batchGeneration.loadAcquire() ) {
+        delete route;
+        return;
+    }
+
+    if ( index >= 0 && index < m_batchResult.size() ) {
+        m_batchResult[index] = route;
+    }
+
+    emit q->batchRouteRetrieved( index, route );
+}
+
+void RoutingRunnerManager::Private::cleanupBatchRoutingTask( int generation )
+{
+    if ( --m_pendingBatchTasks[generation] > 0 ) {
+        return;
+    }
+
+    m_pendingBatchTasks.remove( generation );
+    qDeleteAll( m_batchRequests.take( generation ) );
+    if ( generation == m_batchGeneration.loadAcquire() ) {
+        emit q->batchRoutingFinished();
+    }
+}
+
+void RoutingRunnerManager::Private::copyRequests( const QVector<const RouteRequest*> &requests,
+                                                  QVector<const RouteRequest*> &batch, QVector<RouteRequest*> &copies )
+{
+    batch.reserve( requests.size() );
+    copies.reserve( requests.size() );
+    for ( const RouteRequest *request: requests ) {
+        RouteRequest *copy = new RouteRequest;
+        copy->setRoutingProfile( request->routingProfile() );
+        for ( int i = 0; i < request->size(); ++i ) {
+            copy->append( (*request)[i] );
+            copy->setVisited( i, request->visited( i ) );
+        }
+        batch << copy;
+        copies << copy;
+    }
+}
+
+bool RoutingRunnerManager::Private::routeMetrics( const GeoDataDocument *route, qreal &length, qreal &duration )
+{
+    if ( !route ) {
+        return false;
+    }
+
+    for ( const GeoDataPlacemark *placemark: route->placemarkList() ) {
+        const GeoDataExtendedData &data = placemark->extendedData();
+        if ( data.contains( QStringLiteral( "length" ) ) && data.contains( QStringLiteral( "duration" ) ) ) {
+            length = data.value( QStringLiteral( "length" ) ).value().toReal();
+            if ( data.contains( QStringLiteral( "durationSeconds" ) ) ) {
+                duration = data.value( QStringLiteral( "durationSeconds" ) ).value().toReal();
+            } else {
+                // A QTime can't hold routes of a day or longer, only used for runners not providing seconds
+                const QTime time = QTime::fromString( data.value( QStringLiteral( "duration" ) ).value().toString(), Qt::ISODate );
+                duration = time.isValid() ? QTime( 0, 0 ).secsTo( time ) : -1;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
 RoutingRunnerManager::RoutingRunnerManager( const MarbleModel *marbleModel, QObject *parent )
     : QObject( parent ),
       d( new Private( this, marbleModel ) )
@@ -168,6 +346,56 @@ QVector<GeoDataDocument*> RoutingRunnerManager::searchRoute( const RouteRequest
     return d->m_routingResult;
 }
 
+void RoutingRunnerManager::retrieveRoutes( const QVector<const RouteRequest *> &requests )
+{
+    // Tasks may still run after the caller deleted its requests, they work on copies
+    QVector<const RouteRequest*> batch;
+    QVector<RouteRequest*> copies;
+    Private::copyRequests( requests, batch, copies );
+    d->startBatch( batch, copies );
+}
+
+QVector<GeoDataDocument*> RoutingRunnerManager::searchRoutes( const QVector<const RouteRequest *> &requests, int timeout )
+{
+    // Tasks keep running after a timeout, they work on copies of the requests
+    QVector<const RouteRequest*> batch;
+    QVector<RouteRequest*> copies;
+    Private::copyRequests( requests, batch, copies );
+    return d->searchRoutes( batch, copies, timeout );
+}
+
+void RoutingRunnerManager::searchRouteMatrix( const QVector<GeoDataCoordinates> &origins,
+                                              const QVector<GeoDataCoordinates> &destinations,
+                                              const RoutingProfile &profile,
+                                              QVector<qreal> &lengths, QVector<qreal> &durations,
+                                              int timeout )
+{
+    QVector<RouteRequest*> requests;
+    QVector<const RouteRequest*> batch;
+    requests.reserve( origins.size() * destinations.size() );
+    batch.reserve( origins.size() * destinations.size() );
+    for ( const GeoDataCoordinates &origin: origins ) {
+        for ( const GeoDataCoordinates &destination: destinations ) {
+            RouteRequest *request = new RouteRequest;
+            request->setRoutingProfile( profile );
+            request->append( origin );
+            request->append( destination );
+            requests << request;
+            batch << request;
+        }
+    }
+
+    // The requests are deleted once the tasks using them are done, even after a timeout
+    const QVector<GeoDataDocument*> routes = d->searchRoutes( batch, requests, timeout );
+
+    lengths.fill( -1, batch.size() );
+    durations.fill( -1, batch.size() );
+    for ( int i = 0; i < routes.size(); ++i ) {
+        Private::routeMetrics( routes[i], lengths[i], durations[i] );
+        delete routes[i];
+    }
+}
+
 }
 
 #include "moc_RoutingRunnerManager.cpp"
@@ -21,9 +21,11 @@
 namespace Marble
 {
 
+class GeoDataCoordinates;
 class GeoDataDocument;
 class MarbleModel;
 class RouteRequest;
+class RoutingProfile;
 class RoutingTask;
 
 class MARBLE_EXPORT RoutingRunnerManager : public QObject
@@ -50,6 +52,40 @@ public:
     void retrieveRoute( const RouteRequest *request );
     QVector<GeoDataDocument *> searchRoute( const RouteRequest *request, int timeout = 30000 );
 
+    /**
+     * Calculate one route for each of the given route requests.
+     *
+     * In contrast to @see retrieveRoute only a single routing plugin is used,
+     * preferring plugins that work offline. The requests are split into chunks
+     * which are processed in parallel on all available cores, each chunk with
+     * one runner instance so that runners can keep their search state between
+     * queries. All requests are expected to share the routing profile of the
+     * first one. The requests are copied, so they may be deleted as soon as
+     * the call returns.
+     * @see retrieveRoutes is asynchronous with results returned using the
+     * @see batchRouteRetrieved signal.
+     * @see searchRoutes is blocking and returns the routes in request order,
+     * with a null pointer for each request that could not be routed.
+     * @see batchRoutingFinished signal indicates all requests are finished.
+     */
+    void retrieveRoutes( const QVector<const RouteRequest *> &requests );
+    QVector<GeoDataDocument *> searchRoutes( const QVector<const RouteRequest *> &requests, int timeout = 30000 );
+
+    /**
+     * Calculate the length and duration of the routes between each origin and
+     * each destination (a many-to-many distance matrix). Both result vectors are
+     * resized to origins.size() * destinations.size() and are stored row major,
+     * i.e. the route from origins[i] to destinations[j] is found at
+     * index i * destinations.size() + j. Lengths are given in meters, durations
+     * in seconds. Pairs that could not be routed are set to -1.
+     * This method is blocking.
+     */
+    void searchRouteMatrix( const QVector<GeoDataCoordinates> &origins,
+                            const QVector<GeoDataCoordinates> &destinations,
+                            const RoutingProfile &profile,
+                            QVector<qreal> &lengths, QVector<qreal> &durations,
+                            int timeout = 30000 );
+
 Q_SIGNALS:
     /**
      * A route was retrieved
@@ -61,9 +97,22 @@ Q_SIGNALS:
      */
     void routingFinished();
 
+    /**
+     * The route for the request at the given index of a batch was retrieved.
+     * The route is a null pointer if the request could not be routed.
+     */
+    void batchRouteRetrieved( int index, GeoDataDocument *route );
+
+    /**
+     * Emitted whenever all requests of a batch are finished
+     */
+    void batchRoutingFinished();
+
 private:
     Q_PRIVATE_SLOT( d, void addRoutingResult( GeoDataDocument *route ) )
     Q_PRIVATE_SLOT( d, void cleanupRoutingTask( RoutingTask *task ) )
+    Q_PRIVATE_SLOT( d, void addBatchRoutingResult( int generation, int index, GeoDataDocument *route ) )
+    Q_PRIVATE_SLOT( d, void cleanupBatchRoutingTask( int generation ) )
 
     class Private;
     friend class Private;
@@ -11,7 +11,9 @@
 
 #include "RunnerTask.h"
 
+#include "DocumentSnapshot.h"
 #include "MarbleDebug.h"
+#include "MarbleTrace.h"
 #include "ParsingRunner.h"
 #include "ParsingRunnerManager.h"
 #include "SearchRunner.h"
@@ -79,20 +81,73 @@ void RoutingTask::run()
     emit finished( this );
 }
 
-ParsingTask::ParsingTask( ParsingRunner *runner, ParsingRunnerManager *manager, const QString& fileName, DocumentRole role ) :
+BatchRoutingTask::BatchRoutingTask( RoutingRunner *runner, RoutingRunnerManager *manager, const QVector<const RouteRequest*> &routeRequests, int firstIndex,
+                                    int generation, const QAtomicInt *currentGeneration ) :
+    QObject(),
+    m_runner( runner ),
+    m_routeRequests( routeRequests ),
+    m_firstIndex( firstIndex ),
+    m_generation( generation ),
+    m_currentGeneration( currentGeneration ),
+    m_route( nullptr )
+{
+    // Runners emit their result synchronously from within retrieveRoute(), so
+    // a direct connection lets us pick it up before the next request starts
+    connect( m_runner, SIGNAL(routeCalculated(GeoDataDocument*)),
+             this, SLOT(storeRoute(GeoDataDocument*)), Qt::DirectConnection );
+    connect( this, SIGNAL(routeRetrieved(int,int,GeoDataDocument*)),
+             manager, SLOT(addBatchRoutingResult(int,int,GeoDataDocument*)) );
+}
+
+void BatchRoutingTask::run()
+{
+    for ( int i = 0; i < m_routeRequests.size(); ++i ) {
+        if ( m_currentGeneration->loadAcquire() != m_generation ) {
+            // the batch was superseded or timed out
+            break;
+        }
+        m_route = nullptr;
+        m_runner->retrieveRoute( m_routeRequests[i] );
+        emit routeRetrieved( m_generation, m_firstIndex + i, m_route );
+    }
+    m_runner->deleteLater();
+
+    emit finished( m_generation );
+}
+
+void BatchRoutingTask::storeRoute( GeoDataDocument *route )
+{
+    if ( m_route ) {
+        // only the first route per request is kept
+        delete route;
+        return;
+    }
+
+    m_route = route;
+}
+
+ParsingTask::ParsingTask( ParsingRunner *runner, ParsingRunnerManager *manager, const QString& fileName, DocumentRole role, bool useSnapshot ) :
     QObject(),
     m_runner( runner ),
     m_fileName( fileName ),
     m_role( role ),
-    m_manager(manager)
+    m_manager(manager),
+    m_useSnapshot( useSnapshot )
 {
     connect(this, SIGNAL(parsed(GeoDataDocument*,QString)), m_manager, SLOT(addParsingResult(GeoDataDocument*,QString)));
 }
 
 void ParsingTask::run()
 {
+    MarbleTraceScope traceScope( "ParseFile", "parsing" );
     QString error;
-    GeoDataDocument* document = m_runner->parseFile( m_fileName, m_role, error );
+    GeoDataDocument* document = m_useSnapshot ? DocumentSnapshot::load( m_fileName, m_role ) : nullptr;
+    if ( !document ) {
+        document = m_runner->parseFile( m_fileName, m_role, error );
+        if ( document && m_useSnapshot ) {
+            DocumentSnapshot::save( m_fileName, document );
+        }
+    }
     emit parsed(document, error);
     m_runner->deleteLater();
     emit finished();
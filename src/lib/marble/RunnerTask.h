@@ -15,8 +15,10 @@
 #include "GeoDataDocument.h"
 #include "GeoDataLatLonBox.h"
 
+#include <QAtomicInt>
 #include <QRunnable>
 #include <QString>
+#include <QVector>
 
 namespace Marble
 {
@@ -97,13 +99,52 @@ private:
     const RouteRequest *const m_routeRequest;
 };
 
+/** A RunnerTask that executes a series of route calculations with a single runner */
+class BatchRoutingTask : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param firstIndex The batch index of the first of the given route requests
+     * @param generation The batch the task belongs to
+     * @param currentGeneration The current batch, the task stops once it differs from @p generation
+     */
+    BatchRoutingTask( RoutingRunner *runner, RoutingRunnerManager *manager, const QVector<const RouteRequest*> &routeRequests, int firstIndex,
+                      int generation, const QAtomicInt *currentGeneration );
+
+    /**
+     * @reimp
+     */
+    void run() override;
+
+Q_SIGNALS:
+    void routeRetrieved( int generation, int index, GeoDataDocument *route );
+    void finished( int generation );
+
+private Q_SLOTS:
+    void storeRoute( GeoDataDocument *route );
+
+private:
+    RoutingRunner *const m_runner;
+    const QVector<const RouteRequest*> m_routeRequests;
+    const int m_firstIndex;
+    const int m_generation;
+    const QAtomicInt *const m_currentGeneration;
+    GeoDataDocument *m_route;
+};
+
 /** A RunnerTask that executes a file Parsing */
 class ParsingTask : public QObject, public QRunnable
 {
     Q_OBJECT
 
 public:
-    ParsingTask( ParsingRunner *runner, ParsingRunnerManager *manager, const QString& fileName, DocumentRole role );
+    /**
+     * @param useSnapshot Restore the document from its snapshot if one is up to date,
+     * otherwise store a snapshot of the parsed document. @see DocumentSnapshot
+     */
+    ParsingTask( ParsingRunner *runner, ParsingRunnerManager *manager, const QString& fileName, DocumentRole role, bool useSnapshot = false );
 
     /**
      * @reimp
@@ -119,6 +160,7 @@ private:
     QString m_fileName;
     DocumentRole m_role;
     ParsingRunnerManager* m_manager;
+    bool m_useSnapshot;
 };
 
 }
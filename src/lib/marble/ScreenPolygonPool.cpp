@@ -0,0 +1,86 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ScreenPolygonPool.h"
+
+#include <QPolygonF>
+
+namespace Marble
+{
+
+namespace {
+
+// Enough for the polygons of a dense vector tile view
+const int maximumPoolSize = 4096;
+// Polygons holding on to more memory are rare, don't hoard it
+const int maximumPolygonCapacity = 65536;
+// Points kept by the polygons of a pool, 16 MiB per thread
+const qint64 maximumPoolPoints = 1024 * 1024;
+
+class PolygonFreeList
+{
+public:
+    PolygonFreeList() :
+        m_points( 0 )
+    {
+    }
+
+    ~PolygonFreeList()
+    {
+        qDeleteAll( m_polygons );
+    }
+
+    QVector<QPolygonF*> m_polygons;
+    qint64 m_points;
+};
+
+thread_local PolygonFreeList freeList;
+
+}
+
+QPolygonF *ScreenPolygonPool::create()
+{
+    QVector<QPolygonF*> &polygons = freeList.m_polygons;
+    if ( polygons.isEmpty() ) {
+        return new QPolygonF;
+    }
+
+    QPolygonF *const polygon = polygons.last();
+    polygons.removeLast();
+    freeList.m_points -= polygon->capacity();
+    return polygon;
+}
+
+void ScreenPolygonPool::release( QPolygonF *polygon )
+{
+    if ( !polygon ) {
+        return;
+    }
+
+    QVector<QPolygonF*> &polygons = freeList.m_polygons;
+    if ( polygons.size() >= maximumPoolSize || polygon->capacity() > maximumPolygonCapacity
+         || freeList.m_points + polygon->capacity() > maximumPoolPoints ) {
+        delete polygon;
+        return;
+    }
+
+    // Keeps the capacity of the polygon unless its data is shared
+    polygon->clear();
+    freeList.m_points += polygon->capacity();
+    polygons << polygon;
+}
+
+void ScreenPolygonPool::release( QVector<QPolygonF*> &polygons )
+{
+    for ( QPolygonF *polygon: polygons ) {
+        release( polygon );
+    }
+    polygons.clear();
+}
+
+}
@@ -0,0 +1,55 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_SCREENPOLYGONPOOL_H
+#define MARBLE_SCREENPOLYGONPOOL_H
+
+#include "marble_export.h"
+
+#include <QVector>
+
+class QPolygonF;
+
+namespace Marble
+{
+
+/**
+ * @brief Recycles the screen polygons created while projecting geometries
+ *
+ * The projections hand out heap allocated polygons for each geometry they
+ * project. Polygons given back with release() keep their memory and are
+ * handed out again by create() in the same thread, so once a few frames
+ * have been rendered projecting a similar view allocates no more memory.
+ * Each thread keeps at most 4096 polygons with up to a million points in
+ * total, about 16 MiB; polygons beyond that are deleted on release().
+ *
+ * Deleting a polygon returned by create() is fine as well, it is just not
+ * reused then.
+ */
+class MARBLE_EXPORT ScreenPolygonPool
+{
+public:
+    /**
+     * Returns an empty polygon, taken from the pool of the calling thread if possible.
+     */
+    static QPolygonF *create();
+
+    /**
+     * Puts @p polygon back into the pool of the calling thread for reuse.
+     */
+    static void release( QPolygonF *polygon );
+
+    /**
+     * Puts all @p polygons back into the pool and clears the vector.
+     */
+    static void release( QVector<QPolygonF*> &polygons );
+};
+
+}
+
+#endif
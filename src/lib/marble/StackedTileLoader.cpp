@@ -189,6 +189,9 @@ void StackedTileLoader::updateTile( TileId const &tileId, QImage const &tileImag
 {
     const TileId stackedTileId( 0, tileId.zoomLevel(), tileId.x(), tileId.y() );
 
+    // The merged tiles must not hide the new texture tile
+    d->m_layerDecorator->discardMergedTile( stackedTileId );
+
     StackedTile * displayedTile = d->m_tilesOnDisplay.take( stackedTileId );
     if ( displayedTile ) {
         Q_ASSERT( !d->m_tileCache.contains( stackedTileId ) );
@@ -206,6 +209,42 @@ void StackedTileLoader::updateTile( TileId const &tileId, QImage const &tileImag
     }
 }
 
+void StackedTileLoader::updateSunShading()
+{
+    QList<TileId> updatedTiles;
+
+    d->m_cacheLock.lockForWrite();
+
+    QHash<TileId, StackedTile*>::iterator it = d->m_tilesOnDisplay.begin();
+    QHash<TileId, StackedTile*>::iterator const end = d->m_tilesOnDisplay.end();
+    for (; it != end; ++it ) {
+        if ( !d->m_layerDecorator->sunShadingChanged( *it.value() ) ) {
+            continue;
+        }
+
+        StackedTile *const stackedTile = d->m_layerDecorator->updateSunShading( *it.value() );
+        stackedTile->setUsed( true );
+        delete it.value();
+        it.value() = stackedTile;
+        updatedTiles << it.key();
+    }
+
+    // Tiles out of sight are recreated when they come into view again
+    for ( const TileId &id: d->m_tileCache.keys() ) {
+        if ( d->m_layerDecorator->sunShadingChanged( *d->m_tileCache.object( id ) ) ) {
+            d->m_tileCache.remove( id );
+        }
+    }
+
+    d->m_layerDecorator->updateSunPosition();
+
+    d->m_cacheLock.unlock();
+
+    for ( const TileId &id: updatedTiles ) {
+        emit tileLoaded( id );
+    }
+}
+
 RenderState StackedTileLoader::renderState() const
 {
     RenderState renderState( "Stacked Tiles" );
@@ -222,6 +261,7 @@ void StackedTileLoader::clear()
     qDeleteAll( d->m_tilesOnDisplay );
     d->m_tilesOnDisplay.clear();
     d->m_tileCache.clear(); // clear the tile cache in physical memory
+    d->m_layerDecorator->updateSunPosition();
 
     emit cleared();
 }
@@ -132,6 +132,12 @@ class StackedTileLoader : public QObject
          */
         void updateTile(TileId const & tileId, QImage const &tileImage );
 
+        /**
+         * Shades the tiles for the current position of the sun. Only tiles
+         * whose shading changes are recreated, the others are kept.
+         */
+        void updateSunShading();
+
         RenderState renderState() const;
 
     Q_SIGNALS:
@@ -19,6 +19,11 @@
 #include <QVector>
 #include <QElapsedTimer>
 #include <QPainter>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QVarLengthArray>
+
+#include <algorithm>
 
 #include "GeoPainter.h"
 #include "MarbleDebug.h"
@@ -30,36 +35,97 @@
 #include "GeoDataFeature.h"
 #include "GeoDataPlacemark.h"
 #include "AbstractProjection.h"
+#include "Quaternion.h"
 
 namespace Marble
 {
 
-// 4 uchar long queue
-class EmbossFifo
+namespace {
+
+// The pixels [xLeft, xRight) of row y lie on the sphere
+void sphereRowSpan( int y, int imgwidth, int imgheight, qint64 radius, int &xLeft, int &xRight )
 {
-public:
-    EmbossFifo()
-        : data( 0 )
-    {}
+    const int  imgrx = imgwidth / 2;
+    const int  imgry = imgheight / 2;
+    const int  dy = imgry - y;
+    const int  rx = (int)sqrt( (qreal)( radius * radius - dy * dy ) );
 
-    inline uchar head() const
-    {
-        // return least significant byte as head of queue
-        return data & 0x000000FF;
+    xLeft  = 0;
+    xRight = imgwidth;
+
+    if ( imgrx-rx > 0 ) {
+        xLeft  = imgrx - rx;
+        xRight = imgrx + rx;
     }
+}
 
-    inline void enqueue(uchar value)
-    {
-        // drop current head by shifting by one byte
-        // and append new value as most significant byte to queue
-        data = ((data >> 8) & 0x00FFFFFF) | (value << 24);
+// The last three grey values of the sphere's rows above row y, the newest
+// one in the most significant byte
+quint32 sphereEmbossState( const QImage *image, int yTop, int y, qint64 radius )
+{
+    quint32 emboss = 0;
+    int count = 0;
+
+    for ( int row = y - 1; row >= yTop && count < 3; --row ) {
+        int xLeft, xRight;
+        sphereRowSpan( row, image->width(), image->height(), radius, xLeft, xRight );
+
+        const uchar *readData = image->constScanLine( row );
+        for ( int x = xRight - 1; x >= xLeft && count < 3; --x, ++count ) {
+            emboss |= quint32( readData[x * 4] ) << ( 8 * ( 2 - count ) );
+        }
     }
 
+    return emboss;
+}
+
+inline QRgb blendPixel( QRgb landcolor, QRgb watercolor, int alpha )
+{
+    qreal c = 1.0 / 255.0;
+
+    return qRgb(
+                (int) ( c * ( alpha * qRed( landcolor )
+                              + ( 255 - alpha ) * qRed( watercolor ) ) ),
+                (int) ( c * ( alpha * qGreen( landcolor )
+                              + ( 255 - alpha ) * qGreen( watercolor ) ) ),
+                (int) ( c * ( alpha * qBlue( landcolor )
+                              + ( 255 - alpha ) * qBlue( watercolor ) ) )
+                );
+}
+
+}
+
+class TextureColorizer::ColorizeJob : public QRunnable
+{
+public:
+    ColorizeJob( const TextureColorizer *colorizer, QImage *image, int yTop, int yBottom, qint64 radius, quint32 emboss );
+
+    void run() override;
+
 private:
-    // 4 byte long queue
-    quint32 data;
+    const TextureColorizer *const m_colorizer;
+    QImage *const m_image;
+    const int m_yTop;
+    const int m_yBottom;
+    const qint64 m_radius;
+    const quint32 m_emboss;
 };
 
+TextureColorizer::ColorizeJob::ColorizeJob( const TextureColorizer *colorizer, QImage *image, int yTop, int yBottom, qint64 radius, quint32 emboss )
+    : m_colorizer( colorizer ),
+      m_image( image ),
+      m_yTop( yTop ),
+      m_yBottom( yBottom ),
+      m_radius( radius ),
+      m_emboss( emboss )
+{
+}
+
+void TextureColorizer::ColorizeJob::run()
+{
+    m_colorizer->colorizeRows( m_image, m_yTop, m_yBottom, m_radius, m_emboss );
+}
+
 
 TextureColorizer::TextureColorizer( const QString &seafile,
                                     const QString &landfile )
@@ -144,11 +210,23 @@ TextureColorizer::TextureColorizer( const QString &seafile,
 void TextureColorizer::addSeaDocument( const GeoDataDocument *seaDocument )
 {
     m_seaDocuments.append( seaDocument );
+    m_coastImageKey.clear();
 }
 
 void TextureColorizer::addLandDocument( const GeoDataDocument *landDocument )
 {
     m_landDocuments.append( landDocument );
+    m_coastImageKey.clear();
+}
+
+bool TextureColorizer::removeDocument( const GeoDataDocument *document )
+{
+    if ( m_seaDocuments.removeAll( document ) + m_landDocuments.removeAll( document ) == 0 ) {
+        return false;
+    }
+
+    m_coastImageKey.clear();
+    return true;
 }
 
 void TextureColorizer::setShowRelief( bool show )
@@ -213,8 +291,27 @@ void TextureColorizer::drawTextureMap( GeoPainter *painter )
     }
 }
 
-void TextureColorizer::colorize( QImage *origimg, const ViewportParams *viewport, MapQuality mapQuality )
+void TextureColorizer::updateCoastImage( const ViewportParams *viewport, MapQuality mapQuality )
 {
+    // The coast image only depends on the viewport, not on the texture
+    const Quaternion axis = viewport->planetAxis();
+    QVector<qreal> key;
+    key.reserve( 12 + m_landDocuments.size() + m_seaDocuments.size() );
+    key << viewport->projection() << viewport->radius() << viewport->width() << viewport->height()
+        << viewport->centerLongitude() << viewport->centerLatitude() << viewport->heading()
+        << axis.v[Q_W] << axis.v[Q_X] << axis.v[Q_Y] << axis.v[Q_Z] << mapQuality;
+    for( const GeoDataDocument *doc: m_landDocuments ) {
+        key << doc->isVisible();
+    }
+    for( const GeoDataDocument *doc: m_seaDocuments ) {
+        key << doc->isVisible();
+    }
+
+    if ( key == m_coastImageKey ) {
+        return;
+    }
+    m_coastImageKey = key;
+
     if ( m_coastImage.size() != viewport->size() )
         m_coastImage = QImage( viewport->size(), QImage::Format_RGB32 );
 
@@ -228,6 +325,12 @@ void TextureColorizer::colorize( QImage *origimg, const ViewportParams *viewport
     painter.setRenderHint( QPainter::Antialiasing, antialiased );
 
     drawTextureMap( &painter );
+}
+
+void TextureColorizer::colorize( QImage *origimg, const ViewportParams *viewport, MapQuality mapQuality,
+                                 QThreadPool *threadPool )
+{
+    updateCoastImage( viewport, mapQuality );
 
     const qint64 radius = viewport->radius() * viewport->currentProjection()->clippingRadius();
 
@@ -235,17 +338,16 @@ void TextureColorizer::colorize( QImage *origimg, const ViewportParams *viewport
     const int  imgwidth  = origimg->width();
     const int  imgrx     = imgwidth / 2;
     const int  imgry     = imgheight / 2;
-    // This variable is not used anywhere..
     const int  imgradius = imgrx * imgrx + imgry * imgry;
 
-    int     bump = 8;
+    int yTop = 0;
+    int yBottom = imgheight;
+    // Whole rows are colored if negative, otherwise the part of each row on the sphere
+    qint64 rowRadius = -1;
 
     if ( radius * radius > imgradius
          || !viewport->currentProjection()->isClippedToSphere() )
     {
-        int yTop = 0;
-        int yBottom = imgheight;
-
         if( !viewport->currentProjection()->isClippedToSphere() && !viewport->currentProjection()->traversablePoles() )
         {
             qreal realYTop, realYBottom, dummyX;
@@ -256,85 +358,104 @@ void TextureColorizer::colorize( QImage *origimg, const ViewportParams *viewport
             yTop = qBound(qreal(0.0), realYTop, qreal(imgheight));
             yBottom = qBound(qreal(0.0), realYBottom, qreal(imgheight));
         }
+    }
+    else {
+        yTop    = ( imgry-radius < 0 ) ? 0 : imgry-radius;
+        yBottom = ( yTop == 0 ) ? imgheight : imgry + radius;
+        rowRadius = radius;
+    }
 
-        const int itEnd = yBottom;
-
-        for (int y = yTop; y < itEnd; ++y) {
+    const int numThreads = threadPool ? threadPool->maxThreadCount() : 1;
+    if ( numThreads <= 1 || yBottom - yTop < 2 * numThreads ) {
+        colorizeRows( origimg, yTop, yBottom, rowRadius, 0 );
+        return;
+    }
 
-            QRgb  *writeData         = (QRgb*)( origimg->scanLine( y ) );
-            const QRgb  *coastData   = (QRgb*)( m_coastImage.scanLine( y ) );
+    // On the sphere the emboss queue carries over from one row to the next. The
+    // state each job starts with is read before any job overwrites the grey values.
+    QVector<QRunnable*> jobs;
+    jobs.reserve( numThreads );
+    const int yStep = qCeil( qreal( yBottom - yTop ) / qreal( numThreads ) );
+    for ( int i = 0; i < numThreads; ++i ) {
+        const int yStart = yTop +  i      * yStep;
+        const int yEnd   = qMin( yBottom, yTop + ( i + 1 ) * yStep );
+        if ( yStart >= yEnd ) {
+            break;
+        }
+        const quint32 emboss = rowRadius < 0 ? 0 : sphereEmbossState( origimg, yTop, yStart, rowRadius );
+        jobs << new ColorizeJob( this, origimg, yStart, yEnd, rowRadius, emboss );
+    }
 
-            uchar *readDataStart     = origimg->scanLine( y );
-            const uchar *readDataEnd = readDataStart + imgwidth*4;
+    for ( QRunnable *job: jobs ) {
+        threadPool->start( job );
+    }
 
-            EmbossFifo  emboss;
+    threadPool->waitForDone();
+}
 
-            for ( uchar* readData = readDataStart; 
-                  readData < readDataEnd;
-                  readData += 4, ++writeData, ++coastData )
-            {
+void TextureColorizer::colorizeRows( QImage *origimg, int yTop, int yBottom, qint64 radius, quint32 emboss ) const
+{
+    const int imgwidth  = origimg->width();
+    const int imgheight = origimg->height();
 
-                // Cheap Emboss / Bumpmapping
-                uchar&  grey = *readData; // qBlue(*data);
+    for ( int y = yTop; y < yBottom; ++y ) {
+        QRgb  *writeData         = (QRgb*)( origimg->scanLine( y ) );
+        const QRgb  *coastData   = (const QRgb*)( m_coastImage.constScanLine( y ) );
 
-                if ( m_showRelief ) {
-                    emboss.enqueue(grey);
-                    bump = ( emboss.head() + 8 - grey );
-                    if (bump < 0) {
-                        bump = 0;
-                    } else if (bump > 15) {
-                        bump = 15;
-                    }
-                }
-                setPixel( coastData, writeData, bump, grey );
-            }
+        if ( radius < 0 ) {
+            colorizeLine( writeData, coastData, imgwidth, 0, 8, 0 );
+        }
+        else {
+            int xLeft, xRight;
+            sphereRowSpan( y, imgwidth, imgheight, radius, xLeft, xRight );
+            emboss = colorizeLine( writeData + xLeft, coastData + xLeft, xRight - xLeft, emboss, 16, 1 );
         }
     }
-    else {
-        int yTop    = ( imgry-radius < 0 ) ? 0 : imgry-radius;
-        const int yBottom = ( yTop == 0 ) ? imgheight : imgry + radius;
+}
 
-        EmbossFifo  emboss;
+quint32 TextureColorizer::colorizeLine( QRgb *data, const QRgb *coastData, int width,
+                                        quint32 emboss, int bumpOffset, int bumpShift ) const
+{
+    // The grey values of the row, preceded by the last three of the emboss queue
+    QVarLengthArray<uchar, 4099> greys( width + 3 );
+    QVarLengthArray<uchar, 4096> bumps( width );
 
-        for ( int y = yTop; y < yBottom; ++y ) {
-            const int  dy = imgry - y;
-            int  rx = (int)sqrt( (qreal)( radius * radius - dy * dy ) );
-            int  xLeft  = 0; 
-            int  xRight = imgwidth;
+    greys[0] = emboss & 0xFF;
+    greys[1] = ( emboss >> 8 ) & 0xFF;
+    greys[2] = ( emboss >> 16 ) & 0xFF;
 
-            if ( imgrx-rx > 0 ) {
-                xLeft  = imgrx - rx; 
-                xRight = imgrx + rx;
-            }
+    const uchar *readData = (const uchar*)( data );
+    for ( int x = 0; x < width; ++x ) {
+        greys[x + 3] = readData[x * 4]; // qBlue(*data);
+    }
 
-            QRgb  *writeData         = (QRgb*)( origimg->scanLine( y ) )  + xLeft;
-            const QRgb *coastData    = (QRgb*)( m_coastImage.scanLine( y ) ) + xLeft;
-
-            uchar *readDataStart     = origimg->scanLine( y ) + xLeft * 4;
-            const uchar *readDataEnd = origimg->scanLine( y ) + xRight * 4;
-
- 
-            for ( uchar* readData = readDataStart;
-                  readData < readDataEnd;
-                  readData += 4, ++writeData, ++coastData )
-            {
-                // Cheap Emboss / Bumpmapping
-
-                uchar& grey = *readData; // qBlue(*data);
-
-                if ( m_showRelief ) {
-                    emboss.enqueue(grey);
-                    bump = ( emboss.head() + 16 - grey ) >> 1;
-                    if (bump < 0) {
-                        bump = 0;
-                    } else if (bump > 15) {
-                        bump = 15;
-                    }
-                }
-                setPixel( coastData, writeData, bump, grey );
-            }
+    // Cheap Emboss / Bumpmapping: compare each pixel to the third one to its left.
+    // These loops have no branches, so the compiler can vectorize them.
+    if ( m_showRelief ) {
+        for ( int x = 0; x < width; ++x ) {
+            bumps[x] = qBound( 0, ( greys[x] + bumpOffset - greys[x + 3] ) >> bumpShift, 15 );
         }
     }
+    else {
+        std::fill( bumps.begin(), bumps.end(), uchar( 8 ) );
+    }
+
+    const uint *palette = &texturepalette[0][0];
+    for ( int x = 0; x < width; ++x ) {
+        const uint *colors = palette + bumps[x] * 512 + greys[x + 3];
+        const int alpha = qRed( coastData[x] );
+        if ( alpha == 0 ) {
+            data[x] = colors[0];
+        }
+        else if ( alpha == 255 ) {
+            data[x] = colors[0x100];
+        }
+        else {
+            data[x] = blendPixel( colors[0x100], colors[0], alpha );
+        }
+    }
+
+    return greys[width] | ( greys[width + 1] << 8 ) | ( greys[width + 2] << 16 );
 }
 
 void TextureColorizer::setPixel( const QRgb *coastData, QRgb *writeData, int bump, uchar grey )
@@ -346,19 +467,7 @@ void TextureColorizer::setPixel( const QRgb *coastData, QRgb *writeData, int bum
         *writeData = texturepalette[bump][grey];
     }
     else {
-        qreal c = 1.0 / 255.0;
-
-        QRgb landcolor  = (QRgb)(texturepalette[bump][grey + 0x100]);
-        QRgb watercolor = (QRgb)(texturepalette[bump][grey]);
-
-        *writeData = qRgb(
-                    (int) ( c * ( alpha * qRed( landcolor )
-                                  + ( 255 - alpha ) * qRed( watercolor ) ) ),
-                    (int) ( c * ( alpha * qGreen( landcolor )
-                                  + ( 255 - alpha ) * qGreen( watercolor ) ) ),
-                    (int) ( c * ( alpha * qBlue( landcolor )
-                                  + ( 255 - alpha ) * qBlue( watercolor ) ) )
-                    );
+        *writeData = blendPixel( texturepalette[bump][grey + 0x100], texturepalette[bump][grey], alpha );
     }
 }
 }
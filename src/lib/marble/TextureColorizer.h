@@ -22,6 +22,9 @@
 #include <QString>
 #include <QImage>
 #include <QColor>
+#include <QVector>
+
+class QThreadPool;
 
 namespace Marble
 {
@@ -41,22 +44,44 @@ class TextureColorizer
 
     void addLandDocument( const GeoDataDocument *landDocument );
 
+    /**
+     * Stops drawing @p document into the coast mask, e.g. before it is deleted.
+     * Returns whether @p document was a sea or land document.
+     */
+    bool removeDocument( const GeoDataDocument *document );
+
     void setShowRelief( bool show );
 
     static void drawIndividualDocument( GeoPainter *painter, const GeoDataDocument *document );
 
     void drawTextureMap( GeoPainter *painter );
 
-    void colorize( QImage *origimg, const ViewportParams *viewport, MapQuality mapQuality );
+    /**
+     * Colors the grey scale image @p origimg according to the sea and land palettes.
+     * The rows of the image are split across the threads of @p threadPool, or
+     * colored in the calling thread if it is null. The mask of coast lines is kept
+     * and reused as long as the viewport, the documents and their visibility do
+     * not change.
+     */
+    void colorize( QImage *origimg, const ViewportParams *viewport, MapQuality mapQuality,
+                   QThreadPool *threadPool = nullptr );
 
     void setPixel( const QRgb *coastData, QRgb *writeData, int bump, uchar grey );
 
  private:
+    class ColorizeJob;
+
+    void updateCoastImage( const ViewportParams *viewport, MapQuality mapQuality );
+    void colorizeRows( QImage *origimg, int yTop, int yBottom, qint64 radius, quint32 emboss ) const;
+    quint32 colorizeLine( QRgb *data, const QRgb *coastData, int width,
+                          quint32 emboss, int bumpOffset, int bumpShift ) const;
+
     QString m_seafile;
     QString m_landfile;
     QList<const GeoDataDocument*> m_seaDocuments;
     QList<const GeoDataDocument*> m_landDocuments;
     QImage m_coastImage;
+    QVector<qreal> m_coastImageKey;
     uint texturepalette[16][512];
     bool m_showRelief;
     QRgb      m_landColor;
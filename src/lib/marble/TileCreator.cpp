@@ -14,13 +14,19 @@
 
 #include <cmath>
 
+#include <QAtomicInt>
 #include <QDir>
+#include <QFile>
+#include <QFuture>
 #include <QRect>
 #include <QSize>
 #include <QVector>
 #include <QApplication>
 #include <QImage>
+#include <QImageReader>
 #include <QPainter>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
 
 #include "MarbleGlobal.h"
 #include "MarbleDirs.h"
@@ -33,7 +39,7 @@ namespace Marble
 class TileCreatorPrivate
 {
  public:
-    TileCreatorPrivate( TileCreatorSource *source,
+    TileCreatorPrivate( TileCreator *parent, TileCreatorSource *source,
                         const QString& dem, const QString& targetDir=QString() )
        : m_dem( dem ),
          m_targetDir( targetDir ),
@@ -41,13 +47,23 @@ class TileCreatorPrivate
          m_tileFormat( "jpg" ),
          m_resume( false ),
          m_verify( false ),
-         m_source( source )
+         m_source( source ),
+         m_maxTileLevel( 0 ),
+         m_totalTileCount( 0 ),
+         m_createdTilesCount( 0 ),
+         m_percentCompleted( 0 ),
+         m_writeFailed( 0 ),
+         q( parent )
      {
         if (m_dem == QLatin1String("true")) {
             m_tileQuality = 70;
         } else {
             m_tileQuality = 85;
         }
+
+        for ( int cnt = 0; cnt <= 255; ++cnt ) {
+            m_grayScalePalette.insert(cnt, qRgb(cnt, cnt, cnt));
+        }
     }
 
     ~TileCreatorPrivate()
@@ -55,6 +71,25 @@ class TileCreatorPrivate
         delete m_source;
     }
 
+    QString tileName( int tileLevel, int n, int m ) const;
+
+    /**
+     * Reads row @p n of the highest tile level from the source. Tiles which are
+     * kept from a previous run are left null, an empty row means a read error.
+     */
+    QVector<QImage> readRow( int n );
+
+    /**
+     * Saves row @p n of @p tileLevel in parallel and reduces each tile into its
+     * quarter of the tile above it. Once both rows below a row of the next lower
+     * level are done, that row is processed the same way.
+     */
+    bool processRow( int tileLevel, int n, const QVector<QImage> &tiles );
+
+    bool saveTile( const QImage &tile, const QString &tileName, bool verify ) const;
+    QImage emptyTile() const;
+    void reduceTile( const QImage &tile, uchar *parentBits, int bytesPerLine, int row, int column ) const;
+
  public:
     QString  m_dem;
     QString  m_targetDir;
@@ -65,24 +100,45 @@ class TileCreatorPrivate
     bool     m_verify;
 
     TileCreatorSource  *m_source;
+
+    QVector<QRgb> m_grayScalePalette;
+    int      m_maxTileLevel;
+    int      m_totalTileCount;
+    int      m_createdTilesCount;
+    int      m_percentCompleted;
+    QAtomicInt m_writeFailed;
+
+    // The tiles of the row currently assembled on each level below the highest one
+    QVector<QVector<QImage> > m_parentRows;
+
+    TileCreator *const q;
 };
 
+// Decoding the source image in strips of about this size keeps the memory
+// use bounded independent of the size of the source image
+static const qint64 stripBytes = 256 * 1024 * 1024;
+
 class TileCreatorSourceImage : public TileCreatorSource
 {
 public:
     explicit TileCreatorSourceImage( const QString &sourcePath )
-        : m_sourceImage( QImage( sourcePath ) ),
-          m_cachedRowNum( -1 )
+        : m_sourcePath( sourcePath ),
+          m_stripFirstRow( -1 ),
+          m_stripRowCount( 0 )
     {
+        QImageReader reader( sourcePath );
+        m_imageSize = reader.size();
+        m_readsStrips = reader.supportsOption( QImageIOHandler::ClipRect );
     }
 
     QSize fullImageSize() const override
     {
-        if ( m_sourceImage.size().width() > 21600 || m_sourceImage.height() > 10800 ) {
+        // Formats which can't be read in parts have to fit into memory at once
+        if ( !m_readsStrips && ( m_imageSize.width() > 21600 || m_imageSize.height() > 10800 ) ) {
             qDebug("Install map too large!");
             return QSize();
         }
-        return m_sourceImage.size();
+        return m_imageSize;
     }
 
     QImage tile(int n, int m, int maxTileLevel) override
@@ -90,77 +146,78 @@ public:
         int  mmax = TileLoaderHelper::levelToColumn( defaultLevelZeroColumns, maxTileLevel );
         int  nmax = TileLoaderHelper::levelToRow( defaultLevelZeroRows, maxTileLevel );
 
-        int imageHeight = m_sourceImage.height();
-        int imageWidth = m_sourceImage.width();
-
-        // If the image size of the image source does not match the expected
-        // geometry we need to smooth-scale the image in advance to match
-        // the required size
-        bool needsScaling = ( imageWidth != 2 * nmax * (int)( c_defaultTileSize )
-                            ||  imageHeight != nmax * (int)( c_defaultTileSize ) );
-
-        if ( needsScaling )
-            mDebug() << "Image Size doesn't match 2*n*TILEWIDTH x n*TILEHEIGHT geometry. Scaling ...";
-
         int  stdImageWidth  = 2 * nmax * c_defaultTileSize;
-        if ( stdImageWidth == 0 )
-            stdImageWidth = 2 * c_defaultTileSize;
 
-        int  stdImageHeight  = nmax * c_defaultTileSize;
-        if ( stdImageWidth != imageWidth ) {
-            mDebug() <<
-            QString( "TileCreator::createTiles() The size of the final image will measure  %1 x %2 pixels").arg(stdImageWidth).arg(stdImageHeight);
+        if ( n < m_stripFirstRow || n >= m_stripFirstRow + m_stripRowCount ) {
+            readStrip( n, nmax, stdImageWidth );
         }
 
-        QImage row;
+        if ( m_strip.isNull() ) {
+            mDebug() << "Read-Error! Null QImage!";
+            return QImage();
+        }
 
-        if ( m_cachedRowNum == n ) {
+        QImage  tile = m_strip.copy( m * stdImageWidth / mmax, ( n - m_stripFirstRow ) * c_defaultTileSize,
+                                     c_defaultTileSize, c_defaultTileSize );
 
-            row = m_rowCache;
+        return tile;
+    }
 
+private:
+    void readStrip( int n, int nmax, int stdImageWidth )
+    {
+        int imageHeight = m_imageSize.height();
+        int imageWidth = m_imageSize.width();
+
+        // Each strip read by a QImageReader decodes the image from its start,
+        // so take as many rows of tiles at once as the budget allows
+        qint64 const rowBytes = qint64( stdImageWidth ) * c_defaultTileSize * 4;
+        m_stripFirstRow = n;
+        m_stripRowCount = qBound( 1, int( stripBytes / rowBytes ), nmax - n );
+
+        int const top = (int)( (qreal)( n * imageHeight ) / (qreal)( nmax ) );
+        int const bottom = (int)( (qreal)( ( n + m_stripRowCount ) * imageHeight ) / (qreal)( nmax ) );
+        QRect const sourceStripRect( 0, top, imageWidth, bottom - top );
+
+        if ( m_readsStrips ) {
+            QImageReader reader( m_sourcePath );
+            reader.setClipRect( sourceStripRect );
+            m_strip = reader.read();
         } else {
-
-            QRect   sourceRowRect( 0, (int)( (qreal)( n * imageHeight ) / (qreal)( nmax )),
-                                imageWidth,(int)( (qreal)( imageHeight ) / (qreal)( nmax ) ) );
-
-
-            row = m_sourceImage.copy( sourceRowRect );
-
-            if ( needsScaling ) {
-                // Pick the current row and smooth scale it
-                // to make it match the expected size
-                QSize destSize( stdImageWidth, c_defaultTileSize );
-                row = row.scaled( destSize,
-                                Qt::IgnoreAspectRatio,
-                                Qt::SmoothTransformation );
+            if ( m_sourceImage.isNull() ) {
+                m_sourceImage = QImage( m_sourcePath );
             }
-
-            m_cachedRowNum = n;
-            m_rowCache = row;
+            m_strip = m_sourceImage.copy( sourceStripRect );
         }
 
-        if ( row.isNull() ) {
-            mDebug() << "Read-Error! Null QImage!";
-            return QImage();
+        // If the image size of the image source does not match the expected
+        // geometry we need to smooth-scale the strip to match the required size
+        QSize const destSize( stdImageWidth, m_stripRowCount * c_defaultTileSize );
+        if ( !m_strip.isNull() && m_strip.size() != destSize ) {
+            mDebug() << "Image Size doesn't match 2*n*TILEWIDTH x n*TILEHEIGHT geometry. Scaling ...";
+            m_strip = m_strip.scaled( destSize,
+                                      Qt::IgnoreAspectRatio,
+                                      Qt::SmoothTransformation );
         }
-
-        QImage  tile = row.copy( m * stdImageWidth / mmax, 0, c_defaultTileSize, c_defaultTileSize );
-
-        return tile;
     }
 
-private:
+    QString m_sourcePath;
+    QSize m_imageSize;
+    bool m_readsStrips;
+
+    // Only used for formats which can't be read in strips
     QImage m_sourceImage;
 
-    QImage m_rowCache;
-    int m_cachedRowNum;
+    QImage m_strip;
+    int m_stripFirstRow;
+    int m_stripRowCount;
 };
 
 
 TileCreator::TileCreator(const QString& sourceDir, const QString& installMap,
                          const QString& dem, const QString& targetDir)
     : QThread(nullptr),
-      d( new TileCreatorPrivate( nullptr, dem, targetDir ) )
+      d( new TileCreatorPrivate( this, nullptr, dem, targetDir ) )
 
 {
     mDebug() << "Prefix: " << sourceDir
@@ -193,7 +250,7 @@ TileCreator::TileCreator(const QString& sourceDir, const QString& installMap,
 
 TileCreator::TileCreator( TileCreatorSource* source, const QString& dem, const QString& targetDir )
     : QThread(nullptr),
-      d( new TileCreatorPrivate( source, dem, targetDir ) )
+      d( new TileCreatorPrivate( this, source, dem, targetDir ) )
 {
     setTerminationEnabled( true );
 }
@@ -220,11 +277,6 @@ void TileCreator::run()
 
     mDebug() << "Installing tiles to: " << d->m_targetDir;
 
-    QVector<QRgb> grayScalePalette;
-    for ( int cnt = 0; cnt <= 255; ++cnt ) {
-        grayScalePalette.insert(cnt, qRgb(cnt, cnt, cnt));
-    }
-
     QSize fullImageSize = d->m_source->fullImageSize();
     int  imageWidth  = fullImageSize.width();
     int  imageHeight = fullImageSize.height();
@@ -246,7 +298,7 @@ void TileCreator::run()
         maxTileLevel = static_cast<int>( approxMaxTileLevel + 1 );
 
     if ( maxTileLevel < 0 ) {
-        mDebug() 
+        mDebug()
         << QString( "TileCreator::createTiles(): Invalid Maximum Tile Level: %1" )
         .arg( maxTileLevel );
     }
@@ -270,310 +322,247 @@ void TileCreator::run()
 
     mDebug() << totalTileCount << " tiles to be created in total.";
 
-    int  mmax = TileLoaderHelper::levelToColumn( defaultLevelZeroColumns, maxTileLevel );
-    int  nmax = TileLoaderHelper::levelToRow( defaultLevelZeroRows, maxTileLevel );
+    d->m_maxTileLevel = maxTileLevel;
+    d->m_totalTileCount = totalTileCount;
+    d->m_createdTilesCount = 0;
+    d->m_percentCompleted = 0;
+    d->m_writeFailed = 0;
+    d->m_parentRows = QVector<QVector<QImage> >( qMax( 0, maxTileLevel ) );
 
-    // Loading each row at highest spatial resolution and cropping tiles
-    int      percentCompleted = 0;
-    int      createdTilesCount = 0;
-    QString  tileName;
+    int  nmax = TileLoaderHelper::levelToRow( defaultLevelZeroRows, maxTileLevel );
 
-    // Creating directory structure for the highest level
-    QString  dirName( d->m_targetDir
-                      + QString("%1").arg(maxTileLevel) );
-    if ( !QDir( dirName ).exists() ) 
-        ( QDir::root() ).mkpath( dirName );
+    // Reading the next row at highest spatial resolution while the tiles of the
+    // current one are saved, all lower levels are built from memory on the way
+    QFuture<QVector<QImage> > nextRow = QtConcurrent::run( d, &TileCreatorPrivate::readRow, 0 );
 
     for ( int n = 0; n < nmax; ++n ) {
-        QString dirName( d->m_targetDir
-                         + QString("%1/%2").arg(maxTileLevel).arg(n, tileDigits, 10, QLatin1Char('0')));
-        if ( !QDir( dirName ).exists() ) 
-            ( QDir::root() ).mkpath( dirName );
-    }
+        QVector<QImage> const row = nextRow.result();
+        if ( row.isEmpty() ) {
+            return;
+        }
 
-    for ( int n = 0; n < nmax; ++n ) {
+        if ( n + 1 < nmax ) {
+            nextRow = QtConcurrent::run( d, &TileCreatorPrivate::readRow, n + 1 );
+        }
 
-        for ( int m = 0; m < mmax; ++m ) {
+        bool const ok = d->processRow( maxTileLevel, n, row );
+        if ( !ok ) {
+            nextRow.waitForFinished();
+            if ( d->m_writeFailed.loadAcquire() ) {
+                mDebug() << "Tile write failure. Missing write permissions?";
+                emit progress( 100 );
+            }
+            return;
+        }
+    }
 
-            mDebug() << "** tile" << m << "x" << n;
+    mDebug() << "Tile creation completed.";
 
-            if ( d->m_cancelled ) 
-                return;
+    d->m_percentCompleted = 100;
+    emit progress( d->m_percentCompleted );
 
-            tileName = d->m_targetDir + QString("%1/%2/%2_%3.%4")
-                                       .arg( maxTileLevel )
-                                       .arg(n, tileDigits, 10, QLatin1Char('0'))
-                                       .arg(m, tileDigits, 10, QLatin1Char('0'))
-                                       .arg( d->m_tileFormat );
+    mDebug() << "percentCompleted: " << d->m_percentCompleted;
+}
 
-            if ( QFile::exists( tileName ) && d->m_resume ) {
+QString TileCreatorPrivate::tileName( int tileLevel, int n, int m ) const
+{
+    return m_targetDir + QString("%1/%2/%2_%3.%4")
+                         .arg( tileLevel )
+                         .arg(n, tileDigits, 10, QLatin1Char('0'))
+                         .arg(m, tileDigits, 10, QLatin1Char('0'))
+                         .arg( m_tileFormat );
+}
 
-                //mDebug() << tileName << "exists already";
+QVector<QImage> TileCreatorPrivate::readRow( int n )
+{
+    int  mmax = TileLoaderHelper::levelToColumn( defaultLevelZeroColumns, m_maxTileLevel );
 
-            } else {
+    QVector<QImage> row( mmax );
+    for ( int m = 0; m < mmax; ++m ) {
+        if ( m_cancelled )
+            return QVector<QImage>();
 
-                QImage tile = d->m_source->tile( n, m, maxTileLevel );
+        if ( m_resume && QFile::exists( tileName( m_maxTileLevel, n, m ) ) ) {
+            // Loaded from disk when it is needed for the lower levels
+            continue;
+        }
 
-                if ( tile.isNull() ) {
-                    mDebug() << "Read-Error! Null QImage!";
-                    return;
-                }
+        row[m] = m_source->tile( n, m, m_maxTileLevel );
+        if ( row[m].isNull() ) {
+            mDebug() << "Read-Error! Null QImage!";
+            return QVector<QImage>();
+        }
+    }
 
-                if (d->m_dem == QLatin1String("true")) {
-                    tile = tile.convertToFormat(QImage::Format_Indexed8,
-                                                grayScalePalette,
-                                                Qt::ThresholdDither);
-                }
+    return row;
+}
 
-                bool  ok = tile.save(tileName, d->m_tileFormat.toLatin1().data(), d->m_tileFormat == QLatin1String("jpg") ? 100 : d->m_tileQuality);
-                if ( !ok )
-                    mDebug() << "Error while writing Tile: " << tileName;
-
-                mDebug() << tileName << "size" << QFile( tileName ).size();
-
-                if ( d->m_verify ) {
-                    QImage writtenTile(tileName);
-                    Q_ASSERT( writtenTile.size() == tile.size() );
-                    for ( int i=0; i < writtenTile.size().width(); ++i) {
-                        for ( int j=0; j < writtenTile.size().height(); ++j) {
-                            if ( writtenTile.pixel( i, j ) != tile.pixel( i, j ) ) {
-                                unsigned int  pixel = tile.pixel( i, j);
-                                unsigned int  writtenPixel = writtenTile.pixel( i, j);
-                                qWarning() << "***** pixel" << i << j << "is off by" << (pixel - writtenPixel) << "pixel" << pixel << "writtenPixel" << writtenPixel;
-                                QByteArray baPixel((char*)&pixel, sizeof(unsigned int));
-                                qWarning() << "pixel" << baPixel.size() << "0x" << baPixel.toHex();
-                                QByteArray baWrittenPixel((char*)&writtenPixel, sizeof(unsigned int));
-                                qWarning() << "writtenPixel" << baWrittenPixel.size() << "0x" << baWrittenPixel.toHex();
-                                Q_ASSERT(false);
-                            }
-                        }
-                    }
-                }
+bool TileCreatorPrivate::processRow( int tileLevel, int n, const QVector<QImage> &tiles )
+{
+    QString  dirName( m_targetDir
+                      + QString("%1/%2")
+                          .arg(tileLevel)
+                          .arg(n, tileDigits, 10, QLatin1Char('0')));
+    if ( !QDir( dirName ).exists() )
+        ( QDir::root() ).mkpath( dirName );
 
+    // Two rows of tiles make up one row of the next lower level
+    QVector<uchar*> parentBits;
+    int bytesPerLine = 0;
+    if ( tileLevel > 0 ) {
+        QVector<QImage> &parentRow = m_parentRows[tileLevel - 1];
+        if ( n % 2 == 0 ) {
+            parentRow = QVector<QImage>( tiles.size() / 2, QImage() );
+            for ( QImage &parent: parentRow ) {
+                parent = emptyTile();
             }
-
-            percentCompleted =  (int) ( 90 * (qreal)(createdTilesCount) 
-                                        / (qreal)(totalTileCount) );	
-            createdTilesCount++;
-
-            mDebug() << "percentCompleted" << percentCompleted;
-            emit progress( percentCompleted );
         }
+        // Detaching here lets the workers write to the quarters without locking
+        for ( QImage &parent: parentRow ) {
+            parentBits << parent.bits();
+        }
+        bytesPerLine = parentRow.first().bytesPerLine();
     }
 
-    mDebug() << "tileLevel: " << maxTileLevel << " successfully created.";
-
-    tileLevel = maxTileLevel;
-
-    // Now that we have the tiles at the highest resolution lets build
-    // them together four by four.
-
-    while( tileLevel > 0 ) {
-        tileLevel--;
-
-        int  nmaxit =  TileLoaderHelper::levelToRow( defaultLevelZeroRows, tileLevel );
-
-        for ( int n = 0; n < nmaxit; ++n ) {
-            QString  dirName( d->m_targetDir
-                              + QString("%1/%2")
-                                  .arg(tileLevel)
-                                  .arg(n, tileDigits, 10, QLatin1Char('0')));
+    QVector<int> columns( tiles.size() );
+    for ( int m = 0; m < columns.size(); ++m ) {
+        columns[m] = m;
+    }
 
-            // mDebug() << "dirName: " << dirName;
-            if ( !QDir( dirName ).exists() ) 
-                ( QDir::root() ).mkpath( dirName );
+    bool const isMaxTileLevel = tileLevel == m_maxTileLevel;
+    QtConcurrent::blockingMap( columns, [&]( int m ) {
+        if ( m_cancelled || m_writeFailed.loadAcquire() )
+            return;
 
-            int   mmaxit = TileLoaderHelper::levelToColumn( defaultLevelZeroColumns, tileLevel );
-            for ( int m = 0; m < mmaxit; ++m ) {
+        QImage tile = tiles.at( m );
+        QString const newTileName = tileName( tileLevel, n, m );
 
-                if ( d->m_cancelled )
+        if ( m_resume && QFile::exists( newTileName ) ) {
+            //mDebug() << newTileName << "exists already";
+            if ( tile.isNull() ) {
+                tile = QImage( newTileName );
+                if ( tile.size() != QSize( c_defaultTileSize, c_defaultTileSize ) ) {
+                    m_writeFailed.storeRelease( 1 );
                     return;
-
-                QString newTileName = d->m_targetDir + QString("%1/%2/%2_%3.%4")
-                                           .arg( tileLevel )
-                                           .arg(n, tileDigits, 10, QLatin1Char('0'))
-                                           .arg(m, tileDigits, 10, QLatin1Char('0'))
-                                           .arg( d->m_tileFormat );
-
-                if ( QFile::exists( newTileName ) && d->m_resume ) {
-                    //mDebug() << newTileName << "exists already";
-                } else {
-                    tileName = d->m_targetDir + QString("%1/%2/%2_%3.%4")
-                                            .arg( tileLevel + 1 )
-                                            .arg(2*n, tileDigits, 10, QLatin1Char('0'))
-                                            .arg(2*m, tileDigits, 10, QLatin1Char('0'))
-                                            .arg( d->m_tileFormat );
-                    QImage  img_topleft( tileName );
-
-                    tileName = d->m_targetDir + QString("%1/%2/%2_%3.%4")
-                                            .arg( tileLevel + 1 )
-                                            .arg(2*n, tileDigits, 10, QLatin1Char('0'))
-                                            .arg(2*m+1, tileDigits, 10, QLatin1Char('0'))
-                                            .arg( d->m_tileFormat );
-                    QImage  img_topright( tileName );
-
-                    tileName = d->m_targetDir + QString("%1/%2/%2_%3.%4")
-                                            .arg( tileLevel + 1 )
-                                            .arg(2*n+1, tileDigits, 10, QLatin1Char('0'))
-                                            .arg(2*m, tileDigits, 10, QLatin1Char('0'))
-                                            .arg( d->m_tileFormat );
-                    QImage  img_bottomleft( tileName );
-
-                    tileName = d->m_targetDir + QString("%1/%2/%2_%3.%4")
-                                            .arg( tileLevel + 1 )
-                                            .arg(2*n+1, tileDigits, 10, QLatin1Char('0'))
-                                            .arg(2*m+1, tileDigits, 10, QLatin1Char('0'))
-                                            .arg( d->m_tileFormat );
-                    QImage  img_bottomright( tileName );
-
-                    QSize const expectedSize( c_defaultTileSize, c_defaultTileSize );
-                    if ( img_topleft.size() != expectedSize ||
-                         img_topright.size() != expectedSize ||
-                         img_bottomleft.size() != expectedSize ||
-                         img_bottomright.size() != expectedSize ) {
-                        mDebug() << "Tile write failure. Missing write permissions?";
-                        emit progress( 100 );
-                        return;
-                    }
-                    QImage  tile = img_topleft;
-
-                    if (d->m_dem == QLatin1String("true")) {
-
-                        tile.setColorTable( grayScalePalette );
-                        uchar* destLine;
-
-                        for ( uint y = 0; y < c_defaultTileSize / 2; ++y ) {
-                            destLine = tile.scanLine( y );
-                            const uchar* srcLine = img_topleft.scanLine( 2 * y );
-                            for ( uint x = 0; x < c_defaultTileSize / 2; ++x )
-                                destLine[x] = srcLine[ 2*x ];
-                        }
-                        for ( uint y = 0; y < c_defaultTileSize / 2; ++y ) {
-                            destLine = tile.scanLine( y );
-                            const uchar* srcLine = img_topright.scanLine( 2 * y );
-                            for ( uint x = c_defaultTileSize / 2; x < c_defaultTileSize; ++x )
-                                destLine[x] = srcLine[ 2 * ( x - c_defaultTileSize / 2 ) ];
-                        }
-                        for ( uint y = c_defaultTileSize / 2; y < c_defaultTileSize; ++y ) {
-                            destLine = tile.scanLine( y );
-                            const uchar* srcLine = img_bottomleft.scanLine( 2 * ( y - c_defaultTileSize / 2 ) );
-                            for ( uint x = 0; x < c_defaultTileSize / 2; ++x )
-                                destLine[ x ] = srcLine[ 2 * x ];
-                        }
-                        for ( uint y = c_defaultTileSize / 2; y < c_defaultTileSize; ++y ) {
-                            destLine = tile.scanLine( y );
-                            const uchar* srcLine = img_bottomright.scanLine( 2 * ( y - c_defaultTileSize/2 ) );
-                            for ( uint x = c_defaultTileSize / 2; x < c_defaultTileSize; ++x )
-                                destLine[x] = srcLine[ 2 * ( x - c_defaultTileSize / 2 ) ];
-                        }
-                    }
-                    else {
-
-                        // tile.depth() != 8
-
-                        img_topleft = img_topleft.convertToFormat( QImage::Format_ARGB32 );
-                        img_topright = img_topright.convertToFormat( QImage::Format_ARGB32 );
-                        img_bottomleft = img_bottomleft.convertToFormat( QImage::Format_ARGB32 );
-                        img_bottomright = img_bottomright.convertToFormat( QImage::Format_ARGB32 );
-                        tile = img_topleft;
-
-                        QRgb* destLine;
-
-                        for ( uint y = 0; y < c_defaultTileSize / 2; ++y ) {
-                            destLine = (QRgb*) tile.scanLine( y );
-                            const QRgb* srcLine = (QRgb*) img_topleft.scanLine( 2 * y );
-                            for ( uint x = 0; x < c_defaultTileSize / 2; ++x )
-                                destLine[x] = srcLine[ 2 * x ];
-                        }
-                        for ( uint y = 0; y < c_defaultTileSize / 2; ++y ) {
-                            destLine = (QRgb*) tile.scanLine( y );
-                            const QRgb* srcLine = (QRgb*) img_topright.scanLine( 2 * y );
-                            for ( uint x = c_defaultTileSize / 2; x < c_defaultTileSize; ++x )
-                                destLine[x] = srcLine[ 2 * ( x - c_defaultTileSize / 2 ) ];
-                        }
-                        for ( uint y = c_defaultTileSize / 2; y < c_defaultTileSize; ++y ) {
-                            destLine = (QRgb*) tile.scanLine( y );
-                            const QRgb* srcLine = (QRgb*) img_bottomleft.scanLine( 2 * ( y-c_defaultTileSize/2 ) );
-                            for ( uint x = 0; x < c_defaultTileSize / 2; ++x )
-                                destLine[x] = srcLine[ 2 * x ];
-                        }
-                        for ( uint y = c_defaultTileSize / 2; y < c_defaultTileSize; ++y ) {
-                            destLine = (QRgb*) tile.scanLine( y );
-                            const QRgb* srcLine = (QRgb*) img_bottomright.scanLine( 2 * ( y-c_defaultTileSize / 2 ) );
-                            for ( uint x = c_defaultTileSize / 2; x < c_defaultTileSize; ++x )
-                                destLine[x] = srcLine[ 2*( x-c_defaultTileSize / 2 ) ];
-                        }
-                    }
-
-                    mDebug() << newTileName;
-
-                    // Saving at 100% JPEG quality to have a high-quality
-                    // version to create the remaining needed tiles from.
-                    bool  ok = tile.save(newTileName, d->m_tileFormat.toLatin1().data(), d->m_tileFormat == QLatin1String("jpg") ? 100 : d->m_tileQuality);
-                    if ( ! ok )
-                        mDebug() << "Error while writing Tile: " << newTileName;
                 }
+            }
+        } else {
+            if (m_dem == QLatin1String("true")) {
+                tile = tile.convertToFormat(QImage::Format_Indexed8,
+                                            m_grayScalePalette,
+                                            Qt::ThresholdDither);
+            }
 
-                percentCompleted =  (int) ( 90 * (qreal)(createdTilesCount)
-                                            / (qreal)(totalTileCount) );	
-                createdTilesCount++;
-						
-                emit progress( percentCompleted );
-                mDebug() << "percentCompleted" << percentCompleted;
+            if ( !saveTile( tile, newTileName, m_verify && isMaxTileLevel ) ) {
+                m_writeFailed.storeRelease( 1 );
+                return;
             }
         }
-        mDebug() << "tileLevel: " << tileLevel << " successfully created.";
-    }
-    mDebug() << "Tile creation completed.";
 
-    if (d->m_tileFormat == QLatin1String("jpg") && d->m_tileQuality != 100) {
+        if ( tileLevel > 0 ) {
+            reduceTile( tile, parentBits[m / 2], bytesPerLine, n % 2, m % 2 );
+        }
+    } );
+
+    if ( m_cancelled || m_writeFailed.loadAcquire() )
+        return false;
+
+    m_createdTilesCount += tiles.size();
+    int const percentCompleted = (int) ( 99 * (qreal)(m_createdTilesCount)
+                                         / (qreal)(m_totalTileCount) );
+    if ( percentCompleted != m_percentCompleted ) {
+        // Don't reach 100% before the end as this would close the dialog unexpectedly
+        m_percentCompleted = percentCompleted;
+        emit q->progress( m_percentCompleted );
+        mDebug() << "percentCompleted" << m_percentCompleted;
+    }
 
-        // Applying correct lower JPEG compression now that we created all tiles
-        int savedTilesCount = 0;
+    if ( tileLevel > 0 && n % 2 == 1 ) {
+        QVector<QImage> const parentRow = m_parentRows[tileLevel - 1];
+        m_parentRows[tileLevel - 1].clear();
+        return processRow( tileLevel - 1, n / 2, parentRow );
+    }
 
-        tileLevel = 0;
-        while ( tileLevel <= maxTileLevel ) {
-            int nmaxit =  TileLoaderHelper::levelToRow( defaultLevelZeroRows, tileLevel );
-            for ( int n = 0; n < nmaxit; ++n) {
-                int mmaxit =  TileLoaderHelper::levelToColumn( defaultLevelZeroColumns, tileLevel );
-                for ( int m = 0; m < mmaxit; ++m) {
+    return true;
+}
 
-                    if ( d->m_cancelled )
-                        return;
+bool TileCreatorPrivate::saveTile( const QImage &tile, const QString &tileName, bool verify ) const
+{
+    // All levels are built from memory, so each tile is encoded once at its final quality
+    bool  ok = tile.save( tileName, m_tileFormat.toLatin1().data(), m_tileQuality );
+    if ( !ok ) {
+        mDebug() << "Error while writing Tile: " << tileName;
+        return false;
+    }
 
-                    savedTilesCount++;
+    if ( verify ) {
+        QImage writtenTile(tileName);
+        Q_ASSERT( writtenTile.size() == tile.size() );
+        for ( int i=0; i < writtenTile.size().width(); ++i) {
+            for ( int j=0; j < writtenTile.size().height(); ++j) {
+                if ( writtenTile.pixel( i, j ) != tile.pixel( i, j ) ) {
+                    unsigned int  pixel = tile.pixel( i, j);
+                    unsigned int  writtenPixel = writtenTile.pixel( i, j);
+                    qWarning() << "***** pixel" << i << j << "is off by" << (pixel - writtenPixel) << "pixel" << pixel << "writtenPixel" << writtenPixel;
+                    QByteArray baPixel((char*)&pixel, sizeof(unsigned int));
+                    qWarning() << "pixel" << baPixel.size() << "0x" << baPixel.toHex();
+                    QByteArray baWrittenPixel((char*)&writtenPixel, sizeof(unsigned int));
+                    qWarning() << "writtenPixel" << baWrittenPixel.size() << "0x" << baWrittenPixel.toHex();
+                    Q_ASSERT(false);
+                }
+            }
+        }
+    }
 
-                    tileName = d->m_targetDir + QString("%1/%2/%2_%3.%4")
-                                            .arg( tileLevel )
-                                            .arg(n, tileDigits, 10, QLatin1Char('0'))
-                                            .arg(m, tileDigits, 10, QLatin1Char('0'))
-                                            .arg( d->m_tileFormat );
-                    QImage tile( tileName );
+    return true;
+}
 
-                    bool ok;
+QImage TileCreatorPrivate::emptyTile() const
+{
+    if (m_dem == QLatin1String("true")) {
+        QImage tile( c_defaultTileSize, c_defaultTileSize, QImage::Format_Indexed8 );
+        tile.setColorTable( m_grayScalePalette );
+        return tile;
+    }
 
-                    ok = tile.save( tileName, d->m_tileFormat.toLatin1().data(), d->m_tileQuality );
+    return QImage( c_defaultTileSize, c_defaultTileSize, QImage::Format_ARGB32 );
+}
 
-                    if ( !ok )
-                        mDebug() << "Error while writing Tile: " << tileName;
-                    // Don't exceed 99% as this would cancel the thread unexpectedly
-                    percentCompleted = 90 + (int)( 9 * (qreal)(savedTilesCount)
-                                                / (qreal)(totalTileCount) );
-                    emit progress( percentCompleted );
-                    mDebug() << "percentCompleted" << percentCompleted;
-                    //mDebug() << "Saving Tile #" << savedTilesCount
-                    //         << " of " << totalTileCount
-                    //         << " Percent: " << percentCompleted;
-                }
-            }
-            tileLevel++;
+void TileCreatorPrivate::reduceTile( const QImage &tile, uchar *parentBits, int bytesPerLine,
+                                     int row, int column ) const
+{
+    // The top and left quarters take the first c_defaultTileSize / 2 pixels,
+    // the bottom and right ones the rest
+    uint const half = c_defaultTileSize / 2;
+    uint const yStart = row == 0 ? 0 : half;
+    uint const yEnd = row == 0 ? half : c_defaultTileSize;
+    uint const xStart = column == 0 ? 0 : half;
+    uint const xEnd = column == 0 ? half : c_defaultTileSize;
+
+    if (m_dem == QLatin1String("true")) {
+
+        // Grayscale tiles kept from a previous run are read with the same pixel values
+        QImage const source = tile.depth() == 8 ? tile
+                              : tile.convertToFormat( QImage::Format_Indexed8, m_grayScalePalette, Qt::ThresholdDither );
+
+        for ( uint y = yStart; y < yEnd; ++y ) {
+            uchar* destLine = parentBits + y * bytesPerLine;
+            const uchar* srcLine = source.constScanLine( 2 * ( y - yStart ) );
+            for ( uint x = xStart; x < xEnd; ++x )
+                destLine[x] = srcLine[ 2 * ( x - xStart ) ];
         }
     }
+    else {
 
-    percentCompleted = 100;
-    emit progress( percentCompleted );
+        QImage const source = tile.convertToFormat( QImage::Format_ARGB32 );
 
-    mDebug() << "percentCompleted: " << percentCompleted;
+        for ( uint y = yStart; y < yEnd; ++y ) {
+            QRgb* destLine = (QRgb*) ( parentBits + y * bytesPerLine );
+            const QRgb* srcLine = (const QRgb*) source.constScanLine( 2 * ( y - yStart ) );
+            for ( uint x = xStart; x < xEnd; ++x )
+                destLine[x] = srcLine[ 2 * ( x - xStart ) ];
+        }
+    }
 }
 
 void TileCreator::setTileFormat(const QString& format)
@@ -45,7 +45,8 @@ public:
     /**
      * Must return one specific tile
      *
-     * tileLevel can be used to calculate the number of tiles in a row or column
+     * tileLevel can be used to calculate the number of tiles in a row or column.
+     * Tiles are requested row by row, and never from more than one thread at once.
      */
     virtual QImage tile( int n, int m, int tileLevel ) = 0;
 };
@@ -30,10 +30,12 @@
 #include "GeoSceneTileDataset.h"
 #include "GeoSceneTypes.h"
 #include "GeoSceneVectorTileDataset.h"
+#include "GeoDataArena.h"
 #include "GeoDataDocument.h"
 #include "HttpDownloadManager.h"
 #include "MarbleDebug.h"
 #include "MarbleDirs.h"
+#include "MarbleTrace.h"
 #include "TileId.h"
 #include "TileLoaderHelper.h"
 #include "ParseRunnerPlugin.h"
@@ -66,6 +68,7 @@ TileLoader::~TileLoader()
 //     - if expired: create TextureTile, state is set to Expired by default, trigger dl,
 QImage TileLoader::loadTileImage( GeoSceneTextureTileDataset const *textureLayer, TileId const & tileId, DownloadUsage const usage )
 {
+    MarbleTraceScope traceScope( "LoadTextureTile", "tiles" );
     QString const fileName = tileFileName( textureLayer, tileId );
 
     TileStatus status = tileStatus( textureLayer, tileId );
@@ -101,6 +104,7 @@ QImage TileLoader::loadTileImage( GeoSceneTextureTileDataset const *textureLayer
 
 GeoDataDocument *TileLoader::loadTileVectorData( GeoSceneVectorTileDataset const *textureLayer, TileId const & tileId, DownloadUsage const usage )
 {
+    MarbleTraceScope traceScope( "LoadVectorTile", "tiles" );
     // FIXME: textureLayer->fileFormat() could be used in the future for use just that parser, instead of all available parsers
 
     QString const fileName = tileFileName( textureLayer, tileId );
@@ -333,6 +337,8 @@ GeoDataDocument *TileLoader::openVectorFile(const QString &fileName) const
         if ( extensions.contains( suffix ) || extensions.contains( completeSuffix ) ) {
             ParsingRunner* runner = plugin->newRunner();
             QString error;
+            // Tiles are deleted as a whole, so their objects can share an arena
+            GeoDataArena::Scope arenaScope;
             GeoDataDocument* document = runner->parseFile(fileName, UserDocument, error);
             if (!document && !error.isEmpty()) {
                 mDebug() << QString("Failed to open vector tile %1: %2").arg(fileName, error);
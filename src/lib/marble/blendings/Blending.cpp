@@ -15,11 +15,48 @@
 
 #include "Blending.h"
 
+#include <QImage>
+#include <QPair>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrentMap>
+
 namespace Marble
 {
 
+// Fewer rows are not worth the overhead of another thread
+static const int minimumBandHeight = 32;
+
 Blending::~Blending()
 {
 }
 
+bool Blending::dependsOnSun() const
+{
+    return false;
+}
+
+void Blending::blendRows( QImage * const image, std::function<void( int yTop, int yBottom )> const & blendRows )
+{
+    int const height = image->height();
+    int const bandCount = qBound( 1, height / minimumBandHeight, QThread::idealThreadCount() );
+    if ( bandCount == 1 ) {
+        blendRows( 0, height );
+        return;
+    }
+
+    // Detach now, the threads must not do that concurrently
+    image->bits();
+
+    QVector<QPair<int, int> > bands;
+    bands.reserve( bandCount );
+    for ( int i = 0; i < bandCount; ++i ) {
+        bands << qMakePair( i * height / bandCount, ( i + 1 ) * height / bandCount );
+    }
+
+    QtConcurrent::blockingMap( bands, [&blendRows]( QPair<int, int> const & band ) {
+        blendRows( band.first, band.second );
+    } );
+}
+
 }
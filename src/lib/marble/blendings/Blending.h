@@ -16,6 +16,8 @@
 #ifndef MARBLE_BLENDING_H
 #define MARBLE_BLENDING_H
 
+#include <functional>
+
 class QImage;
 
 namespace Marble
@@ -27,6 +29,18 @@ class Blending
  public:
     virtual ~Blending();
     virtual void blend( QImage * const bottom, TextureTile const * const top ) const = 0;
+
+    /**
+     * Returns whether the result depends on the position of the sun, so that it
+     * has to be recomputed whenever the sun moves.
+     */
+    virtual bool dependsOnSun() const;
+
+    /**
+     * Calls @p blendRows for bands of rows of @p image in parallel and waits for
+     * all of them. The image gets detached first, so each band may be written to.
+     */
+    static void blendRows( QImage * const image, std::function<void( int yTop, int yBottom )> const & blendRows );
 };
 
 }
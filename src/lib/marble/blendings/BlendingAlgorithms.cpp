@@ -49,17 +49,17 @@ void GrayscaleBlending::blend( QImage * const bottom, TextureTile const * const
 
     // Draw a grayscale version of the bottom image
     int const width = bottom->width();
-    int const height = bottom->height();
-
-    for ( int y = 0; y < height; ++y ) {
-        for ( int x = 0; x < width; ++x ) {
-            QRgb const topPixel = topImagePremult.pixel( x, y );
-            int const gray = qGray( topPixel );
-            QRgb const grayPixel = qRgb( gray, gray, gray );
-            bottom->setPixel( x, y,grayPixel );
-        }
-    }
 
+    blendRows( bottom, [&]( int yTop, int yBottom ) {
+        for ( int y = yTop; y < yBottom; ++y ) {
+            QRgb * const bottomLine = reinterpret_cast<QRgb *>( bottom->scanLine( y ) );
+            QRgb const * const topLine = reinterpret_cast<QRgb const *>( topImagePremult.constScanLine( y ) );
+            for ( int x = 0; x < width; ++x ) {
+                int const gray = qGray( topLine[x] );
+                bottomLine[x] = qRgb( gray, gray, gray );
+            }
+        }
+    } );
 }
 
 // pre-conditions:
@@ -73,24 +73,36 @@ void IndependentChannelBlending::blend( QImage * const bottom,
     Q_ASSERT( bottom->size() == topImage->size() );
     Q_ASSERT( bottom->format() == QImage::Format_ARGB32_Premultiplied );
 
+    // There are only 256 * 256 different pairs of channel intensities, so
+    // blendChannel() is evaluated once for each of them instead of three times
+    // per pixel. The results are truncated just like qRgb() would do.
+    std::call_once( m_lookupTableCreated, [this]() {
+        m_lookupTable.resize( 256 * 256 );
+        for ( int bottomIntensity = 0; bottomIntensity < 256; ++bottomIntensity ) {
+            for ( int topIntensity = 0; topIntensity < 256; ++topIntensity ) {
+                int const result = blendChannel( bottomIntensity / 255.0, topIntensity / 255.0 ) * 255.0;
+                m_lookupTable[( bottomIntensity << 8 ) | topIntensity] = result & 0xff;
+            }
+        }
+    } );
+
+    uchar const * const lookupTable = m_lookupTable.constData();
     int const width = bottom->width();
-    int const height = bottom->height();
     QImage const topImagePremult = topImage->convertToFormat( QImage::Format_ARGB32_Premultiplied );
-    for ( int y = 0; y < height; ++y ) {
-        for ( int x = 0; x < width; ++x ) {
-            QRgb const bottomPixel = bottom->pixel( x, y );
-            QRgb const topPixel = topImagePremult.pixel( x, y );
-            qreal const resultRed = blendChannel( qRed( bottomPixel ) / 255.0,
-                                                  qRed( topPixel ) / 255.0 );
-            qreal const resultGreen = blendChannel( qGreen( bottomPixel ) / 255.0,
-                                                    qGreen( topPixel ) / 255.0 );
-            qreal const resultBlue = blendChannel( qBlue( bottomPixel ) / 255.0,
-                                                   qBlue( topPixel ) / 255.0 );
-            bottom->setPixel( x, y, qRgb( resultRed * 255.0,
-                                          resultGreen * 255.0,
-                                          resultBlue * 255.0 ));
+
+    blendRows( bottom, [&]( int yTop, int yBottom ) {
+        for ( int y = yTop; y < yBottom; ++y ) {
+            QRgb * const bottomLine = reinterpret_cast<QRgb *>( bottom->scanLine( y ) );
+            QRgb const * const topLine = reinterpret_cast<QRgb const *>( topImagePremult.constScanLine( y ) );
+            for ( int x = 0; x < width; ++x ) {
+                QRgb const bottomPixel = bottomLine[x];
+                QRgb const topPixel = topLine[x];
+                bottomLine[x] = qRgb( lookupTable[( qRed( bottomPixel ) << 8 ) | qRed( topPixel )],
+                                      lookupTable[( qGreen( bottomPixel ) << 8 ) | qGreen( topPixel )],
+                                      lookupTable[( qBlue( bottomPixel ) << 8 ) | qBlue( topPixel )] );
+            }
         }
-    }
+    } );
 }
 
 
@@ -325,20 +337,43 @@ void CloudsBlending::blend( QImage * const bottom, TextureTile const * const top
     QImage const * const topImage = top->image();
     Q_ASSERT( topImage );
     Q_ASSERT( bottom->size() == topImage->size() );
+
+    // The clouds only depend on the red channel, which pixel() would return as
+    // qRed( color ) for all formats
+    QImage const topRgb = ( topImage->format() == QImage::Format_RGB32
+                            || topImage->format() == QImage::Format_ARGB32
+                            || topImage->format() == QImage::Format_ARGB32_Premultiplied )
+        ? *topImage
+        : topImage->convertToFormat( QImage::Format_RGB32 );
+
+    // Result of each bottom intensity (high byte) under each cloud intensity (low byte)
+    static QVector<uchar> const lookupTable = [] {
+        QVector<uchar> result( 256 * 256 );
+        for ( int bottomIntensity = 0; bottomIntensity < 256; ++bottomIntensity ) {
+            for ( int cloudIntensity = 0; cloudIntensity < 256; ++cloudIntensity ) {
+                qreal const c = cloudIntensity / 255.0;
+                result[( bottomIntensity << 8 ) | cloudIntensity] = ( int )( bottomIntensity + ( 255 - bottomIntensity ) * c );
+            }
+        }
+        return result;
+    }();
+
+    uchar const * const table = lookupTable.constData();
     int const width = bottom->width();
-    int const height = bottom->height();
-    for ( int y = 0; y < height; ++y ) {
-        for ( int x = 0; x < width; ++x ) {
-            qreal const c = qRed( topImage->pixel( x, y )) / 255.0;
-            QRgb const bottomPixel = bottom->pixel( x, y );
-            int const bottomRed = qRed( bottomPixel );
-            int const bottomGreen = qGreen( bottomPixel );
-            int const bottomBlue = qBlue( bottomPixel );
-            bottom->setPixel( x, y, qRgb(( int )( bottomRed + ( 255 - bottomRed ) * c ),
-                                         ( int )( bottomGreen + ( 255 - bottomGreen ) * c ),
-                                         ( int )( bottomBlue + ( 255 - bottomBlue ) * c )));
+
+    blendRows( bottom, [&]( int yTop, int yBottom ) {
+        for ( int y = yTop; y < yBottom; ++y ) {
+            QRgb * const bottomLine = reinterpret_cast<QRgb *>( bottom->scanLine( y ) );
+            QRgb const * const topLine = reinterpret_cast<QRgb const *>( topRgb.constScanLine( y ) );
+            for ( int x = 0; x < width; ++x ) {
+                int const c = qRed( topLine[x] );
+                QRgb const bottomPixel = bottomLine[x];
+                bottomLine[x] = qRgb( table[( qRed( bottomPixel ) << 8 ) | c],
+                                      table[( qGreen( bottomPixel ) << 8 ) | c],
+                                      table[( qBlue( bottomPixel ) << 8 ) | c] );
+            }
         }
-    }
+    } );
 }
 
 
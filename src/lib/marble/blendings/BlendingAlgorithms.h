@@ -17,6 +17,9 @@
 #define MARBLE_BLENDING_ALGORITHMS_H
 
 #include <QtGlobal>
+#include <QVector>
+
+#include <mutex>
 
 #include "Blending.h"
 
@@ -40,6 +43,10 @@ class IndependentChannelBlending: public Blending
     // all color intensity values are in the range 0..1
     virtual qreal blendChannel( qreal const bottomColorIntensity,
                                 qreal const topColorIntensity ) const = 0;
+
+    // blendChannel() for all pairs of 8 bit intensities, bottom in the high byte of the index
+    mutable QVector<uchar> m_lookupTable;
+    mutable std::once_flag m_lookupTableCreated;
 };
 
 
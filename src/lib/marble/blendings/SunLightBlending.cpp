@@ -41,6 +41,11 @@ SunLightBlending::~SunLightBlending()
 {
 }
 
+bool SunLightBlending::dependsOnSun() const
+{
+    return true;
+}
+
 void SunLightBlending::blend( QImage * const tileImage, TextureTile const * const top ) const
 {
     if ( tileImage->depth() != 32 )
@@ -64,72 +69,74 @@ void SunLightBlending::blend( QImage * const tileImage, TextureTile const * cons
 
     const QImage *nighttile = top->image();
 
-    for ( int cur_y = 0; cur_y < tileHeight; ++cur_y ) {
-        const qreal lat = lat_scale * ( id.y() * tileHeight + cur_y ) - 0.5*M_PI;
-        const qreal a = sin( ( lat+DEG2RAD * m_sunLocator->getLat() )/2.0 );
-        const qreal c = cos(lat)*cos( -DEG2RAD * m_sunLocator->getLat() );
+    blendRows( tileImage, [&]( int yTop, int yBottom ) {
+        for ( int cur_y = yTop; cur_y < yBottom; ++cur_y ) {
+            const qreal lat = lat_scale * ( id.y() * tileHeight + cur_y ) - 0.5*M_PI;
+            const qreal a = sin( ( lat+DEG2RAD * m_sunLocator->getLat() )/2.0 );
+            const qreal c = cos(lat)*cos( -DEG2RAD * m_sunLocator->getLat() );
 
-        QRgb* scanline  = (QRgb*)tileImage->scanLine( cur_y );
-        const QRgb* nscanline = (QRgb*)nighttile->scanLine( cur_y );
+            QRgb* scanline  = (QRgb*)tileImage->scanLine( cur_y );
+            const QRgb* nscanline = (QRgb*)nighttile->scanLine( cur_y );
 
-        qreal lastShade = -10.0;
+            qreal lastShade = -10.0;
 
-        int cur_x = 0;
+            int cur_x = 0;
 
-        while ( cur_x < tileWidth ) {
+            while ( cur_x < tileWidth ) {
 
-            const bool interpolate = ( cur_x != 0 && cur_x < ipRight && cur_x + n < tileWidth );
+                const bool interpolate = ( cur_x != 0 && cur_x < ipRight && cur_x + n < tileWidth );
 
-            qreal shade = 0;
+                qreal shade = 0;
 
-            if ( interpolate ) {
-                const int check = cur_x + n;
-                const qreal checklon   = lon_scale * ( id.x() * tileWidth + check );
-                shade = m_sunLocator->shading( checklon, a, c );
+                if ( interpolate ) {
+                    const int check = cur_x + n;
+                    const qreal checklon   = lon_scale * ( id.x() * tileWidth + check );
+                    shade = m_sunLocator->shading( checklon, a, c );
 
-                // if the shading didn't change across the interpolation
-                // interval move on and don't change anything.
-                if ( shade == lastShade && shade == 1.0 ) {
-                    scanline += n;
-                    nscanline += n;
-                    cur_x += n;
-                    continue;
-                }
-                if ( shade == lastShade && shade == 0.0 ) {
-                    for ( int t = 0; t < n; ++t ) {
+                    // if the shading didn't change across the interpolation
+                    // interval move on and don't change anything.
+                    if ( shade == lastShade && shade == 1.0 ) {
+                        scanline += n;
+                        nscanline += n;
+                        cur_x += n;
+                        continue;
+                    }
+                    if ( shade == lastShade && shade == 0.0 ) {
+                        for ( int t = 0; t < n; ++t ) {
+                            SunLocator::shadePixelComposite(*scanline, *nscanline, shade);
+                            ++scanline;
+                            ++nscanline;
+                        }
+                        cur_x += n;
+                        continue;
+                    }
+
+                    qreal lon = lon_scale * (id.x() * tileWidth + cur_x);
+                    for ( int t = 0; t < n ; ++t ) {
+                        shade = m_sunLocator->shading( lon, a, c );
                         SunLocator::shadePixelComposite(*scanline, *nscanline, shade);
                         ++scanline;
                         ++nscanline;
+                        lon += lon_scale;
                     }
                     cur_x += n;
-                    continue;
                 }
 
-                qreal lon = lon_scale * (id.x() * tileWidth + cur_x);
-                for ( int t = 0; t < n ; ++t ) {
-                    shade = m_sunLocator->shading( lon, a, c );
-                    SunLocator::shadePixelComposite(*scanline, *nscanline, shade);
-                    ++scanline;
-                    ++nscanline;
-                    lon += lon_scale;
-                }
-                cur_x += n;
-            }
-
-            else {
-                // Make sure we don't exceed the image memory
-                if ( cur_x < tileWidth ) {
-                    qreal lon   = lon_scale * ( id.x() * tileWidth + cur_x );
-                    shade = m_sunLocator->shading( lon, a, c );
-                    SunLocator::shadePixelComposite(*scanline, *nscanline, shade);
-                    ++scanline;
-                    ++nscanline;
-                    ++cur_x;
+                else {
+                    // Make sure we don't exceed the image memory
+                    if ( cur_x < tileWidth ) {
+                        qreal lon   = lon_scale * ( id.x() * tileWidth + cur_x );
+                        shade = m_sunLocator->shading( lon, a, c );
+                        SunLocator::shadePixelComposite(*scanline, *nscanline, shade);
+                        ++scanline;
+                        ++nscanline;
+                        ++cur_x;
+                    }
                 }
+                lastShade = shade;
             }
-            lastShade = shade;
         }
-    }
+    } );
 }
 
 void SunLightBlending::setLevelZeroLayout( int levelZeroColumns, int levelZeroRows )
@@ -31,6 +31,7 @@ class SunLightBlending: public Blending
     explicit SunLightBlending( const SunLocator * sunLocator );
     ~SunLightBlending() override;
     void blend( QImage * const bottom, TextureTile const * const top ) const override;
+    bool dependsOnSun() const override;
 
     void setLevelZeroLayout( int levelZeroColumns, int levelZeroRows );
 
@@ -0,0 +1,220 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoDataArena.h"
+
+#include <QMutex>
+
+#ifdef Q_OS_WIN
+#include <malloc.h>
+#endif
+#include <cstdlib>
+#include <new>
+
+namespace Marble
+{
+
+struct GeoDataArena::Chunk
+{
+    Chunk() : references( 1 ) {}
+
+    // Objects allocated from the chunk, plus one while the arena allocates from it
+    QAtomicInt references;
+};
+
+namespace {
+
+// Keep allocations aligned like those of operator new
+const std::size_t alignment = alignof( std::max_align_t );
+
+constexpr std::size_t aligned( std::size_t size )
+{
+    return ( size + alignment - 1 ) & ~( alignment - 1 );
+}
+
+// Chunks are aligned to their size, so the chunk of an object is found by
+// masking its address
+const int chunkBits = 16;
+const std::size_t chunkSize = std::size_t( 1 ) << chunkBits;
+// Larger objects are rare, they would waste the rest of a chunk
+const std::size_t maximumArenaAllocation = 1024;
+
+/**
+ * Two level bitmap over the address space recording which chunk sized
+ * regions are arena chunks. Tag bits above the address bits are ignored.
+ * Leaves are never freed, each of them covers 64 GiB of address space.
+ */
+const int addressBits = sizeof( void* ) == 8 ? 48 : 32;
+const int leafBits = addressBits - chunkBits < 20 ? addressBits - chunkBits : 20;
+const int rootBits = addressBits - chunkBits - leafBits;
+
+struct ChunkMapLeaf
+{
+    QAtomicInteger<quint32> words[( 1 << leafBits ) / 32];
+};
+
+QAtomicPointer<ChunkMapLeaf> chunkMap[1 << rootBits];
+QMutex chunkMapMutex;
+
+quintptr chunkIndex( const void *pointer )
+{
+    const quintptr address = quintptr( pointer ) & ( ( quintptr( 1 ) << ( addressBits - 1 ) << 1 ) - 1 );
+    return address >> chunkBits;
+}
+
+void markChunk( const void *chunk, bool isChunk )
+{
+    const quintptr index = chunkIndex( chunk );
+    QAtomicPointer<ChunkMapLeaf> &root = chunkMap[index >> leafBits];
+    ChunkMapLeaf *leaf = root.loadAcquire();
+    if ( !leaf ) {
+        QMutexLocker locker( &chunkMapMutex );
+        leaf = root.loadAcquire();
+        if ( !leaf ) {
+            leaf = new ChunkMapLeaf;
+            root.storeRelease( leaf );
+        }
+    }
+
+    const quintptr bit = index & ( ( 1 << leafBits ) - 1 );
+    const quint32 mask = quint32( 1 ) << ( bit % 32 );
+    if ( isChunk ) {
+        leaf->words[bit / 32].fetchAndOrOrdered( mask );
+    } else {
+        leaf->words[bit / 32].fetchAndAndOrdered( ~mask );
+    }
+}
+
+bool isInChunk( const void *pointer )
+{
+    const quintptr index = chunkIndex( pointer );
+    const ChunkMapLeaf *leaf = chunkMap[index >> leafBits].loadAcquire();
+    if ( !leaf ) {
+        return false;
+    }
+
+    const quintptr bit = index & ( ( 1 << leafBits ) - 1 );
+    return leaf->words[bit / 32].loadAcquire() & ( quint32( 1 ) << ( bit % 32 ) );
+}
+
+void *allocateChunkMemory()
+{
+#ifdef Q_OS_WIN
+    void *const memory = _aligned_malloc( chunkSize, chunkSize );
+#else
+    void *memory = nullptr;
+    if ( posix_memalign( &memory, chunkSize, chunkSize ) != 0 ) {
+        memory = nullptr;
+    }
+#endif
+    if ( !memory ) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void freeChunkMemory( void *memory )
+{
+#ifdef Q_OS_WIN
+    _aligned_free( memory );
+#else
+    std::free( memory );
+#endif
+}
+
+// Allocations only look for the arena of their thread while any scope exists
+QAtomicInt activeScopes;
+thread_local GeoDataArena *currentArena = nullptr;
+
+}
+
+GeoDataArena::GeoDataArena() :
+    m_chunk( nullptr ),
+    m_position( nullptr ),
+    m_end( nullptr )
+{
+}
+
+GeoDataArena::~GeoDataArena()
+{
+    if ( m_chunk ) {
+        release( m_chunk );
+    }
+}
+
+void *GeoDataArena::allocate( std::size_t size )
+{
+    if ( activeScopes.load() && size <= maximumArenaAllocation ) {
+        if ( GeoDataArena *const arena = currentArena ) {
+            void *const result = arena->allocateFromChunk( size );
+            arena->m_chunk->references.ref();
+            return result;
+        }
+    }
+
+    return ::operator new( size );
+}
+
+void GeoDataArena::deallocate( void *pointer )
+{
+    if ( !pointer ) {
+        return;
+    }
+
+    if ( isInChunk( pointer ) ) {
+        release( reinterpret_cast<Chunk*>( quintptr( pointer ) & ~quintptr( chunkSize - 1 ) ) );
+    } else {
+        ::operator delete( pointer );
+    }
+}
+
+void *GeoDataArena::allocateFromChunk( std::size_t size )
+{
+    size = aligned( size );
+    if ( std::size_t( m_end - m_position ) < size ) {
+        // The previous chunk is freed as soon as its objects are gone
+        if ( m_chunk ) {
+            release( m_chunk );
+        }
+        char *const memory = static_cast<char*>( allocateChunkMemory() );
+        m_chunk = new ( memory ) Chunk;
+        markChunk( m_chunk, true );
+        m_position = memory + aligned( sizeof( Chunk ) );
+        m_end = memory + chunkSize;
+    }
+
+    void *const result = m_position;
+    m_position += size;
+    return result;
+}
+
+void GeoDataArena::release( Chunk *chunk )
+{
+    if ( !chunk->references.deref() ) {
+        markChunk( chunk, false );
+        chunk->~Chunk();
+        freeChunkMemory( chunk );
+    }
+}
+
+GeoDataArena::Scope::Scope() :
+    m_arena( new GeoDataArena ),
+    m_previous( currentArena )
+{
+    currentArena = m_arena;
+    activeScopes.ref();
+}
+
+GeoDataArena::Scope::~Scope()
+{
+    activeScopes.deref();
+    currentArena = m_previous;
+    delete m_arena;
+}
+
+}
@@ -0,0 +1,104 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_GEODATAARENA_H
+#define MARBLE_GEODATAARENA_H
+
+#include "geodata_export.h"
+
+#include <QAtomicInt>
+
+#include <cstddef>
+
+namespace Marble
+{
+
+/**
+ * @brief Monotonic memory arena for the objects of a parsed document
+ *
+ * Features and geometries created while a GeoDataArena::Scope is active in
+ * the current thread are placed into the scope's arena by a simple bump of a
+ * pointer. The arena takes its memory from the heap in chunks of 64 KiB,
+ * aligned to their size. Deleting an object only decrements the counter of its
+ * chunk; a chunk is freed in one go once the arena has moved on to the next
+ * chunk, or the scope has ended, and all objects allocated from it have been
+ * deleted.
+ *
+ * Objects created outside of a scope are allocated with plain operator new,
+ * without any bookkeeping. Unless a scope is active in some thread, allocation
+ * costs one extra load of a global counter, deletion two lookups in a bitmap
+ * telling chunks from heap memory.
+ *
+ * Use a scope around code that creates a document which is deleted as a
+ * whole later on, like the parsing of a vector tile. Memory of objects that
+ * are deleted early is only reclaimed together with the rest of their chunk.
+ * Implicitly shared data like coordinates and the data of geometries is not
+ * placed into the arena, as copies of it easily outlive the document.
+ *
+ * Objects placed into an arena are aligned like objects allocated by
+ * operator new, to alignof( std::max_align_t ).
+ */
+class GEODATA_EXPORT GeoDataArena
+{
+public:
+    /**
+     * Creates a new arena and makes it the current one of the calling thread
+     * for the lifetime of the scope. Scopes nest.
+     */
+    class GEODATA_EXPORT Scope
+    {
+    public:
+        Scope();
+        ~Scope();
+
+    private:
+        Q_DISABLE_COPY( Scope )
+        GeoDataArena *m_arena;
+        GeoDataArena *m_previous;
+    };
+
+    /**
+     * Allocates @p size bytes from the current arena of the calling thread,
+     * or with operator new if there is none.
+     */
+    static void *allocate( std::size_t size );
+
+    /**
+     * Frees memory returned by allocate(). May be called from any thread.
+     */
+    static void deallocate( void *pointer );
+
+private:
+    Q_DISABLE_COPY( GeoDataArena )
+    GeoDataArena();
+    ~GeoDataArena();
+
+    struct Chunk;
+
+    void *allocateFromChunk( std::size_t size );
+    static void release( Chunk *chunk );
+
+    Chunk *m_chunk;
+    char *m_position;
+    char *m_end;
+};
+
+}
+
+/**
+ * Routes all heap allocations of a class and its subclasses through GeoDataArena.
+ * Leaves the following declarations public.
+ */
+#define GEODATA_ARENA_ALLOCATED \
+public: \
+    static void *operator new( std::size_t size ) { return Marble::GeoDataArena::allocate( size ); } \
+    static void *operator new( std::size_t, void *place ) { return place; } \
+    static void operator delete( void *pointer ) { Marble::GeoDataArena::deallocate( pointer ); } \
+    static void operator delete( void *, void * ) {}
+
+#endif
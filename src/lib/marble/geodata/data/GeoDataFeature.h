@@ -13,6 +13,7 @@
 #ifndef MARBLE_GEODATAFEATURE_H
 #define MARBLE_GEODATAFEATURE_H
 
+#include "GeoDataArena.h"
 #include "GeoDataObject.h"
 
 #include "geodata_export.h"
@@ -48,6 +49,8 @@ class GeoDataSnippet;
  */
 class GEODATA_EXPORT GeoDataFeature : public GeoDataObject
 {
+    GEODATA_ARENA_ALLOCATED
+
  public:
     GeoDataFeature();
     /// Create a new GeoDataFeature with @p name as its name.
@@ -118,6 +118,8 @@ public:
 
 class GeoDataFeaturePrivate
 {
+    GEODATA_ARENA_ALLOCATED
+
   public:
     GeoDataFeaturePrivate() :
         m_name(),
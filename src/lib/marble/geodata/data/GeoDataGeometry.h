@@ -15,6 +15,7 @@
 #define MARBLE_GEODATAGEOMETRY_H
 
 
+#include "GeoDataArena.h"
 #include "GeoDataObject.h"
 #include "MarbleGlobal.h"
 
@@ -42,6 +43,8 @@ class GeoDataMultiGeometry;
 
 class GEODATA_EXPORT GeoDataGeometry : public GeoDataObject
 {
+    GEODATA_ARENA_ALLOCATED
+
  public:
     ~GeoDataGeometry() override;
 
@@ -20,15 +20,20 @@
 #include "GeoDataPolyStyle.h"
 #include "OsmPlacemarkData.h"
 #include "GeoPainter.h"
+#include "ScreenPolygonPool.h"
 
-#include <QScreen>
 #include <QApplication>
+#include <QPainterPath>
+#include <QScreen>
 
 namespace Marble
 {
 
 BuildingGraphicsItem::BuildingGraphicsItem(const GeoDataPlacemark *placemark, const GeoDataBuilding *building)
-    : AbstractGeoPolygonGraphicsItem(placemark, building)
+    : AbstractGeoPolygonGraphicsItem(placemark, building),
+      m_hasInnerBoundaries(false),
+      m_drawAccurate3D(false),
+      m_isCameraAboveBuilding(false)
 {
     if (const auto ring = geodata_cast<GeoDataLinearRing>(&building->multiGeometry()->at(0))) {
         setLinearRing(ring);
@@ -53,19 +58,11 @@ BuildingGraphicsItem::~BuildingGraphicsItem()
     qDeleteAll(m_cachedInnerRoofPolygons);
 }
 
-void BuildingGraphicsItem::initializeBuildingPainting(const GeoPainter* painter, const ViewportParams *viewport,
-                                                      bool &drawAccurate3D, bool &isCameraAboveBuilding ) const
+int BuildingGraphicsItem::physicalPixelSize()
 {
-    drawAccurate3D = false;
-    isCameraAboveBuilding = false;
-
     auto const screen = QApplication::screens().first();
     double const physicalSize = 1.0; // mm
-    int const pixelSize = qRound(physicalSize * screen->physicalDotsPerInch() / (IN2M * M2MM));
-
-    QPointF offsetAtCorner = buildingOffset(QPointF(0, 0), viewport, &isCameraAboveBuilding);
-    qreal maxOffset = qMax( qAbs( offsetAtCorner.x() ), qAbs( offsetAtCorner.y() ) );
-    drawAccurate3D = painter->mapQuality() == HighQuality ? maxOffset > pixelSize : maxOffset > 1.5 * pixelSize;
+    return qRound(physicalSize * screen->physicalDotsPerInch() / (IN2M * M2MM));
 }
 
 void BuildingGraphicsItem::updatePolygons(const ViewportParams &viewport,
@@ -109,9 +106,9 @@ QPointF BuildingGraphicsItem::centroid(const QPolygonF &polygon, double &area)
     return area != 0 ? centroid / (6.0*area) : polygon.boundingRect().center();
 }
 
-QPointF BuildingGraphicsItem::buildingOffset(const QPointF &point, const ViewportParams *viewport, bool* isCameraAboveBuilding) const
+BuildingGraphicsItem::RoofShift BuildingGraphicsItem::roofShift(const ViewportParams *viewport) const
 {
-    qreal const cameraFactor = 0.5 * tan(0.5 * 110 * DEG2RAD);
+    static qreal const cameraFactor = 0.5 * tan(0.5 * 110 * DEG2RAD);
     Q_ASSERT(building()->height() > 0.0);
     qreal const buildingFactor = building()->height() / EARTH_RADIUS;
 
@@ -119,26 +116,24 @@ QPointF BuildingGraphicsItem::buildingOffset(const QPointF &point, const Viewpor
     qreal buildingHeightPixel = viewport->radius() * buildingFactor;
     qreal const cameraDistance = cameraHeightPixel-buildingHeightPixel;
 
-    if (isCameraAboveBuilding) {
-        *isCameraAboveBuilding = cameraDistance > 0;
-    }
-
-    qreal const cc = cameraDistance * cameraHeightPixel;
-    qreal const cb = cameraDistance * buildingHeightPixel;
-
-    // The following lines calculate the same result, but are potentially slower due
-    // to using more trigonometric method calls
+    // The shift calculated by RoofShift is the same as the following, but
+    // avoids the trigonometric method calls
     // qreal const alpha1 = atan2(offsetX, cameraHeightPixel);
     // qreal const alpha2 = atan2(offsetX, cameraHeightPixel-buildingHeightPixel);
     // qreal const shiftX = 2 * (cameraHeightPixel-buildingHeightPixel) * sin(0.5*(alpha2-alpha1));
 
-    qreal const offsetX = point.x() - viewport->width() / 2.0;
-    qreal const offsetY = point.y() - viewport->height() / 2.0;
-
-    qreal const shiftX = offsetX * cb / (cc + offsetX);
-    qreal const shiftY = offsetY * cb / (cc + offsetY);
+    RoofShift shift;
+    shift.centerX = viewport->width() / 2.0;
+    shift.centerY = viewport->height() / 2.0;
+    shift.cc = cameraDistance * cameraHeightPixel;
+    shift.cb = cameraDistance * buildingHeightPixel;
+    shift.isCameraAboveBuilding = cameraDistance > 0;
+    return shift;
+}
 
-    return QPointF(shiftX, shiftY);
+QPointF BuildingGraphicsItem::buildingOffset(const QPointF &point, const ViewportParams *viewport) const
+{
+    return roofShift(viewport)(point);
 }
 
 void BuildingGraphicsItem::paint(GeoPainter* painter, const ViewportParams* viewport, const QString &layer, int tileZoomLevel)
@@ -155,21 +150,7 @@ void BuildingGraphicsItem::paint(GeoPainter* painter, const ViewportParams* view
 
     // For level 18, 19 .. render 3D buildings in perspective
     if (layer.endsWith(QLatin1String("/frame"))) {
-        qDeleteAll(m_cachedOuterPolygons);
-        qDeleteAll(m_cachedInnerPolygons);
-        qDeleteAll(m_cachedOuterRoofPolygons);
-        qDeleteAll(m_cachedInnerRoofPolygons);
-        m_cachedOuterPolygons.clear();
-        m_cachedInnerPolygons.clear();
-        m_cachedOuterRoofPolygons.clear();
-        m_cachedInnerRoofPolygons.clear();
-        updatePolygons(*viewport, m_cachedOuterPolygons,
-                                 m_cachedInnerPolygons,
-                                 m_hasInnerBoundaries);
-        if (m_cachedOuterPolygons.isEmpty()) {
-            return;
-        }
-        paintFrame(painter, viewport);
+        paintFrames(painter, viewport, layer, tileZoomLevel, QVector<BuildingGraphicsItem*>() << this);
     } else if (layer.endsWith(QLatin1String("/roof"))) {
         if (m_cachedOuterPolygons.isEmpty()) {
             return;
@@ -182,10 +163,9 @@ void BuildingGraphicsItem::paint(GeoPainter* painter, const ViewportParams* view
 
 void BuildingGraphicsItem::paintRoof(GeoPainter* painter, const ViewportParams* viewport)
 {
-    bool drawAccurate3D;
-    bool isCameraAboveBuilding;
-    initializeBuildingPainting(painter, viewport, drawAccurate3D, isCameraAboveBuilding);
-    if (!isCameraAboveBuilding) {
+    // Decided when painting the frame
+    bool const drawAccurate3D = m_drawAccurate3D;
+    if (!m_isCameraAboveBuilding) {
         return; // do not render roof if we look inside the building
     }
 
@@ -227,7 +207,7 @@ void BuildingGraphicsItem::paintRoof(GeoPainter* painter, const ViewportParams*
             for( const QPolygonF* innerRoof: m_cachedInnerRoofPolygons ) {
                 painter->drawPolyline( *innerRoof );
             }
-            qDeleteAll(fillPolygons);
+            ScreenPolygonPool::release(fillPolygons);
         }
         else {
             for( const QPolygonF* outerRoof: m_cachedOuterRoofPolygons ) {
@@ -259,7 +239,7 @@ void BuildingGraphicsItem::paintRoof(GeoPainter* painter, const ViewportParams*
             for( const QPolygonF* innerPolygon:  m_cachedInnerPolygons ) {
                 painter->drawPolyline( *innerPolygon );
             }
-            qDeleteAll(fillPolygons);
+            ScreenPolygonPool::release(fillPolygons);
         }
         else {
             for( const QPolygonF* outerPolygon:  m_cachedOuterPolygons ) {
@@ -323,22 +303,146 @@ void BuildingGraphicsItem::paintRoof(GeoPainter* painter, const ViewportParams*
     }
 }
 
-void BuildingGraphicsItem::paintFrame(GeoPainter *painter, const ViewportParams *viewport)
+void BuildingGraphicsItem::paintFrames(GeoPainter *painter, const ViewportParams *viewport, const QString &layer,
+                                       int tileZoomLevel, const QVector<BuildingGraphicsItem*> &buildings)
 {
-    // TODO: how does this match the Q_ASSERT in the constructor?
-    if (building()->height() == 0.0) {
+    // Just display flat buildings for tile level 17
+    if (tileZoomLevel == 17) {
+        for (BuildingGraphicsItem *item: buildings) {
+            item->paint(painter, viewport, layer, tileZoomLevel);
+        }
         return;
     }
 
-    if ((polygon() && !viewport->resolves(polygon()->outerBoundary().latLonAltBox(), 4))
-            || (ring() && !viewport->resolves(ring()->latLonAltBox(), 4))) {
-        return;
+    int const pixelSize = physicalPixelSize();
+    qreal const accurate3DThreshold = painter->mapQuality() == HighQuality ? pixelSize : 1.5 * pixelSize;
+
+    // Walls facing the viewer, all added with the same orientation so that
+    // overlapping walls don't cancel each other out
+    QPainterPath walls;
+    walls.setFillRule(Qt::WindingFill);
+    QColor wallColor;
+    QPen wallPen(Qt::NoPen);
+
+    auto const fillWalls = [&]() {
+        if (walls.isEmpty()) {
+            return;
+        }
+        painter->setPen(wallPen);
+        painter->setBrush(wallColor);
+        painter->drawPath(walls);
+        walls = QPainterPath();
+        walls.setFillRule(Qt::WindingFill);
+        s_previousStyle = nullptr;
+    };
+
+    for (BuildingGraphicsItem *item: buildings) {
+        item->setZValue(item->building()->height());
+
+        ScreenPolygonPool::release(item->m_cachedOuterPolygons);
+        ScreenPolygonPool::release(item->m_cachedInnerPolygons);
+        ScreenPolygonPool::release(item->m_cachedOuterRoofPolygons);
+        ScreenPolygonPool::release(item->m_cachedInnerRoofPolygons);
+        item->updatePolygons(*viewport, item->m_cachedOuterPolygons,
+                             item->m_cachedInnerPolygons,
+                             item->m_hasInnerBoundaries);
+        if (item->m_cachedOuterPolygons.isEmpty()) {
+            continue;
+        }
+
+        // TODO: how does this match the Q_ASSERT in the constructor?
+        bool const hasWalls = item->building()->height() != 0.0
+                && !(item->polygon() && !viewport->resolves(item->polygon()->outerBoundary().latLonAltBox(), 4))
+                && !(item->ring() && !viewport->resolves(item->ring()->latLonAltBox(), 4));
+
+        // The roof is painted for buildings without walls as well, then
+        // without roof polygons of its own
+        RoofShift const shift = item->roofShift(viewport);
+        QPointF const offsetAtCorner = shift(QPointF(0, 0));
+        qreal const maxOffset = qMax(qAbs(offsetAtCorner.x()), qAbs(offsetAtCorner.y()));
+        item->m_drawAccurate3D = hasWalls && maxOffset > accurate3DThreshold;
+        item->m_isCameraAboveBuilding = shift.isCameraAboveBuilding;
+
+        if (!hasWalls) {
+            continue;
+        }
+
+        if (!item->m_drawAccurate3D || !item->m_isCameraAboveBuilding) {
+            fillWalls();
+            item->paintFlatFrame(painter);
+            continue;
+        }
+
+        // Like configurePainterForFrame(), buildings without style get outlined walls
+        GeoDataStyle::ConstPtr const style = item->style();
+        QColor color = painter->brush().color();
+        QPen pen;
+        if (style) {
+            const GeoDataPolyStyle& polyStyle = style->polyStyle();
+            if (!polyStyle.fill()) {
+                continue;
+            }
+            color = polyStyle.paintedColor().darker(150);
+            pen = QPen(Qt::NoPen);
+        }
+
+        if (color != wallColor || pen != wallPen) {
+            fillWalls();
+            wallColor = color;
+            wallPen = pen;
+        }
+
+        addWalls(shift, item->m_cachedOuterPolygons, true, item->m_cachedOuterRoofPolygons, walls);
+        addWalls(shift, item->m_cachedInnerPolygons, false, item->m_cachedInnerRoofPolygons, walls);
     }
 
-    bool drawAccurate3D;
-    bool isCameraAboveBuilding;
-    initializeBuildingPainting(painter, viewport, drawAccurate3D, isCameraAboveBuilding);
+    fillWalls();
+}
 
+void BuildingGraphicsItem::addWalls(const RoofShift &shift, const QVector<QPolygonF*> &outlines, bool isOuter,
+                                    QVector<QPolygonF*> &roofs, QPainterPath &walls)
+{
+    for (const QPolygonF *outline: outlines) {
+        if (outline->isEmpty()) {
+            continue;
+        }
+        // the building sides
+        int const size = outline->size();
+        QPolygonF * roof = ScreenPolygonPool::create();
+        roof->reserve(size);
+        QPointF a = (*outline)[0];
+        QPointF shiftA = a + shift(a);
+        roof->append(shiftA);
+        for (int i=1; i<size; ++i) {
+            QPointF const & b = (*outline)[i];
+            QPointF const shiftB = b + shift(b);
+            // perform backface culling, inner walls are seen from their back
+            bool const backface = (b.x() - a.x()) * (shiftA.y() - a.y())
+                    - (b.y() - a.y()) * (shiftA.x() - a.x()) >= 0;
+            if (backface != isOuter) {
+                if (isOuter) {
+                    walls.moveTo(a);
+                    walls.lineTo(shiftA);
+                    walls.lineTo(shiftB);
+                    walls.lineTo(b);
+                } else {
+                    walls.moveTo(b);
+                    walls.lineTo(shiftB);
+                    walls.lineTo(shiftA);
+                    walls.lineTo(a);
+                }
+                walls.closeSubpath();
+            }
+            a = b;
+            shiftA = shiftB;
+            roof->append(shiftA);
+        }
+        roofs.append(roof);
+    }
+}
+
+void BuildingGraphicsItem::paintFlatFrame(GeoPainter *painter)
+{
     bool isValid = true;
     if (s_previousStyle != style().data()) {
         isValid = configurePainterForFrame(painter);
@@ -347,75 +451,14 @@ void BuildingGraphicsItem::paintFrame(GeoPainter *painter, const ViewportParams
 
     if (!isValid) return;
 
-    if ( drawAccurate3D && isCameraAboveBuilding ) {
-        for (const QPolygonF *outline: m_cachedOuterPolygons) {
-            if (outline->isEmpty()) {
-                continue;
-            }
-            // draw the building sides
-            int const size = outline->size();
-            QPolygonF * outerRoof = new QPolygonF;
-            outerRoof->reserve(outline->size());
-            QPointF a = (*outline)[0];
-            QPointF shiftA = a + buildingOffset(a, viewport);
-            outerRoof->append(shiftA);
-            for (int i=1; i<size; ++i) {
-                QPointF const & b = (*outline)[i];
-                QPointF const shiftB = b + buildingOffset(b, viewport);
-                // perform backface culling
-                bool backface = (b.x() - a.x()) * (shiftA.y() - a.y())
-                        - (b.y() - a.y()) * (shiftA.x() - a.x()) >= 0;
-                if (!backface) {
-                    QPolygonF buildingSide;
-                    buildingSide.reserve(4);
-                    buildingSide << a << shiftA << shiftB << b;
-                    painter->drawPolygon(buildingSide);
-                }
-                a = b;
-                shiftA = shiftB;
-                outerRoof->append(shiftA);
-            }
-            m_cachedOuterRoofPolygons.append(outerRoof);
-        }
-        for (const QPolygonF *outline: m_cachedInnerPolygons) {
-            if (outline->isEmpty()) {
-                continue;
-            }
-            // draw the building sides
-            int const size = outline->size();
-            QPolygonF * innerRoof = new QPolygonF;
-            innerRoof->reserve(outline->size());
-            QPointF a = (*outline)[0];
-            QPointF shiftA = a + buildingOffset(a, viewport);
-            innerRoof->append(shiftA);
-            for (int i=1; i<size; ++i) {
-                QPointF const & b = (*outline)[i];
-                QPointF const shiftB = b + buildingOffset(b, viewport);
-                // perform backface culling
-                bool backface = (b.x() - a.x()) * (shiftA.y() - a.y())
-                        - (b.y() - a.y()) * (shiftA.x() - a.x()) >= 0;
-                if (backface) {
-                    QPolygonF buildingSide;
-                    buildingSide.reserve(4);
-                    buildingSide << a << shiftA << shiftB << b;
-                    painter->drawPolygon(buildingSide);
-                }
-                a = b;
-                shiftA = shiftB;
-                innerRoof->append(shiftA);
-            }
-            m_cachedInnerRoofPolygons.append(innerRoof);
-        }
-    } else {
-            // don't draw the building sides - just draw the base frame instead
-            QVector<QPolygonF*> fillPolygons = painter->createFillPolygons( m_cachedOuterPolygons,
-                                                                   m_cachedInnerPolygons );
+    // don't draw the building sides - just draw the base frame instead
+    QVector<QPolygonF*> fillPolygons = painter->createFillPolygons( m_cachedOuterPolygons,
+                                                                    m_cachedInnerPolygons );
 
-            for( QPolygonF* fillPolygon: fillPolygons ) {
-                painter->drawPolygon(*fillPolygon);
-            }
-            qDeleteAll(fillPolygons);
+    for( QPolygonF* fillPolygon: fillPolygons ) {
+        painter->drawPolygon(*fillPolygon);
     }
+    ScreenPolygonPool::release(fillPolygons);
 }
 
 void BuildingGraphicsItem::screenPolygons(const ViewportParams &viewport, const GeoDataPolygon *polygon,
@@ -14,7 +14,9 @@
 #include "AbstractGeoPolygonGraphicsItem.h"
 #include "GeoDataCoordinates.h"
 
-class QPointF;
+#include <QPointF>
+
+class QPainterPath;
 
 namespace Marble
 {
@@ -28,19 +30,48 @@ public:
 public:
     void paint(GeoPainter* painter, const ViewportParams *viewport, const QString &layer, int tileZoomLevel) override;
 
+    /**
+     * Paints the frame layer of @p buildings, ordered by height like the items
+     * of any other layer. The walls of consecutive buildings of the same color
+     * are gathered into a single path which is filled at once.
+     */
+    static void paintFrames(GeoPainter *painter, const ViewportParams *viewport, const QString &layer,
+                            int tileZoomLevel, const QVector<BuildingGraphicsItem*> &buildings);
+
 private:
-    void paintFrame(GeoPainter* painter, const ViewportParams *viewport);
+    /**
+     * Shifts a screen position at the base of the building to the roof
+     */
+    struct RoofShift
+    {
+        qreal centerX;
+        qreal centerY;
+        qreal cc;
+        qreal cb;
+        bool isCameraAboveBuilding;
+
+        QPointF operator()(const QPointF &point) const
+        {
+            qreal const offsetX = point.x() - centerX;
+            qreal const offsetY = point.y() - centerY;
+            return QPointF(offsetX * cb / (cc + offsetX), offsetY * cb / (cc + offsetY));
+        }
+    };
+
+    void paintFlatFrame(GeoPainter* painter);
 
     void paintRoof(GeoPainter* painter, const ViewportParams *viewport);
     bool configurePainterForFrame(GeoPainter *painter) const;
-    void initializeBuildingPainting(const GeoPainter* painter, const ViewportParams *viewport,
-                                    bool &drawAccurate3D, bool &isCameraAboveBuilding) const;
+    static int physicalPixelSize();
     void updatePolygons(const ViewportParams &viewport,
                          QVector<QPolygonF*>& outlinePolygons,
                          QVector<QPolygonF*>& innerPolygons,
                          bool &hasInnerBoundaries) const;
 
-    QPointF buildingOffset(const QPointF &point, const ViewportParams *viewport, bool* isCameraAboveBuilding = nullptr) const;
+    RoofShift roofShift(const ViewportParams *viewport) const;
+    QPointF buildingOffset(const QPointF &point, const ViewportParams *viewport) const;
+    static void addWalls(const RoofShift &shift, const QVector<QPolygonF*> &outlines, bool isOuter,
+                         QVector<QPolygonF*> &roofs, QPainterPath &walls);
 
     static QPointF centroid(const QPolygonF &polygon, double &area);
     static void screenPolygons(const ViewportParams &viewport, const GeoDataPolygon *polygon,
@@ -56,6 +87,8 @@ private:
     QVector<QPolygonF*> m_cachedOuterRoofPolygons;
     QVector<QPolygonF*> m_cachedInnerRoofPolygons;
     bool m_hasInnerBoundaries;
+    bool m_drawAccurate3D;
+    bool m_isCameraAboveBuilding;
 
 };
 
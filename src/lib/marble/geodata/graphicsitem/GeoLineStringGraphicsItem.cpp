@@ -21,6 +21,7 @@
 #include "GeoDataColorStyle.h"
 #include "MarbleDebug.h"
 #include "OsmPlacemarkData.h"
+#include "ScreenPolygonPool.h"
 
 #include <qmath.h>
 #include <QPainterPathStroker>
@@ -136,8 +137,7 @@ void GeoLineStringGraphicsItem::paint(GeoPainter* painter, const ViewportParams*
     setRenderContext(RenderContext(tileLevel));
 
     if (layer.endsWith(QLatin1String("/outline"))) {
-        qDeleteAll(m_cachedPolygons);
-        m_cachedPolygons.clear();
+        ScreenPolygonPool::release(m_cachedPolygons);
         m_cachedRegion = QRegion();
         painter->polygonsFromLineString(*m_renderLineString, m_cachedPolygons);
         if (m_cachedPolygons.empty()) {
@@ -158,8 +158,7 @@ void GeoLineStringGraphicsItem::paint(GeoPainter* painter, const ViewportParams*
             }
         }
     } else {
-        qDeleteAll(m_cachedPolygons);
-        m_cachedPolygons.clear();
+        ScreenPolygonPool::release(m_cachedPolygons);
         m_cachedRegion = QRegion();
         painter->polygonsFromLineString(*m_renderLineString, m_cachedPolygons);
         if (m_cachedPolygons.empty()) {
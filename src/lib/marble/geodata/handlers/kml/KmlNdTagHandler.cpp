@@ -19,7 +19,6 @@
 #include "GeoDataLineString.h"
 #include "GeoDataLinearRing.h"
 #include "GeoDataPolygon.h"
-#include "GeoDataPoint.h"
 #include "osm/OsmPlacemarkData.h"
 
 // Qt
@@ -45,10 +44,11 @@ GeoNode* KmlndTagHandler::parse( GeoParser& parser ) const
      */
     if( parser.parentElement().represents( kmlTag_OsmPlacemarkData ) && parser.parentElement( 2 ).is<GeoDataPlacemark>() ) {
         GeoDataPlacemark *placemark = parser.parentElement( 2 ).nodeAs<GeoDataPlacemark>();
-        if (auto lineString = geodata_cast<GeoDataLineString>(placemark->geometry())) {
-            // Using GeoDataPoint because GeoDataCoordinates is not a GeoNode, so it can't be returned.
-            GeoDataPoint *point = new GeoDataPoint( lineString->at( ndIndex ) );
-            return point;
+        auto lineString = geodata_cast<GeoDataLineString>(placemark->geometry());
+        if ( lineString && ndIndex >= 0 && ndIndex < lineString->size() ) {
+            // The node's own OsmPlacemarkData is read into the reference of the vertex
+            OsmPlacemarkData *placemarkOsmData = parser.parentElement().nodeAs<OsmPlacemarkData>();
+            return &placemarkOsmData->nodeReference( ndIndex );
         }
         return nullptr;
     }
@@ -65,10 +65,10 @@ GeoNode* KmlndTagHandler::parse( GeoParser& parser ) const
     */
     else if ( parser.parentElement().represents( kmlTag_OsmPlacemarkData ) && parser.parentElement( 1 ).is<GeoDataLinearRing>() ) {
         GeoDataLinearRing *linearRing = parser.parentElement( 1 ).nodeAs<GeoDataLinearRing>();
-
-        // Using GeoDataPoint because GeoDataCoordinates is not a GeoNode, so it can't be returned.
-        GeoDataPoint *point = new GeoDataPoint( linearRing->at( ndIndex ) );
-        return point;
+        if ( ndIndex >= 0 && ndIndex < linearRing->size() ) {
+            OsmPlacemarkData *ringOsmData = parser.parentElement().nodeAs<OsmPlacemarkData>();
+            return &ringOsmData->nodeReference( ndIndex );
+        }
     }
     return nullptr;
 }
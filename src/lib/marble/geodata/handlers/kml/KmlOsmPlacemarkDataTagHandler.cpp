@@ -18,7 +18,6 @@
 #include "GeoDataPolygon.h"
 #include "GeoDataData.h"
 #include "GeoParser.h"
-#include "GeoDataPoint.h"
 #include "osm/OsmPlacemarkData.h"
 
 #include <QVariant>
@@ -43,7 +42,8 @@ GeoNode* KmlOsmPlacemarkDataTagHandler::parse( GeoParser& parser ) const
         placemark->setOsmData(osmData);
         return &placemark->osmData();
     }
-    /* Case 2: This is the OsmPlacemarkData of a Nd
+    /* Case 2: This is the OsmPlacemarkData of a Nd, the nd element provides
+     * the node reference of its vertex
      * <Placemark>
      *      <ExtendedData>
      *          <mx:OsmPlacemarkData>
@@ -51,16 +51,10 @@ GeoNode* KmlOsmPlacemarkDataTagHandler::parse( GeoParser& parser ) const
      *                  <mx:OsmPlacemarkData>
      * ...
      */
-    else if ( parser.parentElement( 1 ).is<OsmPlacemarkData>() && parser.parentElement().is<GeoDataPoint>() ) {
-        OsmPlacemarkData* placemarkOsmData = parser.parentElement( 1 ).nodeAs<OsmPlacemarkData>();
-        GeoDataPoint *point = parser.parentElement().nodeAs<GeoDataPoint>();
-        GeoDataCoordinates coordinates = point->coordinates();
-        /* The GeoDataPoint object was only used as GeoNode wrapper for the GeoDataCoordinates
-         * and it is no longer needed
-         */
-        delete point;
-        placemarkOsmData->addNodeReference( coordinates, osmData );
-        return &placemarkOsmData->nodeReference( coordinates );
+    else if ( parser.parentElement( 1 ).is<OsmPlacemarkData>() && parser.parentElement().is<OsmPlacemarkData>() ) {
+        OsmPlacemarkData *nodeOsmData = parser.parentElement().nodeAs<OsmPlacemarkData>();
+        *nodeOsmData = osmData;
+        return nodeOsmData;
     }
     /* Case 3: This is the OsmPlacemarkData of a polygon's member
      * <Placemark>
@@ -143,14 +143,21 @@ void GeoParser::parseDocument()
     }
 
     bool processChildren = true;
-    QualifiedName qName( name().toString(), namespaceUri().toString() );
 
     if( tokenType() == QXmlStreamReader::Invalid )
         raiseWarning( QString( "%1: %2" ).arg( error() ).arg( errorString() ) );
 
+    // Known elements share the strings of their registered name,
+    // only unknown ones need a copy of their own
+    QualifiedName qName;
+    const GeoTagHandler* handler = GeoTagHandler::recognizes( name(), namespaceUri(), qName );
+    if ( !handler ) {
+        qName = QualifiedName( name().toString(), namespaceUri().toString() );
+    }
+
     GeoStackItem stackItem( qName, nullptr );
 
-    if ( const GeoTagHandler* handler = GeoTagHandler::recognizes( qName )) {
+    if ( handler ) {
         stackItem.assignNode( handler->parse( *this ));
         processChildren = !isEndElement();
     }
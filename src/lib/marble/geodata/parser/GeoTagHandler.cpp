@@ -26,6 +26,11 @@
 // Marble
 #include "MarbleDebug.h"
 
+// Qt
+#include <QAtomicPointer>
+#include <QMutex>
+#include <QVector>
+
 
 namespace Marble
 {
@@ -35,6 +40,102 @@ namespace Marble
 
 GeoTagHandler::TagHash* GeoTagHandler::s_tagHandlerHash = nullptr;
 
+/**
+ * Open addressing table of all registered tag handlers. It is built lazily
+ * from the tag hash, trying a few hash seeds to find one that maps every
+ * qualified name to a slot of its own. Lookups then take a single probe
+ * and compare the element name in place, without creating any QString.
+ */
+class GeoTagTable
+{
+public:
+    typedef QHash<GeoParser::QualifiedName, const GeoTagHandler*> TagHash;
+
+    explicit GeoTagTable( const TagHash &hash );
+
+    const GeoTagHandler* find( const QStringRef &name, const QStringRef &namespaceUri,
+                               GeoParser::QualifiedName &qualifiedName ) const;
+
+    // Replaced tables are kept alive, parsers in other threads may still use them
+    GeoTagTable *m_retired;
+
+private:
+    struct Entry
+    {
+        Entry() : handler( nullptr ) {}
+
+        GeoParser::QualifiedName name;
+        const GeoTagHandler *handler;
+    };
+
+    template<class T>
+    uint slot( const T &name, const T &namespaceUri ) const
+    {
+        return qHash( name, qHash( namespaceUri, m_seed ) ) & m_mask;
+    }
+
+    QVector<Entry> m_entries;
+    uint m_mask;
+    uint m_seed;
+};
+
+GeoTagTable::GeoTagTable( const TagHash &hash ) :
+    m_retired( nullptr ),
+    m_mask( 15 ),
+    m_seed( 0 )
+{
+    while ( m_mask + 1 < uint( 2 * hash.size() ) ) {
+        m_mask = ( m_mask << 1 ) | 1;
+    }
+
+    QVector<bool> occupied;
+    const uint maximumSeed = 32;
+    for ( ; m_seed < maximumSeed; ++m_seed ) {
+        occupied.fill( false, m_mask + 1 );
+        bool perfect = true;
+        for ( TagHash::const_iterator it = hash.constBegin(); it != hash.constEnd() && perfect; ++it ) {
+            const uint index = slot( it.key().first, it.key().second );
+            perfect = !occupied[index];
+            occupied[index] = true;
+        }
+        if ( perfect ) {
+            break;
+        }
+    }
+
+    // Without a perfect seed colliding names fall back to linear probing
+    m_seed = qMin( m_seed, maximumSeed - 1 );
+    m_entries.resize( m_mask + 1 );
+    for ( TagHash::const_iterator it = hash.constBegin(); it != hash.constEnd(); ++it ) {
+        uint index = slot( it.key().first, it.key().second );
+        while ( m_entries[index].handler ) {
+            index = ( index + 1 ) & m_mask;
+        }
+        m_entries[index].name = it.key();
+        m_entries[index].handler = it.value();
+    }
+}
+
+const GeoTagHandler* GeoTagTable::find( const QStringRef &name, const QStringRef &namespaceUri,
+                                          GeoParser::QualifiedName &qualifiedName ) const
+{
+    for ( uint index = slot( name, namespaceUri ); m_entries[index].handler; index = ( index + 1 ) & m_mask ) {
+        const Entry &entry = m_entries[index];
+        if ( name == entry.name.first && namespaceUri == entry.name.second ) {
+            qualifiedName = entry.name;
+            return entry.handler;
+        }
+    }
+
+    return nullptr;
+}
+
+// Rebuilt on the first lookup after handlers were (un)registered. Handlers
+// register during static initialization, so only use constant initialized types.
+static QAtomicPointer<GeoTagTable> s_tagTable;
+static QBasicMutex s_tagTableMutex;
+static GeoTagTable* s_retiredTagTables = nullptr;
+
 GeoTagHandler::GeoTagHandler()
 {
 }
@@ -59,6 +160,7 @@ void GeoTagHandler::registerHandler(const GeoParser::QualifiedName& qName, const
     Q_ASSERT(!hash->contains(qName));
     hash->insert(qName, handler);
     Q_ASSERT(hash->contains(qName));
+    invalidateTagTable();
 
 #if DUMP_TAG_HANDLER_REGISTRATION > 0
     mDebug() << "[GeoTagHandler] -> Recognizing" << qName.first << "tag with namespace" << qName.second;
@@ -73,6 +175,16 @@ void GeoTagHandler::unregisterHandler(const GeoParser::QualifiedName& qName)
     delete hash->value(qName);
     hash->remove(qName);
     Q_ASSERT(!hash->contains(qName));
+    invalidateTagTable();
+}
+
+void GeoTagHandler::invalidateTagTable()
+{
+    QMutexLocker locker(&s_tagTableMutex);
+    if (GeoTagTable* table = s_tagTable.fetchAndStoreOrdered(nullptr)) {
+        table->m_retired = s_retiredTagTables;
+        s_retiredTagTables = table;
+    }
 }
 
 const GeoTagHandler* GeoTagHandler::recognizes(const GeoParser::QualifiedName& qName)
@@ -85,4 +197,20 @@ const GeoTagHandler* GeoTagHandler::recognizes(const GeoParser::QualifiedName& q
     return (*hash)[qName];
 }
 
+const GeoTagHandler* GeoTagHandler::recognizes(const QStringRef& name, const QStringRef& namespaceUri,
+                                               GeoParser::QualifiedName& qualifiedName)
+{
+    GeoTagTable* table = s_tagTable.loadAcquire();
+    if (!table) {
+        QMutexLocker locker(&s_tagTableMutex);
+        table = s_tagTable.loadAcquire();
+        if (!table) {
+            table = new GeoTagTable(*tagHandlerHash());
+            s_tagTable.storeRelease(table);
+        }
+    }
+
+    return table->find(name, namespaceUri, qualifiedName);
+}
+
 }
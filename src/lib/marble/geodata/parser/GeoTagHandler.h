@@ -62,10 +62,19 @@ private: // Only our parser is allowed to access tag handlers.
     friend class GeoParser;
     static const GeoTagHandler* recognizes(const GeoParser::QualifiedName&);
 
+    /**
+     * Looks up the handler of the current element without allocating any
+     * strings. On success @p qualifiedName is set to the registered name,
+     * which shares its data with all other elements of the same name.
+     */
+    static const GeoTagHandler* recognizes(const QStringRef& name, const QStringRef& namespaceUri,
+                                           GeoParser::QualifiedName& qualifiedName);
+
 private:
     typedef QHash<GeoParser::QualifiedName, const GeoTagHandler*> TagHash;
 
     static TagHash* tagHandlerHash();
+    static void invalidateTagTable();
     static TagHash* s_tagHandlerHash;
 };
 
@@ -15,7 +15,9 @@
 #include "GeoTagWriter.h"
 #include "GeoDataDocument.h"
 #include "KmlElementDictionary.h"
+#include "MarbleZipWriter.h"
 
+#include <QBuffer>
 #include <QFileInfo>
 #include <MarbleDebug.h>
 
@@ -52,6 +54,19 @@ bool GeoDataDocumentWriter::write(const QString &filename, const GeoDataDocument
     }
 
     QString const docType = documentIdentifier.isEmpty() ? determineDocumentIdentifier(filename) : documentIdentifier;
+    if (QFileInfo(filename).suffix().toLower() == QLatin1String("kmz")) {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        if (!write(&buffer, document, docType)) {
+            return false;
+        }
+
+        MarbleZipWriter zipWriter(&file);
+        zipWriter.addFile(QStringLiteral("doc.kml"), buffer.data());
+        zipWriter.close();
+        return zipWriter.status() == MarbleZipWriter::NoError;
+    }
+
     return write(&file, document, docType);
 }
 
@@ -70,7 +85,7 @@ void GeoDataDocumentWriter::unregisterWriter(GeoWriterBackend *writer, const QSt
 QString GeoDataDocumentWriter::determineDocumentIdentifier(const QString &filename)
 {
     QString const fileExtension = QFileInfo(filename).suffix().toLower();
-    if (fileExtension == QLatin1String("kml")) {
+    if (fileExtension == QLatin1String("kml") || fileExtension == QLatin1String("kmz")) {
         return kml::kmlTag_nameSpaceOgc22;
     }
     if (fileExtension == QLatin1String("osm")) {
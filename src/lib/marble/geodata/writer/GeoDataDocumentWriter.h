@@ -38,7 +38,8 @@ public:
     static bool write(QIODevice* device, const GeoDataDocument &document, const QString &documentIdentifier);
 
     /**
-     * Convenience method that uses a QFile as QIODevice and determines the document type from the filename extension
+     * Convenience method that uses a QFile as QIODevice and determines the document type from the filename extension.
+     * Files ending in .kmz get the KML document zipped as doc.kml
      * @param filename Target file's name
      * @param document Document to write
      * @param documentIdentifier XML document identifier or filename extension that determines the content type.
@@ -17,6 +17,8 @@
 
 #include "MarbleDebug.h"
 
+#include <cmath>
+
 namespace Marble
 {
 
@@ -58,17 +60,24 @@ bool GeoWriter::writeElement(const GeoNode *object)
 {
     // Add checks to see that everything is ok here
 
-    GeoTagWriter::QualifiedName name( object->nodeType(), m_documentType );
-    const GeoTagWriter* writer = GeoTagWriter::recognizes( name );
+    // Node types are static strings, so their addresses identify them
+    const char *const nodeType = object->nodeType();
+    QHash<const char*, const GeoTagWriter*>::const_iterator i = m_tagWriters.constFind( nodeType );
+    if ( i == m_tagWriters.constEnd() ) {
+        GeoTagWriter::QualifiedName name( nodeType, m_documentType );
+        i = m_tagWriters.insert( nodeType, GeoTagWriter::recognizes( name ) );
+    }
+    const GeoTagWriter* writer = i.value();
 
     if( writer ) {
         if( ! writer->write( object, *this ) ) {
             mDebug() << "An error has been reported by the GeoWriter for: "
-                    << name;
+                    << GeoTagWriter::QualifiedName( nodeType, m_documentType );
             return false;
         }
     } else {
-        mDebug() << "There is no GeoWriter registered for: " << name;
+        mDebug() << "There is no GeoWriter registered for: "
+                 << GeoTagWriter::QualifiedName( nodeType, m_documentType );
         return true;
     }
     return true;
@@ -78,6 +87,7 @@ bool GeoWriter::writeElement(const GeoNode *object)
 void GeoWriter::setDocumentType( const QString &documentType )
 {
     m_documentType = documentType;
+    m_tagWriters.clear();
 }
 
 void GeoWriter::writeElement( const QString &namespaceUri, const QString &key, const QString &value )
@@ -101,6 +111,45 @@ void GeoWriter::writeOptionalElement( const QString &key, const QString &value,
     }
 }
 
+void GeoWriter::appendNumber( QString &target, qreal value, int precision )
+{
+    static const qint64 powersOfTen[] = {
+        1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL,
+        1000000000LL, 10000000000LL, 100000000000LL, 1000000000000LL
+    };
+    int const maximumPrecision = sizeof( powersOfTen ) / sizeof( powersOfTen[0] ) - 1;
+
+    // Scaled values have to be exact integers in a double
+    if ( precision < 0 || precision > maximumPrecision || !std::isfinite( value )
+         || std::fabs( value ) * powersOfTen[precision] >= 4.0e15 ) {
+        target += QString::number( value, 'f', precision );
+        return;
+    }
+
+    bool const negative = value < 0;
+    quint64 digits = std::llround( std::fabs( value ) * powersOfTen[precision] );
+
+    char buffer[32];
+    char *const end = buffer + sizeof( buffer );
+    char *position = end;
+    for ( int i = 0; i < precision; ++i ) {
+        *--position = char( '0' + digits % 10 );
+        digits /= 10;
+    }
+    if ( precision > 0 ) {
+        *--position = '.';
+    }
+    do {
+        *--position = char( '0' + digits % 10 );
+        digits /= 10;
+    } while ( digits > 0 );
+    if ( negative ) {
+        *--position = '-';
+    }
+
+    target += QLatin1String( position, int( end - position ) );
+}
+
 void GeoWriter::writeOptionalAttribute( const QString &key, const QString &value, const QString &defaultValue )
 {
     if( value != defaultValue ) {
@@ -13,6 +13,7 @@
 
 #include "marble_export.h"
 
+#include <QHash>
 #include <QXmlStreamWriter>
 #include <QVariant>
 
@@ -20,6 +21,7 @@ namespace Marble
 {
 
 class GeoNode;
+class GeoTagWriter;
 
 /**
  * @brief Standard Marble way of writing XML
@@ -82,6 +84,14 @@ public:
         }
     }
 
+    /**
+     * @brief Appends @p value with @p precision decimals to @p target
+     * Meant for writing many coordinates, it avoids the temporary strings of
+     * QString::number(). The last digit may differ from QString::number() for
+     * values with more decimals than @p precision.
+     */
+    static void appendNumber( QString &target, qreal value, int precision );
+
 private:
     friend class GeoTagWriter;
     friend class GeoDataDocumentWriter;
@@ -89,6 +99,8 @@ private:
 
 private:
     QString m_documentType;
+    // Tag writers of the current document type by GeoNode::nodeType()
+    QHash<const char*, const GeoTagWriter*> m_tagWriters;
 };
 
 }
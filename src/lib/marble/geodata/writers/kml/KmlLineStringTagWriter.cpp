@@ -48,25 +48,28 @@ bool KmlLineStringTagWriter::write( const GeoNode *node, GeoWriter& writer ) con
             }
         }
 
+        QString coordinatesString;
+        coordinatesString.reserve( lineString->size() * ( hasAltitude ? 40 : 30 ) );
         for ( int i = 0; i < lineString->size(); ++i ) {
-            GeoDataCoordinates coordinates = lineString->at( i );
+            const GeoDataCoordinates &coordinates = lineString->at( i );
             if ( i > 0 )
             {
-                writer.writeCharacters( " " );
+                coordinatesString += QLatin1Char( ' ' );
             }
 
             qreal lon = coordinates.longitude( GeoDataCoordinates::Degree );
-            writer.writeCharacters( QString::number( lon, 'f', 10 ) );
-            writer.writeCharacters( "," );
+            GeoWriter::appendNumber( coordinatesString, lon, 10 );
+            coordinatesString += QLatin1Char( ',' );
             qreal lat = coordinates.latitude( GeoDataCoordinates::Degree );
-            writer.writeCharacters( QString::number( lat, 'f', 10 ) );
+            GeoWriter::appendNumber( coordinatesString, lat, 10 );
 
             if ( hasAltitude ) {
                 qreal alt = coordinates.altitude();
-                writer.writeCharacters( "," );
-                writer.writeCharacters( QString::number( alt, 'f', 2 ) );
+                coordinatesString += QLatin1Char( ',' );
+                GeoWriter::appendNumber( coordinatesString, alt, 2 );
             }
         }
+        writer.writeCharacters( coordinatesString );
 
         writer.writeEndElement();
         writer.writeEndElement();
@@ -40,20 +40,23 @@ bool KmlLinearRingTagWriter::write( const GeoNode *node, GeoWriter& writer ) con
 
         int size = ring->size() >= 3 && ring->first() != ring->last() ? ring->size() + 1 : ring->size();
 
+        QString coordinatesString;
+        coordinatesString.reserve( size * 30 );
         for ( int i = 0; i < size; ++i )
         {
-            GeoDataCoordinates coordinates = ring->at( i % ring->size() );
+            const GeoDataCoordinates &coordinates = ring->at( i % ring->size() );
             if ( i > 0 )
             {
-                writer.writeCharacters( " " );
+                coordinatesString += QLatin1Char( ' ' );
             }
 
             qreal lon = coordinates.longitude( GeoDataCoordinates::Degree );
-            writer.writeCharacters( QString::number( lon, 'f', 10 ) );
-            writer.writeCharacters( "," );
+            GeoWriter::appendNumber( coordinatesString, lon, 10 );
+            coordinatesString += QLatin1Char( ',' );
             qreal lat = coordinates.latitude( GeoDataCoordinates::Degree );
-            writer.writeCharacters( QString::number( lat, 'f', 10 ) );
+            GeoWriter::appendNumber( coordinatesString, lat, 10 );
         }
+        writer.writeCharacters( coordinatesString );
 
         writer.writeEndElement();
         writer.writeEndElement();
@@ -66,8 +66,8 @@ bool KmlOsmPlacemarkDataTagWriter::writeOsmData( const GeoDataGeometry *geometry
     writer.writeOptionalAttribute( "action", osmData.action() );
 
     // Writing the tags
-    QHash<QString, QString>::const_iterator tagsIt = osmData.tagsBegin();
-    QHash<QString, QString>::const_iterator tagsEnd = osmData.tagsEnd();
+    auto tagsIt = osmData.tagsBegin();
+    auto const tagsEnd = osmData.tagsEnd();
     for ( ; tagsIt != tagsEnd; ++tagsIt ) {
         writer.writeStartElement( kml::kmlTag_nameSpaceMx, "tag" );
         writer.writeAttribute( "k", tagsIt.key() );
@@ -78,15 +78,11 @@ bool KmlOsmPlacemarkDataTagWriter::writeOsmData( const GeoDataGeometry *geometry
 
         // Ways
         if (const GeoDataLineString *lineString = dynamic_cast<const GeoDataLineString *>(geometry)) {
-            int ndIndex = 0;
-
             // Writing the component nodes
-            QVector<GeoDataCoordinates>::const_iterator nodeIt = lineString->begin();
-            QVector<GeoDataCoordinates>::const_iterator nodeEnd = lineString->end();
-            for ( ; nodeIt != nodeEnd; ++nodeIt ) {
-                const OsmPlacemarkData &nodeOsmData = osmData.nodeReference( *nodeIt );
+            for ( int ndIndex = 0; ndIndex < lineString->size(); ++ndIndex ) {
+                const OsmPlacemarkData nodeOsmData = osmData.nodeReference( ndIndex );
                 writer.writeStartElement( kml::kmlTag_nameSpaceMx, "nd" );
-                writer.writeAttribute( "index", QString::number( ndIndex++ ) );
+                writer.writeAttribute( "index", QString::number( ndIndex ) );
                 writeOsmData( nullptr, nodeOsmData, writer );
                 writer.writeEndElement();
             }
@@ -32,15 +32,22 @@ bool KmlTrackWriter::write( const GeoNode *node, GeoWriter &writer ) const
     writer.writeStartElement( "gx:Track" );
     KmlObjectTagWriter::writeIdentifiers( writer, track );
 
+    const QVector<QDateTime> when = track->whenList();
+    const QVector<GeoDataCoordinates> coordinates = track->coordinatesList();
+    QString coord;
+
     int points = track->size();
     for ( int i = 0; i < points; i++ ) {
-        writer.writeElement( "when", track->whenList().at( i ).toString( Qt::ISODate ) );
+        writer.writeElement( "when", when.at( i ).toString( Qt::ISODate ) );
 
         qreal lon, lat, alt;
-        track->coordinatesList().at( i ).geoCoordinates( lon, lat, alt, GeoDataCoordinates::Degree );
-        const QString coord = QString::number(lon, 'f', 10) + QLatin1Char(' ') +
-                              QString::number(lat, 'f', 10) + QLatin1Char(' ') +
-                              QString::number(alt, 'f', 10);
+        coordinates.at( i ).geoCoordinates( lon, lat, alt, GeoDataCoordinates::Degree );
+        coord.resize( 0 );
+        GeoWriter::appendNumber( coord, lon, 10 );
+        coord += QLatin1Char(' ');
+        GeoWriter::appendNumber( coord, lat, 10 );
+        coord += QLatin1Char(' ');
+        GeoWriter::appendNumber( coord, alt, 10 );
 
         writer.writeElement( "gx:coord", coord );
     }
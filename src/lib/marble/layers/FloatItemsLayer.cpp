@@ -12,8 +12,12 @@
 
 #include "AbstractFloatItem.h"
 #include "GeoPainter.h"
+#include "MarbleDebug.h"
+#include "MarbleTrace.h"
 #include "ViewportParams.h"
 
+#include <QElapsedTimer>
+
 namespace Marble
 {
 
@@ -37,18 +41,23 @@ bool FloatItemsLayer::render(GeoPainter *painter,
     Q_UNUSED(layer)
 
     for (AbstractFloatItem *item: m_floatItems) {
-        if (!item->enabled()) {
+        // Float items hidden by the user need not be initialized yet
+        if (!item->enabled() || !item->visible()) {
             continue;
         }
 
         if (!item->isInitialized()) {
-            item->initialize();
+            QElapsedTimer initTime;
+            initTime.start();
+            {
+                MarbleTraceScope traceScope(MarbleTrace::internedName(item->nameId()), "plugin");
+                item->initialize();
+            }
+            mDebug() << "Initializing" << item->nameId() << "took" << initTime.elapsed() << "ms";
             emit renderPluginInitialized(item);
         }
 
-        if (item->visible()) {
-            item->paintEvent(painter, viewport);
-        }
+        item->paintEvent(painter, viewport);
     }
 
     return true;
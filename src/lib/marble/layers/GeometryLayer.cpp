@@ -51,6 +51,7 @@
 #include <OsmPlacemarkData.h>
 #include "StyleBuilder.h"
 #include "AbstractGeoPolygonGraphicsItem.h"
+#include "BuildingGraphicsItem.h"
 
 // Qt
 #include <qmath.h>
@@ -110,6 +111,8 @@ public:
     GeoDataRelation::RelationTypes m_visibleRelationTypes;
     bool m_levelTagDebugModeEnabled;
     int m_debugLevelTag;
+    // Consecutive buildings of a frame layer, painted in one go
+    QVector<BuildingGraphicsItem*> m_buildingBatch;
 };
 
 GeometryLayerPrivate::GeometryLayerPrivate(const QAbstractItemModel *model, const StyleBuilder *styleBuilder) :
@@ -249,11 +252,13 @@ bool GeometryLayer::render(GeoPainter *painter, ViewportParams *viewport,
         auto & layerItems = d->m_cachedPaintFragments[layer];
         AbstractGeoPolygonGraphicsItem::s_previousStyle = nullptr;
         GeoLineStringGraphicsItem::s_previousStyle = nullptr;
+        bool const isFrameLayer = layer.endsWith(QLatin1String("/frame"));
+        auto & buildingBatch = d->m_buildingBatch;
         for (auto item: layerItems) {
             if (d->m_levelTagDebugModeEnabled) {
                 if (const auto placemark = geodata_cast<GeoDataPlacemark>(item->feature())) {
                     if (placemark->hasOsmData()) {
-                        QHash<QString, QString>::const_iterator tagIter = placemark->osmData().findTag(QStringLiteral("level"));
+                        auto const tagIter = placemark->osmData().findTag(QStringLiteral("level"));
                         if (tagIter != placemark->osmData().tagsEnd()) {
                             const int val = tagIter.value().toInt();
                             if (val != d->m_debugLevelTag) {
@@ -263,8 +268,22 @@ bool GeometryLayer::render(GeoPainter *painter, ViewportParams *viewport,
                     }
                 }
             }
+            if (isFrameLayer) {
+                if (auto building = dynamic_cast<BuildingGraphicsItem*>(item)) {
+                    buildingBatch << building;
+                    continue;
+                }
+                if (!buildingBatch.isEmpty()) {
+                    BuildingGraphicsItem::paintFrames(painter, viewport, layer, d->m_tileLevel, buildingBatch);
+                    buildingBatch.clear();
+                }
+            }
             item->paint(painter, viewport, layer, d->m_tileLevel);
         }
+        if (!buildingBatch.isEmpty()) {
+            BuildingGraphicsItem::paintFrames(painter, viewport, layer, d->m_tileLevel, buildingBatch);
+            buildingBatch.clear();
+        }
     }
 
     for (const auto & item: d->m_cachedDefaultLayer) {
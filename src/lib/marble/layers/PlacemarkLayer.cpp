@@ -87,7 +87,7 @@ bool PlacemarkLayer::render( GeoPainter *geoPainter, ViewportParams *viewport,
         VisiblePlacemark *const mark = *visit;
         if (m_levelTagDebugModeEnabled) {
             if (mark->placemark()->hasOsmData()) {
-                QHash<QString, QString>::const_iterator tagIter = mark->placemark()->osmData().findTag(QStringLiteral("level"));
+                auto const tagIter = mark->placemark()->osmData().findTag(QStringLiteral("level"));
                 if (tagIter != mark->placemark()->osmData().tagsEnd()) {
                     const int val = tagIter.value().toInt();
                     if (val != m_debugLevelTag) {
@@ -30,6 +30,7 @@
 #include "MergedLayerDecorator.h"
 #include "MarbleDebug.h"
 #include "MarbleDirs.h"
+#include "MarbleTrace.h"
 #include "MarblePlacemarkModel.h"
 #include "StackedTile.h"
 #include "StackedTileLoader.h"
@@ -55,6 +56,7 @@ public:
     void requestDelayedRepaint();
     void updateTextureLayers();
     void updateTile( const TileId &tileId, const QImage &tileImage );
+    void updateSunShading();
 
     void addGroundOverlays( const QModelIndex& parent, int first, int last );
     void removeGroundOverlays( const QModelIndex& parent, int first, int last );
@@ -171,6 +173,12 @@ void TextureLayer::Private::updateTile( const TileId &tileId, const QImage &tile
     requestDelayedRepaint();
 }
 
+void TextureLayer::Private::updateSunShading()
+{
+    m_tileLoader.updateSunShading();
+    m_parent->setNeedsUpdate();
+}
+
 bool TextureLayer::Private::drawOrderLessThan( const GeoDataGroundOverlay* o1, const GeoDataGroundOverlay* o2 )
 {
     return o1->drawOrder() < o2->drawOrder();
@@ -286,6 +294,13 @@ void TextureLayer::addLandDocument( const GeoDataDocument *landDocument )
     }
 }
 
+void TextureLayer::removeDocument( const GeoDataDocument *document )
+{
+    if( d->m_texcolorizer && d->m_texcolorizer->removeDocument( document ) ) {
+        reset();
+    }
+}
+
 int TextureLayer::textureLayerCount() const
 {
     return d->m_layerDecorator.textureLayersSize();
@@ -350,6 +365,7 @@ bool TextureLayer::render( GeoPainter *painter, ViewportParams *viewport,
     }
 
     const QRect dirtyRect = QRect( QPoint( 0, 0), viewport->size() );
+    MarbleTraceScope traceScope( "TextureMapping", "render" );
     d->m_texmapper->mapTexture( painter, viewport, d->m_tileZoomLevel, dirtyRect, d->m_texcolorizer );
     d->m_renderState.addChild( d->m_tileLoader.renderState() );
     return true;
@@ -370,11 +386,11 @@ void TextureLayer::setShowRelief( bool show )
 void TextureLayer::setShowSunShading( bool show )
 {
     disconnect( d->m_sunLocator, SIGNAL(positionChanged(qreal,qreal)),
-                this, SLOT(reset()) );
+                this, SLOT(updateSunShading()) );
 
     if ( show ) {
         connect( d->m_sunLocator, SIGNAL(positionChanged(qreal,qreal)),
-                 this,       SLOT(reset()) );
+                 this,       SLOT(updateSunShading()) );
     }
 
     d->m_layerDecorator.setShowSunShading( show );
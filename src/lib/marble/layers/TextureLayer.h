@@ -52,6 +52,8 @@ class MARBLE_EXPORT TextureLayer : public QObject, public LayerInterface
 
     void addLandDocument( const GeoDataDocument *landDocument );
 
+    void removeDocument( const GeoDataDocument *document );
+
     int textureLayerCount() const;
 
     /**
@@ -133,6 +135,7 @@ public Q_SLOTS:
     Q_PRIVATE_SLOT( d, void requestDelayedRepaint() )
     Q_PRIVATE_SLOT( d, void updateTextureLayers() )
     Q_PRIVATE_SLOT( d, void updateTile( const TileId &tileId, const QImage &tileImage ) )
+    Q_PRIVATE_SLOT( d, void updateSunShading() )
     Q_PRIVATE_SLOT( d, void addGroundOverlays( const QModelIndex& parent, int first, int last ) )
     Q_PRIVATE_SLOT( d, void removeGroundOverlays( const QModelIndex& parent, int first, int last ) )
     Q_PRIVATE_SLOT( d, void resetGroundOverlaysCache() )
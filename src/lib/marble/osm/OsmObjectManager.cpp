@@ -21,7 +21,7 @@
 
 namespace Marble {
 
-qint64 OsmObjectManager::m_minId = -1;
+QAtomicInteger<qint64> OsmObjectManager::m_minId( -1 );
 
 void OsmObjectManager::initializeOsmData( GeoDataPlacemark* placemark )
 {
@@ -36,14 +36,7 @@ void OsmObjectManager::initializeOsmData( GeoDataPlacemark* placemark )
 
     // Assigning osmData to each of the line's nodes ( if they don't already have data )
     if (const auto lineString = geodata_cast<GeoDataLineString>(placemark->geometry())) {
-        QVector<GeoDataCoordinates>::const_iterator it =  lineString->constBegin();
-        QVector<GeoDataCoordinates>::ConstIterator const end = lineString->constEnd();
-
-        for ( ; it != end; ++it ) {
-            if (osmData.nodeReference(*it).isNull()) {
-                osmData.nodeReference(*it).setId(--m_minId);
-            }
-        }
+        initializeNodeReferences(osmData, *lineString);
     }
 
     const auto building = geodata_cast<GeoDataBuilding>(placemark->geometry());
@@ -56,11 +49,7 @@ void OsmObjectManager::initializeOsmData( GeoDataPlacemark* placemark )
     }
     // Assigning osmData to each of the line's nodes ( if they don't already have data )
     if (lineString) {
-        for (auto it =lineString->constBegin(), end = lineString->constEnd(); it != end; ++it ) {
-            if (osmData.nodeReference(*it).isNull()) {
-                osmData.nodeReference(*it).setId(--m_minId);
-            }
-        }
+        initializeNodeReferences(osmData, *lineString);
     }
 
     const GeoDataPolygon* polygon;
@@ -85,14 +74,7 @@ void OsmObjectManager::initializeOsmData( GeoDataPlacemark* placemark )
         }
 
         // Outer boundary nodes
-        QVector<GeoDataCoordinates>::const_iterator it =  outerBoundary.constBegin();
-        QVector<GeoDataCoordinates>::ConstIterator const end = outerBoundary.constEnd();
-
-        for ( ; it != end; ++it ) {
-            if (outerBoundaryData.nodeReference(*it).isNull()) {
-                outerBoundaryData.nodeReference(*it).setId(--m_minId);
-            }
-        }
+        initializeNodeReferences(outerBoundaryData, outerBoundary);
 
         // Each inner boundary
         for( const GeoDataLinearRing &innerRing: polygon->innerBoundaries() ) {
@@ -103,21 +85,33 @@ void OsmObjectManager::initializeOsmData( GeoDataPlacemark* placemark )
             }
 
             // Inner boundary nodes
-            QVector<GeoDataCoordinates>::const_iterator it =  innerRing.constBegin();
-            QVector<GeoDataCoordinates>::ConstIterator const end = innerRing.constEnd();
+            initializeNodeReferences(innerRingData, innerRing);
+        }
+    }
+}
 
-            for ( ; it != end; ++it ) {
-                if (innerRingData.nodeReference(*it).isNull()) {
-                    innerRingData.nodeReference(*it).setId(--m_minId);
-                }
-            }
+void OsmObjectManager::initializeNodeReferences( OsmPlacemarkData &osmData, const GeoDataLineString &lineString )
+{
+    for (int i = 0, n = lineString.size(); i < n; ++i) {
+        OsmPlacemarkData &nodeData = osmData.nodeReference(i);
+        if (!nodeData.isNull()) {
+            continue;
+        }
+        // A closed way refers to its first node again
+        if (i > 0 && i == n - 1 && lineString.at(i) == lineString.at(0)) {
+            nodeData.setId(osmData.nodeReference(0).id());
+        } else {
+            nodeData.setId(--m_minId);
         }
     }
 }
 
 void OsmObjectManager::registerId( qint64 id )
 {
-    m_minId = qMin( id, m_minId );
+    qint64 minId = m_minId.loadAcquire();
+    while ( id < minId && !m_minId.testAndSetOrdered( minId, id, minId ) ) {
+        // minId was updated to the current value, try again
+    }
 }
 
 }
@@ -12,12 +12,14 @@
 #define MARBLE_OSMOBJECTMANAGER_H
 
 #include <marble_export.h>
-#include <QtGlobal>
+#include <QAtomicInteger>
 
 namespace Marble
 {
 
+class GeoDataLineString;
 class GeoDataPlacemark;
+class OsmPlacemarkData;
 
 /**
  * @brief The OsmObjectManager class is used to assign osmData to placemarks that
@@ -40,12 +42,18 @@ public:
     static void registerId( qint64 id );
 
 private:
+    /**
+     * @brief initializeNodeReferences assigns ids to the nodes of @p lineString
+     * which do not have one in @p osmData yet
+     */
+    static void initializeNodeReferences( OsmPlacemarkData &osmData, const GeoDataLineString &lineString );
+
     /**
      * @brief newly created placemarks are assigned negative unique IDs.
      * In order to assure there are no duplicate IDs, they are assigned the
-     * minId - 1 id.
+     * minId - 1 id. Atomic since tiles are clipped concurrently.
      */
-    static qint64 m_minId;
+    static QAtomicInteger<qint64> m_minId;
 };
 
 }
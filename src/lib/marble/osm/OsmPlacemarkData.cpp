@@ -14,8 +14,12 @@
 // Marble
 #include "GeoDataExtendedData.h"
 
+#include <QSet>
+#include <QThreadStorage>
 #include <QXmlStreamAttributes>
 
+#include <algorithm>
+
 namespace Marble
 {
 
@@ -24,6 +28,39 @@ inline uint qHash(Marble::OsmIdentifier ident, uint seed)
     return ::qHash(ident.id, seed) ^ ::qHash((int)ident.type, seed);
 }
 
+namespace {
+
+/**
+ * Returns a string equal to @p string that shares its data with all other
+ * strings interned by the current thread. Only short strings are pooled; long
+ * values like names or descriptions rarely repeat.
+ */
+QString internedString( const QString &string )
+{
+    static const int maximumPoolSize = 16384;
+    static const int maximumLength = 48;
+    static QThreadStorage< QSet<QString> > pools;
+
+    if ( string.size() > maximumLength ) {
+        return string;
+    }
+
+    QSet<QString> &pool = pools.localData();
+    auto const iter = pool.constFind( string );
+    if ( iter != pool.constEnd() ) {
+        return *iter;
+    }
+    if ( pool.size() >= maximumPoolSize ) {
+        return string;
+    }
+    // Deep copy, the string might be a literal of a plugin that gets unloaded
+    QString const pooled( string.constData(), string.size() );
+    pool.insert( pooled );
+    return pooled;
+}
+
+}
+
 OsmPlacemarkData::OsmPlacemarkData():
     m_id( 0 )
 {
@@ -37,43 +74,43 @@ qint64 OsmPlacemarkData::id() const
 
 qint64 OsmPlacemarkData::oid() const
 {
-    auto const value = m_tags.value(QStringLiteral("mx:oid")).toLong();
+    auto const value = tagValue(QStringLiteral("mx:oid")).toLong();
     return value > 0 ? value : m_id;
 }
 
 QString OsmPlacemarkData::changeset() const
 {
-    return m_tags.value(QStringLiteral("mx:changeset"));
+    return tagValue(QStringLiteral("mx:changeset"));
 }
 
 QString OsmPlacemarkData::version() const
 {
-    return m_tags.value(QStringLiteral("mx:version"));
+    return tagValue(QStringLiteral("mx:version"));
 }
 
 QString OsmPlacemarkData::uid() const
 {
-    return m_tags.value(QStringLiteral("mx:uid"));
+    return tagValue(QStringLiteral("mx:uid"));
 }
 
 QString OsmPlacemarkData::isVisible() const
 {
-    return m_tags.value(QStringLiteral("mx:visible"));
+    return tagValue(QStringLiteral("mx:visible"));
 }
 
 QString OsmPlacemarkData::user() const
 {
-    return m_tags.value(QStringLiteral("mx:user"));
+    return tagValue(QStringLiteral("mx:user"));
 }
 
 QString OsmPlacemarkData::timestamp() const
 {
-    return m_tags.value(QStringLiteral("mx:timestamp"));
+    return tagValue(QStringLiteral("mx:timestamp"));
 }
 
 QString OsmPlacemarkData::action() const
 {
-    return m_tags.value(QStringLiteral("mx:action"));
+    return tagValue(QStringLiteral("mx:action"));
 }
 
 void OsmPlacemarkData::setId( qint64 id )
@@ -83,130 +120,156 @@ void OsmPlacemarkData::setId( qint64 id )
 
 void OsmPlacemarkData::setVersion( const QString& version )
 {
-    m_tags[QStringLiteral("mx:version")] = version;
+    addTag(QStringLiteral("mx:version"), version);
 }
 
 void OsmPlacemarkData::setChangeset( const QString& changeset )
 {
-    m_tags[QStringLiteral("mx:changeset")] = changeset;
+    addTag(QStringLiteral("mx:changeset"), changeset);
 }
 
 void OsmPlacemarkData::setUid( const QString& uid )
 {
-    m_tags[QStringLiteral("mx:uid")] = uid;
+    addTag(QStringLiteral("mx:uid"), uid);
 }
 
 void OsmPlacemarkData::setVisible( const QString& visible )
 {
-    m_tags[QStringLiteral("mx:visible")] = visible;
+    addTag(QStringLiteral("mx:visible"), visible);
 }
 
 void OsmPlacemarkData::setUser( const QString& user )
 {
-   m_tags[QStringLiteral("mx:user")] = user;
+   addTag(QStringLiteral("mx:user"), user);
 }
 
 void OsmPlacemarkData::setTimestamp( const QString& timestamp )
 {
-    m_tags[QStringLiteral("mx:timestamp")] = timestamp;
+    addTag(QStringLiteral("mx:timestamp"), timestamp);
 }
 
 void OsmPlacemarkData::setAction( const QString& action )
 {
-    m_tags[QStringLiteral("mx:action")] = action;
+    addTag(QStringLiteral("mx:action"), action);
 }
 
 
 
 QString OsmPlacemarkData::tagValue( const QString& key ) const
 {
-    return m_tags.value( key );
+    auto const iter = lowerBound( key );
+    return iter != m_tags.constEnd() && iter->first == key ? iter->second : QString();
 }
 
 void OsmPlacemarkData::addTag( const QString& key, const QString& value )
 {
-    m_tags.insert( key, value );
+    auto const iter = lowerBound( key );
+    int const index = iter - m_tags.constBegin();
+    if ( iter != m_tags.constEnd() && iter->first == key ) {
+        m_tags[index].second = internedString( value );
+    } else {
+        m_tags.insert( index, Tag( internedString( key ), internedString( value ) ) );
+    }
 }
 
 void OsmPlacemarkData::removeTag( const QString &key )
 {
-    m_tags.remove( key );
+    auto const iter = lowerBound( key );
+    if ( iter != m_tags.constEnd() && iter->first == key ) {
+        m_tags.remove( iter - m_tags.constBegin() );
+    }
 }
 
 bool OsmPlacemarkData::containsTag( const QString &key, const QString &value ) const
 {
-    auto const iter = m_tags.constFind(key);
-    return iter == m_tags.constEnd() ? false : iter.value() == value;
+    auto const iter = lowerBound( key );
+    return iter != m_tags.constEnd() && iter->first == key && iter->second == value;
 }
 
 bool OsmPlacemarkData::containsTagKey( const QString &key ) const
 {
-    return m_tags.contains( key );
+    auto const iter = lowerBound( key );
+    return iter != m_tags.constEnd() && iter->first == key;
 }
 
-QHash<QString, QString>::const_iterator OsmPlacemarkData::findTag(const QString &key) const
+OsmPlacemarkData::TagIterator OsmPlacemarkData::findTag(const QString &key) const
 {
-    return m_tags.constFind(key);
+    auto const iter = lowerBound( key );
+    return iter != m_tags.constEnd() && iter->first == key ? TagIterator( &*iter ) : tagsEnd();
 }
 
-QHash< QString, QString >::const_iterator OsmPlacemarkData::tagsBegin() const
+OsmPlacemarkData::TagIterator OsmPlacemarkData::tagsBegin() const
 {
-    return m_tags.begin();
+    return TagIterator( m_tags.constData() );
 }
 
-QHash< QString, QString >::const_iterator OsmPlacemarkData::tagsEnd() const
+OsmPlacemarkData::TagIterator OsmPlacemarkData::tagsEnd() const
 {
-    return m_tags.constEnd();
+    return TagIterator( m_tags.constData() + m_tags.size() );
 }
 
+QVector<OsmPlacemarkData::Tag>::const_iterator OsmPlacemarkData::lowerBound( const QString &key ) const
+{
+    return std::lower_bound( m_tags.constBegin(), m_tags.constEnd(), key, []( const Tag &tag, const QString &key ) {
+        return tag.first < key;
+    } );
+}
 
 
 
-
-OsmPlacemarkData &OsmPlacemarkData::nodeReference( const GeoDataCoordinates &coordinates )
+OsmPlacemarkData &OsmPlacemarkData::nodeReference( int index )
 {
-    return m_nodeReferences[ coordinates ];
+    if ( index >= m_nodeReferences.size() ) {
+        m_nodeReferences.resize( index + 1 );
+    }
+    return m_nodeReferences[ index ];
 }
 
-OsmPlacemarkData OsmPlacemarkData::nodeReference( const GeoDataCoordinates &coordinates ) const
+OsmPlacemarkData OsmPlacemarkData::nodeReference( int index ) const
 {
-    return m_nodeReferences.value( coordinates );
+    return m_nodeReferences.value( index );
 }
 
-void OsmPlacemarkData::addNodeReference( const GeoDataCoordinates &key, const OsmPlacemarkData &value )
+void OsmPlacemarkData::addNodeReference( int index, const OsmPlacemarkData &value )
 {
-    m_nodeReferences.insert( key, value );
+    nodeReference( index ) = value;
 }
 
-void OsmPlacemarkData::removeNodeReference( const GeoDataCoordinates &key )
+void OsmPlacemarkData::insertNodeReference( int index, const OsmPlacemarkData &value )
 {
-    m_nodeReferences.remove( key );
+    if ( index < m_nodeReferences.size() ) {
+        m_nodeReferences.insert( index, value );
+    } else if ( !value.isNull() || !value.isEmpty() ) {
+        // No references of following vertices to move
+        addNodeReference( index, value );
+    }
 }
 
-bool OsmPlacemarkData::containsNodeReference( const GeoDataCoordinates &key ) const
+void OsmPlacemarkData::removeNodeReference( int index )
 {
-    return m_nodeReferences.contains( key );
+    if ( index >= 0 && index < m_nodeReferences.size() ) {
+        m_nodeReferences.remove( index );
+    }
 }
 
-void OsmPlacemarkData::changeNodeReference( const GeoDataCoordinates &oldKey, const GeoDataCoordinates &newKey )
+bool OsmPlacemarkData::containsNodeReference( int index ) const
 {
-    m_nodeReferences.insert( newKey, m_nodeReferences.value( oldKey ) );
-    m_nodeReferences.remove( oldKey );
+    return index >= 0 && index < m_nodeReferences.size();
 }
 
-QHash<GeoDataCoordinates, OsmPlacemarkData> &OsmPlacemarkData::nodeReferences()
+QVector<OsmPlacemarkData> &OsmPlacemarkData::nodeReferences()
 {
     return m_nodeReferences;
 }
 
-QHash< GeoDataCoordinates, OsmPlacemarkData >::const_iterator OsmPlacemarkData::nodeReferencesBegin() const
+OsmPlacemarkData::NodeReferenceIterator OsmPlacemarkData::nodeReferencesBegin() const
 {
-    return m_nodeReferences.begin();
+    return NodeReferenceIterator( this, 0 );
 }
 
-QHash< GeoDataCoordinates, OsmPlacemarkData >::const_iterator OsmPlacemarkData::nodeReferencesEnd() const
+OsmPlacemarkData::NodeReferenceIterator OsmPlacemarkData::nodeReferencesEnd() const
 {
-    return m_nodeReferences.constEnd();
+    return NodeReferenceIterator( this, m_nodeReferences.size() );
 }
 
 
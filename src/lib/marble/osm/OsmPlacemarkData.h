@@ -14,7 +14,9 @@
 // Qt
 #include <QHash>
 #include <QMetaType>
+#include <QPair>
 #include <QString>
+#include <QVector>
 
 // Marble
 #include "GeoDataCoordinates.h"
@@ -50,8 +52,12 @@ struct OsmIdentifier {
 /**
  * This class is used to encapsulate the osm data fields kept within a placemark's extendedData.
  * It stores OSM server generated data: id, version, changeset, uid, visible, user, timestamp;
- * It also stores a hash map of \<tags\> ( key-value mappings ) and a hash map of component osm
- * placemarks @see m_nodeReferences @see m_memberReferences
+ * It also stores the \<tags\> ( key-value mappings ) and the component osm placemarks
+ * @see m_nodeReferences @see m_memberReferences
+ *
+ * Tags are kept in a small array sorted by key. Keys and short values are shared
+ * through a string pool, so the many placemarks of a vector tile do not hold
+ * their own copies of "highway", "building", "yes" and the like.
  *
  * The usual workflow with osmData goes as follows:
  *
@@ -70,8 +76,53 @@ struct OsmIdentifier {
  */
 class MARBLE_EXPORT OsmPlacemarkData: public GeoNode
 {
+    typedef QPair<QString, QString> Tag;
 
 public:
+    /**
+     * @brief Iterator over the tags, in ascending order of their keys
+     */
+    class TagIterator
+    {
+    public:
+        TagIterator() : m_tag( nullptr ) {}
+
+        const QString &key() const { return m_tag->first; }
+        const QString &value() const { return m_tag->second; }
+
+        TagIterator &operator++() { ++m_tag; return *this; }
+        bool operator==( const TagIterator &other ) const { return m_tag == other.m_tag; }
+        bool operator!=( const TagIterator &other ) const { return m_tag != other.m_tag; }
+
+    private:
+        friend class OsmPlacemarkData;
+        explicit TagIterator( const Tag *tag ) : m_tag( tag ) {}
+        const Tag *m_tag;
+    };
+
+    /**
+     * @brief Iterator over the node references, in the order of the way's vertices.
+     * The key is the index of the vertex.
+     */
+    class NodeReferenceIterator
+    {
+    public:
+        NodeReferenceIterator() : m_data( nullptr ), m_index( 0 ) {}
+
+        int key() const { return m_index; }
+        const OsmPlacemarkData &value() const { return m_data->m_nodeReferences.at( m_index ); }
+
+        NodeReferenceIterator &operator++() { ++m_index; return *this; }
+        bool operator==( const NodeReferenceIterator &other ) const { return m_index == other.m_index && m_data == other.m_data; }
+        bool operator!=( const NodeReferenceIterator &other ) const { return !operator==( other ); }
+
+    private:
+        friend class OsmPlacemarkData;
+        NodeReferenceIterator( const OsmPlacemarkData *data, int index ) : m_data( data ), m_index( index ) {}
+        const OsmPlacemarkData *m_data;
+        int m_index;
+    };
+
     OsmPlacemarkData();
 
     qint64 id() const;
@@ -129,43 +180,46 @@ public:
      * @brief tagValue returns a pointer to the tag that has @p key as key
      * or the end iterator if there is no such tag
      */
-    QHash<QString, QString>::const_iterator findTag(const QString &key) const;
+    TagIterator findTag(const QString &key) const;
 
     /**
-     * @brief iterators for the tags hash.
+     * @brief iterators for the tags.
      */
-    QHash< QString, QString >::const_iterator tagsBegin() const;
-    QHash< QString, QString >::const_iterator tagsEnd() const;
+    TagIterator tagsBegin() const;
+    TagIterator tagsEnd() const;
 
 
     /**
-     * @brief this function returns the osmData associated with a nd
+     * @brief this function returns the osmData associated with the nd of the vertex
+     * with index @p index in the way's geometry. The non-const version expands the
+     * node references up to that vertex on demand, as the editor does when it assigns
+     * ids to new nodes.
      */
-    OsmPlacemarkData &nodeReference( const GeoDataCoordinates& coordinates );
-    OsmPlacemarkData nodeReference( const GeoDataCoordinates& coordinates ) const;
+    OsmPlacemarkData &nodeReference( int index );
+    OsmPlacemarkData nodeReference( int index ) const;
 
     /**
-     * @brief addRef this function inserts a GeoDataCoordinates = OsmPlacemarkData
-     * mapping into the reference hash, equivalent to the \<member ref="@p key" \>
-     * osm core data element
+     * @brief addRef this function sets the osmData of the vertex with index @p index,
+     * equivalent to the \<nd ref="..." \> osm core data element
      */
-    void addNodeReference( const GeoDataCoordinates& key, const OsmPlacemarkData &value );
-    void removeNodeReference( const GeoDataCoordinates& key );
-    bool containsNodeReference( const GeoDataCoordinates& key ) const;
+    void addNodeReference( int index, const OsmPlacemarkData &value );
 
     /**
-     * @brief changeNodeReference is a convenience function that allows the quick change of
-     * a node hash entry. This is generally used to update the osm data in case
-     * nodes are being moved in the editor.
+     * @brief insertNodeReference and removeNodeReference keep the node references
+     * synchronized when the vertex with index @p index is inserted into or removed
+     * from the way's geometry. The references of the following vertices move along.
+     * Moving a vertex does not need any update.
      */
-    void changeNodeReference( const GeoDataCoordinates& oldKey, const GeoDataCoordinates &newKey );
+    void insertNodeReference( int index, const OsmPlacemarkData &value = OsmPlacemarkData() );
+    void removeNodeReference( int index );
+    bool containsNodeReference( int index ) const;
 
     /**
-     * @brief iterators for the reference hashes.
+     * @brief iterators for the node references.
      */
-    QHash< GeoDataCoordinates, OsmPlacemarkData > & nodeReferences();
-    QHash< GeoDataCoordinates, OsmPlacemarkData >::const_iterator nodeReferencesBegin() const;
-    QHash< GeoDataCoordinates, OsmPlacemarkData >::const_iterator nodeReferencesEnd() const;
+    QVector< OsmPlacemarkData > & nodeReferences();
+    NodeReferenceIterator nodeReferencesBegin() const;
+    NodeReferenceIterator nodeReferencesEnd() const;
 
 
 
@@ -221,14 +275,21 @@ public:
     static OsmPlacemarkData fromParserAttributes( const QXmlStreamAttributes &attributes );
 
 private:
+    QVector<Tag>::const_iterator lowerBound( const QString &key ) const;
+
     qint64 m_id;
-    QHash<QString, QString> m_tags;
 
     /**
-     * @brief m_ndRefs is used to store a way's component nodes
+     * @brief m_tags holds the tags sorted by key
+     */
+    QVector<Tag> m_tags;
+
+    /**
+     * @brief m_nodeReferences is used to store a way's component nodes, the index
+     * being the index of the vertex within the way's geometry
      * ( It is empty for other placemark types )
      */
-    QHash< GeoDataCoordinates, OsmPlacemarkData > m_nodeReferences;
+    QVector<OsmPlacemarkData> m_nodeReferences;
 
     /**
      * @brief m_memberRefs is used to store a polygon's member boundaries
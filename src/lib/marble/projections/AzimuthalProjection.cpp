@@ -18,6 +18,7 @@
 #include "GeoDataLineString.h"
 #include "GeoDataCoordinates.h"
 #include "GeoDataLatLonAltBox.h"
+#include "ScreenPolygonPool.h"
 #include "ViewportParams.h"
 
 #include <QPainterPath>
@@ -313,7 +314,7 @@ void AzimuthalProjectionPrivate::crossHorizon( const GeoDataCoordinates & bCoord
     }
     else {
         if ( allowLatePolygonCut && !polygons.last()->isEmpty() ) {
-            QPolygonF *path = new QPolygonF;
+            QPolygonF *path = ScreenPolygonPool::create();
             polygons.append( path );
         }
     }
@@ -341,7 +342,7 @@ bool AzimuthalProjectionPrivate::lineStringToPolygon( const GeoDataLineString &l
     qreal horizonX = -1.0;
     qreal horizonY = -1.0;
 
-    QPolygonF * polygon = new QPolygonF;
+    QPolygonF * polygon = ScreenPolygonPool::create();
     if (!tessellate) {
         polygon->reserve(lineString.size());
     }
@@ -484,7 +485,7 @@ bool AzimuthalProjectionPrivate::lineStringToPolygon( const GeoDataLineString &l
                 if (   !previousGlobeHidesPoint
                     && !lineString.isClosed()
                     ) {
-                    polygons.append( new QPolygonF );
+                    polygons.append( ScreenPolygonPool::create() );
                 }
             }
 
@@ -515,7 +516,7 @@ bool AzimuthalProjectionPrivate::lineStringToPolygon( const GeoDataLineString &l
     }
 
     if ( polygons.last()->size() <= 1 ){
-        delete polygons.last();
+        ScreenPolygonPool::release( polygons.last() );
         polygons.pop_back(); // Clean up "unused" empty polygon instances
     }
 
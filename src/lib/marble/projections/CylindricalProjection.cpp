@@ -20,6 +20,7 @@
 #include "GeoDataLineString.h"
 #include "GeoDataCoordinates.h"
 #include "GeoDataLatLonAltBox.h"
+#include "ScreenPolygonPool.h"
 #include "ViewportParams.h"
 
 #include <QPainterPath>
@@ -283,7 +284,7 @@ bool CylindricalProjectionPrivate::lineStringToPolygon( const GeoDataLineString
     int mirrorCount = 0;
     qreal distance = repeatDistance( viewport );
 
-    QPolygonF * polygon = new QPolygonF;
+    QPolygonF * polygon = ScreenPolygonPool::create();
     if (!tessellate) {
         polygon->reserve(lineString.size());
     }
@@ -403,8 +404,8 @@ void CylindricalProjectionPrivate::translatePolygons( const QVector<QPolygonF *>
     QVector<QPolygonF *>::const_iterator itEnd = polygons.constEnd();
 
     for( ; itPolygon != itEnd; ++itPolygon ) {
-        QPolygonF * polygon = new QPolygonF;
-        *polygon = **itPolygon;
+        QPolygonF * polygon = ScreenPolygonPool::create();
+        *polygon << **itPolygon;
         polygon->translate( xOffset, 0 );
         translatedPolygons.append( polygon );
     }
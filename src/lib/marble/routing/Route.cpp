@@ -17,7 +17,8 @@ Route::Route() :
     m_distance( 0.0 ),
     m_travelTime( 0 ),
     m_positionDirty( true ),
-    m_closestSegmentIndex( -1 )
+    m_closestSegmentIndex( -1 ),
+    m_closestEdgeIndex( -1 )
 {
     // nothing to do
 }
@@ -27,6 +28,7 @@ void Route::addRouteSegment( const RouteSegment &segment )
     if ( segment.isValid() ) {
         m_bounds = m_bounds.united( segment.bounds() );
         m_distance += segment.distance();
+        m_segmentIndex.addSegment( m_segments.size(), m_path.size(), segment.path() );
         m_path << segment.path();
         if ( segment.maneuver().position().isValid() ) {
             m_turnPoints << segment.maneuver().position();
@@ -101,35 +103,27 @@ GeoDataCoordinates Route::position() const
 
 void Route::updatePosition() const
 {
-    if ( !m_segments.isEmpty() ) {
-        if ( m_closestSegmentIndex < 0 || m_closestSegmentIndex >= m_segments.size() ) {
-            m_closestSegmentIndex = 0;
-        }
-
-        qreal distance = m_segments[m_closestSegmentIndex].distanceTo( m_position, m_currentWaypoint, m_positionOnRoute );
-        QList<int> candidates;
-
-        for ( int i=0; i<m_segments.size(); ++i ) {
-            if ( i != m_closestSegmentIndex && m_segments[i].minimalDistanceTo( m_position ) <= distance ) {
-                candidates << i;
-            }
-        }
-
-        GeoDataCoordinates closest, interpolated;
-        for( int i: candidates ) {
-            qreal const dist = m_segments[i].distanceTo( m_position, closest, interpolated );
-            if ( distance < 0.0 || dist < distance ) {
-                distance = dist;
-                m_closestSegmentIndex = i;
-                m_positionOnRoute = interpolated;
-                m_currentWaypoint = closest;
-            }
-        }
+    RouteSegmentIndex::Match match;
+    if ( m_segmentIndex.closestEdge( m_position, m_closestEdgeIndex, match ) ) {
+        m_closestEdgeIndex = match.edge;
+        m_closestSegmentIndex = match.segment;
+        m_positionOnRoute = match.interpolated;
+        m_currentWaypoint = m_path[match.pathIndex];
     }
 
     m_positionDirty = false;
 }
 
+int Route::closestPathIndex( const GeoDataCoordinates &coordinates ) const
+{
+    return m_segmentIndex.closestPoint( coordinates );
+}
+
+const RouteSegmentIndex & Route::segmentIndex() const
+{
+    return m_segmentIndex;
+}
+
 const RouteSegment & Route::currentSegment() const
 {
     if ( m_positionDirty ) {
@@ -12,6 +12,7 @@
 #define MARBLE_ROUTE_H
 
 #include "RouteSegment.h"
+#include "RouteSegmentIndex.h"
 #include "GeoDataLatLonBox.h"
 
 namespace Marble
@@ -52,6 +53,17 @@ public:
 
     GeoDataCoordinates positionOnRoute() const;
 
+    /**
+     * Index of the point in path() closest to the given coordinates, the
+     * first one in case of ties, or -1 if the route is empty.
+     */
+    int closestPathIndex( const GeoDataCoordinates &coordinates ) const;
+
+    /**
+     * Spatial index over the route path, for snapping arbitrary positions onto the route
+     */
+    const RouteSegmentIndex & segmentIndex() const;
+
 private:
     void updatePosition() const;
 
@@ -69,10 +81,14 @@ private:
 
     int m_travelTime;
 
+    RouteSegmentIndex m_segmentIndex;
+
     mutable bool m_positionDirty;
 
     mutable int m_closestSegmentIndex;
 
+    mutable int m_closestEdgeIndex;
+
     mutable GeoDataCoordinates m_positionOnRoute;
 
     mutable GeoDataCoordinates m_currentWaypoint;
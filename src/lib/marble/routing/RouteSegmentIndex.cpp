@@ -0,0 +1,317 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "RouteSegmentIndex.h"
+
+#include "GeoDataLineString.h"
+#include "MarbleGlobal.h"
+#include "MarbleMath.h"
+
+#include <qmath.h>
+
+namespace Marble
+{
+
+namespace {
+    /** Number of grid columns around the globe, so that columns wrap at the antimeridian */
+    const int cellCount = 12566;
+    /** Grid cell edge length in radians, about 3 km */
+    const qreal cellSize = 2 * M_PI / cellCount;
+    /** Edges covering more cells than this in either direction are not bucketed */
+    const int maxEdgeCells = 16;
+    /** Number of edges following the hint that are checked first */
+    const int windowSize = 32;
+    /** Tolerance in meters for preferring an edge following the hint */
+    const qreal snapTolerance = 10.0;
+}
+
+RouteSegmentIndex::Match::Match() :
+    edge( -1 ),
+    segment( -1 ),
+    pathIndex( -1 ),
+    distance( -1.0 )
+{
+    // nothing to do
+}
+
+RouteSegmentIndex::RouteSegmentIndex() :
+    m_minX( 0 ),
+    m_maxX( -1 ),
+    m_minY( 0 ),
+    m_maxY( -1 )
+{
+    // nothing to do
+}
+
+void RouteSegmentIndex::clear()
+{
+    m_edges.clear();
+    m_cells.clear();
+    m_oversizedEdges.clear();
+    m_minX = 0;
+    m_maxX = -1;
+    m_minY = 0;
+    m_maxY = -1;
+}
+
+bool RouteSegmentIndex::isEmpty() const
+{
+    return m_edges.isEmpty();
+}
+
+int RouteSegmentIndex::size() const
+{
+    return m_edges.size();
+}
+
+quint64 RouteSegmentIndex::cellKey( int x, int y )
+{
+    // columns east of the antimeridian continue on its west side
+    x = ( x % cellCount + cellCount ) % cellCount;
+    return ( quint64( quint32( x ) ) << 32 ) | quint32( y );
+}
+
+qreal RouteSegmentIndex::unwrapLon( qreal lon, qreal reference )
+{
+    if ( lon - reference > M_PI ) {
+        return lon - 2 * M_PI;
+    } else if ( lon - reference < -M_PI ) {
+        return lon + 2 * M_PI;
+    }
+
+    return lon;
+}
+
+int RouteSegmentIndex::cellX( qreal lon ) const
+{
+    return qFloor( lon / cellSize );
+}
+
+int RouteSegmentIndex::cellY( qreal lat ) const
+{
+    return qFloor( lat / cellSize );
+}
+
+void RouteSegmentIndex::addSegment( int segment, int firstPathIndex, const GeoDataLineString &path )
+{
+    if ( path.isEmpty() ) {
+        return;
+    }
+
+    m_edges.reserve( m_edges.size() + path.size() );
+
+    Edge edge;
+    edge.segment = segment;
+    if ( path.size() == 1 ) {
+        // A degenerated edge, matching RouteSegment::distanceTo for single point paths
+        edge.lon1 = edge.lon2 = path.first().longitude();
+        edge.lat1 = edge.lat2 = path.first().latitude();
+        edge.startIndex = firstPathIndex;
+        edge.pathIndex = firstPathIndex;
+        addEdge( edge );
+        return;
+    }
+
+    for ( int i = 1; i < path.size(); ++i ) {
+        edge.lon1 = path[i-1].longitude();
+        edge.lat1 = path[i-1].latitude();
+        // edges crossing the antimeridian take the short way around the globe
+        edge.lon2 = unwrapLon( path[i].longitude(), edge.lon1 );
+        edge.lat2 = path[i].latitude();
+        edge.startIndex = firstPathIndex + i - 1;
+        edge.pathIndex = firstPathIndex + i;
+        addEdge( edge );
+    }
+}
+
+void RouteSegmentIndex::addEdge( const Edge &edge )
+{
+    int const index = m_edges.size();
+    m_edges.push_back( edge );
+
+    int const x1 = cellX( qMin( edge.lon1, edge.lon2 ) );
+    int const x2 = cellX( qMax( edge.lon1, edge.lon2 ) );
+    int const y1 = cellY( qMin( edge.lat1, edge.lat2 ) );
+    int const y2 = cellY( qMax( edge.lat1, edge.lat2 ) );
+
+    if ( x2 - x1 > maxEdgeCells || y2 - y1 > maxEdgeCells ) {
+        m_oversizedEdges.push_back( index );
+        return;
+    }
+
+    if ( m_maxX < m_minX ) {
+        m_minX = x1;
+        m_maxX = x2;
+        m_minY = y1;
+        m_maxY = y2;
+    } else {
+        m_minX = qMin( m_minX, x1 );
+        m_maxX = qMax( m_maxX, x2 );
+        m_minY = qMin( m_minY, y1 );
+        m_maxY = qMax( m_maxY, y2 );
+    }
+
+    for ( int x = x1; x <= x2; ++x ) {
+        for ( int y = y1; y <= y2; ++y ) {
+            m_cells[cellKey( x, y )].push_back( index );
+        }
+    }
+}
+
+qreal RouteSegmentIndex::edgeDistance( int index, qreal lon, qreal lat, qreal &projectedLon, qreal &projectedLat ) const
+{
+    // Same planar projection as RouteSegment::projected()
+    const Edge &edge = m_edges[index];
+    lon = unwrapLon( lon, edge.lon1 );
+    qreal const dLon = edge.lon2 - edge.lon1;
+    qreal const dLat = edge.lat2 - edge.lat1;
+    qreal const len = dLon * dLon + dLat * dLat;
+    qreal const t = len > 0.0 ? ( ( lat - edge.lat1 ) * dLat + ( lon - edge.lon1 ) * dLon ) / len : 0.0;
+    if ( t <= 0.0 ) {
+        projectedLon = edge.lon1;
+        projectedLat = edge.lat1;
+    } else if ( t >= 1.0 ) {
+        projectedLon = edge.lon2;
+        projectedLat = edge.lat2;
+    } else {
+        projectedLon = edge.lon1 + t * dLon;
+        projectedLat = edge.lat1 + t * dLat;
+    }
+
+    return EARTH_RADIUS * distanceSphere( lon, lat, projectedLon, projectedLat );
+}
+
+void RouteSegmentIndex::matchEdge( int index, qreal lon, qreal lat, Match &match ) const
+{
+    qreal projectedLon;
+    qreal projectedLat;
+    qreal const distance = edgeDistance( index, lon, lat, projectedLon, projectedLat );
+    if ( match.edge < 0 || distance < match.distance ) {
+        match.edge = index;
+        match.distance = distance;
+        match.interpolated = GeoDataCoordinates( GeoDataCoordinates::normalizeLon( projectedLon ), projectedLat );
+    }
+}
+
+template<class Visitor>
+void RouteSegmentIndex::searchRings( qreal lon, qreal lat, qreal bound, Visitor visit ) const
+{
+    // Cells of ring r are at least (r-1) cells away from the position, so the
+    // search stops once that exceeds the best match found so far
+    qreal const cellMeters = EARTH_RADIUS * cellSize * qMax<qreal>( 0.01, qCos( qAbs( lat ) + cellSize ) );
+
+    int const x0 = cellX( lon );
+    int const y0 = cellY( lat );
+    int const maxRing = qMax( qMin( cellCount / 2, qMax( qAbs( x0 - m_minX ), qAbs( x0 - m_maxX ) ) ),
+                              qMax( qAbs( y0 - m_minY ), qAbs( y0 - m_maxY ) ) );
+    for ( int ring = 0; ring <= maxRing && m_maxX >= m_minX; ++ring ) {
+        if ( bound >= 0.0 && ( ring - 1 ) * cellMeters > bound ) {
+            break;
+        }
+
+        for ( int x = x0 - ring; x <= x0 + ring; ++x ) {
+            bool const border = x == x0 - ring || x == x0 + ring;
+            int const step = border ? 1 : 2 * ring;
+            for ( int y = y0 - ring; y <= y0 + ring; y += qMax( 1, step ) ) {
+                QHash<quint64, QVector<int> >::const_iterator const cell = m_cells.constFind( cellKey( x, y ) );
+                if ( cell != m_cells.constEnd() ) {
+                    for ( int index: cell.value() ) {
+                        qreal const distance = visit( index );
+                        if ( distance >= 0.0 && ( bound < 0.0 || distance < bound ) ) {
+                            bound = distance;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool RouteSegmentIndex::closestEdge( const GeoDataCoordinates &position, int hint, Match &match ) const
+{
+    match = Match();
+    if ( m_edges.isEmpty() ) {
+        return false;
+    }
+
+    qreal const lon = position.longitude();
+    qreal const lat = position.latitude();
+
+    // Windowed search along the route, starting at the previous match
+    Match windowMatch;
+    if ( hint >= 0 && hint < m_edges.size() ) {
+        int const last = qMin( m_edges.size() - 1, hint + windowSize );
+        for ( int i = hint; i <= last; ++i ) {
+            matchEdge( i, lon, lat, windowMatch );
+        }
+    }
+
+    for ( int index: m_oversizedEdges ) {
+        matchEdge( index, lon, lat, match );
+    }
+
+    qreal bound = windowMatch.edge >= 0 ? windowMatch.distance : -1.0;
+    if ( match.edge >= 0 && ( bound < 0.0 || match.distance < bound ) ) {
+        bound = match.distance;
+    }
+
+    searchRings( lon, lat, bound, [&]( int index ) {
+        matchEdge( index, lon, lat, match );
+        return match.distance;
+    } );
+
+    // Map matching: stay on the route part of the previous match unless another
+    // part of the route is clearly closer
+    if ( windowMatch.edge >= 0 && ( match.edge < 0 || windowMatch.distance <= match.distance + snapTolerance ) ) {
+        match = windowMatch;
+    }
+
+    Q_ASSERT( match.edge >= 0 );
+    match.segment = m_edges[match.edge].segment;
+    match.pathIndex = m_edges[match.edge].pathIndex;
+    return true;
+}
+
+int RouteSegmentIndex::closestPoint( const GeoDataCoordinates &position ) const
+{
+    if ( m_edges.isEmpty() ) {
+        return -1;
+    }
+
+    qreal const lon = position.longitude();
+    qreal const lat = position.latitude();
+
+    // Every path point is an end point of an edge bucketed in the point's cell
+    // or of an oversized edge
+    int closest = -1;
+    qreal minDistance = -1.0;
+    auto const matchPoints = [&]( int index ) {
+        const Edge &edge = m_edges[index];
+        qreal const startDistance = EARTH_RADIUS * distanceSphere( lon, lat, edge.lon1, edge.lat1 );
+        qreal const endDistance = EARTH_RADIUS * distanceSphere( lon, lat, edge.lon2, edge.lat2 );
+        // ties go to the point first on the route
+        if ( closest < 0 || startDistance < minDistance || ( startDistance == minDistance && edge.startIndex < closest ) ) {
+            closest = edge.startIndex;
+            minDistance = startDistance;
+        }
+        if ( endDistance < minDistance || ( endDistance == minDistance && edge.pathIndex < closest ) ) {
+            closest = edge.pathIndex;
+            minDistance = endDistance;
+        }
+        return minDistance;
+    };
+
+    for ( int index: m_oversizedEdges ) {
+        matchPoints( index );
+    }
+
+    searchRings( lon, lat, minDistance, matchPoints );
+    return closest;
+}
+
+}
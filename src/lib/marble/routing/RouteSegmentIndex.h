@@ -0,0 +1,136 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_ROUTESEGMENTINDEX_H
+#define MARBLE_ROUTESEGMENTINDEX_H
+
+#include "marble_export.h"
+#include "GeoDataCoordinates.h"
+
+#include <QHash>
+#include <QVector>
+
+namespace Marble
+{
+
+class GeoDataLineString;
+
+/**
+ * @brief A spatial index over the edges of a route polyline
+ *
+ * Edges are stored in a flat array in route order and bucketed into a
+ * regular longitude/latitude grid. Closest edge queries first look at a
+ * window of edges following a previous match (the common case while driving
+ * along the route) and then search the grid in rings around the position,
+ * stopping as soon as no closer edge can be found.
+ */
+class MARBLE_EXPORT RouteSegmentIndex
+{
+public:
+    struct Match
+    {
+        Match();
+
+        /** Index of the matched edge, -1 if none */
+        int edge;
+
+        /** Index of the RouteSegment the edge belongs to */
+        int segment;
+
+        /** Index of the edge's end point in the route path */
+        int pathIndex;
+
+        /** Distance of the position to the edge, in meters */
+        qreal distance;
+
+        /** The position snapped onto the edge */
+        GeoDataCoordinates interpolated;
+    };
+
+    RouteSegmentIndex();
+
+    void clear();
+
+    bool isEmpty() const;
+
+    int size() const;
+
+    /**
+     * Appends the edges of the given segment path
+     * @param segment Index of the RouteSegment the path belongs to
+     * @param firstPathIndex Index of the first path point in the route path
+     */
+    void addSegment( int segment, int firstPathIndex, const GeoDataLineString &path );
+
+    /**
+     * Determines the edge closest to the given position.
+     * @param hint The edge of a previous match or -1. Edges following the hint
+     * are preferred over other edges that are only slightly closer, which keeps
+     * matches stable on routes that pass the same place several times.
+     * @return false if the index is empty
+     */
+    bool closestEdge( const GeoDataCoordinates &position, int hint, Match &match ) const;
+
+    /**
+     * Determines the route path point closest to the given position.
+     * @return the index of the point in the route path, the first one on the
+     * route in case of ties, or -1 if the index is empty
+     */
+    int closestPoint( const GeoDataCoordinates &position ) const;
+
+private:
+    struct Edge
+    {
+        qreal lon1;
+        qreal lat1;
+        qreal lon2;
+        qreal lat2;
+        int segment;
+        int startIndex;
+        int pathIndex;
+    };
+
+    static quint64 cellKey( int x, int y );
+
+    /** @p lon shifted by a full turn if that brings it closer to @p reference */
+    static qreal unwrapLon( qreal lon, qreal reference );
+
+    int cellX( qreal lon ) const;
+
+    int cellY( qreal lat ) const;
+
+    void addEdge( const Edge &edge );
+
+    qreal edgeDistance( int edge, qreal lon, qreal lat, qreal &projectedLon, qreal &projectedLat ) const;
+
+    void matchEdge( int edge, qreal lon, qreal lat, Match &match ) const;
+
+    /**
+     * Calls @p visit for the edges bucketed around the given position, in rings
+     * of growing distance. @p visit returns the best distance found so far in
+     * meters, or a negative value if there is none yet.
+     */
+    template<class Visitor>
+    void searchRings( qreal lon, qreal lat, qreal bound, Visitor visit ) const;
+
+    QVector<Edge> m_edges;
+
+    QHash<quint64, QVector<int> > m_cells;
+
+    /** Edges spanning too many cells, checked in every query */
+    QVector<int> m_oversizedEdges;
+
+    int m_minX;
+    int m_maxX;
+    int m_minY;
+    int m_maxY;
+};
+
+}
+
+#endif
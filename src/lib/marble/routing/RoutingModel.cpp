@@ -227,7 +227,7 @@ int RoutingModel::rightNeighbor( const GeoDataCoordinates &position, RouteReques
     }
 
     // Generate an ordered list of all waypoints
-    GeoDataLineString points = d->m_route.path();
+    const GeoDataLineString &points = d->m_route.path();
     QMap<int,int> mapping;
 
     // Force first mapping point to match the route start
@@ -236,6 +236,14 @@ int RoutingModel::rightNeighbor( const GeoDataCoordinates &position, RouteReques
     // Calculate the mapping between waypoints and via points
     // Need two for loops to avoid getting stuck in local minima
     for ( int j=1; j<route->size()-1; ++j ) {
+        // The spatial index finds the closest waypoint quickly. Only if that
+        // one lies before the previous via point's one, fall back to a scan
+        const int closest = d->m_route.closestPathIndex( route->at( j ) );
+        if ( closest >= mapping[j-1] ) {
+            mapping[j] = closest;
+            continue;
+        }
+
         qreal minDistance = -1.0;
         for ( int i=mapping[j-1]; i<points.size(); ++i ) {
             const qreal distance = points[i].sphericalDistanceTo(route->at(j));
@@ -247,15 +255,7 @@ int RoutingModel::rightNeighbor( const GeoDataCoordinates &position, RouteReques
     }
 
     // Determine waypoint with minimum distance to the provided position
-    qreal minWaypointDistance = -1.0;
-    int waypoint=0;
-    for ( int i=0; i<points.size(); ++i ) {
-        const qreal waypointDistance = points[i].sphericalDistanceTo(position);
-        if ( minWaypointDistance < 0.0 || waypointDistance < minWaypointDistance ) {
-            minWaypointDistance = waypointDistance;
-            waypoint = i;
-        }
-    }
+    const int waypoint = qMax( 0, d->m_route.closestPathIndex( position ) );
 
     // Force last mapping point to match the route destination
     mapping[route->size()-1] = points.size()-1;
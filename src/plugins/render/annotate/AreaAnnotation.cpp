@@ -31,9 +31,31 @@
 #include "PolylineNode.h"
 #include "osm/OsmPlacemarkData.h"
 
+#include <algorithm>
+
 
 namespace Marble {
 
+namespace {
+
+/**
+ * Keeps the node references of a ring synchronized with the ring when it gets
+ * rotated to start at the vertex @p first and a new vertex is appended to it.
+ */
+void rotateNodeReferences( OsmPlacemarkData &ringData, int ringSize, int first )
+{
+    QVector<OsmPlacemarkData> &nodes = ringData.nodeReferences();
+    if ( nodes.isEmpty() ) {
+        return;
+    }
+
+    nodes.resize( ringSize );
+    std::rotate( nodes.begin(), nodes.begin() + first, nodes.end() );
+    nodes.append( OsmPlacemarkData() );
+}
+
+}
+
 const int AreaAnnotation::regularDim = 15;
 const int AreaAnnotation::selectedDim = 15;
 const int AreaAnnotation::mergedDim = 20;
@@ -150,10 +172,6 @@ void AreaAnnotation::move( const GeoDataCoordinates &source, const GeoDataCoordi
     GeoDataPolygon *polygon = static_cast<GeoDataPolygon*>( placemark()->geometry() );
     GeoDataLinearRing outerRing = polygon->outerBoundary();
     QVector<GeoDataLinearRing> innerRings = polygon->innerBoundaries();
-    OsmPlacemarkData *osmData = nullptr;
-    if ( placemark()->hasOsmData() ) {
-        osmData = &placemark()->osmData();
-    }
 
     polygon->outerBoundary().clear();
     polygon->innerBoundaries().clear();
@@ -168,10 +186,6 @@ void AreaAnnotation::move( const GeoDataCoordinates &source, const GeoDataCoordi
 
     for ( int i = 0; i < outerRing.size(); ++i ) {
         const GeoDataCoordinates movedPoint = outerRing.at(i).rotateAround(rotAxis);
-        // Keeping the OsmPlacemarkData synchronized with the geometry
-        if ( osmData ) {
-            osmData->memberReference( -1 ).changeNodeReference( outerRing.at( i ), movedPoint );
-        }
         polygon->outerBoundary().append( movedPoint );
     }
 
@@ -179,9 +193,6 @@ void AreaAnnotation::move( const GeoDataCoordinates &source, const GeoDataCoordi
         GeoDataLinearRing newRing( Tessellate );
         for ( int j = 0; j < innerRings.at(i).size(); ++j ) {
             const GeoDataCoordinates movedPoint = innerRings.at(i).at(j).rotateAround(rotAxis);
-            if ( osmData ) {
-                osmData->memberReference( i ).changeNodeReference( innerRings.at( i ).at( j ), movedPoint );
-            }
             newRing.append( movedPoint );
         }
         polygon->innerBoundaries().append( newRing );
@@ -282,7 +293,7 @@ void AreaAnnotation::deleteAllSelectedNodes()
                 return;
             }
             if ( osmData ) {
-                osmData->memberReference( -1 ).removeNodeReference( initialOuterRing.at( i ) );
+                osmData->memberReference( -1 ).removeNodeReference( i );
             }
             m_outerNodesList.removeAt( i );
             outerRing.remove( i );
@@ -305,7 +316,7 @@ void AreaAnnotation::deleteAllSelectedNodes()
                 }
 
                 if ( osmData ) {
-                    osmData->memberReference( i ).removeNodeReference( initialInnerRings.at( i ).at( j ) );
+                    osmData->memberReference( i ).removeNodeReference( j );
                 }
                 innerRings[i].remove( j );
                 m_innerNodesList[i].removeAt( j );
@@ -361,7 +372,7 @@ void AreaAnnotation::deleteClickedNode()
 
         // Keep the OsmPlacemarkData synchronized with the geometry
         if ( osmData ) {
-            osmData->removeNodeReference( outerRing.at( i ) );
+            osmData->memberReference( -1 ).removeNodeReference( i );
         }
         outerRing.remove( i );
         m_outerNodesList.removeAt( i );
@@ -375,7 +386,7 @@ void AreaAnnotation::deleteClickedNode()
             return;
         }
         if ( osmData ) {
-            osmData->memberReference( i ).removeNodeReference( innerRings.at( i ).at( j ) );
+            osmData->memberReference( i ).removeNodeReference( j );
         }
         innerRings[i].remove( j );
         m_innerNodesList[i].removeAt( j );
@@ -994,25 +1005,15 @@ bool AreaAnnotation::processEditingOnMove( QMouseEvent *mouseEvent )
         GeoDataPolygon *polygon = static_cast<GeoDataPolygon*>( placemark()->geometry() );
         GeoDataLinearRing &outerRing = polygon->outerBoundary();
         QVector<GeoDataLinearRing> &innerRings = polygon->innerBoundaries();
-        OsmPlacemarkData *osmData = nullptr;
-        if ( placemark()->hasOsmData() ) {
-            osmData = &placemark()->osmData();
-        }
 
         const int i = m_clickedNodeIndexes.first;
         const int j = m_clickedNodeIndexes.second;
 
+        // The node references are kept by vertex index, so they stay in sync with moved nodes
         if ( j == -1 ) {
-            // Keeping the osmPlacemarkData synchronized with the geometry
-            if ( osmData ) {
-                 osmData->memberReference( -1 ).changeNodeReference( outerRing.at( i ), newCoords );
-            }
             outerRing[i] = newCoords;
         } else {
             Q_ASSERT( i != -1 && j != -1 );
-            if ( osmData ) {
-                 osmData->memberReference( i ).changeNodeReference( innerRings.at( i ).at( j ), newCoords );
-            }
             innerRings[i].at(j) = newCoords;
         }
 
@@ -1021,10 +1022,6 @@ bool AreaAnnotation::processEditingOnMove( QMouseEvent *mouseEvent )
         GeoDataPolygon *polygon = static_cast<GeoDataPolygon*>( placemark()->geometry() );
         GeoDataLinearRing outerRing = polygon->outerBoundary();
         QVector<GeoDataLinearRing> innerRings = polygon->innerBoundaries();
-        OsmPlacemarkData *osmData = nullptr;
-        if ( placemark()->hasOsmData() ) {
-            osmData = &placemark()->osmData();
-        }
 
         Quaternion latRectAxis = Quaternion::fromEuler( 0, lon, 0);
         Quaternion latAxis = Quaternion::fromEuler( -deltaLat, 0, 0);
@@ -1037,9 +1034,6 @@ bool AreaAnnotation::processEditingOnMove( QMouseEvent *mouseEvent )
 
         for ( int i = 0; i < outerRing.size(); ++i ) {
             const GeoDataCoordinates movedPoint = outerRing.at(i).rotateAround(rotAxis);
-            if ( osmData ) {
-                osmData->memberReference( -1 ).changeNodeReference( outerRing.at( i ), movedPoint );
-            }
             polygon->outerBoundary().append( movedPoint );
         }
 
@@ -1047,9 +1041,6 @@ bool AreaAnnotation::processEditingOnMove( QMouseEvent *mouseEvent )
             GeoDataLinearRing newRing( Tessellate );
             for ( int j = 0; j < innerRings.at(i).size(); ++j ) {
                 const GeoDataCoordinates movedPoint = innerRings.at(i).at(j).rotateAround(rotAxis);
-                if ( osmData ) {
-                    osmData->memberReference( i ).changeNodeReference( innerRings.at( i ).at( j ) , movedPoint );
-                }
                 newRing.append( movedPoint );
             }
             polygon->innerBoundaries().append( newRing );
@@ -1198,8 +1189,7 @@ bool AreaAnnotation::processMergingOnPress( QMouseEvent *mouseEvent )
                                                                                                                  0.5 );
             // Keeping the osm data synchronized with the geometry
             if ( osmData ) {
-                osmData->memberReference( -1 ).changeNodeReference( outerRing.at( outerIndex ), mergedNode );
-                osmData->memberReference( -1 ).removeNodeReference( outerRing.at( m_firstMergedNode.first ) );
+                osmData->memberReference( -1 ).removeNodeReference( m_firstMergedNode.first );
             }
 
             outerRing[outerIndex] = mergedNode;
@@ -1344,6 +1334,10 @@ bool AreaAnnotation::processAddingNodesOnPress( QMouseEvent *mouseEvent )
             GeoDataCoordinates newCoords = newRing.first().interpolate( newRing.last(), 0.5 );
             newRing.append( newCoords );
 
+            if ( placemark()->hasOsmData() && placemark()->osmData().containsMemberReference( -1 ) ) {
+                rotateNodeReferences( placemark()->osmData().memberReference( -1 ), outerRing.size(), i );
+            }
+
             m_outerNodesList = newList;
             m_outerNodesList.append( PolylineNode( QRegion() ) );
 
@@ -1365,6 +1359,10 @@ bool AreaAnnotation::processAddingNodesOnPress( QMouseEvent *mouseEvent )
             GeoDataCoordinates newCoords = newRing.first().interpolate( newRing.last(), 0.5 );
             newRing.append( newCoords );
 
+            if ( placemark()->hasOsmData() && placemark()->osmData().containsMemberReference( i ) ) {
+                rotateNodeReferences( placemark()->osmData().memberReference( i ), innerRings.at( i ).size(), j );
+            }
+
             m_innerNodesList[i] = newList;
             m_innerNodesList[i].append( PolylineNode( QRegion() ) );
 
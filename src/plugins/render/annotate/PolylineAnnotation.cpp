@@ -277,10 +277,6 @@ void PolylineAnnotation::move( const GeoDataCoordinates &source, const GeoDataCo
 {
     GeoDataLineString *lineString = static_cast<GeoDataLineString*>( placemark()->geometry() );
     GeoDataLineString oldLineString = *lineString;
-    OsmPlacemarkData *osmData = nullptr;
-    if ( placemark()->hasOsmData() ) {
-        osmData = &placemark()->osmData();
-    }
     lineString->clear();
 
     const qreal deltaLat = destination.latitude() - source.latitude();
@@ -293,9 +289,6 @@ void PolylineAnnotation::move( const GeoDataCoordinates &source, const GeoDataCo
 
     for ( int i = 0; i < oldLineString.size(); ++i ) {
         const GeoDataCoordinates movedPoint = oldLineString.at(i).rotateAround(rotAxis);
-        if ( osmData ) {
-            osmData->changeNodeReference( oldLineString.at( i ), movedPoint );
-        }
         lineString->append( movedPoint );
     }
 }
@@ -360,7 +353,7 @@ void PolylineAnnotation::deleteAllSelectedNodes()
                 return;
             }
             if ( osmData ) {
-                osmData->removeNodeReference( line->at( i ) );
+                osmData->removeNodeReference( i );
             }
             m_nodesList.removeAt( i );
             line->remove( i );
@@ -386,7 +379,7 @@ void PolylineAnnotation::deleteClickedNode()
     }
 
     if ( osmData ) {
-        osmData->removeMemberReference( m_clickedNodeIndex );
+        osmData->removeNodeReference( m_clickedNodeIndex );
     }
 
     m_nodesList.removeAt( m_clickedNodeIndex );
@@ -590,24 +583,12 @@ bool PolylineAnnotation::processEditingOnMove( QMouseEvent *mouseEvent )
 
     if ( m_interactingObj == InteractingNode ) {
         GeoDataLineString *line = static_cast<GeoDataLineString*>( placemark()->geometry() );
-        OsmPlacemarkData *osmData = nullptr;
-        if ( placemark()->hasOsmData() ) {
-            osmData = &placemark()->osmData();
-        }
-
-        // Keeping the OsmPlacemarkData synchronized with the geometry
-        if ( osmData ) {
-            osmData->changeNodeReference( line->at( m_clickedNodeIndex ), newCoords );
-        }
+        // The node references are kept by vertex index, so they stay in sync with the moved node
         line->at(m_clickedNodeIndex) = newCoords;
 
         return true;
     } else if ( m_interactingObj == InteractingPolyline ) {
         GeoDataLineString *lineString = static_cast<GeoDataLineString*>( placemark()->geometry() );
-        OsmPlacemarkData *osmData = nullptr;
-        if ( placemark()->hasOsmData() ) {
-            osmData = &placemark()->osmData();
-        }
         const GeoDataLineString oldLineString = *lineString;
         lineString->clear();
 
@@ -621,9 +602,6 @@ bool PolylineAnnotation::processEditingOnMove( QMouseEvent *mouseEvent )
 
         for ( int i = 0; i < oldLineString.size(); ++i ) {
             const GeoDataCoordinates movedPoint = oldLineString.at(i).rotateAround(rotAxis);
-            if ( osmData ) {
-                osmData->changeNodeReference( oldLineString.at( i ), movedPoint );
-            }
             lineString->append( movedPoint );
         }
 
@@ -738,6 +716,10 @@ bool PolylineAnnotation::processAddingNodesOnPress( QMouseEvent *mouseEvent )
 
         line->insert( virtualIndex + 1, line->at( virtualIndex ).interpolate( line->at( virtualIndex + 1 ), 0.5 ) );
         m_nodesList.insert( virtualIndex + 1, PolylineNode() );
+        // Keeping the OsmPlacemarkData synchronized with the geometry
+        if ( placemark()->hasOsmData() ) {
+            placemark()->osmData().insertNodeReference( virtualIndex + 1 );
+        }
 
         m_adjustedNode = virtualIndex + 1;
         m_virtualHoveredNode = -1;
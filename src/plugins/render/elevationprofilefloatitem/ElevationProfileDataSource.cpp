@@ -42,9 +42,11 @@ QVector<QPointF> ElevationProfileDataSource::calculateElevationData(const GeoDat
     QVector<QPointF> result;
     qreal distance = 0;
 
+    const QVector<qreal> elevations = getElevations( lineString );
+
     //GeoDataLineString path;
     for ( int i = 0; i < lineString.size(); i++ ) {
-        const qreal ele = getElevation( lineString[i] );
+        const qreal ele = elevations[i];
 
         if ( i ) {
             distance += EARTH_RADIUS * lineString[i-1].sphericalDistanceTo(lineString[i]);
@@ -107,9 +109,14 @@ bool ElevationProfileTrackDataSource::isDataAvailable() const
     return !m_trackHash.isEmpty();
 }
 
-qreal ElevationProfileTrackDataSource::getElevation(const GeoDataCoordinates &coordinates) const
+QVector<qreal> ElevationProfileTrackDataSource::getElevations(const GeoDataLineString &lineString) const
 {
-    return coordinates.altitude();
+    QVector<qreal> elevations;
+    elevations.reserve( lineString.size() );
+    for ( const GeoDataCoordinates &coordinates: lineString ) {
+        elevations << coordinates.altitude();
+    }
+    return elevations;
 }
 
 void ElevationProfileTrackDataSource::handleObjectAdded(GeoDataObject *object)
@@ -235,12 +242,14 @@ bool ElevationProfileRouteDataSource::isDataAvailable() const
     return m_routingModel && m_routingModel->rowCount() > 0;
 }
 
-qreal ElevationProfileRouteDataSource::getElevation(const GeoDataCoordinates &coordinates) const
+QVector<qreal> ElevationProfileRouteDataSource::getElevations(const GeoDataLineString &lineString) const
 {
-    const qreal lat = coordinates.latitude ( GeoDataCoordinates::Degree );
-    const qreal lon = coordinates.longitude( GeoDataCoordinates::Degree );
-    qreal ele = m_elevationModel->height( lon, lat );
-    return ele;
+    QVector<GeoDataCoordinates> coordinates;
+    coordinates.reserve( lineString.size() );
+    for ( const GeoDataCoordinates &point: lineString ) {
+        coordinates << point;
+    }
+    return m_elevationModel->heights( coordinates );
 }
 // end of impl of ElevationProfileRouteDataSource
 
@@ -111,13 +111,12 @@ void SatellitesModel::updateVisibility()
             // TLE satellites are always earth satellites
             bool enabled = (m_lcPlanet == QLatin1String("earth"));
             eItem->setEnabled( enabled );
-
-            if( enabled ) {
-                eItem->update();
-            }
         }
     }
 
+    // Propagates the orbits of all enabled TLE satellites concurrently
+    updateItems();
+
     endUpdateItems();
 }
 
@@ -36,12 +36,22 @@ SatellitesTLEItem::SatellitesTLEItem( const QString &name,
     : TrackerPluginItem( name ),
       m_satrec( satrec ),
       m_track( new GeoDataTrack() ),
-      m_clock( clock )
+      m_clock( clock ),
+      m_trackStart( 0 ),
+      m_trackEnd( -1 ),
+      m_prepared( false ),
+      m_keepTrack( false ),
+      m_windowStart( 0 ),
+      m_windowEnd( 0 ),
+      m_hasCurrentSample( false )
 {
     double tumin, mu, xke, j2, j3, j4, j3oj2;
     double radiusearthkm;
     getgravconst( wgs84, tumin, mu, radiusearthkm, xke, j2, j3, j4, j3oj2 );
     m_earthSemiMajorAxis = radiusearthkm;
+    m_epoch = timeAtEpoch().toMSecsSinceEpoch();
+    // time interval between each point in the track
+    m_step = qMax<qint64>( 1, period() * 1000 / 100.0 );
 
     setDescription();
 
@@ -72,53 +82,119 @@ void SatellitesTLEItem::setDescription()
     placemark()->setDescription( html );
 }
 
-void SatellitesTLEItem::update()
+void SatellitesTLEItem::prepareUpdate()
 {
+    m_prepared = false;
     if( !isEnabled() ) {
         return;
     }
 
-    QDateTime startTime = m_clock->dateTime();
-    QDateTime endTime = startTime;
+    const qint64 now = m_clock->dateTime().toMSecsSinceEpoch();
+    m_windowStart = now;
+    m_windowEnd = now;
     if( isTrackVisible() ) {
-        startTime = startTime.addSecs( -2 * 60 );
-        endTime = startTime.addSecs( period() );
+        m_windowStart = now - 2 * 60 * 1000;
+        m_windowEnd = m_windowStart + qint64( period() * 1000 );
+    }
+
+    m_hasCurrentSample = sampleAt( now, m_currentSample );
+
+    // Points of the track calculated earlier which are still inside of the
+    // window are kept, only the missing parts on both ends are calculated
+    m_keepTrack = m_trackStart <= m_trackEnd && m_trackStart < m_windowEnd && m_trackEnd >= m_windowStart;
+    m_samples.clear();
+    Sample sample;
+    if ( m_keepTrack ) {
+        for ( qint64 time = m_trackStart - m_step; time >= m_windowStart; time -= m_step ) {
+            if ( sampleAt( time, sample ) ) {
+                m_samples.prepend( sample );
+            }
+        }
+        for ( qint64 time = m_trackEnd + m_step; time < m_windowEnd; time += m_step ) {
+            if ( sampleAt( time, sample ) ) {
+                m_samples.append( sample );
+            }
+        }
+    } else {
+        for ( qint64 time = m_windowStart; time < m_windowEnd; time += m_step ) {
+            if ( sampleAt( time, sample ) ) {
+                m_samples.append( sample );
+            }
+        }
+    }
+
+    m_prepared = true;
+}
+
+void SatellitesTLEItem::update()
+{
+    if( !isEnabled() ) {
+        return;
+    }
+
+    if ( !m_prepared ) {
+        prepareUpdate();
     }
+    m_prepared = false;
 
-    m_track->removeBefore( startTime );
-    m_track->removeAfter( endTime );
+    if ( m_keepTrack ) {
+        m_track->removeBefore( QDateTime::fromMSecsSinceEpoch( m_windowStart, Qt::UTC ) );
+        m_track->removeAfter( QDateTime::fromMSecsSinceEpoch( m_windowEnd, Qt::UTC ) );
 
-    addPointAt( m_clock->dateTime() );
+        // Keep the range of calculated points aligned to the sampling steps
+        if ( m_trackStart < m_windowStart ) {
+            m_trackStart += ( m_windowStart - m_trackStart + m_step - 1 ) / m_step * m_step;
+        }
+        if ( m_trackEnd > m_windowEnd ) {
+            m_trackEnd -= ( m_trackEnd - m_windowEnd + m_step - 1 ) / m_step * m_step;
+        }
+    } else {
+        m_track->clear();
+        m_trackStart = 0;
+        m_trackEnd = -1;
+    }
 
-    // time interval between each point in the track, in seconds
-    double step = period() / 100.0;
+    for ( const Sample &sample: m_samples ) {
+        const QDateTime when = QDateTime::fromMSecsSinceEpoch( sample.time, Qt::UTC );
+        if ( m_track->size() > 0 && m_track->lastWhen().toMSecsSinceEpoch() < sample.time ) {
+            // Appending is cheap, inserting needs to search for the position
+            m_track->appendWhen( when );
+            m_track->appendCoordinates( sample.coordinates );
+        } else {
+            m_track->addPoint( when, sample.coordinates );
+        }
+    }
 
-    for ( double i = startTime.toTime_t(); i < endTime.toTime_t(); i += step ) {
-        // No need to add points in this interval
-        if ( i >= m_track->firstWhen().toTime_t() ) {
-            i = m_track->lastWhen().toTime_t() + step;
+    if ( !m_samples.isEmpty() ) {
+        if ( m_trackStart > m_trackEnd ) {
+            m_trackStart = m_samples.first().time;
+            m_trackEnd = m_samples.last().time;
+        } else {
+            m_trackStart = qMin( m_trackStart, m_samples.first().time );
+            m_trackEnd = qMax( m_trackEnd, m_samples.last().time );
         }
+        m_samples.clear();
+    }
 
-        addPointAt( QDateTime::fromTime_t( i ) );
+    if ( m_hasCurrentSample ) {
+        m_track->addPoint( QDateTime::fromMSecsSinceEpoch( m_currentSample.time, Qt::UTC ), m_currentSample.coordinates );
     }
 }
 
-void SatellitesTLEItem::addPointAt( const QDateTime &dateTime )
+bool SatellitesTLEItem::sampleAt( qint64 time, Sample &sample )
 {
     // in minutes
-    double timeSinceEpoch = (double)( dateTime.toTime_t() -
-        timeAtEpoch().toTime_t() ) / 60.0;
+    const double timeSinceEpoch = ( time - m_epoch ) / 60000.0;
 
     double r[3], v[3];
     sgp4( wgs84, m_satrec, timeSinceEpoch, r, v );
-
-    GeoDataCoordinates coordinates = fromTEME(
-        r[0], r[1], r[2], gmst( timeSinceEpoch ) );
     if ( m_satrec.error != 0 ) {
-        return;
+        return false;
     }
 
-    m_track->addPoint( dateTime, coordinates);
+    sample.time = time;
+    sample.coordinates = fromTEME( r[0], r[1], r[2], gmst( timeSinceEpoch ) );
+    return true;
 }
 
 QDateTime SatellitesTLEItem::timeAtEpoch() const
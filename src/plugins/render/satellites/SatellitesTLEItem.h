@@ -12,6 +12,9 @@
 #define MARBLE_SATELLITESTLEITEM_H
 
 #include "TrackerPluginItem.h"
+#include "GeoDataCoordinates.h"
+
+#include <QVector>
 
 #include <sgp4unit.h>
 
@@ -20,7 +23,6 @@ class QDateTime;
 
 namespace Marble {
 
-class GeoDataCoordinates;
 class GeoDataTrack;
 class MarbleClock;
 
@@ -35,23 +37,53 @@ public:
                        elsetrec satrec,
                        const MarbleClock *clock );
 
+    /**
+     * Propagates the orbit to the points of the track which are not
+     * calculated yet. As time advances only a few new points at the end
+     * of the track are needed.
+     */
+    void prepareUpdate() override;
+
     void update() override;
 
 private:
+    struct Sample
+    {
+        qint64 time; // in msecs since the Unix epoch
+        GeoDataCoordinates coordinates;
+    };
+
     double m_earthSemiMajorAxis; // in km
     elsetrec m_satrec;
+    qint64 m_epoch; // satellite epoch in msecs since the Unix epoch
+    qint64 m_step; // time between two points of the track, in msecs
 
     GeoDataTrack *m_track;
 
     const MarbleClock *m_clock;
 
+    // Time range of the calculated track, in msecs since the Unix epoch,
+    // empty if m_trackStart > m_trackEnd
+    qint64 m_trackStart;
+    qint64 m_trackEnd;
+
+    // Results of prepareUpdate() not yet applied to the track
+    bool m_prepared;
+    bool m_keepTrack;
+    qint64 m_windowStart;
+    qint64 m_windowEnd;
+    QVector<Sample> m_samples;
+    bool m_hasCurrentSample;
+    Sample m_currentSample;
+
     void setDescription();
 
     /**
-     * Add a point in the GeoDataTrack geometry of the placemark with time
-     * dateTime and coordinates of the satellite determined from m_satrec.
+     * Calculate the coordinates of the satellite determined from m_satrec
+     * at @p time in msecs since the Unix epoch.
+     * @return false if the propagation failed
      */
-    void addPointAt( const QDateTime &dateTime );
+    bool sampleAt( qint64 time, Sample &sample );
 
     /**
      * Create a GeoDataCoordinates object from the cartesian coordinates
@@ -71,6 +71,10 @@ void TrackerPluginItem::setVisible( bool visible )
     d->m_placemark->setVisible( visible );
 }
 
+void TrackerPluginItem::prepareUpdate()
+{
+}
+
 bool TrackerPluginItem::isTrackVisible() const
 {
     return d->m_trackVisible;
@@ -76,6 +76,18 @@ public:
      */
     virtual void setTrackVisible( bool visible );
 
+    /**
+     * Reimplement this method to do the expensive part of update() in advance,
+     * for example to calculate new coordinates. If this item is in a
+     * TrackerPluginModel, this method is called for all enabled items
+     * concurrently from a thread pool, right before update() is called for
+     * each of them in the GUI thread. It must neither touch the placemark nor
+     * any other state shared between items.
+     *
+     * The default implementation does nothing.
+     */
+    virtual void prepareUpdate();
+
     /**
      * Reimplement this method to update the placemark, for example to change its coordinates.
      * If this item is in a TrackerPluginModel, this method will be called regularly.
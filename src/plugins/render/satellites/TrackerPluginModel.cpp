@@ -20,9 +20,35 @@
 #include "MarbleModel.h"
 #include "TrackerPluginItem.h"
 
+#include <QRunnable>
+#include <QThreadPool>
+
 namespace Marble
 {
 
+class TrackerPrepareJob : public QRunnable
+{
+public:
+    TrackerPrepareJob( const QVector<TrackerPluginItem*> &items, int begin, int end )
+        : m_items( items ),
+          m_begin( begin ),
+          m_end( end )
+    {
+    }
+
+    void run() override
+    {
+        for ( int i = m_begin; i < m_end; ++i ) {
+            m_items.at( i )->prepareUpdate();
+        }
+    }
+
+private:
+    const QVector<TrackerPluginItem*> m_items;
+    const int m_begin;
+    const int m_end;
+};
+
 class TrackerPluginModelPrivate
 {
 public:
@@ -52,6 +78,22 @@ public:
 
     void update()
     {
+        QVector<TrackerPluginItem*> enabledItems;
+        enabledItems.reserve( m_itemVector.size() );
+        for( TrackerPluginItem *item: m_itemVector ) {
+            if ( item->isEnabled() ) {
+                enabledItems.append( item );
+            }
+        }
+
+        // A few chunks per thread even out items of different cost
+        const int count = enabledItems.size();
+        const int chunks = qMin( count, 4 * m_threadPool.maxThreadCount() );
+        for ( int i = 0; i < chunks; ++i ) {
+            m_threadPool.start( new TrackerPrepareJob( enabledItems, i * count / chunks, ( i + 1 ) * count / chunks ) );
+        }
+        m_threadPool.waitForDone();
+
         for( TrackerPluginItem *item: m_itemVector ) {
             item->update();
         }
@@ -79,6 +121,7 @@ public:
     CacheStoragePolicy m_storagePolicy;
     HttpDownloadManager *m_downloadManager;
     QVector<TrackerPluginItem *> m_itemVector;
+    QThreadPool m_threadPool;
 };
 
 TrackerPluginModel::TrackerPluginModel( GeoDataTreeModel *treeModel )
@@ -156,6 +199,11 @@ void TrackerPluginModel::endUpdateItems()
     emit itemUpdateEnded();
 }
 
+void TrackerPluginModel::updateItems()
+{
+    d->update();
+}
+
 void TrackerPluginModel::downloadFile(const QUrl &url, const QString &id)
 {
     d->m_downloadManager->addJob( url, id, id, DownloadBrowse );
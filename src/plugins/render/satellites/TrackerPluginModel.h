@@ -77,6 +77,12 @@ public:
      */
     void endUpdateItems();
 
+    /**
+     * Update all enabled items. The expensive parts of the updates are done
+     * concurrently, see TrackerPluginItem::prepareUpdate().
+     */
+    void updateItems();
+
     /**
      * Adds @p url to the download queue.
      * Once the file is downloaded, parseFile() will be called with its first
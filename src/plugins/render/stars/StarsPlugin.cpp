@@ -22,6 +22,8 @@
 #include <QPainterPath>
 #include <qmath.h>
 
+#include <algorithm>
+
 #include "MarbleClock.h"
 #include "MarbleColors.h"
 #include "MarbleDebug.h"
@@ -61,6 +63,7 @@ StarsPlugin::StarsPlugin( const MarbleModel *marbleModel )
       m_dsosLoaded( false ),
       m_zoomSunMoon( true ),
       m_viewSolarSystemLabel( true ),
+      m_starCatalogDirty( true ),
       m_magnitudeLimit( 100 ),
       m_zoomCoefficient( 4 ),
       m_constellationBrush( Marble::Oxygen::aluminumGray5 ),
@@ -594,6 +597,7 @@ void StarsPlugin::loadStars()
         // Increment Index for use in hash
         ++starIndex;
     }
+    m_starCatalogDirty = true;
 
     // load the Sun pixmap
     // TODO: adjust pixmap size according to distance
@@ -683,6 +687,119 @@ void StarsPlugin::createStarPixmaps()
     }
 
     m_starPixmapsCreated = true;
+    m_starCatalogDirty = true;
+}
+
+void StarsPlugin::buildStarCatalog()
+{
+    QVector<int> order( m_stars.size() );
+    for ( int i = 0; i < order.size(); ++i ) {
+        order[i] = i;
+    }
+    std::stable_sort( order.begin(), order.end(), [this]( int a, int b ) {
+        return m_stars.at( a ).magnitude() < m_stars.at( b ).magnitude();
+    } );
+
+    m_starX.resize( order.size() );
+    m_starY.resize( order.size() );
+    m_starZ.resize( order.size() );
+    m_starMagnitudes.resize( order.size() );
+    m_starCatalogPixmaps.resize( order.size() );
+    for ( int i = 0; i < order.size(); ++i ) {
+        const StarPoint &star = m_stars.at( order.at( i ) );
+        m_starX[i] = star.quaternion().v[Q_X];
+        m_starY[i] = star.quaternion().v[Q_Y];
+        m_starZ[i] = star.quaternion().v[Q_Z];
+        m_starMagnitudes[i] = star.magnitude();
+        // colorId is used to select which pixmap in vector to display
+        m_starCatalogPixmaps[i] = starPixmap( star.magnitude(), star.colorId() );
+    }
+
+    m_starCatalogDirty = false;
+    m_starLayerKey.clear();
+}
+
+void StarsPlugin::renderStars( GeoPainter *painter, const ViewportParams *viewport,
+                               const matrix &skyAxisMatrix, qreal skyRadius, qreal earthRadius )
+{
+    if ( m_starCatalogDirty ) {
+        buildStarCatalog();
+    }
+
+    const int width = viewport->width();
+    const int height = viewport->height();
+    const qreal pixelRatio = painter->device() ? painter->device()->devicePixelRatioF() : 1.0;
+
+    // The stars only move if the camera or the time changes, until then
+    // the layer rendered before is good enough
+    QVector<qreal> key;
+    key.reserve( 15 );
+    for ( int i = 0; i < 3; ++i ) {
+        key << skyAxisMatrix[i][0] << skyAxisMatrix[i][1] << skyAxisMatrix[i][2];
+    }
+    key << skyRadius << earthRadius << width << height << pixelRatio << m_magnitudeLimit;
+
+    if ( key != m_starLayerKey ) {
+        // Show only stars brighter than the magnitude threshold
+        const int count = std::lower_bound( m_starMagnitudes.constBegin(), m_starMagnitudes.constEnd(),
+                                            qreal( m_magnitudeLimit ) ) - m_starMagnitudes.constBegin();
+
+        m_rotatedX.resize( count );
+        m_rotatedY.resize( count );
+        m_rotatedZ.resize( count );
+        const qreal *x = m_starX.constData();
+        const qreal *y = m_starY.constData();
+        const qreal *z = m_starZ.constData();
+        qreal *rotatedX = m_rotatedX.data();
+        qreal *rotatedY = m_rotatedY.data();
+        qreal *rotatedZ = m_rotatedZ.data();
+        const qreal m00 = skyAxisMatrix[0][0], m01 = skyAxisMatrix[0][1], m02 = skyAxisMatrix[0][2];
+        const qreal m10 = skyAxisMatrix[1][0], m11 = skyAxisMatrix[1][1], m12 = skyAxisMatrix[1][2];
+        const qreal m20 = skyAxisMatrix[2][0], m21 = skyAxisMatrix[2][1], m22 = skyAxisMatrix[2][2];
+        // Same as Quaternion::rotateAroundAxis(), without branches for all stars at once
+        for ( int s = 0; s < count; ++s ) {
+            rotatedX[s] = m00 * x[s] + m10 * y[s] + m20 * z[s];
+            rotatedY[s] = m01 * x[s] + m11 * y[s] + m21 * z[s];
+            rotatedZ[s] = m02 * x[s] + m12 * y[s] + m22 * z[s];
+        }
+
+        m_starLayer = QPixmap( QSize( width, height ) * pixelRatio );
+        m_starLayer.setDevicePixelRatio( pixelRatio );
+        m_starLayer.fill( Qt::transparent );
+        QPainter layerPainter( &m_starLayer );
+
+        const qreal earthRadiusSquared = earthRadius * earthRadius;
+        for ( int s = 0; s < count; ++s ) {
+            if ( rotatedZ[s] > 0 ) {
+                continue;
+            }
+
+            const qreal earthCenteredX = rotatedX[s] * skyRadius;
+            const qreal earthCenteredY = rotatedY[s] * skyRadius;
+
+            // Don't draw stars hidden by the earth
+            if ( rotatedZ[s] < 0
+                 && earthCenteredX * earthCenteredX + earthCenteredY * earthCenteredY < earthRadiusSquared ) {
+                continue;
+            }
+
+            // Let (x, y) be the position on the screen of the star
+            const int screenX = ( int )( width  / 2 + earthCenteredX );
+            const int screenY = ( int )( height / 2 - earthCenteredY );
+
+            // Skip stars that are outside the screen area
+            if ( screenX < 0 || screenX >= width || screenY < 0 || screenY >= height ) {
+                continue;
+            }
+
+            const QPixmap &pixmap = m_starCatalogPixmaps.at( s );
+            layerPainter.drawPixmap( screenX - pixmap.width() / 2, screenY - pixmap.height() / 2, pixmap );
+        }
+
+        m_starLayerKey = key;
+    }
+
+    painter->drawPixmap( 0, 0, m_starLayer );
 }
 
 void StarsPlugin::loadConstellations()
@@ -1065,47 +1182,7 @@ bool StarsPlugin::render( GeoPainter *painter, ViewportParams *viewport,
         }
 
         // Render Stars
-
-        for ( int s = 0; s < m_stars.size(); ++s  ) {
-            Quaternion  qpos = m_stars.at(s).quaternion();
-
-            qpos.rotateAroundAxis( skyAxisMatrix );
-
-            if ( qpos.v[Q_Z] > 0 ) {
-                continue;
-            }
-
-            qreal  earthCenteredX = qpos.v[Q_X] * skyRadius;
-            qreal  earthCenteredY = qpos.v[Q_Y] * skyRadius;
-
-            // Don't draw high placemarks (e.g. satellites) that aren't visible.
-            if ( qpos.v[Q_Z] < 0
-                    && ( ( earthCenteredX * earthCenteredX
-                           + earthCenteredY * earthCenteredY )
-                         < earthRadius * earthRadius ) ) {
-                continue;
-            }
-
-            // Let (x, y) be the position on the screen of the placemark..
-            const int x = ( int )( viewport->width()  / 2 + skyRadius * qpos.v[Q_X] );
-            const int y = ( int )( viewport->height() / 2 - skyRadius * qpos.v[Q_Y] );
-
-            // Skip placemarks that are outside the screen area
-            if ( x < 0 || x >= viewport->width()
-                    || y < 0 || y >= viewport->height() )
-                continue;
-
-            // Show star if it is brighter than magnitude threshold
-            if ( m_stars.at(s).magnitude() < m_magnitudeLimit ) {
-
-                // colorId is used to select which pixmap in vector to display
-                int colorId = m_stars.at(s).colorId();
-                QPixmap s_pixmap = starPixmap(m_stars.at(s).magnitude(), colorId);
-                int sizeX = s_pixmap.width();
-                int sizeY = s_pixmap.height();
-                painter->drawPixmap( x-sizeX/2, y-sizeY/2 ,s_pixmap );
-            }
-        }
+        renderStars( painter, viewport, skyAxisMatrix, skyRadius, earthRadius );
 
         if ( m_renderSun ) {
             // sun
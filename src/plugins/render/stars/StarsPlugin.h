@@ -20,6 +20,7 @@
 #include <QMap>
 #include <QVariant>
 #include <QBrush>
+#include <QPixmap>
 
 #include "RenderPlugin.h"
 #include "Quaternion.h"
@@ -222,6 +223,12 @@ private:
                       matrix &skyAxisMatrix) const;
     void createStarPixmaps();
     void loadStars();
+    void buildStarCatalog();
+    void renderStars(GeoPainter *painter,
+                     const ViewportParams *viewport,
+                     const matrix &skyAxisMatrix,
+                     qreal skyRadius,
+                     qreal earthRadius);
     void loadConstellations();
     void loadDsos();
     QPointer<QDialog> m_configDialog;
@@ -244,6 +251,23 @@ private:
     bool m_zoomSunMoon;
     bool m_viewSolarSystemLabel;
     QVector<StarPoint> m_stars;
+
+    // The stars sorted by magnitude, brightest first, so that the stars
+    // above the magnitude limit are skipped altogether. Stored as separate
+    // arrays so that the rotation of the whole catalog vectorizes.
+    bool m_starCatalogDirty;
+    QVector<qreal> m_starX;
+    QVector<qreal> m_starY;
+    QVector<qreal> m_starZ;
+    QVector<qreal> m_starMagnitudes;
+    QVector<QPixmap> m_starCatalogPixmaps;
+    QVector<qreal> m_rotatedX;
+    QVector<qreal> m_rotatedY;
+    QVector<qreal> m_rotatedZ;
+
+    // Rendered stars, reused as long as sky orientation and viewport stay the same
+    QPixmap m_starLayer;
+    QVector<qreal> m_starLayerKey;
     QPixmap m_pixmapSun;
     QPixmap m_pixmapMoon;
     QVector<Constellation> m_constellations;
@@ -196,12 +196,13 @@ GeoDataDocument *CycleStreetsRunner::parse( const QByteArray &content ) const
     }
     routePlacemark->setGeometry( routeWaypoints );
 
+    const int seconds = route["time"].toInt();
     QTime duration;
-    duration = duration.addSecs( route["time"].toInt() );
+    duration = duration.addSecs( seconds );
     qreal length = routeWaypoints->length( EARTH_RADIUS );
 
     const QString name = nameString( "CS", length, duration );
-    const GeoDataExtendedData data = routeData( length, duration );
+    const GeoDataExtendedData data = routeData( length, duration, seconds );
     routePlacemark->setExtendedData( data );
     result->setName( name );
     result->append( routePlacemark );
@@ -14,9 +14,9 @@
 #include "MarbleDebug.h"
 #include <MarbleZipReader.h>
 
-#include <QBuffer>
 #include <QFile>
 #include <QFileInfo>
+#include <QScopedPointer>
 
 namespace Marble
 {
@@ -39,14 +39,16 @@ GeoDataDocument *KmlRunner::parseFile(const QString &fileName, DocumentRole role
         return nullptr;
     }
 
-    QBuffer buffer;
+    // The KML is parsed while it is inflated, the reader has to outlive the entry device
+    QScopedPointer<MarbleZipReader> zipReader;
+    QScopedPointer<QIODevice> zipDevice;
     QIODevice* device = nullptr;
 
     if (fileName.toLower().endsWith(QLatin1String(".kmz"))) {
-        MarbleZipReader zipReader(&file);
+        zipReader.reset(new MarbleZipReader(&file));
 
         QStringList kmlFiles;
-        for(const MarbleZipReader::FileInfo &zipFileInfo : zipReader.fileInfoList()) {
+        for(const MarbleZipReader::FileInfo &zipFileInfo : zipReader->fileInfoList()) {
             if (zipFileInfo.filePath.toLower().endsWith(QLatin1String(".kml"))) {
                 kmlFiles.append(zipFileInfo.filePath);
             }
@@ -59,10 +61,13 @@ GeoDataDocument *KmlRunner::parseFile(const QString &fileName, DocumentRole role
             mDebug() << QStringLiteral("File %1 contains multiple KML files").arg(fileName);
         }
 
-        QByteArray const data = zipReader.fileData(kmlFiles[0]);
-        buffer.setData(data);
-        buffer.open(QBuffer::ReadOnly);
-        device = &buffer;
+        zipDevice.reset(zipReader->fileDevice(kmlFiles[0]));
+        if (!zipDevice) {
+            error = QStringLiteral("Cannot read %1 from file %2").arg(kmlFiles[0], fileName);
+            mDebug() << error;
+            return nullptr;
+        }
+        device = zipDevice.data();
     } else {
         device = &file;
     }
@@ -227,11 +227,12 @@ GeoDataDocument* MapQuestRunner::parse( const QByteArray &content ) const
     }
     routePlacemark->setGeometry( routeWaypoints );
 
+    const int seconds = root.elementsByTagName(QStringLiteral("time")).at(0).toElement().text().toInt();
     QTime time;
-    time = time.addSecs(root.elementsByTagName(QStringLiteral("time")).at(0).toElement().text().toInt());
+    time = time.addSecs(seconds);
     qreal length = routeWaypoints->length( EARTH_RADIUS );
     const QString name = nameString( "MQ", length, time );
-    const GeoDataExtendedData data = routeData( length, time );
+    const GeoDataExtendedData data = routeData( length, time, seconds );
     routePlacemark->setExtendedData( data );
     result->setName( name );
     result->append( routePlacemark );
@@ -237,7 +237,7 @@ void MonavRunner::retrieveRoute( const RouteRequest *route )
     time = time.addSecs( duration );
     qreal length = waypoints->length( EARTH_RADIUS );
     const QString name = nameString( "Monav", length, time );
-    const GeoDataExtendedData data = routeData( length, time );
+    const GeoDataExtendedData data = routeData( length, time, duration );
     GeoDataDocument *result = d->createDocument( waypoints, instructions, name, data );
     emit routeCalculated( result );
 }
@@ -201,11 +201,12 @@ GeoDataDocument *OSRMRunner::parse( const QByteArray &input ) const
                 routeWaypoints = decodePolyline(routeGeometryValue.toString());
                 routePlacemark->setGeometry( routeWaypoints );
 
+                const int seconds = qRound(route.value(QStringLiteral("duration")).toDouble());
                 auto time = QTime(0, 0, 0);
-                time = time.addSecs(qRound(route.value(QStringLiteral("duration")).toDouble()));
+                time = time.addSecs(seconds);
                 qreal length = routeWaypoints->length( EARTH_RADIUS );
                 const QString name = nameString( "OSRM", length, time );
-                const GeoDataExtendedData extendedData = routeData( length, time );
+                const GeoDataExtendedData extendedData = routeData( length, time, seconds );
                 routePlacemark->setExtendedData( extendedData );
                 result->setName( name );
                 result->append( routePlacemark );
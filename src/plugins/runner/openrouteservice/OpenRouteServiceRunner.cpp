@@ -193,6 +193,7 @@ GeoDataDocument* OpenRouteServiceRunner::parse( const QByteArray &content ) cons
     GeoDataPlacemark* routePlacemark = new GeoDataPlacemark;
     routePlacemark->setName(QStringLiteral("Route"));
     QTime time;
+    qint64 totalSeconds = -1;
     QDomNodeList summary = root.elementsByTagName(QStringLiteral("xls:RouteSummary"));
     if ( summary.size() > 0 ) {
         QDomNodeList timeNodeList = summary.item(0).toElement().elementsByTagName(QStringLiteral("xls:TotalTime"));
@@ -200,10 +201,10 @@ GeoDataDocument* OpenRouteServiceRunner::parse( const QByteArray &content ) cons
             QRegExp regexp = QRegExp( "^P(?:(\\d+)D)?T(?:(\\d+)H)?(?:(\\d+)M)?(\\d+)S" );
             if ( regexp.indexIn( timeNodeList.item( 0 ).toElement().text() ) == 0 ) {
                 QStringList matches = regexp.capturedTexts();
-                unsigned int hours( 0 ), minutes( 0 ), seconds( 0 );
+                unsigned int days( 0 ), hours( 0 ), minutes( 0 ), seconds( 0 );
                 switch ( matches.size() ) {
                 case 5:
-                    // days    = regexp.cap( matches.size() - 4 ).toInt();
+                    days    = regexp.cap( matches.size() - 4 ).toInt();
                     // Intentionally no break
                 case 4:
                     hours   = regexp.cap( matches.size() - 3 ).toInt();
@@ -219,6 +220,7 @@ GeoDataDocument* OpenRouteServiceRunner::parse( const QByteArray &content ) cons
                 }
 
                 time = QTime( hours, minutes, seconds, 0 );
+                totalSeconds = ( ( qint64( days ) * 24 + hours ) * 60 + minutes ) * 60 + seconds;
             }
         }
     }
@@ -242,7 +244,7 @@ GeoDataDocument* OpenRouteServiceRunner::parse( const QByteArray &content ) cons
 
     qreal length = routeWaypoints->length( EARTH_RADIUS );
     const QString name = nameString( "ORS", length, time );
-    const GeoDataExtendedData data = routeData( length, time );
+    const GeoDataExtendedData data = routeData( length, time, totalSeconds );
     routePlacemark->setExtendedData( data );
     result->setName( name );
 
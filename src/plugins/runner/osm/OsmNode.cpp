@@ -47,7 +47,7 @@ GeoDataPlacemark *OsmNode::create() const
     coordinates.setAltitude(m_osmData.tagValue("ele").toDouble());
     placemark->setCoordinate(coordinates);
 
-    QHash<QString, QString>::const_iterator tagIter;
+    OsmPlacemarkData::TagIterator tagIter;
     if ((category == GeoDataPlacemark::TransportCarShare || category == GeoDataPlacemark::MoneyAtm)
             && (tagIter = m_osmData.findTag(QStringLiteral("operator"))) != m_osmData.tagsEnd()) {
         placemark->setName(tagIter.value());
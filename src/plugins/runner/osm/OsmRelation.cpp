@@ -97,8 +97,9 @@ void OsmRelation::createMultipolygon(GeoDataDocument *document, OsmWays &ways, c
             usedWays << wayId;
         } // else we keep it
 
-        for(auto nodeId: ways[wayId].references()) {
-            ways[wayId].osmData().addNodeReference(nodes[nodeId].coordinates(), nodes[nodeId].osmData());
+        OsmWay &way = ways[wayId];
+        for (int i = 0; i < way.references().size(); ++i) {
+            way.osmData().addNodeReference(i, nodes[way.references()[i]].osmData());
         }
     }
 
@@ -241,8 +242,8 @@ OsmRelation::OsmRings OsmRelation::rings(const QStringList &roles, const OsmWays
                 return OsmRings();
             }
             const auto &node = nodes[id];
+            placemarkData.addNodeReference(ring.size(), node.osmData());
             ring << node.coordinates();
-            placemarkData.addNodeReference(node.coordinates(), node.osmData());
         }
         Q_ASSERT(ways.contains(wayId));
         currentWays << wayId;
@@ -274,8 +275,8 @@ OsmRelation::OsmRings OsmRelation::rings(const QStringList &roles, const OsmWays
                             }
                             if ( id != lastReference ) {
                                 const auto &node = nodes[id];
+                                placemarkData.addNodeReference(ring.size(), node.osmData());
                                 ring << node.coordinates();
-                                placemarkData.addNodeReference(node.coordinates(), node.osmData());
                                 currentNodes << id;
                             }
                         }
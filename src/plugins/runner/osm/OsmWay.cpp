@@ -41,7 +41,7 @@ GeoDataPlacemark *OsmWay::create(const OsmNodes &nodes, QSet<qint64> &usedNodes)
             }
 
             OsmNode const & node = nodeIter.value();
-            osmData.addNodeReference(node.coordinates(), node.osmData());
+            osmData.addNodeReference(i, node.osmData());
             linearRing.append(node.coordinates());
             usedNodes << nodeId;
         }
@@ -50,7 +50,7 @@ GeoDataPlacemark *OsmWay::create(const OsmNodes &nodes, QSet<qint64> &usedNodes)
             GeoDataBuilding building;
             building.setName(extractBuildingName());
             building.setHeight(extractBuildingHeight());
-            building.setEntries(extractNamedEntries());
+            building.setEntries(extractNamedEntries(linearRing));
             building.multiGeometry()->append(new GeoDataLinearRing(linearRing.optimized()));
 
             geometry = new GeoDataBuilding(building);
@@ -68,7 +68,7 @@ GeoDataPlacemark *OsmWay::create(const OsmNodes &nodes, QSet<qint64> &usedNodes)
             }
 
             OsmNode const & node = nodeIter.value();
-            osmData.addNodeReference(node.coordinates(), node.osmData());
+            osmData.addNodeReference(lineString.size(), node.osmData());
             lineString.append(node.coordinates());
             usedNodes << nodeId;
         }
@@ -242,7 +242,7 @@ double OsmWay::extractBuildingHeight() const
 {
     double height = 8.0;
 
-    QHash<QString, QString>::const_iterator tagIter;
+    OsmPlacemarkData::TagIterator tagIter;
     if ((tagIter = m_osmData.findTag(QStringLiteral("height"))) != m_osmData.tagsEnd()) {
         height = GeoDataBuilding::parseBuildingHeight(tagIter.value());
     } else if ((tagIter = m_osmData.findTag(QStringLiteral("building:levels"))) != m_osmData.tagsEnd()) {
@@ -255,16 +255,16 @@ double OsmWay::extractBuildingHeight() const
     return qBound(1.0, height, 1000.0);
 }
 
-QVector<GeoDataBuilding::NamedEntry> OsmWay::extractNamedEntries() const
+QVector<GeoDataBuilding::NamedEntry> OsmWay::extractNamedEntries(const GeoDataLinearRing &ring) const
 {
     QVector<GeoDataBuilding::NamedEntry> entries;
 
     const auto end = m_osmData.nodeReferencesEnd();
-    for (auto iter = m_osmData.nodeReferencesBegin(); iter != end; ++iter) {
+    for (auto iter = m_osmData.nodeReferencesBegin(); iter != end && iter.key() < ring.size(); ++iter) {
         const auto tagIter = iter.value().findTag(QStringLiteral("addr:housenumber"));
         if (tagIter != iter.value().tagsEnd()) {
             GeoDataBuilding::NamedEntry entry;
-            entry.point = iter.key();
+            entry.point = ring.at(iter.key());
             entry.label = tagIter.value();
             entries.push_back(entry);
         }
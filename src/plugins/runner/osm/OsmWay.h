@@ -22,6 +22,7 @@
 namespace Marble {
 
 class GeoDataDocument;
+class GeoDataLinearRing;
 
 class OsmWay
 {
@@ -51,7 +52,7 @@ private:
 
     QString extractBuildingName() const;
     double extractBuildingHeight() const;
-    QVector<GeoDataBuilding::NamedEntry> extractNamedEntries() const;
+    QVector<GeoDataBuilding::NamedEntry> extractNamedEntries(const GeoDataLinearRing &ring) const;
 };
 
 typedef QHash<qint64,OsmWay> OsmWays;
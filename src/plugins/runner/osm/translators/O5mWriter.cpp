@@ -27,7 +27,16 @@
 namespace Marble
 {
 
-QSet<QString> O5mWriter::m_blacklistedTags;
+// Filled up front, the writer may be used from several threads at once
+const QSet<QString> O5mWriter::m_blacklistedTags = {
+    QStringLiteral("mx:version"),
+    QStringLiteral("mx:changeset"),
+    QStringLiteral("mx:uid"),
+    QStringLiteral("mx:visible"),
+    QStringLiteral("mx:user"),
+    QStringLiteral("mx:timestamp"),
+    QStringLiteral("mx:action")
+};
 
 bool O5mWriter::write(QIODevice *device, const GeoDataDocument &document)
 {
@@ -248,19 +257,16 @@ void O5mWriter::writeRelationMembers(const GeoDataRelation *relation, qint64 (&l
 
 void O5mWriter::writeReferences(const GeoDataLineString &lineString, qint64 &lastId, const OsmPlacemarkData &osmData, QDataStream &stream) const
 {
-    QVector<GeoDataCoordinates>::const_iterator it = lineString.constBegin();
-    QVector<GeoDataCoordinates>::ConstIterator const end = lineString.constEnd();
-
-    for ( ; it != end; ++it ) {
-        qint64 id = osmData.nodeReference( *it ).id();
+    for ( int i = 0; i < lineString.size(); ++i ) {
+        qint64 id = osmData.nodeReference( i ).id();
         qint64 idDiff = id - lastId;
         writeSigned(idDiff, stream);
         lastId = id;
     }
 
     if (!lineString.isEmpty() && lineString.isClosed()) {
-        auto const startId = osmData.nodeReference(lineString.first()).id();
-        auto const endId = osmData.nodeReference(lineString.last()).id();
+        auto const startId = osmData.nodeReference(0).id();
+        auto const endId = osmData.nodeReference(lineString.size() - 1).id();
         if (startId != endId) {
             qint64 idDiff = startId - lastId;
             writeSigned(idDiff, stream);
@@ -277,16 +283,6 @@ void O5mWriter::writeVersion(const OsmPlacemarkData &, QDataStream &stream) cons
 
 void O5mWriter::writeTags(const OsmPlacemarkData &osmData, StringTable &stringTable, QDataStream &stream) const
 {
-    if (m_blacklistedTags.isEmpty()) {
-        m_blacklistedTags << QStringLiteral("mx:version");
-        m_blacklistedTags << QStringLiteral("mx:changeset");
-        m_blacklistedTags << QStringLiteral("mx:uid");
-        m_blacklistedTags << QStringLiteral("mx:visible");
-        m_blacklistedTags << QStringLiteral("mx:user");
-        m_blacklistedTags << QStringLiteral("mx:timestamp");
-        m_blacklistedTags << QStringLiteral("mx:action");
-    }
-
     for (auto iter=osmData.tagsBegin(), end = osmData.tagsEnd(); iter != end; ++iter) {
         if (!m_blacklistedTags.contains(iter.key())) {
             writeStringPair(StringPair(iter.key(), iter.value()), stringTable, stream);
@@ -299,16 +295,18 @@ void O5mWriter::writeStringPair(const StringPair &pair, StringTable &stringTable
     Q_ASSERT(stringTable.size() <= 15000);
     auto const iter = stringTable.constFind(pair);
     if (iter == stringTable.cend()) {
-        m_stringPairBuffer.clear();
-        m_stringPairBuffer.push_back(char(0x00));
-        m_stringPairBuffer.push_back(pair.first.toUtf8());
+        // Per thread, tiles are written concurrently by the tile creator
+        static thread_local QByteArray stringPairBuffer;
+        stringPairBuffer.clear();
+        stringPairBuffer.push_back(char(0x00));
+        stringPairBuffer.push_back(pair.first.toUtf8());
         if (!pair.second.isEmpty()) {
-            m_stringPairBuffer.push_back(char(0x00));
-            m_stringPairBuffer.push_back(pair.second.toUtf8());
+            stringPairBuffer.push_back(char(0x00));
+            stringPairBuffer.push_back(pair.second.toUtf8());
         }
-        m_stringPairBuffer.push_back(char(0x00));
-        stream.writeRawData(m_stringPairBuffer.constData(), m_stringPairBuffer.size());
-        bool const tooLong = (m_stringPairBuffer.size() - (pair.second.isEmpty() ? 2 : 3)) > 250;
+        stringPairBuffer.push_back(char(0x00));
+        stream.writeRawData(stringPairBuffer.constData(), stringPairBuffer.size());
+        bool const tooLong = (stringPairBuffer.size() - (pair.second.isEmpty() ? 2 : 3)) > 250;
         bool const tableFull = stringTable.size() > 15000;
         Q_ASSERT(!tableFull);
         if (!tooLong && !tableFull) {
@@ -48,9 +48,7 @@ private:
   void writeUnsigned(quint32 value, QDataStream &stream) const;
   qint32 deltaTo(double value, double previous) const;
 
-  static QSet<QString> m_blacklistedTags;
-
-  mutable QByteArray m_stringPairBuffer;
+  static const QSet<QString> m_blacklistedTags;
 };
 
 }
@@ -50,8 +50,8 @@ void OsmConverter::read(const GeoDataDocument *document)
             if (geodata_cast<GeoDataPoint>(placemark->geometry())) {
                 m_nodes << OsmConverter::Node(placemark->coordinate(), osmData);
             } else if (const auto lineString = geodata_cast<GeoDataLineString>(placemark->geometry())) {
-                for (auto const &coordinates: *lineString) {
-                    m_nodes << OsmConverter::Node(coordinates, osmData.nodeReference(coordinates));
+                for (int i = 0; i < lineString->size(); ++i) {
+                    m_nodes << OsmConverter::Node(lineString->at(i), osmData.nodeReference(i));
                 }
                 m_ways << OsmConverter::Way(lineString, osmData);
             } else if (const auto linearRing = geodata_cast<GeoDataLinearRing>(placemark->geometry())) {
@@ -94,8 +94,8 @@ const OsmConverter::Relations &OsmConverter::relations() const
 void OsmConverter::processLinearRing(GeoDataLinearRing *linearRing,
                                      const OsmPlacemarkData& osmData)
 {
-    for (auto const &coordinates: *linearRing) {
-        m_nodes << OsmConverter::Node(coordinates, osmData.nodeReference(coordinates));
+    for (int i = 0; i < linearRing->size(); ++i) {
+        m_nodes << OsmConverter::Node(linearRing->at(i), osmData.nodeReference(i));
     }
     m_ways << OsmConverter::Way(linearRing, osmData);
 }
@@ -109,8 +109,8 @@ void OsmConverter::processPolygon(GeoDataPolygon *polygon,
     // Writing all the outerRing's nodes
     const GeoDataLinearRing &outerRing = polygon->outerBoundary();
     const OsmPlacemarkData outerRingOsmData = osmData.memberReference( index );
-    for (auto const &coordinates: outerRing) {
-        m_nodes << OsmConverter::Node(coordinates, outerRingOsmData.nodeReference(coordinates));
+    for (int i = 0; i < outerRing.size(); ++i) {
+        m_nodes << OsmConverter::Node(outerRing.at(i), outerRingOsmData.nodeReference(i));
     }
     m_ways << OsmConverter::Way(&outerRing, outerRingOsmData);
 
@@ -118,8 +118,8 @@ void OsmConverter::processPolygon(GeoDataPolygon *polygon,
     for (auto const &innerRing: polygon->innerBoundaries() ) {
         ++index;
         const OsmPlacemarkData innerRingOsmData = osmData.memberReference( index );
-        for (auto const &coordinates: innerRing) {
-            m_nodes << OsmConverter::Node(coordinates, innerRingOsmData.nodeReference(coordinates));
+        for (int i = 0; i < innerRing.size(); ++i) {
+            m_nodes << OsmConverter::Node(innerRing.at(i), innerRingOsmData.nodeReference(i));
         }
         m_ways << OsmConverter::Way(&innerRing, innerRingOsmData);
     }
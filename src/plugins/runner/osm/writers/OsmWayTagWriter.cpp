@@ -35,19 +35,16 @@ void OsmWayTagWriter::writeWay( const GeoDataLineString& lineString,
     OsmTagTagWriter::writeTags( osmData, writer );
 
     // Writing all the component nodes ( Nd tags )
-    QVector<GeoDataCoordinates>::const_iterator it =  lineString.constBegin();
-    QVector<GeoDataCoordinates>::ConstIterator const end = lineString.constEnd();
-
-    for ( ; it != end; ++it ) {
-        QString ndId = QString::number( osmData.nodeReference( *it ).id() );
+    for ( int i = 0; i < lineString.size(); ++i ) {
+        QString ndId = QString::number( osmData.nodeReference( i ).id() );
         writer.writeStartElement( osm::osmTag_nd );
         writer.writeAttribute( "ref", ndId );
         writer.writeEndElement();
     }
 
     if (!lineString.isEmpty() && lineString.isClosed()) {
-        auto const startId = osmData.nodeReference(lineString.first()).id();
-        auto const endId = osmData.nodeReference(lineString.last()).id();
+        auto const startId = osmData.nodeReference(0).id();
+        auto const endId = osmData.nodeReference(lineString.size() - 1).id();
         if (startId != endId) {
             writer.writeStartElement( osm::osmTag_nd );
             writer.writeAttribute( "ref", QString::number(startId));
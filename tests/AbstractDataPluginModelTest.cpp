@@ -32,6 +32,7 @@ public:
     {}
 
     void setInitialized( bool initialized ) { m_initialized = initialized; }
+    void emitUpdated() { emit updated(); }
 
     bool initialized() const override { return m_initialized; }
     bool operator<( const AbstractDataPluginItem *other ) const override { return this < other; }
@@ -88,10 +89,14 @@ private Q_SLOTS:
     void itemsVersusInitialized_data();
     void itemsVersusInitialized();
 
+    void itemsVersusLateInitialized();
+
     void itemsVersusAddedAngularResolution();
 
     void itemsVersusSetSticky();
 
+    void itemsVersusCoordinate();
+
  private:
     const MarbleModel m_marbleModel;
     static const ViewportParams fullViewport;
@@ -302,6 +307,22 @@ void AbstractDataPluginModelTest::itemsVersusInitialized()
     QCOMPARE( static_cast<bool>( model.items( &fullViewport, 1 ).contains( item ) ), initialized );
 }
 
+void AbstractDataPluginModelTest::itemsVersusLateInitialized()
+{
+    TestDataPluginItem *item = new TestDataPluginItem;
+    item->setInitialized( false );
+
+    TestDataPluginModel model( &m_marbleModel );
+    model.addItemToList( item );
+
+    QVERIFY( !model.items( &fullViewport, 1 ).contains( item ) );
+
+    // e.g. an image got downloaded, the item does not emit updated() for that
+    item->setInitialized( true );
+
+    QVERIFY( model.items( &fullViewport, 1 ).contains( item ) );
+}
+
 void AbstractDataPluginModelTest::itemsVersusAddedAngularResolution()
 {
     const ViewportParams zoomedViewport( Equirectangular, 0, 0, 10000, QSize( 230, 230 ) );
@@ -341,6 +362,27 @@ void AbstractDataPluginModelTest::itemsVersusSetSticky()
     QVERIFY( !model.items( &fullViewport, 1 ).contains( item ) );
 }
 
+void AbstractDataPluginModelTest::itemsVersusCoordinate()
+{
+    const ViewportParams zoomedViewport( Equirectangular, 0, 0, 10000, QSize( 230, 230 ) );
+
+    TestDataPluginItem *item = new TestDataPluginItem;
+    item->setInitialized( true );
+    item->setCoordinate( GeoDataCoordinates( 90, 45, 0, GeoDataCoordinates::Degree ) );
+
+    TestDataPluginModel model( &m_marbleModel );
+    model.addItemToList( item );
+
+    QVERIFY( !model.items( &zoomedViewport, 1 ).contains( item ) );
+    QVERIFY( model.items( &fullViewport, 1 ).contains( item ) );
+
+    // the model picks up new coordinates once the item got updated
+    item->setCoordinate( GeoDataCoordinates( 0, 0 ) );
+    item->emitUpdated();
+
+    QVERIFY( model.items( &zoomedViewport, 1 ).contains( item ) );
+}
+
 QTEST_MAIN( AbstractDataPluginModelTest )
 
 #include "AbstractDataPluginModelTest.moc"
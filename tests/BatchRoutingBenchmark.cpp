@@ -0,0 +1,144 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "MarbleDebug.h"
+#include "MarbleDirs.h"
+#include "MarbleModel.h"
+#include "RoutingRunnerManager.h"
+#include "GeoDataCoordinates.h"
+#include "GeoDataDocument.h"
+#include "routing/RouteRequest.h"
+#include "routing/RoutingProfile.h"
+
+#include <QTest>
+
+namespace Marble
+{
+
+/**
+ * Measures the throughput of the batch routing API of RoutingRunnerManager.
+ * Routes between random points around Berlin are calculated with the offline
+ * routing plugins; the test is skipped if no offline routing data is installed.
+ */
+class BatchRoutingBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void benchmarkRoutes_data();
+    void benchmarkRoutes();
+
+    void benchmarkMatrix_data();
+    void benchmarkMatrix();
+
+private:
+    static QVector<GeoDataCoordinates> randomCoordinates( int count );
+};
+
+void BatchRoutingBenchmark::initTestCase()
+{
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+    qsrand( 42 );
+}
+
+QVector<GeoDataCoordinates> BatchRoutingBenchmark::randomCoordinates( int count )
+{
+    QVector<GeoDataCoordinates> result;
+    for ( int i = 0; i < count; ++i ) {
+        const qreal lon = 13.3 + 0.2 * qrand() / RAND_MAX;
+        const qreal lat = 52.45 + 0.1 * qrand() / RAND_MAX;
+        result << GeoDataCoordinates( lon, lat, 0.0, GeoDataCoordinates::Degree );
+    }
+
+    return result;
+}
+
+void BatchRoutingBenchmark::benchmarkRoutes_data()
+{
+    QTest::addColumn<int>( "count" );
+
+    QTest::newRow( "100" ) << 100;
+    QTest::newRow( "1000" ) << 1000;
+}
+
+void BatchRoutingBenchmark::benchmarkRoutes()
+{
+    QFETCH( int, count );
+
+    MarbleModel model;
+    model.setWorkOffline( true );
+    RoutingRunnerManager runnerManager( &model );
+
+    const QVector<GeoDataCoordinates> sources = randomCoordinates( count );
+    const QVector<GeoDataCoordinates> destinations = randomCoordinates( count );
+    QVector<RouteRequest*> requests;
+    QVector<const RouteRequest*> batch;
+    for ( int i = 0; i < count; ++i ) {
+        RouteRequest *request = new RouteRequest( this );
+        request->append( sources[i] );
+        request->append( destinations[i] );
+        requests << request;
+        batch << request;
+    }
+
+    QVector<GeoDataDocument*> routes;
+    QBENCHMARK_ONCE {
+        routes = runnerManager.searchRoutes( batch, 600000 );
+    }
+
+    int routed = 0;
+    for ( GeoDataDocument *route: routes ) {
+        routed += route ? 1 : 0;
+    }
+    qDeleteAll( routes );
+    qDeleteAll( requests );
+
+    if ( routed == 0 ) {
+        QSKIP( "No offline routing plugin could calculate routes" );
+    }
+}
+
+void BatchRoutingBenchmark::benchmarkMatrix_data()
+{
+    QTest::addColumn<int>( "size" );
+
+    QTest::newRow( "10x10" ) << 10;
+    QTest::newRow( "30x30" ) << 30;
+}
+
+void BatchRoutingBenchmark::benchmarkMatrix()
+{
+    QFETCH( int, size );
+
+    MarbleModel model;
+    model.setWorkOffline( true );
+    RoutingRunnerManager runnerManager( &model );
+
+    const QVector<GeoDataCoordinates> sources = randomCoordinates( size );
+    const QVector<GeoDataCoordinates> destinations = randomCoordinates( size );
+    QVector<qreal> lengths;
+    QVector<qreal> durations;
+    QBENCHMARK_ONCE {
+        runnerManager.searchRouteMatrix( sources, destinations, RoutingProfile(), lengths, durations, 600000 );
+    }
+
+    QCOMPARE( lengths.size(), size * size );
+    QCOMPARE( durations.size(), size * size );
+    if ( lengths.count( -1 ) == lengths.size() ) {
+        QSKIP( "No offline routing plugin could calculate routes" );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::BatchRoutingBenchmark )
+
+#include "BatchRoutingBenchmark.moc"
@@ -0,0 +1,228 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "ElevationModel.h"
+#include "GeoDataCoordinates.h"
+#include "MarbleDirs.h"
+#include "MarbleGlobal.h"
+#include "MarbleModel.h"
+
+#include <QDir>
+#include <QImage>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+/**
+ * Runs the elevation model on srtm2 tiles of level 9 with known heights,
+ * generated into a local data path of the test.
+ */
+class ElevationModelTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void height_data();
+    void height();
+    void noData();
+    void heights();
+    void heightsManyTiles();
+    void heightProfile();
+
+private:
+    static qreal expectedHeight( qreal lon, qreal lat );
+    static GeoDataCoordinates fixtureCoordinates( int i, int count );
+
+    QTemporaryDir m_localPath;
+};
+
+namespace {
+
+// Layout of srtm2 at level 9
+const int tileSize = 675;
+const qreal pixelsPerDegree = 1024 * tileSize / 360.0;
+
+// The fixture covers 2 x 2 tiles starting at this tile
+const int fixtureX = 550;
+const int fixtureY = 110;
+
+// Pixels without elevation data in the fixture tile at the bottom right
+const QRect noDataPixels( 300, 300, 40, 40 );
+
+}
+
+qreal ElevationModelTest::expectedHeight( qreal lon, qreal lat )
+{
+    // The fixture heights are linear in the pixel position, so bilinear
+    // interpolation reproduces them exactly
+    const qreal x = ( 180 + lon ) * pixelsPerDegree - fixtureX * tileSize;
+    const qreal y = ( 90 - lat ) * pixelsPerDegree - fixtureY * tileSize;
+    return x + 2 * y - 500;
+}
+
+GeoDataCoordinates ElevationModelTest::fixtureCoordinates( int i, int count )
+{
+    // Spread over all fixture tiles, but not into the pixels without data
+    const qreal lon = 13.40 + 0.45 * i / count;
+    const qreal lat = 50.85 + 0.45 * ( ( 37 * i ) % count ) / count;
+    return GeoDataCoordinates( lon, lat, 0, GeoDataCoordinates::Degree );
+}
+
+void ElevationModelTest::initTestCase()
+{
+    QVERIFY( m_localPath.isValid() );
+    QStandardPaths::setTestModeEnabled( true );
+    qputenv( "XDG_DATA_HOME", QFile::encodeName( m_localPath.path() ) );
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+
+    // The height is kept in the lower 16 bits of each pixel
+    for ( int tileY = fixtureY; tileY < fixtureY + 2; ++tileY ) {
+        for ( int tileX = fixtureX; tileX < fixtureX + 2; ++tileX ) {
+            QImage tile( tileSize, tileSize, QImage::Format_RGB32 );
+            for ( int y = 0; y < tileSize; ++y ) {
+                QRgb *line = reinterpret_cast<QRgb *>( tile.scanLine( y ) );
+                for ( int x = 0; x < tileSize; ++x ) {
+                    const int height = ( tileX - fixtureX ) * tileSize + x + 2 * ( ( tileY - fixtureY ) * tileSize + y ) - 500;
+                    line[x] = qRgb( 0, ( height >> 8 ) & 0xff, height & 0xff );
+                }
+            }
+            if ( tileX > fixtureX && tileY > fixtureY ) {
+                for ( int y = noDataPixels.top(); y <= noDataPixels.bottom(); ++y ) {
+                    for ( int x = noDataPixels.left(); x <= noDataPixels.right(); ++x ) {
+                        tile.setPixel( x, y, qRgb( 0, 0x80, 0x00 ) );
+                    }
+                }
+            }
+
+            const QString directory = QString( "%1/maps/earth/srtm2/9/%2" ).arg( MarbleDirs::localPath() )
+                                                                           .arg( tileY, tileDigits, 10, QLatin1Char( '0' ) );
+            QVERIFY( QDir().mkpath( directory ) );
+            QVERIFY( tile.save( QString( "%1/%2_%3.png" ).arg( directory )
+                                .arg( tileY, tileDigits, 10, QLatin1Char( '0' ) )
+                                .arg( tileX, tileDigits, 10, QLatin1Char( '0' ) ) ) );
+        }
+    }
+}
+
+void ElevationModelTest::height_data()
+{
+    QTest::addColumn<qreal>( "lon" );
+    QTest::addColumn<qreal>( "lat" );
+
+    // Negative heights are near the north west corner of the fixture
+    QTest::newRow( "negative" ) << 13.3600 << 51.3280;
+    QTest::newRow( "pixel" ) << 13.3593750 + 100 / pixelsPerDegree << 51.328125 - 200 / pixelsPerDegree;
+    QTest::newRow( "between pixels" ) << 13.5 << 51.1;
+    QTest::newRow( "tile seam" ) << 13.7109375 - 0.4 / pixelsPerDegree << 51.2;
+    QTest::newRow( "tile corner" ) << 13.7109375 - 0.5 / pixelsPerDegree << 50.9765625 + 0.5 / pixelsPerDegree;
+}
+
+void ElevationModelTest::height()
+{
+    QFETCH( qreal, lon );
+    QFETCH( qreal, lat );
+
+    MarbleModel model;
+    model.setWorkOffline( true );
+    const ElevationModel *elevationModel = model.elevationModel();
+    QVERIFY( elevationModel );
+
+    QVERIFY( qAbs( elevationModel->height( lon, lat ) - expectedHeight( lon, lat ) ) < 1e-6 );
+}
+
+void ElevationModelTest::noData()
+{
+    MarbleModel model;
+    model.setWorkOffline( true );
+    const ElevationModel *elevationModel = model.elevationModel();
+
+    const QPointF center = QRectF( noDataPixels ).center();
+    const qreal lon = ( ( fixtureX + 1 ) * tileSize + center.x() ) / pixelsPerDegree - 180;
+    const qreal lat = 90 - ( ( fixtureY + 1 ) * tileSize + center.y() ) / pixelsPerDegree;
+    QCOMPARE( elevationModel->height( lon, lat ), qreal( invalidElevationData ) );
+
+    const QVector<qreal> heights = elevationModel->heights( QVector<GeoDataCoordinates>()
+                                                            << GeoDataCoordinates( lon, lat, 0, GeoDataCoordinates::Degree ) );
+    QCOMPARE( heights.size(), 1 );
+    QCOMPARE( heights.first(), qreal( invalidElevationData ) );
+}
+
+void ElevationModelTest::heights()
+{
+    MarbleModel model;
+    model.setWorkOffline( true );
+    const ElevationModel *elevationModel = model.elevationModel();
+
+    // More points than interpolated in one thread
+    const int count = 10000;
+    QVector<GeoDataCoordinates> coordinates;
+    for ( int i = 0; i < count; ++i ) {
+        coordinates << fixtureCoordinates( i, count );
+    }
+
+    const QVector<qreal> heights = elevationModel->heights( coordinates );
+    QCOMPARE( heights.size(), count );
+    for ( int i = 0; i < count; ++i ) {
+        const qreal lon = coordinates[i].longitude( GeoDataCoordinates::Degree );
+        const qreal lat = coordinates[i].latitude( GeoDataCoordinates::Degree );
+        if ( qAbs( heights[i] - expectedHeight( lon, lat ) ) >= 1e-6 ) {
+            QFAIL( qPrintable( QString( "Height %1 at %2, %3, expected %4" ).arg( heights[i] ).arg( lon ).arg( lat )
+                               .arg( expectedHeight( lon, lat ) ) ) );
+        }
+    }
+}
+
+void ElevationModelTest::heightsManyTiles()
+{
+    MarbleModel model;
+    model.setWorkOffline( true );
+    const ElevationModel *elevationModel = model.elevationModel();
+
+    // Points in more tiles than heights() holds at once, alternating with the
+    // fixture. Tiles outside of the fixture are scaled from lower levels.
+    QVector<GeoDataCoordinates> coordinates;
+    for ( int i = 0; i < 60; ++i ) {
+        coordinates << GeoDataCoordinates( -170.0 + 5.5 * i, -60.0 + 2.0 * i, 0, GeoDataCoordinates::Degree );
+        coordinates << fixtureCoordinates( i, 60 );
+    }
+
+    const QVector<qreal> heights = elevationModel->heights( coordinates );
+    QCOMPARE( heights.size(), coordinates.size() );
+    for ( int i = 0; i < coordinates.size(); ++i ) {
+        const qreal lon = coordinates[i].longitude( GeoDataCoordinates::Degree );
+        const qreal lat = coordinates[i].latitude( GeoDataCoordinates::Degree );
+        QCOMPARE( heights[i], elevationModel->height( lon, lat ) );
+    }
+}
+
+void ElevationModelTest::heightProfile()
+{
+    MarbleModel model;
+    model.setWorkOffline( true );
+    const ElevationModel *elevationModel = model.elevationModel();
+
+    const QVector<GeoDataCoordinates> profile = elevationModel->heightProfile( 13.40, 51.00, 13.45, 51.02 );
+    QVERIFY( profile.size() > 10 );
+    for ( const GeoDataCoordinates &point: profile ) {
+        const qreal lon = point.longitude( GeoDataCoordinates::Degree );
+        const qreal lat = point.latitude( GeoDataCoordinates::Degree );
+        QVERIFY( qAbs( point.altitude() - expectedHeight( lon, lat ) ) < 1e-6 );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::ElevationModelTest )
+
+#include "ElevationModelTest.moc"
@@ -0,0 +1,168 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoDataCoordinates.h"
+#include "GeoDataDocument.h"
+#include "GeoDataDocumentWriter.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataTrack.h"
+#include "KmlElementDictionary.h"
+#include "MarbleZipReader.h"
+
+#include <QBuffer>
+#include <QDateTime>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+/**
+ * Measures writing a day of tracks of a fleet of vehicles to KML and KMZ.
+ * The KMZ file is read back to check the chunked compression of large entries
+ * and the streaming decompression of MarbleZipReader::fileDevice().
+ */
+class KmlWriterBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void writeKml_data();
+    void writeKml();
+    void writeKmz_data();
+    void writeKmz();
+    void readKmz_data();
+    void readKmz();
+
+private:
+    static void addTrackCounts();
+    static GeoDataDocument *createTracks( int trackCount, int pointCount );
+    static QByteArray kmlData( const GeoDataDocument &document );
+};
+
+void KmlWriterBenchmark::addTrackCounts()
+{
+    QTest::addColumn<int>( "trackCount" );
+    QTest::addColumn<int>( "pointCount" );
+
+    // one point every ten seconds over a day
+    QTest::newRow( "10 tracks" ) << 10 << 8640;
+    QTest::newRow( "100 tracks" ) << 100 << 8640;
+}
+
+GeoDataDocument *KmlWriterBenchmark::createTracks( int trackCount, int pointCount )
+{
+    GeoDataDocument *document = new GeoDataDocument;
+    const QDateTime start( QDate( 2017, 6, 1 ), QTime( 0, 0 ), Qt::UTC );
+    for ( int i = 0; i < trackCount; ++i ) {
+        GeoDataTrack *track = new GeoDataTrack;
+        qreal lon = 13.0 + 0.01 * i;
+        qreal lat = 52.3 + 0.005 * i;
+        for ( int j = 0; j < pointCount; ++j ) {
+            lon += 0.0001 * ( ( j * 7 + i ) % 11 - 5 );
+            lat += 0.0001 * ( ( j * 5 + i ) % 9 - 4 );
+            track->addPoint( start.addSecs( 10 * j ),
+                             GeoDataCoordinates( lon, lat, 30.0 + j % 17, GeoDataCoordinates::Degree ) );
+        }
+
+        GeoDataPlacemark *placemark = new GeoDataPlacemark( QString::number( i ) );
+        placemark->setGeometry( track );
+        document->append( placemark );
+    }
+    return document;
+}
+
+QByteArray KmlWriterBenchmark::kmlData( const GeoDataDocument &document )
+{
+    QBuffer buffer;
+    buffer.open( QIODevice::WriteOnly );
+    GeoDataDocumentWriter::write( &buffer, document, kml::kmlTag_nameSpaceOgc22 );
+    return buffer.data();
+}
+
+void KmlWriterBenchmark::writeKml_data()
+{
+    addTrackCounts();
+}
+
+void KmlWriterBenchmark::writeKml()
+{
+    QFETCH( int, trackCount );
+    QFETCH( int, pointCount );
+
+    QScopedPointer<GeoDataDocument> document( createTracks( trackCount, pointCount ) );
+
+    QBENCHMARK {
+        QBuffer buffer;
+        QVERIFY( buffer.open( QIODevice::WriteOnly ) );
+        QVERIFY( GeoDataDocumentWriter::write( &buffer, *document, kml::kmlTag_nameSpaceOgc22 ) );
+    }
+}
+
+void KmlWriterBenchmark::writeKmz_data()
+{
+    addTrackCounts();
+}
+
+void KmlWriterBenchmark::writeKmz()
+{
+    QFETCH( int, trackCount );
+    QFETCH( int, pointCount );
+
+    QScopedPointer<GeoDataDocument> document( createTracks( trackCount, pointCount ) );
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+    const QString kmzFile = directory.path() + QLatin1String( "/tracks.kmz" );
+
+    QBENCHMARK {
+        QVERIFY( GeoDataDocumentWriter::write( kmzFile, *document ) );
+    }
+
+    MarbleZipReader reader( kmzFile );
+    QCOMPARE( reader.fileData( QStringLiteral( "doc.kml" ) ), kmlData( *document ) );
+}
+
+void KmlWriterBenchmark::readKmz_data()
+{
+    addTrackCounts();
+}
+
+void KmlWriterBenchmark::readKmz()
+{
+    QFETCH( int, trackCount );
+    QFETCH( int, pointCount );
+
+    QScopedPointer<GeoDataDocument> document( createTracks( trackCount, pointCount ) );
+    const QByteArray expected = kmlData( *document );
+    QTemporaryDir directory;
+    QVERIFY( directory.isValid() );
+    const QString kmzFile = directory.path() + QLatin1String( "/tracks.kmz" );
+    QVERIFY( GeoDataDocumentWriter::write( kmzFile, *document ) );
+    MarbleZipReader reader( kmzFile );
+
+    // read back in small pieces, as the KML parser does
+    QByteArray streamed;
+    QBENCHMARK {
+        QScopedPointer<QIODevice> entry( reader.fileDevice( QStringLiteral( "doc.kml" ) ) );
+        QVERIFY( entry );
+        streamed.clear();
+        char chunk[16384];
+        qint64 read;
+        while ( ( read = entry->read( chunk, sizeof( chunk ) ) ) > 0 ) {
+            streamed.append( chunk, read );
+        }
+        QVERIFY( entry->atEnd() );
+    }
+    QCOMPARE( streamed, expected );
+}
+
+}
+
+QTEST_MAIN( Marble::KmlWriterBenchmark )
+
+#include "KmlWriterBenchmark.moc"
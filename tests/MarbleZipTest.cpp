@@ -0,0 +1,255 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "MarbleZipReader.h"
+#include "MarbleZipWriter.h"
+
+#include <QBuffer>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QtEndian>
+
+namespace Marble
+{
+
+/**
+ * Checks reading archive entries through MarbleZipReader::fileDevice(), from
+ * memory mapped files as well as in chunks from other archive devices.
+ */
+class MarbleZipTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void storedEntry_data();
+    void storedEntry();
+    void deflatedEntries_data();
+    void deflatedEntries();
+    void missingEntry();
+    void truncatedEntry_data();
+    void truncatedEntry();
+    void corruptEntry_data();
+    void corruptEntry();
+
+private:
+    static void addArchiveTypes();
+    static QByteArray createArchive( MarbleZipWriter::CompressionPolicy policy, const QMap<QString, QByteArray> &entries );
+    static QByteArray readAll( QIODevice *device, int chunkSize );
+    MarbleZipReader *createReader( const QByteArray &archive, bool isFile );
+
+    QTemporaryDir m_directory;
+    QBuffer m_archiveBuffer;
+    QByteArray m_text;
+};
+
+void MarbleZipTest::initTestCase()
+{
+    QVERIFY( m_directory.isValid() );
+
+    // Letters do not compress well, so the deflated entry is read in several chunks
+    quint32 random = 42;
+    m_text.reserve( 300000 );
+    for ( int i = 0; i < 300000; ++i ) {
+        random = random * 1103515245 + 12345;
+        m_text.append( char( 'a' + ( random >> 16 ) % 26 ) );
+    }
+}
+
+void MarbleZipTest::addArchiveTypes()
+{
+    QTest::addColumn<bool>( "isFile" );
+
+    QTest::newRow( "mapped file" ) << true;
+    QTest::newRow( "buffer" ) << false;
+}
+
+QByteArray MarbleZipTest::createArchive( MarbleZipWriter::CompressionPolicy policy, const QMap<QString, QByteArray> &entries )
+{
+    QBuffer buffer;
+    buffer.open( QIODevice::WriteOnly );
+    MarbleZipWriter writer( &buffer );
+    writer.setCompressionPolicy( policy );
+    for ( auto iter = entries.constBegin(), end = entries.constEnd(); iter != end; ++iter ) {
+        writer.addFile( iter.key(), iter.value() );
+    }
+    writer.close();
+    return buffer.data();
+}
+
+QByteArray MarbleZipTest::readAll( QIODevice *device, int chunkSize )
+{
+    QByteArray result;
+    QByteArray chunk( chunkSize, Qt::Uninitialized );
+    qint64 read;
+    while ( ( read = device->read( chunk.data(), chunkSize ) ) > 0 ) {
+        result.append( chunk.constData(), read );
+    }
+    return result;
+}
+
+MarbleZipReader *MarbleZipTest::createReader( const QByteArray &archive, bool isFile )
+{
+    if ( isFile ) {
+        const QString fileName = m_directory.path() + QStringLiteral( "/%1.zip" ).arg( QTest::currentTestFunction() );
+        QFile file( fileName );
+        file.open( QIODevice::WriteOnly | QIODevice::Truncate );
+        file.write( archive );
+        file.close();
+        return new MarbleZipReader( fileName );
+    }
+
+    m_archiveBuffer.close();
+    m_archiveBuffer.setData( archive );
+    m_archiveBuffer.open( QIODevice::ReadOnly );
+    return new MarbleZipReader( &m_archiveBuffer );
+}
+
+void MarbleZipTest::storedEntry_data()
+{
+    addArchiveTypes();
+}
+
+void MarbleZipTest::storedEntry()
+{
+    QFETCH( bool, isFile );
+
+    QMap<QString, QByteArray> entries;
+    entries[QStringLiteral( "doc.kml" )] = m_text;
+    entries[QStringLiteral( "files/icon.png" )] = QByteArray( "not really an image" );
+    QScopedPointer<MarbleZipReader> reader( createReader( createArchive( MarbleZipWriter::NeverCompress, entries ), isFile ) );
+
+    for ( auto iter = entries.constBegin(), end = entries.constEnd(); iter != end; ++iter ) {
+        QScopedPointer<QIODevice> device( reader->fileDevice( iter.key() ) );
+        QVERIFY( device );
+        // Stored entries are served from a buffer holding the entry as it is in the archive
+        QVERIFY( qobject_cast<QBuffer *>( device.data() ) );
+        QCOMPARE( device->size(), qint64( iter.value().size() ) );
+        QCOMPARE( readAll( device.data(), 4096 ), iter.value() );
+    }
+}
+
+void MarbleZipTest::deflatedEntries_data()
+{
+    addArchiveTypes();
+}
+
+void MarbleZipTest::deflatedEntries()
+{
+    QFETCH( bool, isFile );
+
+    QMap<QString, QByteArray> entries;
+    entries[QStringLiteral( "doc.kml" )] = m_text;
+    entries[QStringLiteral( "half.kml" )] = QByteArray( m_text.constData() + m_text.size() / 2, m_text.size() / 2 );
+    QScopedPointer<MarbleZipReader> reader( createReader( createArchive( MarbleZipWriter::AlwaysCompress, entries ), isFile ) );
+
+    QScopedPointer<QIODevice> first( reader->fileDevice( QStringLiteral( "doc.kml" ) ) );
+    QScopedPointer<QIODevice> second( reader->fileDevice( QStringLiteral( "half.kml" ) ) );
+    QVERIFY( first );
+    QVERIFY( second );
+    QVERIFY( first->isSequential() );
+
+    // Both entries share the archive device, each chunk has to be read from its own offset
+    QByteArray firstData;
+    QByteArray secondData;
+    char chunk[1000];
+    qint64 read;
+    do {
+        read = first->read( chunk, sizeof( chunk ) );
+        if ( read > 0 ) {
+            firstData.append( chunk, read );
+        }
+        const qint64 secondRead = second->read( chunk, sizeof( chunk ) );
+        if ( secondRead > 0 ) {
+            secondData.append( chunk, secondRead );
+        }
+        read = qMax( read, secondRead );
+    } while ( read > 0 );
+
+    QVERIFY( first->atEnd() );
+    QVERIFY( second->atEnd() );
+    QCOMPARE( firstData, entries[QStringLiteral( "doc.kml" )] );
+    QCOMPARE( secondData, entries[QStringLiteral( "half.kml" )] );
+    QCOMPARE( reader->fileData( QStringLiteral( "doc.kml" ) ), firstData );
+}
+
+void MarbleZipTest::missingEntry()
+{
+    QMap<QString, QByteArray> entries;
+    entries[QStringLiteral( "doc.kml" )] = QByteArray( "<kml/>" );
+    QScopedPointer<MarbleZipReader> reader( createReader( createArchive( MarbleZipWriter::AlwaysCompress, entries ), false ) );
+
+    QVERIFY( !reader->fileDevice( QStringLiteral( "missing.kml" ) ) );
+}
+
+void MarbleZipTest::truncatedEntry_data()
+{
+    addArchiveTypes();
+}
+
+void MarbleZipTest::truncatedEntry()
+{
+    QFETCH( bool, isFile );
+
+    QMap<QString, QByteArray> entries;
+    entries[QStringLiteral( "doc.kml" )] = m_text;
+    QByteArray archive = createArchive( MarbleZipWriter::AlwaysCompress, entries );
+
+    // Claim only half of the compressed data in the central directory
+    const int central = archive.lastIndexOf( QByteArray( "PK\x01\x02", 4 ) );
+    QVERIFY( central > 0 );
+    uchar *compressedSize = reinterpret_cast<uchar *>( archive.data() ) + central + 20;
+    qToLittleEndian<quint32>( qFromLittleEndian<quint32>( compressedSize ) / 2, compressedSize );
+
+    QScopedPointer<MarbleZipReader> reader( createReader( archive, isFile ) );
+    QScopedPointer<QIODevice> device( reader->fileDevice( QStringLiteral( "doc.kml" ) ) );
+    QVERIFY( device );
+
+    QTest::ignoreMessage( QtWarningMsg, "QZip: \"Unexpected end of compressed data\"" );
+    const QByteArray data = readAll( device.data(), 4096 );
+    QVERIFY( data.size() < m_text.size() );
+    QVERIFY( m_text.startsWith( data ) );
+    char byte;
+    QCOMPARE( device->read( &byte, 1 ), qint64( -1 ) );
+    QCOMPARE( device->errorString(), QStringLiteral( "Unexpected end of compressed data" ) );
+}
+
+void MarbleZipTest::corruptEntry_data()
+{
+    addArchiveTypes();
+}
+
+void MarbleZipTest::corruptEntry()
+{
+    QFETCH( bool, isFile );
+
+    QMap<QString, QByteArray> entries;
+    entries[QStringLiteral( "doc.kml" )] = m_text;
+    QByteArray archive = createArchive( MarbleZipWriter::AlwaysCompress, entries );
+
+    // The first deflate block header gets the reserved block type
+    const uchar *localHeader = reinterpret_cast<const uchar *>( archive.constData() );
+    QCOMPARE( qFromLittleEndian<quint32>( localHeader ), quint32( 0x04034b50 ) );
+    const int dataOffset = 30 + qFromLittleEndian<quint16>( localHeader + 26 ) + qFromLittleEndian<quint16>( localHeader + 28 );
+    archive[dataOffset] = char( 0xff );
+
+    QScopedPointer<MarbleZipReader> reader( createReader( archive, isFile ) );
+    QScopedPointer<QIODevice> device( reader->fileDevice( QStringLiteral( "doc.kml" ) ) );
+    QVERIFY( device );
+
+    QTest::ignoreMessage( QtWarningMsg, "QZip: \"Compressed data is corrupted\"" );
+    char chunk[4096];
+    QCOMPARE( device->read( chunk, sizeof( chunk ) ), qint64( -1 ) );
+    QCOMPARE( device->errorString(), QStringLiteral( "Compressed data is corrupted" ) );
+}
+
+}
+
+QTEST_MAIN( Marble::MarbleZipTest )
+
+#include "MarbleZipTest.moc"
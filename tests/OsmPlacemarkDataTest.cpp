@@ -0,0 +1,111 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "osm/OsmPlacemarkData.h"
+
+#include <QTest>
+
+namespace Marble
+{
+
+class OsmPlacemarkDataTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void tags();
+    void nodeReferences();
+
+private:
+    static OsmPlacemarkData node( qint64 id );
+    static int nodeReferenceCount( const OsmPlacemarkData &data );
+};
+
+OsmPlacemarkData OsmPlacemarkDataTest::node( qint64 id )
+{
+    OsmPlacemarkData result;
+    result.setId( id );
+    return result;
+}
+
+int OsmPlacemarkDataTest::nodeReferenceCount( const OsmPlacemarkData &data )
+{
+    int count = 0;
+    for ( auto iter = data.nodeReferencesBegin(); iter != data.nodeReferencesEnd(); ++iter ) {
+        ++count;
+    }
+    return count;
+}
+
+void OsmPlacemarkDataTest::tags()
+{
+    OsmPlacemarkData data;
+    data.addTag( QStringLiteral( "name" ), QStringLiteral( "Unter den Linden" ) );
+    data.addTag( QStringLiteral( "highway" ), QStringLiteral( "primary" ) );
+    data.addTag( QStringLiteral( "highway" ), QStringLiteral( "secondary" ) );
+
+    QCOMPARE( data.tagValue( QStringLiteral( "highway" ) ), QStringLiteral( "secondary" ) );
+    QVERIFY( data.containsTag( QStringLiteral( "name" ), QStringLiteral( "Unter den Linden" ) ) );
+    QCOMPARE( data.tagsBegin().key(), QStringLiteral( "highway" ) );
+
+    data.removeTag( QStringLiteral( "highway" ) );
+    QVERIFY( !data.containsTagKey( QStringLiteral( "highway" ) ) );
+    QVERIFY( data.findTag( QStringLiteral( "highway" ) ) == data.tagsEnd() );
+}
+
+void OsmPlacemarkDataTest::nodeReferences()
+{
+    const int size = 10;
+
+    OsmPlacemarkData data;
+    // reads must not expand the references
+    const OsmPlacemarkData &constData = data;
+    for ( int i = 0; i < size; ++i ) {
+        data.addNodeReference( i, node( i + 1 ) );
+    }
+    QCOMPARE( nodeReferenceCount( data ), size );
+
+    // a reference of an existing vertex replaces its data
+    data.addNodeReference( size / 2, node( 1000 ) );
+    QCOMPARE( nodeReferenceCount( data ), size );
+    QCOMPARE( constData.nodeReference( size / 2 ).id(), qint64( 1000 ) );
+
+    // the references of the following vertices move along with removed vertices
+    data.removeNodeReference( 1 );
+    QCOMPARE( nodeReferenceCount( data ), size - 1 );
+    QCOMPARE( constData.nodeReference( 1 ).id(), qint64( 3 ) );
+    QCOMPARE( constData.nodeReference( size / 2 - 1 ).id(), qint64( 1000 ) );
+    QVERIFY( !data.containsNodeReference( size - 1 ) );
+    QVERIFY( constData.nodeReference( size - 1 ).isNull() );
+
+    // ... and with inserted ones
+    data.insertNodeReference( 1 );
+    QCOMPARE( nodeReferenceCount( data ), size );
+    QVERIFY( constData.nodeReference( 1 ).isNull() );
+    QCOMPARE( constData.nodeReference( 2 ).id(), qint64( 3 ) );
+
+    // inserting behind the known references only expands them if there is data
+    data.insertNodeReference( size + 1 );
+    QCOMPARE( nodeReferenceCount( data ), size );
+
+    // the editor expands the references on demand
+    data.nodeReference( size + 1 ).setId( 2000 );
+    QCOMPARE( nodeReferenceCount( data ), size + 2 );
+    QVERIFY( constData.nodeReference( size ).isNull() );
+    QCOMPARE( constData.nodeReference( size + 1 ).id(), qint64( 2000 ) );
+
+    int index = 0;
+    for ( auto iter = data.nodeReferencesBegin(); iter != data.nodeReferencesEnd(); ++iter, ++index ) {
+        QCOMPARE( iter.key(), index );
+        QCOMPARE( iter.value().id(), constData.nodeReference( index ).id() );
+    }
+}
+
+QTEST_MAIN( Marble::OsmPlacemarkDataTest )
+
+#include "OsmPlacemarkDataTest.moc"
@@ -10,8 +10,14 @@
 
 
 #include "MarbleDirs.h"
+#include "MarbleTrace.h"
 #include "PluginManager.h"
 
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
 #include <QTest>
 
 namespace Marble
@@ -21,9 +27,37 @@ class PluginManagerTest : public QObject
 {
     Q_OBJECT
     private Q_SLOTS:
+        void initTestCase();
         void loadPlugins();
+        void loadPluginsFromIndex();
+
+    private:
+        static int loadedLibraries();
+
+        QTemporaryDir m_localPath;
 };
 
+void PluginManagerTest::initTestCase()
+{
+    // Keep the plugin index out of the user's Marble directory
+    QVERIFY( m_localPath.isValid() );
+    MarbleDirs::setMarbleLocalPath( m_localPath.path() );
+}
+
+int PluginManagerTest::loadedLibraries()
+{
+    // Each plugin library loaded is recorded as a trace event
+    const QJsonArray events = QJsonDocument::fromJson( MarbleTrace::chromeTrace() ).object().value( QStringLiteral( "traceEvents" ) ).toArray();
+    int result = 0;
+    for ( const QJsonValue &event: events ) {
+        if ( event.toObject().value( QStringLiteral( "cat" ) ).toString() == QLatin1String( "plugin" ) ) {
+            ++result;
+        }
+    }
+    MarbleTrace::clear();
+    return result;
+}
+
 void PluginManagerTest::loadPlugins()
 {
     MarbleDirs::setMarbleDataPath( DATA_PATH );
@@ -44,6 +78,44 @@ void PluginManagerTest::loadPlugins()
     QCOMPARE( renderPlugins + positionPlugins + runnerPlugins, pluginNumber );
 }
 
+void PluginManagerTest::loadPluginsFromIndex()
+{
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+
+    // Start without the index written by loadPlugins()
+    QTemporaryDir localPath;
+    QVERIFY( localPath.isValid() );
+    MarbleDirs::setMarbleLocalPath( localPath.path() );
+    MarbleTrace::setEnabled( true );
+    MarbleTrace::clear();
+
+    // Without an index all libraries are loaded to find the parsing runners
+    PluginManager first;
+    const int parsingRunnerPlugins = first.parsingRunnerPlugins().size();
+    const int allLibraries = loadedLibraries();
+    const int renderPlugins = first.renderPlugins().size();
+    const int searchRunnerPlugins = first.searchRunnerPlugins().size();
+    QCOMPARE( loadedLibraries(), 0 );
+    QVERIFY( QFile::exists( localPath.path() + QLatin1String( "/cache/plugins.index" ) ) );
+
+    // The second manager only loads the libraries the index lists for each kind of plugin
+    PluginManager second;
+    QCOMPARE( second.parsingRunnerPlugins().size(), parsingRunnerPlugins );
+    const int parsingLibraries = loadedLibraries();
+    QVERIFY( parsingLibraries <= parsingRunnerPlugins );
+    if ( renderPlugins > 0 ) {
+        // Libraries of render plugins provide no parsing runners
+        QVERIFY( parsingLibraries < allLibraries );
+    }
+
+    QCOMPARE( second.renderPlugins().size(), renderPlugins );
+    QCOMPARE( second.searchRunnerPlugins().size(), searchRunnerPlugins );
+
+    MarbleTrace::setEnabled( false );
+    MarbleDirs::setMarbleLocalPath( m_localPath.path() );
+}
+
 }
 
 QTEST_MAIN( Marble::PluginManagerTest )
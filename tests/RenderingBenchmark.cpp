@@ -0,0 +1,456 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoDataCoordinates.h"
+#include "GeoPainter.h"
+#include "LayerInterface.h"
+#include "MarbleDirs.h"
+#include "MarbleGlobal.h"
+#include "MarbleMap.h"
+#include "MarbleModel.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QPair>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QThreadPool>
+#include <QtMath>
+
+#include <algorithm>
+
+namespace Marble
+{
+
+/**
+ * Records when the layers of each render position start painting. The marker
+ * has the lowest z value in every render position, so the time between two
+ * marks is the time spent in the layers of one render position.
+ */
+class RenderPositionMarker : public LayerInterface
+{
+public:
+    QStringList renderPosition() const override
+    {
+        return QStringList() << QStringLiteral("STARS") << QStringLiteral("BEHIND_TARGET")
+                             << QStringLiteral("SURFACE") << QStringLiteral("HOVERS_ABOVE_SURFACE")
+                             << QStringLiteral("GRATICULE") << QStringLiteral("PLACEMARKS")
+                             << QStringLiteral("ATMOSPHERE") << QStringLiteral("ORBIT")
+                             << QStringLiteral("ALWAYS_ON_TOP") << QStringLiteral("FLOAT_ITEM")
+                             << QStringLiteral("USER_TOOLS");
+    }
+
+    bool render( GeoPainter *, ViewportParams *, const QString &renderPos, GeoSceneLayer * ) override
+    {
+        m_marks.append( qMakePair( renderPos, m_timer.nsecsElapsed() ) );
+        return true;
+    }
+
+    qreal zValue() const override { return -1.0e9; }
+
+    QString runtimeTrace() const override { return QStringLiteral( "RenderPositionMarker" ); }
+
+    void startFrame()
+    {
+        m_marks.clear();
+        m_timer.start();
+    }
+
+    /**
+     * Ends the current frame and appends the milliseconds spent in each render position
+     * to @p times. Returns the duration of the whole frame in milliseconds.
+     */
+    qreal finishFrame( QHash<QString, QVector<qreal> > &times ) const
+    {
+        const qint64 end = m_timer.nsecsElapsed();
+        for ( int i = 0; i < m_marks.size(); ++i ) {
+            const qint64 next = i + 1 < m_marks.size() ? m_marks[i+1].second : end;
+            times[m_marks[i].first] << ( next - m_marks[i].second ) / 1.0e6;
+        }
+        return end / 1.0e6;
+    }
+
+private:
+    QElapsedTimer m_timer;
+    QVector<QPair<QString, qint64> > m_marks;
+};
+
+/**
+ * Replays scripted camera paths over the test map themes in tests/data/maps in
+ * all projections and measures frame times, the time spent in each render position
+ * and in each layer, the time until all data of a view is loaded and the memory in use. Rendering
+ * happens offscreen into a QImage and the model works offline, so only local
+ * data is used. The texture tiles and vector data of the themes are generated
+ * on startup.
+ *
+ * By default only a short smoke run of one theme and projection is done. Set the
+ * environment variable MARBLE_BENCHMARK_FULL to run all themes, projections and
+ * frames. Set MARBLE_BENCHMARK_JSON to the name of a file to write all results
+ * to as JSON, e.g. for comparing runs of different versions.
+ */
+class RenderingBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkCameraPaths_data();
+    void benchmarkCameraPaths();
+
+private:
+    enum CameraPath {
+        Pan,
+        Zoom,
+        FlyTo,
+        Rotate
+    };
+
+    void setCamera( MarbleMap &map, CameraPath path, int frame ) const;
+    qint64 waitForData( MarbleMap &map, QImage &image ) const;
+    static QJsonObject statistics( QVector<qreal> values );
+    static qint64 memoryUsage( const QString &field );
+    static bool installMapTheme( const QString &theme );
+    static bool createTextureTiles( const QString &directory, int maximumTileLevel );
+    static bool createLandPolygons( const QString &fileName );
+
+    QTemporaryDir m_localPath;
+    bool m_fullRun;
+    int m_frameCount;
+    int m_dataTimeout;
+    QJsonArray m_results;
+};
+
+namespace {
+
+const QSize imageSize( 512, 384 );
+
+}
+
+void RenderingBenchmark::initTestCase()
+{
+    m_fullRun = !qgetenv( "MARBLE_BENCHMARK_FULL" ).isEmpty();
+    m_frameCount = m_fullRun ? 24 : 4;
+    m_dataTimeout = m_fullRun ? 10000 : 2000;
+
+    // Install the test themes into a local data path of our own, everything
+    // else is found in the system data path
+    QVERIFY( m_localPath.isValid() );
+    QStandardPaths::setTestModeEnabled( true );
+    qputenv( "XDG_DATA_HOME", QFile::encodeName( m_localPath.path() ) );
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+
+    const QString mapsPath = MarbleDirs::localPath() + QLatin1String( "/maps/earth/" );
+    QVERIFY( installMapTheme( QStringLiteral( "benchmark-vector" ) ) );
+    QVERIFY( installMapTheme( QStringLiteral( "benchmark-texture" ) ) );
+    QVERIFY( createLandPolygons( mapsPath + QLatin1String( "benchmark-vector/land.kml" ) ) );
+    QVERIFY( createTextureTiles( mapsPath + QLatin1String( "benchmark-texture" ), 3 ) );
+}
+
+bool RenderingBenchmark::installMapTheme( const QString &theme )
+{
+    const QString source = QLatin1String( TESTSRCDIR "/data/maps/earth/" ) + theme + QLatin1Char( '/' ) + theme + QLatin1String( ".dgml" );
+    const QString directory = MarbleDirs::localPath() + QLatin1String( "/maps/earth/" ) + theme;
+    return QDir().mkpath( directory ) && QFile::copy( source, directory + QLatin1Char( '/' ) + theme + QLatin1String( ".dgml" ) );
+}
+
+bool RenderingBenchmark::createTextureTiles( const QString &directory, int maximumTileLevel )
+{
+    // Tiles in the Marble storage layout with two columns and one row at level zero
+    for ( int level = 0; level <= maximumTileLevel; ++level ) {
+        const int rows = 1 << level;
+        for ( int y = 0; y < rows; ++y ) {
+            const QString rowPath = QString( "%1/%2/%3" ).arg( directory ).arg( level ).arg( y, tileDigits, 10, QLatin1Char( '0' ) );
+            if ( !QDir().mkpath( rowPath ) ) {
+                return false;
+            }
+            for ( int x = 0; x < 2 * rows; ++x ) {
+                QImage tile( 256, 256, QImage::Format_RGB32 );
+                tile.fill( QColor::fromHsv( 360 * x / ( 2 * rows ), 128, 64 + 128 * y / rows ) );
+                QPainter painter( &tile );
+                painter.setPen( Qt::white );
+                painter.drawRect( 0, 0, 255, 255 );
+                painter.drawLine( 0, 0, 255, 255 );
+                painter.end();
+                const QString fileName = QString( "%1/%2_%3.png" ).arg( rowPath ).arg( y, tileDigits, 10, QLatin1Char( '0' ) )
+                                                                   .arg( x, tileDigits, 10, QLatin1Char( '0' ) );
+                if ( !tile.save( fileName ) ) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool RenderingBenchmark::createLandPolygons( const QString &fileName )
+{
+    QFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) ) {
+        return false;
+    }
+
+    // One irregular polygon with 120 nodes in each cell of a 10 degree grid
+    file.write( "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                "<kml xmlns=\"http://www.opengis.net/kml/2.2\"><Document>\n" );
+    for ( int lat = -80; lat < 80; lat += 10 ) {
+        for ( int lon = -180; lon < 180; lon += 10 ) {
+            QByteArray coordinates;
+            const int nodes = 120;
+            for ( int i = 0; i <= nodes; ++i ) {
+                const qreal angle = 2 * M_PI * ( i % nodes ) / nodes;
+                const qreal radius = 3.5 + qSin( 7 * angle + lon ) + 0.5 * qCos( 13 * angle + lat );
+                coordinates += QByteArray::number( lon + 5 + radius * qCos( angle ), 'f', 5 ) + ','
+                             + QByteArray::number( lat + 5 + radius * qSin( angle ), 'f', 5 ) + ' ';
+            }
+            file.write( "<Placemark><Polygon><outerBoundaryIs><LinearRing><coordinates>" );
+            file.write( coordinates );
+            file.write( "</coordinates></LinearRing></outerBoundaryIs></Polygon></Placemark>\n" );
+        }
+    }
+    file.write( "</Document></kml>\n" );
+    return file.error() == QFile::NoError;
+}
+
+void RenderingBenchmark::cleanupTestCase()
+{
+    const QString fileName = QString::fromLocal8Bit( qgetenv( "MARBLE_BENCHMARK_JSON" ) );
+    if ( fileName.isEmpty() ) {
+        return;
+    }
+
+    QJsonObject report;
+    report.insert( QStringLiteral( "benchmark" ), QStringLiteral( "RenderingBenchmark" ) );
+    report.insert( QStringLiteral( "width" ), imageSize.width() );
+    report.insert( QStringLiteral( "height" ), imageSize.height() );
+    report.insert( QStringLiteral( "framesPerPath" ), m_frameCount );
+    report.insert( QStringLiteral( "peakMemory" ), memoryUsage( QStringLiteral( "VmHWM" ) ) );
+    report.insert( QStringLiteral( "results" ), m_results );
+
+    QFile file( fileName );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    file.write( QJsonDocument( report ).toJson() );
+    qDebug() << "Results written to" << fileName;
+}
+
+void RenderingBenchmark::setCamera( MarbleMap &map, CameraPath path, int frame ) const
+{
+    const qreal t = frame / qreal( m_frameCount - 1 );
+    switch ( path ) {
+    case Pan:
+        map.setRadius( 800 );
+        map.setHeading( 0 );
+        map.centerOn( -10.0 + 60.0 * t, 50.0 );
+        break;
+    case Zoom:
+        // Zoom in and out again, exponentially like the mouse wheel does
+        map.setHeading( 0 );
+        map.centerOn( 13.4, 52.5 );
+        map.setRadius( qRound( 250 * qPow( 16.0, 1.0 - qAbs( 2.0 * t - 1.0 ) ) ) );
+        break;
+    case FlyTo: {
+        // Zoom out on the way and in again at the destination like MarbleWidget::flyTo()
+        const GeoDataCoordinates source( 13.4, 52.5, 0.0, GeoDataCoordinates::Degree );
+        const GeoDataCoordinates destination( 151.2, -33.9, 0.0, GeoDataCoordinates::Degree );
+        const GeoDataCoordinates position = source.interpolate( destination, t );
+        map.setHeading( 0 );
+        map.setRadius( qRound( 2000 * ( 1.0 - 0.85 * qSin( M_PI * t ) ) ) );
+        map.centerOn( position.longitude( GeoDataCoordinates::Degree ), position.latitude( GeoDataCoordinates::Degree ) );
+        break;
+    }
+    case Rotate:
+        map.setRadius( 1200 );
+        map.centerOn( 13.4, 52.5 );
+        map.setHeading( 360.0 * frame / m_frameCount );
+        break;
+    }
+}
+
+qint64 RenderingBenchmark::waitForData( MarbleMap &map, QImage &image ) const
+{
+    QElapsedTimer timer;
+    timer.start();
+    while ( true ) {
+        {
+            GeoPainter painter( &image, map.viewport(), map.mapQuality() );
+            map.paint( painter, QRect() );
+        }
+        const RenderStatus status = map.renderStatus();
+        if ( status == Complete || status == Incomplete || timer.elapsed() > m_dataTimeout ) {
+            break;
+        }
+        QTest::qWait( 10 );
+    }
+    return timer.elapsed();
+}
+
+QJsonObject RenderingBenchmark::statistics( QVector<qreal> values )
+{
+    QJsonObject result;
+    if ( values.isEmpty() ) {
+        return result;
+    }
+
+    std::sort( values.begin(), values.end() );
+    const auto percentile = [&values] ( qreal p ) {
+        return values[qMin( values.size() - 1, qMax( 0, qCeil( p * values.size() ) - 1 ) )];
+    };
+
+    qreal sum = 0.0;
+    for ( const qreal value: values ) {
+        sum += value;
+    }
+
+    result.insert( QStringLiteral( "min" ), values.first() );
+    result.insert( QStringLiteral( "mean" ), sum / values.size() );
+    result.insert( QStringLiteral( "p50" ), percentile( 0.50 ) );
+    result.insert( QStringLiteral( "p90" ), percentile( 0.90 ) );
+    result.insert( QStringLiteral( "p99" ), percentile( 0.99 ) );
+    result.insert( QStringLiteral( "max" ), values.last() );
+    return result;
+}
+
+qint64 RenderingBenchmark::memoryUsage( const QString &field )
+{
+    // Only available on Linux, in kB
+    QFile status( QStringLiteral( "/proc/self/status" ) );
+    if ( !status.open( QIODevice::ReadOnly ) ) {
+        return -1;
+    }
+
+    const QByteArray prefix = field.toLatin1() + ':';
+    for ( const QByteArray &line: status.readAll().split( '\n' ) ) {
+        if ( line.startsWith( prefix ) ) {
+            return line.mid( prefix.size() ).trimmed().split( ' ' ).first().toLongLong();
+        }
+    }
+    return -1;
+}
+
+void RenderingBenchmark::benchmarkCameraPaths_data()
+{
+    QTest::addColumn<QString>( "mapThemeId" );
+    QTest::addColumn<int>( "projection" );
+
+    const QStringList mapThemeIds = QStringList()
+            << QStringLiteral( "earth/benchmark-vector/benchmark-vector.dgml" )
+            << QStringLiteral( "earth/benchmark-texture/benchmark-texture.dgml" );
+
+    const QStringList projections = QStringList()
+            << QStringLiteral( "Spherical" ) << QStringLiteral( "Equirectangular" )
+            << QStringLiteral( "Mercator" ) << QStringLiteral( "Gnomonic" )
+            << QStringLiteral( "Stereographic" ) << QStringLiteral( "LambertAzimuthal" )
+            << QStringLiteral( "AzimuthalEquidistant" ) << QStringLiteral( "VerticalPerspective" );
+
+    if ( !m_fullRun ) {
+        QTest::newRow( "benchmark-vector/Spherical" ) << mapThemeIds.first() << int( Spherical );
+        return;
+    }
+
+    for ( const QString &mapThemeId: mapThemeIds ) {
+        for ( int projection = Spherical; projection <= VerticalPerspective; ++projection ) {
+            const QString name = mapThemeId.section( QLatin1Char( '/' ), 1, 1 ) + QLatin1Char( '/' ) + projections[projection];
+            QTest::newRow( name.toLatin1().constData() ) << mapThemeId << projection;
+        }
+    }
+}
+
+void RenderingBenchmark::benchmarkCameraPaths()
+{
+    QFETCH( QString, mapThemeId );
+    QFETCH( int, projection );
+
+    const QStringList pathNames = QStringList() << QStringLiteral( "pan" ) << QStringLiteral( "zoom" )
+                                                << QStringLiteral( "flyTo" ) << QStringLiteral( "rotate" );
+
+    MarbleModel model;
+    model.setWorkOffline( true );
+    MarbleMap map( &model );
+    map.setMapThemeId( mapThemeId );
+    QCOMPARE( map.mapThemeId(), mapThemeId );
+    map.setProjection( Projection( projection ) );
+    map.setSize( imageSize );
+
+    RenderPositionMarker marker;
+    map.addLayer( &marker );
+
+    QImage image( imageSize, QImage::Format_ARGB32_Premultiplied );
+
+    for ( int path = Pan; path <= Rotate; ++path ) {
+        map.setViewContext( Still );
+        setCamera( map, CameraPath( path ), 0 );
+        const qint64 dataLatency = waitForData( map, image );
+
+        map.setViewContext( Animation );
+        QVector<qreal> frameTimes;
+        QHash<QString, QVector<qreal> > positionTimes;
+        QHash<QString, QVector<qreal> > layerTimes;
+        for ( int frame = 0; frame < m_frameCount; ++frame ) {
+            setCamera( map, CameraPath( path ), frame );
+            image.fill( Qt::transparent );
+            GeoPainter painter( &image, map.viewport(), map.mapQuality() );
+            marker.startFrame();
+            map.paint( painter, QRect() );
+            frameTimes << marker.finishFrame( positionTimes );
+            for ( const LayerStatistics &layer: map.frameStatistics().layers ) {
+                if ( layer.name != marker.runtimeTrace() ) {
+                    layerTimes[layer.name] << layer.renderTime;
+                }
+            }
+            QCoreApplication::processEvents();
+        }
+
+        map.setViewContext( Still );
+        const qint64 settleTime = waitForData( map, image );
+
+        QJsonObject renderPositions;
+        for ( auto iter = positionTimes.constBegin(), end = positionTimes.constEnd(); iter != end; ++iter ) {
+            renderPositions.insert( iter.key(), statistics( iter.value() ) );
+        }
+        QJsonObject layers;
+        for ( auto iter = layerTimes.constBegin(), end = layerTimes.constEnd(); iter != end; ++iter ) {
+            layers.insert( iter.key(), statistics( iter.value() ) );
+        }
+
+        const QJsonObject frameStatistics = statistics( frameTimes );
+        QJsonObject result;
+        result.insert( QStringLiteral( "mapThemeId" ), mapThemeId );
+        result.insert( QStringLiteral( "projection" ), QString::fromLatin1( QTest::currentDataTag() ).section( QLatin1Char( '/' ), 1 ) );
+        result.insert( QStringLiteral( "path" ), pathNames[path] );
+        result.insert( QStringLiteral( "frameTime" ), frameStatistics );
+        result.insert( QStringLiteral( "renderPositions" ), renderPositions );
+        result.insert( QStringLiteral( "layers" ), layers );
+        result.insert( QStringLiteral( "dataLatency" ), dataLatency );
+        result.insert( QStringLiteral( "settleTime" ), settleTime );
+        result.insert( QStringLiteral( "memory" ), memoryUsage( QStringLiteral( "VmRSS" ) ) );
+        m_results.append( result );
+
+        qDebug() << QTest::currentDataTag() << pathNames[path] << "frame time p50"
+                 << frameStatistics.value( QStringLiteral( "p50" ) ).toDouble() << "ms, p90"
+                 << frameStatistics.value( QStringLiteral( "p90" ) ).toDouble() << "ms, data loaded after"
+                 << dataLatency << "ms";
+    }
+
+    map.removeLayer( &marker );
+    QThreadPool::globalInstance()->waitForDone();
+}
+
+}
+
+QTEST_MAIN( Marble::RenderingBenchmark )
+
+#include "RenderingBenchmark.moc"
@@ -0,0 +1,235 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "routing/Route.h"
+#include "routing/RouteRequest.h"
+#include "routing/RouteSegmentIndex.h"
+#include "routing/RoutingModel.h"
+#include "GeoDataLineString.h"
+#include "GeoDataTreeModel.h"
+#include "PositionTracking.h"
+
+#include <QTest>
+
+namespace Marble
+{
+
+class RouteSegmentIndexTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void emptyIndex();
+    void closestEdge();
+    void preferHint();
+    void routePosition();
+    void closestPoint();
+    void antimeridian();
+    void rightNeighbor();
+
+private:
+    static GeoDataLineString line( qreal lon1, qreal lat1, qreal lon2, qreal lat2, int points );
+    static Route zigzagRoute();
+};
+
+Route RouteSegmentIndexTest::zigzagRoute()
+{
+    Route route;
+    for ( int i = 0; i < 6; ++i ) {
+        RouteSegment segment;
+        segment.setPath( line( 13.0 + 0.1 * i, 52.0 + 0.05 * ( i % 2 ), 13.1 + 0.1 * i, 52.0 + 0.05 * ( ( i + 1 ) % 2 ), 17 ) );
+        route.addRouteSegment( segment );
+    }
+    return route;
+}
+
+GeoDataLineString RouteSegmentIndexTest::line( qreal lon1, qreal lat1, qreal lon2, qreal lat2, int points )
+{
+    GeoDataLineString result;
+    for ( int i = 0; i < points; ++i ) {
+        qreal const t = qreal( i ) / ( points - 1 );
+        result << GeoDataCoordinates( lon1 + t * ( lon2 - lon1 ), lat1 + t * ( lat2 - lat1 ),
+                                      0.0, GeoDataCoordinates::Degree );
+    }
+
+    return result;
+}
+
+void RouteSegmentIndexTest::emptyIndex()
+{
+    const RouteSegmentIndex index;
+    RouteSegmentIndex::Match match;
+
+    QVERIFY( index.isEmpty() );
+    QVERIFY( !index.closestEdge( GeoDataCoordinates( 0.1, 0.1 ), -1, match ) );
+    QCOMPARE( match.edge, -1 );
+}
+
+void RouteSegmentIndexTest::closestEdge()
+{
+    RouteSegmentIndex index;
+    const GeoDataLineString first = line( 13.0, 52.0, 13.5, 52.0, 501 );
+    const GeoDataLineString second = line( 13.5, 52.0, 13.5, 52.5, 501 );
+    index.addSegment( 0, 0, first );
+    index.addSegment( 1, first.size(), second );
+    QCOMPARE( index.size(), 1000 );
+
+    RouteSegmentIndex::Match match;
+    const GeoDataCoordinates nearFirst( 13.2004, 52.0002, 0.0, GeoDataCoordinates::Degree );
+    QVERIFY( index.closestEdge( nearFirst, -1, match ) );
+    QCOMPARE( match.segment, 0 );
+    QCOMPARE( match.pathIndex, 201 );
+    QVERIFY( match.distance < 25.0 );
+    QVERIFY( qAbs( match.interpolated.latitude( GeoDataCoordinates::Degree ) - 52.0 ) < 1e-9 );
+
+    // far away from the route, only found by extending the ring search
+    const GeoDataCoordinates farAway( 13.51, 53.0, 0.0, GeoDataCoordinates::Degree );
+    QVERIFY( index.closestEdge( farAway, -1, match ) );
+    QCOMPARE( match.segment, 1 );
+    QCOMPARE( match.pathIndex, first.size() + 500 );
+}
+
+void RouteSegmentIndexTest::preferHint()
+{
+    // a route going back and forth on the same road
+    RouteSegmentIndex index;
+    const GeoDataLineString forth = line( 13.0, 52.0, 13.1, 52.0, 101 );
+    const GeoDataLineString back = line( 13.1, 52.00001, 13.0, 52.00001, 101 );
+    index.addSegment( 0, 0, forth );
+    index.addSegment( 1, forth.size(), back );
+
+    const GeoDataCoordinates position( 13.05, 52.000006, 0.0, GeoDataCoordinates::Degree );
+    RouteSegmentIndex::Match match;
+    QVERIFY( index.closestEdge( position, -1, match ) );
+    QCOMPARE( match.segment, 1 );
+
+    QVERIFY( index.closestEdge( position, 40, match ) );
+    QCOMPARE( match.segment, 0 );
+}
+
+void RouteSegmentIndexTest::routePosition()
+{
+    RouteSegment first;
+    first.setPath( line( 13.0, 52.0, 13.5, 52.0, 51 ) );
+    RouteSegment second;
+    second.setPath( line( 13.5, 52.0, 13.5, 52.5, 51 ) );
+
+    Route route;
+    route.addRouteSegment( first );
+    route.addRouteSegment( second );
+    QCOMPARE( route.segmentIndex().size(), 100 );
+
+    route.setPosition( GeoDataCoordinates( 13.501, 52.25, 0.0, GeoDataCoordinates::Degree ) );
+    QCOMPARE( route.currentSegment(), route.at( 1 ) );
+    QVERIFY( qAbs( route.positionOnRoute().longitude( GeoDataCoordinates::Degree ) - 13.5 ) < 1e-9 );
+    QCOMPARE( route.closestPathIndex( GeoDataCoordinates( 13.0, 52.0, 0.0, GeoDataCoordinates::Degree ) ), 0 );
+    QCOMPARE( route.closestPathIndex( GeoDataCoordinates( 13.5, 52.5, 0.0, GeoDataCoordinates::Degree ) ), 101 );
+}
+
+void RouteSegmentIndexTest::closestPoint()
+{
+    const Route route = zigzagRoute();
+    const GeoDataLineString &path = route.path();
+
+    for ( qreal lon = 12.9; lon < 13.7; lon += 0.013 ) {
+        for ( qreal lat = 51.9; lat < 52.2; lat += 0.011 ) {
+            const GeoDataCoordinates position( lon, lat, 0.0, GeoDataCoordinates::Degree );
+            // the linear scan the index replaces, keeping the first of equally close points
+            int expected = 0;
+            for ( int i = 1; i < path.size(); ++i ) {
+                if ( path[i].sphericalDistanceTo( position ) < path[expected].sphericalDistanceTo( position ) ) {
+                    expected = i;
+                }
+            }
+            QCOMPARE( route.closestPathIndex( position ), expected );
+        }
+    }
+}
+
+void RouteSegmentIndexTest::antimeridian()
+{
+    // a route crossing the antimeridian from east to west, point 10 lies on it
+    GeoDataLineString path;
+    for ( int i = 0; i <= 20; ++i ) {
+        qreal const lon = ( 17990 + i ) / 100.0;
+        path << GeoDataCoordinates( lon > 180.0 ? lon - 360.0 : lon, -16.0 - 0.005 * i, 0.0, GeoDataCoordinates::Degree );
+    }
+    RouteSegmentIndex index;
+    index.addSegment( 0, 0, path );
+    QCOMPARE( index.size(), 20 );
+
+    // just south of the edge from point 10 to 11, which crosses the antimeridian
+    const GeoDataCoordinates west( -179.99, -16.0545, 0.0, GeoDataCoordinates::Degree );
+    RouteSegmentIndex::Match match;
+    QVERIFY( index.closestEdge( west, -1, match ) );
+    QCOMPARE( match.pathIndex, 11 );
+    QVERIFY( match.distance < 100.0 );
+    QVERIFY( qAbs( match.interpolated.longitude( GeoDataCoordinates::Degree ) + 179.99 ) < 0.001 );
+
+    const GeoDataCoordinates east( 179.99, -16.0455, 0.0, GeoDataCoordinates::Degree );
+    QVERIFY( index.closestEdge( east, -1, match ) );
+    QCOMPARE( match.pathIndex, 10 );
+    QVERIFY( match.distance < 100.0 );
+
+    QCOMPARE( index.closestPoint( GeoDataCoordinates( -179.999, -16.05, 0.0, GeoDataCoordinates::Degree ) ), 10 );
+    QCOMPARE( index.closestPoint( GeoDataCoordinates( -179.981, -16.061, 0.0, GeoDataCoordinates::Degree ) ), 12 );
+    QCOMPARE( index.closestPoint( GeoDataCoordinates( 179.981, -16.041, 0.0, GeoDataCoordinates::Degree ) ), 8 );
+}
+
+void RouteSegmentIndexTest::rightNeighbor()
+{
+    const Route route = zigzagRoute();
+    const GeoDataLineString &path = route.path();
+
+    GeoDataTreeModel treeModel;
+    PositionTracking positionTracking( &treeModel );
+    RouteRequest request;
+    request.append( path.first() );
+    request.append( GeoDataCoordinates( 13.21, 52.04, 0.0, GeoDataCoordinates::Degree ) );
+    request.append( GeoDataCoordinates( 13.39, 52.01, 0.0, GeoDataCoordinates::Degree ) );
+    request.append( path.last() );
+    RoutingModel model( &request, &positionTracking );
+    model.setRoute( route );
+
+    // the via point to path point mapping rightNeighbor did before using the index
+    QVector<int> mapping;
+    mapping << 0;
+    for ( int j = 1; j < request.size() - 1; ++j ) {
+        int closest = mapping.last();
+        for ( int i = mapping.last(); i < path.size(); ++i ) {
+            if ( path[i].sphericalDistanceTo( request.at( j ) ) < path[closest].sphericalDistanceTo( request.at( j ) ) ) {
+                closest = i;
+            }
+        }
+        mapping << closest;
+    }
+    mapping << path.size() - 1;
+
+    for ( int i = 0; i < path.size(); i += 5 ) {
+        int waypoint = 0;
+        for ( int k = 1; k < path.size(); ++k ) {
+            if ( path[k].sphericalDistanceTo( path[i] ) < path[waypoint].sphericalDistanceTo( path[i] ) ) {
+                waypoint = k;
+            }
+        }
+        int expected = request.size() - 1;
+        for ( int j = 0; j < mapping.size(); ++j ) {
+            if ( mapping[j] > waypoint ) {
+                expected = j;
+                break;
+            }
+        }
+        QCOMPARE( model.rightNeighbor( path[i], &request ), expected );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::RouteSegmentIndexTest )
+
+#include "RouteSegmentIndexTest.moc"
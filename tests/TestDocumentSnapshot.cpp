@@ -0,0 +1,290 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "DocumentSnapshot.h"
+#include "MarbleDirs.h"
+#include "GeoDataParser.h"
+#include "GeoDataDocument.h"
+#include "GeoDataFolder.h"
+#include "GeoDataLatLonAltBox.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPolygon.h"
+#include "GeoDataStyle.h"
+#include "GeoDataLineStyle.h"
+#include "GeoDataLinearRing.h"
+#include "osm/OsmPlacemarkData.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Marble
+{
+
+class TestDocumentSnapshot : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void roundTrip();
+    void outdatedSnapshot();
+    void unsupportedDocument();
+    void osmData();
+    void cities();
+
+private:
+    static GeoDataDocument *parse( const QByteArray &content );
+
+    QTemporaryDir m_directory;
+    QString m_sourceFileName;
+};
+
+void TestDocumentSnapshot::initTestCase()
+{
+    MarbleDirs::setMarbleDataPath( DATA_PATH );
+    MarbleDirs::setMarblePluginPath( PLUGIN_PATH );
+
+    QVERIFY( m_directory.isValid() );
+    m_sourceFileName = m_directory.path() + QLatin1String( "/snapshot.kml" );
+    QFile source( m_sourceFileName );
+    QVERIFY( source.open( QIODevice::WriteOnly ) );
+    source.write(
+"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+"<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n"
+"  <Document>\n"
+"    <name>Snapshot</name>\n"
+"    <Style id=\"red\"><LineStyle><color>ff0000ff</color><width>3</width></LineStyle></Style>\n"
+"    <Folder>\n"
+"      <name>Folder</name>\n"
+"      <Placemark>\n"
+"        <name>Point</name>\n"
+"        <ExtendedData><Data name=\"key\"><value>value</value></Data></ExtendedData>\n"
+"        <Point><coordinates>13.4,52.5,34</coordinates></Point>\n"
+"      </Placemark>\n"
+"    </Folder>\n"
+"    <Placemark>\n"
+"      <name>Polygon</name>\n"
+"      <styleUrl>#red</styleUrl>\n"
+"      <Polygon>\n"
+"        <outerBoundaryIs><LinearRing><coordinates>\n"
+"          -122.365662,37.826988,0 -122.365202,37.826302,0 -122.364581,37.82655,0 -122.365662,37.826988,0\n"
+"        </coordinates></LinearRing></outerBoundaryIs>\n"
+"        <innerBoundaryIs><LinearRing><coordinates>\n"
+"          -122.3652,37.8267,0 -122.3650,37.8266,0 -122.3649,37.8267,0 -122.3652,37.8267,0\n"
+"        </coordinates></LinearRing></innerBoundaryIs>\n"
+"      </Polygon>\n"
+"    </Placemark>\n"
+"  </Document>\n"
+"</kml>" );
+}
+
+GeoDataDocument *TestDocumentSnapshot::parse( const QByteArray &content )
+{
+    GeoDataParser parser( GeoData_KML );
+    QByteArray data( content );
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::ReadOnly );
+    if ( !parser.read( &buffer ) ) {
+        return nullptr;
+    }
+
+    return static_cast<GeoDataDocument*>( parser.releaseDocument() );
+}
+
+void TestDocumentSnapshot::roundTrip()
+{
+    QFile source( m_sourceFileName );
+    QVERIFY( source.open( QIODevice::ReadOnly ) );
+    GeoDataDocument *document = parse( source.readAll() );
+    QVERIFY( document );
+
+    QVERIFY( DocumentSnapshot::save( m_sourceFileName, document ) );
+    QVERIFY( DocumentSnapshot::isUpToDate( m_sourceFileName ) );
+
+    GeoDataLatLonBox bounds;
+    QVERIFY( DocumentSnapshot::bounds( m_sourceFileName, bounds ) );
+    QVERIFY( bounds == GeoDataLatLonBox( document->latLonAltBox() ) );
+
+    GeoDataDocument *snapshot = DocumentSnapshot::load( m_sourceFileName, UserDocument );
+    QVERIFY( snapshot );
+    QCOMPARE( snapshot->name(), QString( "Snapshot" ) );
+    QCOMPARE( snapshot->documentRole(), UserDocument );
+    QCOMPARE( snapshot->fileName(), m_sourceFileName );
+    QCOMPARE( snapshot->size(), 2 );
+    QCOMPARE( snapshot->style( "red" )->lineStyle().width(), float( 3 ) );
+    QCOMPARE( snapshot->style( "red" )->lineStyle().color(), document->style( "red" )->lineStyle().color() );
+
+    const QVector<GeoDataPlacemark*> original = document->placemarkList();
+    const QVector<GeoDataPlacemark*> restored = snapshot->placemarkList();
+    QCOMPARE( restored.size(), original.size() );
+    for ( int i = 0; i < restored.size(); ++i ) {
+        QCOMPARE( restored[i]->name(), original[i]->name() );
+        QCOMPARE( restored[i]->styleUrl(), original[i]->styleUrl() );
+        QCOMPARE( restored[i]->coordinate(), original[i]->coordinate() );
+        QCOMPARE( restored[i]->geometry()->latLonAltBox(), original[i]->geometry()->latLonAltBox() );
+    }
+
+    const GeoDataPlacemark *point = static_cast<const GeoDataFolder*>( snapshot->child( 0 ) )->placemarkList().first();
+    QCOMPARE( point->extendedData().value( "key" ).value().toString(), QString( "value" ) );
+
+    const GeoDataPolygon *polygon = geodata_cast<GeoDataPolygon>( snapshot->placemarkList().first()->geometry() );
+    QVERIFY( polygon );
+    QCOMPARE( polygon->outerBoundary().size(), 4 );
+    QCOMPARE( polygon->innerBoundaries().size(), 1 );
+
+    delete snapshot;
+    delete document;
+}
+
+void TestDocumentSnapshot::outdatedSnapshot()
+{
+    QVERIFY( DocumentSnapshot::isUpToDate( m_sourceFileName ) );
+
+    QFile source( m_sourceFileName );
+    QVERIFY( source.open( QIODevice::Append ) );
+    source.write( "\n" );
+    source.close();
+
+    QVERIFY( !DocumentSnapshot::isUpToDate( m_sourceFileName ) );
+    QVERIFY( !DocumentSnapshot::load( m_sourceFileName ) );
+    GeoDataLatLonBox bounds;
+    QVERIFY( !DocumentSnapshot::bounds( m_sourceFileName, bounds ) );
+}
+
+void TestDocumentSnapshot::unsupportedDocument()
+{
+    const QByteArray content =
+"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+"<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n"
+"  <Document>\n"
+"    <GroundOverlay><name>Overlay</name></GroundOverlay>\n"
+"  </Document>\n"
+"</kml>\n";
+
+    // Large enough to be worth a snapshot
+    const QString sourceFileName = m_directory.path() + QLatin1String( "/overlay.kml" );
+    QFile source( sourceFileName );
+    QVERIFY( source.open( QIODevice::WriteOnly ) );
+    source.write( content );
+    source.write( "<!--" + QByteArray( 64 * 1024, ' ' ) + "-->\n" );
+    source.close();
+    QVERIFY( DocumentSnapshot::isCacheable( sourceFileName ) );
+
+    GeoDataDocument *document = parse( content );
+    QVERIFY( document );
+    QVERIFY( !DocumentSnapshot::save( sourceFileName, document ) );
+    delete document;
+
+    // The marker keeps the source from being serialized and looked up again
+    QVERIFY( QFile::exists( DocumentSnapshot::snapshotPath( sourceFileName ) ) );
+    QVERIFY( !DocumentSnapshot::isCacheable( sourceFileName ) );
+    QVERIFY( !DocumentSnapshot::isUpToDate( sourceFileName ) );
+    QVERIFY( !DocumentSnapshot::load( sourceFileName ) );
+    QVERIFY( !DocumentSnapshot::save( sourceFileName, nullptr ) );
+    QFile::remove( DocumentSnapshot::snapshotPath( sourceFileName ) );
+}
+
+void TestDocumentSnapshot::osmData()
+{
+    const QString sourceFileName = m_directory.path() + QLatin1String( "/building.osm" );
+    QFile source( sourceFileName );
+    QVERIFY( source.open( QIODevice::WriteOnly ) );
+    source.write( "<osm/>" );
+    source.close();
+
+    GeoDataLinearRing outer;
+    outer << GeoDataCoordinates( 13.40, 52.50, 0, GeoDataCoordinates::Degree )
+          << GeoDataCoordinates( 13.41, 52.50, 0, GeoDataCoordinates::Degree )
+          << GeoDataCoordinates( 13.41, 52.51, 0, GeoDataCoordinates::Degree );
+    GeoDataPolygon *polygon = new GeoDataPolygon;
+    polygon->setOuterBoundary( outer );
+
+    OsmPlacemarkData outerData;
+    outerData.setId( 2 );
+    for ( int i = 0; i < outer.size(); ++i ) {
+        OsmPlacemarkData node;
+        node.setId( 10 + i );
+        node.addTag( QStringLiteral( "entrance" ), QString::number( i ) );
+        outerData.addNodeReference( i, node );
+    }
+    OsmPlacemarkData osmData;
+    osmData.setId( 1 );
+    osmData.addTag( QStringLiteral( "building" ), QStringLiteral( "yes" ) );
+    osmData.addTag( QStringLiteral( "name" ), QStringLiteral( "Building" ) );
+    osmData.addMemberReference( -1, outerData );
+    osmData.addRelation( 3, OsmType::Relation, QStringLiteral( "outer" ) );
+
+    GeoDataPlacemark *placemark = new GeoDataPlacemark( QStringLiteral( "Building" ) );
+    placemark->setGeometry( polygon );
+    placemark->setVisualCategory( GeoDataPlacemark::Building );
+    placemark->setOsmData( osmData );
+    GeoDataDocument document;
+    document.append( placemark );
+
+    QVERIFY( DocumentSnapshot::save( sourceFileName, &document ) );
+    GeoDataDocument *snapshot = DocumentSnapshot::load( sourceFileName );
+    QVERIFY( snapshot );
+    QCOMPARE( snapshot->placemarkList().size(), 1 );
+
+    const GeoDataPlacemark *restored = snapshot->placemarkList().first();
+    QCOMPARE( restored->visualCategory(), GeoDataPlacemark::Building );
+    QVERIFY( restored->hasOsmData() );
+    const OsmPlacemarkData &restoredData = restored->osmData();
+    QCOMPARE( restoredData.id(), qint64( 1 ) );
+    QCOMPARE( restoredData.tagValue( QStringLiteral( "building" ) ), QStringLiteral( "yes" ) );
+    QCOMPARE( restoredData.tagValue( QStringLiteral( "name" ) ), QStringLiteral( "Building" ) );
+    QVERIFY( restoredData.containsRelation( 3 ) );
+
+    const OsmPlacemarkData restoredOuter = restoredData.memberReference( -1 );
+    QCOMPARE( restoredOuter.id(), qint64( 2 ) );
+    for ( int i = 0; i < outer.size(); ++i ) {
+        const OsmPlacemarkData node = restoredOuter.nodeReference( i );
+        QCOMPARE( node.id(), qint64( 10 + i ) );
+        QCOMPARE( node.tagValue( QStringLiteral( "entrance" ) ), QString::number( i ) );
+    }
+
+    delete snapshot;
+}
+
+void TestDocumentSnapshot::cities()
+{
+    QFile source( CITIES_PATH );
+    QVERIFY( source.open( QIODevice::ReadOnly ) );
+
+    QElapsedTimer timer;
+    timer.start();
+    GeoDataDocument *document = parse( source.readAll() );
+    QVERIFY( document );
+    const qint64 parseTime = timer.elapsed();
+
+    const QString fileName = m_directory.path() + QLatin1String( "/cities.kml" );
+    QVERIFY( QFile::copy( CITIES_PATH, fileName ) );
+    QVERIFY( DocumentSnapshot::save( fileName, document ) );
+
+    timer.start();
+    GeoDataDocument *snapshot = DocumentSnapshot::load( fileName );
+    QVERIFY( snapshot );
+    qDebug() << "parsing:" << parseTime << "ms, loading snapshot:" << timer.elapsed() << "ms";
+
+    QCOMPARE( snapshot->placemarkList().size(), document->placemarkList().size() );
+    QCOMPARE( snapshot->placemarkList().last()->population(), document->placemarkList().last()->population() );
+
+    QFile::remove( DocumentSnapshot::snapshotPath( fileName ) );
+    QFile::remove( DocumentSnapshot::snapshotPath( m_sourceFileName ) );
+    delete snapshot;
+    delete document;
+}
+
+}
+
+QTEST_MAIN( Marble::TestDocumentSnapshot )
+
+#include "TestDocumentSnapshot.moc"
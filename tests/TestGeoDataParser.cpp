@@ -0,0 +1,73 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "GeoDataParser.h"
+#include "GeoDataDocument.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataStyle.h"
+#include "GeoDataTrack.h"
+
+#include <QBuffer>
+#include <QTest>
+
+namespace Marble
+{
+
+class TestGeoDataParser : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void handlerLookup();
+
+private:
+    static const char *const s_kml;
+};
+
+const char *const TestGeoDataParser::s_kml =
+"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+"<kml xmlns=\"http://www.opengis.net/kml/2.2\" xmlns:gx=\"http://www.google.com/kml/ext/2.2\">\n"
+"  <Document>\n"
+"    <name>Document</name>\n"
+"    <Style id=\"style\"><IconStyle><scale>2</scale></IconStyle></Style>\n"
+"    <Placemark><name>First</name><Point><coordinates>1,2</coordinates></Point></Placemark>\n"
+"    <unknownElement><Placemark><name>Ignored</name></Placemark></unknownElement>\n"
+"    <Folder>\n"
+"      <name>Folder</name>\n"
+"      <Placemark><name>Nested</name><Point><coordinates>3,4</coordinates></Point></Placemark>\n"
+"    </Folder>\n"
+"    <Placemark>\n"
+"      <name>Track</name>\n"
+"      <gx:Track><when>2010-05-28T02:02:09Z</when><gx:coord>-122.207881 37.371915 156</gx:coord></gx:Track>\n"
+"    </Placemark>\n"
+"  </Document>\n"
+"</kml>";
+
+void TestGeoDataParser::handlerLookup()
+{
+    GeoDataParser parser( GeoData_KML );
+    QByteArray data( s_kml );
+    QBuffer buffer( &data );
+    QVERIFY( buffer.open( QIODevice::ReadOnly ) );
+    QVERIFY( parser.read( &buffer ) );
+
+    GeoDataDocument *document = static_cast<GeoDataDocument*>( parser.releaseDocument() );
+    QVERIFY( document );
+    QCOMPARE( document->name(), QString( "Document" ) );
+    QCOMPARE( document->size(), 3 );
+    QCOMPARE( document->style( "style" )->iconStyle().scale(), float( 2 ) );
+    QCOMPARE( document->placemarkList().size(), 2 );
+    QVERIFY( geodata_cast<GeoDataTrack>( document->placemarkList().last()->geometry() ) );
+    delete document;
+}
+
+}
+
+QTEST_MAIN( Marble::TestGeoDataParser )
+
+#include "TestGeoDataParser.moc"
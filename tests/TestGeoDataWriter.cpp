@@ -38,6 +38,8 @@ private Q_SLOTS:
     void saveAndCompare();
     void saveAndCompareEquality_data();
     void saveAndCompareEquality();
+    void appendNumber_data();
+    void appendNumber();
     void cleanupTestCase();
 private:
     QDir dataDir;
@@ -209,6 +211,43 @@ void TestGeoDataWriter::saveAndCompareEquality()
     QVERIFY( *initialDoc == *otherDoc );
 }
 
+void TestGeoDataWriter::appendNumber_data()
+{
+    QTest::addColumn<qreal>( "value" );
+    QTest::addColumn<int>( "precision" );
+
+    QTest::newRow( "zero" ) << 0.0 << 10;
+    QTest::newRow( "integer" ) << 42.0 << 10;
+    QTest::newRow( "longitude" ) << 13.3812983891 << 10;
+    QTest::newRow( "negative" ) << -122.4194155 << 10;
+    QTest::newRow( "negative fraction" ) << -0.25 << 3;
+    QTest::newRow( "carry" ) << 0.99999999999 << 10;
+    QTest::newRow( "negative carry" ) << -9.99999999999 << 10;
+    QTest::newRow( "carry into integer digits" ) << 199.999 << 2;
+    QTest::newRow( "altitude" ) << 1234.5678 << 2;
+    QTest::newRow( "precision 0" ) << 42.4 << 0;
+    QTest::newRow( "negative precision 0" ) << -2.7 << 0;
+    QTest::newRow( "carry precision 0" ) << 9.6 << 0;
+    QTest::newRow( "largest scaled" ) << 123456.789 << 10;
+    QTest::newRow( "large" ) << 1.0e10 << 10;
+    QTest::newRow( "negative large" ) << -3.5e12 << 4;
+    QTest::newRow( "precision above maximum" ) << 1.5 << 13;
+    QTest::newRow( "nan" ) << qQNaN() << 10;
+    QTest::newRow( "infinity" ) << qInf() << 10;
+    QTest::newRow( "negative infinity" ) << -qInf() << 10;
+}
+
+void TestGeoDataWriter::appendNumber()
+{
+    QFETCH( qreal, value );
+    QFETCH( int, precision );
+
+    // appends to what is there already
+    QString target = QStringLiteral( "1," );
+    GeoWriter::appendNumber( target, value, precision );
+    QCOMPARE( target, QStringLiteral( "1," ) + QString::number( value, 'f', precision ) );
+}
+
 void TestGeoDataWriter::cleanupTestCase()
 {
     QMap<QString, QSharedPointer<GeoDataParser> >::iterator itpoint = parsers.begin();
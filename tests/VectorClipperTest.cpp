@@ -0,0 +1,269 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#include "VectorClipper.h"
+
+#include "GeoDataDocument.h"
+#include "GeoDataLatLonBox.h"
+#include "GeoDataLineString.h"
+#include "GeoDataLinearRing.h"
+#include "GeoDataPlacemark.h"
+#include "GeoDataPoint.h"
+#include "GeoDataPolygon.h"
+#include "GeoDataRelation.h"
+#include "GeoSceneMercatorTileProjection.h"
+#include "TileId.h"
+#include "osm/OsmPlacemarkData.h"
+
+#include <QHash>
+#include <QMap>
+#include <QTest>
+
+#include <algorithm>
+#include <memory>
+
+namespace Marble
+{
+
+/** Placemarks of a tile grouped by category, tags and geometry with their number and total area or length */
+using TileContent = QMap<QString, QPair<int, qreal> >;
+
+class VectorClipperTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void clipRecursively_data();
+    void clipRecursively();
+    void selectedTiles();
+    void zoomLevelFilter();
+
+private:
+    GeoDataCoordinates coordinates( qreal x, qreal y ) const;
+    GeoDataPlacemark *addPlacemark( qint64 id, GeoDataPlacemark::GeoDataVisualCategory category,
+                                    const QString &key, const QString &value, GeoDataGeometry *geometry );
+    static TileContent content( const GeoDataDocument *tile );
+    static void compare( const TileContent &actual, const TileContent &expected, const TileId &tileId );
+
+    GeoSceneMercatorTileProjection m_projection;
+    TileId m_root;
+    GeoDataLatLonBox m_rootBox;
+    std::unique_ptr<GeoDataDocument> m_document;
+    std::unique_ptr<VectorClipper> m_clipper;
+};
+
+void VectorClipperTest::initTestCase()
+{
+    m_root = TileId::fromCoordinates( GeoDataCoordinates( 8.2, 49.1, 0.0, GeoDataCoordinates::Degree ), 11 );
+    m_rootBox = m_projection.geoCoordinates( m_root );
+    m_document.reset( new GeoDataDocument );
+
+    // A wood reaching beyond the root tile with a hole inside it
+    GeoDataPolygon *wood = new GeoDataPolygon;
+    GeoDataLinearRing outer;
+    outer << coordinates( -0.2, -0.15 ) << coordinates( 1.15, -0.2 ) << coordinates( 1.2, 1.1 ) << coordinates( -0.1, 1.2 );
+    wood->setOuterBoundary( outer );
+    GeoDataLinearRing inner;
+    inner << coordinates( 0.3, 0.55 ) << coordinates( 0.45, 0.57 ) << coordinates( 0.43, 0.7 ) << coordinates( 0.31, 0.68 );
+    wood->appendInnerBoundary( inner );
+    addPlacemark( 1, GeoDataPlacemark::NaturalWood, QStringLiteral( "natural" ), QStringLiteral( "wood" ), wood );
+
+    GeoDataLineString *primary = new GeoDataLineString;
+    *primary << coordinates( -0.1, 0.13 ) << coordinates( 0.37, 0.61 ) << coordinates( 0.71, 0.29 ) << coordinates( 1.1, 0.83 );
+    GeoDataPlacemark *route = addPlacemark( 2, GeoDataPlacemark::HighwayPrimary, QStringLiteral( "highway" ), QStringLiteral( "primary" ), primary );
+
+    // Large enough for tiles of level 15 only
+    GeoDataPolygon *park = new GeoDataPolygon;
+    GeoDataLinearRing parkRing;
+    parkRing << coordinates( 0.52, 0.23 ) << coordinates( 0.53, 0.23 ) << coordinates( 0.53, 0.24 ) << coordinates( 0.52, 0.24 );
+    park->setOuterBoundary( parkRing );
+    addPlacemark( 3, GeoDataPlacemark::LeisurePark, QStringLiteral( "leisure" ), QStringLiteral( "park" ), park );
+
+    addPlacemark( 4, GeoDataPlacemark::AmenityPostBox, QStringLiteral( "amenity" ), QStringLiteral( "post_box" ),
+                  new GeoDataPoint( coordinates( 0.81, 0.66 ) ) );
+
+    GeoDataLineString *residential = new GeoDataLineString;
+    *residential << coordinates( 0.05, 0.95 ) << coordinates( 0.47, 0.88 ) << coordinates( 0.95, 0.91 );
+    addPlacemark( 5, GeoDataPlacemark::HighwayResidential, QStringLiteral( "highway" ), QStringLiteral( "residential" ), residential );
+
+    GeoDataRelation *relation = new GeoDataRelation;
+    relation->osmData().setId( 6 );
+    relation->osmData().addTag( QStringLiteral( "type" ), QStringLiteral( "route" ) );
+    relation->addMember( route, 2, OsmType::Way, QString() );
+    m_document->append( relation );
+
+    m_clipper.reset( new VectorClipper( m_document.get(), 17, []( const GeoDataPlacemark *placemark ) {
+        return placemark->visualCategory() == GeoDataPlacemark::HighwayResidential ? 13 : 0;
+    } ) );
+}
+
+void VectorClipperTest::clipRecursively_data()
+{
+    QTest::addColumn<QVector<int> >( "zoomLevels" );
+
+    QTest::newRow( "root" ) << ( QVector<int>() << 11 );
+    QTest::newRow( "below root" ) << ( QVector<int>() << 14 );
+    QTest::newRow( "several" ) << ( QVector<int>() << 11 << 13 << 15 );
+}
+
+void VectorClipperTest::clipRecursively()
+{
+    QFETCH( QVector<int>, zoomLevels );
+
+    QHash<TileId, TileContent> tiles;
+    m_clipper->clipRecursively( m_root, zoomLevels, [&]( GeoDataDocument *clipped, const TileId &tileId ) {
+        std::unique_ptr<GeoDataDocument> tile( clipped );
+        QVERIFY( !tiles.contains( tileId ) );
+        tiles.insert( tileId, content( tile.get() ) );
+    } );
+
+    int expectedTiles = 0;
+    for ( int zoomLevel: zoomLevels ) {
+        expectedTiles += 1 << ( 2 * ( zoomLevel - m_root.zoomLevel() ) );
+    }
+    QCOMPARE( tiles.size(), expectedTiles );
+
+    for ( auto iter = tiles.constBegin(), end = tiles.constEnd(); iter != end; ++iter ) {
+        auto const & tileId = iter.key();
+        QVERIFY( zoomLevels.contains( tileId.zoomLevel() ) );
+        std::unique_ptr<GeoDataDocument> expected( m_clipper->clipTo( tileId.zoomLevel(), tileId.x(), tileId.y() ) );
+        compare( iter.value(), content( expected.get() ), tileId );
+    }
+}
+
+void VectorClipperTest::selectedTiles()
+{
+    int const x13 = m_root.x() * 4 + 1;
+    int const y13 = m_root.y() * 4 + 2;
+    QSet<TileId> selection;
+    selection << TileId( 0, 13, x13, y13 );
+    selection << TileId( 0, 15, x13 * 4 + 3, y13 * 4 );
+    selection << TileId( 0, 15, m_root.x() * 16 + 15, m_root.y() * 16 + 15 );
+    selection << TileId( 0, 12, m_root.x() * 2 + 1, m_root.y() * 2 );
+    QSet<TileId> tileIds = selection;
+    // Outside of the root tile
+    tileIds << TileId( 0, 13, m_root.x() * 4 + 4, m_root.y() * 4 );
+    tileIds << TileId( 0, 10, m_root.x() / 2, m_root.y() / 2 );
+
+    QHash<TileId, TileContent> tiles;
+    m_clipper->clipRecursively( m_root, tileIds, [&]( GeoDataDocument *clipped, const TileId &tileId ) {
+        std::unique_ptr<GeoDataDocument> tile( clipped );
+        QVERIFY( !tiles.contains( tileId ) );
+        tiles.insert( tileId, content( tile.get() ) );
+    } );
+
+    QCOMPARE( tiles.keys().toSet(), selection );
+    for ( auto iter = tiles.constBegin(), end = tiles.constEnd(); iter != end; ++iter ) {
+        auto const & tileId = iter.key();
+        std::unique_ptr<GeoDataDocument> expected( m_clipper->clipTo( tileId.zoomLevel(), tileId.x(), tileId.y() ) );
+        compare( iter.value(), content( expected.get() ), tileId );
+    }
+}
+
+void VectorClipperTest::zoomLevelFilter()
+{
+    QString const residential = QString::number( GeoDataPlacemark::HighwayResidential );
+    auto const hasResidential = [&]( const GeoDataDocument *tile ) {
+        auto const keys = content( tile ).keys();
+        return std::any_of( keys.constBegin(), keys.constEnd(), [&]( const QString &key ) {
+            return key.startsWith( residential + QLatin1Char( ' ' ) );
+        } );
+    };
+
+    std::unique_ptr<GeoDataDocument> root( m_clipper->clipTo( m_root.zoomLevel(), m_root.x(), m_root.y() ) );
+    QVERIFY( !hasResidential( root.get() ) );
+    QVERIFY( !root->isEmpty() );
+
+    TileId const tileId = TileId::fromCoordinates( coordinates( 0.47, 0.88 ), 13 );
+    std::unique_ptr<GeoDataDocument> tile( m_clipper->clipTo( tileId.zoomLevel(), tileId.x(), tileId.y() ) );
+    QVERIFY( hasResidential( tile.get() ) );
+}
+
+GeoDataCoordinates VectorClipperTest::coordinates( qreal x, qreal y ) const
+{
+    return GeoDataCoordinates( m_rootBox.west() + x * ( m_rootBox.east() - m_rootBox.west() ),
+                               m_rootBox.north() + y * ( m_rootBox.south() - m_rootBox.north() ) );
+}
+
+GeoDataPlacemark *VectorClipperTest::addPlacemark( qint64 id, GeoDataPlacemark::GeoDataVisualCategory category,
+                                                   const QString &key, const QString &value, GeoDataGeometry *geometry )
+{
+    GeoDataPlacemark *placemark = new GeoDataPlacemark;
+    placemark->setGeometry( geometry );
+    placemark->setVisualCategory( category );
+    placemark->osmData().setId( id );
+    placemark->osmData().addTag( key, value );
+    m_document->append( placemark );
+    return placemark;
+}
+
+TileContent VectorClipperTest::content( const GeoDataDocument *tile )
+{
+    auto const area = []( const GeoDataLineString &ring ) {
+        qreal result = 0.0;
+        for ( int i = 0, n = ring.size(); i < n; ++i ) {
+            auto const & a = ring[i];
+            auto const & b = ring[( i + 1 ) % n];
+            result += a.longitude() * b.latitude() - b.longitude() * a.latitude();
+        }
+        return qAbs( result / 2.0 );
+    };
+
+    TileContent result;
+    if ( !tile ) {
+        return result;
+    }
+    for ( auto feature: tile->featureList() ) {
+        QString key;
+        qreal measure = 0.0;
+        if ( const auto relation = geodata_cast<GeoDataRelation>( feature ) ) {
+            key = QStringLiteral( "relation %1" ).arg( relation->osmData().id() );
+        } else if ( const auto placemark = geodata_cast<GeoDataPlacemark>( feature ) ) {
+            // Clipped placemarks get new ids, the mx:oid tag keeps the original one
+            QStringList tags;
+            auto const & osmData = placemark->osmData();
+            for ( auto iter = osmData.tagsBegin(), end = osmData.tagsEnd(); iter != end; ++iter ) {
+                tags << iter.key() + QLatin1Char( '=' ) + iter.value();
+            }
+            tags.sort();
+            auto const geometry = placemark->geometry();
+            key = QStringLiteral( "%1 %2 %3" ).arg( placemark->visualCategory() ).arg( tags.join( QLatin1Char( ';' ) ) ).arg( geometry->nodeType() );
+            if ( const auto polygon = geodata_cast<GeoDataPolygon>( geometry ) ) {
+                measure = area( polygon->outerBoundary() );
+                for ( auto const & innerBoundary: polygon->innerBoundaries() ) {
+                    measure -= area( innerBoundary );
+                }
+            } else if ( const auto lineString = geodata_cast<GeoDataLineString>( geometry ) ) {
+                measure = lineString->length( 1.0 );
+            }
+        }
+        result[key].first += 1;
+        result[key].second += measure;
+    }
+    return result;
+}
+
+void VectorClipperTest::compare( const TileContent &actual, const TileContent &expected, const TileId &tileId )
+{
+    QString const tile = QStringLiteral( "%1/%2/%3" ).arg( tileId.zoomLevel() ).arg( tileId.x() ).arg( tileId.y() );
+    QVERIFY2( actual.keys() == expected.keys(), qPrintable( tile ) );
+    for ( auto iter = expected.constBegin(), end = expected.constEnd(); iter != end; ++iter ) {
+        auto const & value = actual[iter.key()];
+        QVERIFY2( value.first == iter.value().first, qPrintable( tile + QLatin1Char( ' ' ) + iter.key() ) );
+        // Vertices where pieces of the parent tile are cut again can move by the rounding to clipper coordinates
+        qreal const tolerance = 1e-4 * qMax( qAbs( value.second ), qAbs( iter.value().second ) ) + 1e-12;
+        QVERIFY2( qAbs( value.second - iter.value().second ) <= tolerance, qPrintable( tile + QLatin1Char( ' ' ) + iter.key() ) );
+    }
+}
+
+}
+
+QTEST_MAIN( Marble::VectorClipperTest )
+
+#include "VectorClipperTest.moc"
@@ -11,6 +11,7 @@
 
 // A simple tool to read a .kml file and write it back to a .cache file
 
+#include <DocumentSnapshot.h>
 #include <ParsingRunnerManager.h>
 #include <PluginManager.h>
 #include <MarbleClock.h>
@@ -92,7 +93,8 @@ int main(int argc, char** argv)
     if ( inputIndex > 0 && inputIndex + 1 < argc ) {
         inputFilename = app.arguments().at( inputIndex + 1 );
     } else {
-        qDebug( " Syntax: kml2cache -i sourcefile [-o cache-targetfile]" );
+        qDebug( " Syntax: kml2cache -i sourcefile [-o cache-targetfile | -s]" );
+        qDebug( "  -s: store a document snapshot in the local cache instead of writing a .cache file" );
         return 1;
     }
 
@@ -108,5 +110,14 @@ int main(int argc, char** argv)
         return 2;
     }
 
+    if ( app.arguments().contains( "-s" ) ) {
+        if ( !DocumentSnapshot::save( inputFilename, document ) ) {
+            qDebug() << "Could not write a snapshot, the document contains unsupported data";
+            return 3;
+        }
+        qDebug() << "Snapshot written to" << DocumentSnapshot::snapshotPath( inputFilename );
+        return 0;
+    }
+
     saveFile( outputFilename, document );
 }
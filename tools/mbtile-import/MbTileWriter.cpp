@@ -48,6 +48,10 @@ MbTileWriter::MbTileWriter(const QString &filename, const QString &extension) :
         setMetaData("format", extension);
         setMetaData("attribution", "Data from <a href=\"https://openstreetmap.org/\">OpenStreetMap</a> and <a href=\"https://www.naturalearthdata.com/\">Natural Earth</a> contributors");
     }
+    m_insertQuery = QSqlQuery(database);
+    m_insertQuery.prepare( "INSERT OR REPLACE INTO tiles"
+                           " (zoom_level, tile_column, tile_row, tile_data)"
+                           " VALUES (?, ?, ?, ?)" );
     execQuery("BEGIN TRANSACTION");
 }
 
@@ -96,6 +100,11 @@ void MbTileWriter::addTile(const QFileInfo &file, qint32 x, qint32 y, qint32 z)
 }
 
 void MbTileWriter::addTile(QIODevice *device, qint32 x, qint32 y, qint32 z)
+{
+    addTile(device->readAll(), x, y, z);
+}
+
+void MbTileWriter::addTile(const QByteArray &data, qint32 x, qint32 y, qint32 z)
 {
     ++m_tileCounter;
     if (m_commitInterval > 0 && m_tileCounter % m_commitInterval == 0) {
@@ -103,15 +112,13 @@ void MbTileWriter::addTile(QIODevice *device, qint32 x, qint32 y, qint32 z)
         execQuery("BEGIN TRANSACTION");
     }
 
-    QSqlQuery query;
-    query.prepare( "INSERT OR REPLACE INTO tiles"
-                   " (zoom_level, tile_column, tile_row, tile_data)"
-                   " VALUES (?, ?, ?, ?)" );
-    query.addBindValue(z);
-    query.addBindValue(x);
-    query.addBindValue(y);
-    query.addBindValue(device->readAll());
-    execQuery(query);
+    // The statement is prepared once, sqlite only needs to bind the new values
+    m_insertQuery.addBindValue(z);
+    m_insertQuery.addBindValue(x);
+    m_insertQuery.addBindValue(y);
+    m_insertQuery.addBindValue(data);
+    execQuery(m_insertQuery);
+    m_insertQuery.finish();
 }
 
 bool MbTileWriter::hasTile(qint32 x, qint32 y, qint32 z) const
@@ -29,6 +29,7 @@ public:
 
     void addTile(const QFileInfo &file, qint32 x, qint32 y, qint32 z);
     void addTile(QIODevice* device, qint32 x, qint32 y, qint32 z);
+    void addTile(const QByteArray &data, qint32 x, qint32 y, qint32 z);
     bool hasTile(qint32 x, qint32 y, qint32 z) const;
 
 private:
@@ -36,6 +37,7 @@ private:
     void execQuery(QSqlQuery &query) const;
     void setMetaData(const QString &name, const QString &value);
 
+    QSqlQuery m_insertQuery;
     bool m_overwriteTiles;
     bool m_reportProgress;
     int m_tileCounter;
@@ -41,7 +41,27 @@ private:
     {
         bool const isArea = lineString.isClosed() && VectorClipper::canBeArea(visualCategory);
         qreal const epsilon = epsilonFor(isArea ? 45.0 : 30.0);
-        *reducedLine = douglasPeucker(lineString, osmData, epsilon);
+        QVector<int> keptNodes;
+        if (!lineString.isEmpty()) {
+            keptNodes << 0;
+            douglasPeucker(lineString, 0, lineString.size() - 1, osmData, epsilon, keptNodes);
+        }
+
+        // Node references are kept by vertex index, they follow the remaining vertices
+        QVector<OsmPlacemarkData> &nodeReferences = osmData.nodeReferences();
+        QVector<OsmPlacemarkData> reducedReferences;
+        if (!nodeReferences.isEmpty()) {
+            reducedReferences.reserve(keptNodes.size());
+        }
+        for (int index: keptNodes) {
+            *reducedLine << lineString[index];
+            if (!nodeReferences.isEmpty()) {
+                reducedReferences << nodeReferences.value(index);
+            }
+        }
+        if (!nodeReferences.isEmpty()) {
+            nodeReferences = reducedReferences;
+        }
 
         qint64 prevSize = lineString.size();
         qint64 reducedSize = reducedLine->size();
@@ -59,38 +79,24 @@ private:
         setBorderPoints(osmData, borderPoints, reducedLine->size());
     }
 
+    /**
+     * Appends the indices of the vertices between @p first (exclusive) and @p last (inclusive)
+     * of @p lineString which are kept to @p keptNodes
+     */
     template<class T>
-    T extract(T const & lineString, int start, int end) const
-    {
-        T result;
-        for (int i=start; i<=end; ++i) {
-            result << lineString[i];
-        }
-        return result;
-    }
-
-    template<class T>
-    T merge(T const & a, T const &b) const
-    {
-        T result = a;
-        int const index = a.size();
-        result << b;
-        result.remove(index);
-        return result;
-    }
-
-    template<class T>
-    T douglasPeucker(T const & lineString, const OsmPlacemarkData &osmData, qreal epsilon) const
+    void douglasPeucker(T const & lineString, int first, int last, const OsmPlacemarkData &osmData, qreal epsilon, QVector<int> &keptNodes) const
     {
-        if (lineString.size() < 3) {
-            return lineString;
+        if (last - first < 2) {
+            for (int i = first + 1; i <= last; ++i) {
+                keptNodes << i;
+            }
+            return;
         }
 
         double maxDistance = 0.0;
-        int index = 1;
-        int const end = lineString.size()-1;
-        for (int i = 1; i<end; ++i) {
-            double const distance = perpendicularDistance(lineString[i], lineString[0], lineString[end]);
+        int index = first + 1;
+        for (int i = first + 1; i<last; ++i) {
+            double const distance = perpendicularDistance(lineString[i], lineString[first], lineString[last]);
             if (distance > maxDistance) {
                 index = i;
                 maxDistance = distance;
@@ -98,21 +104,18 @@ private:
         }
 
         if (maxDistance >= epsilon) {
-            T const left = douglasPeucker(extract(lineString, 0, index), osmData, epsilon);
-            T const right = douglasPeucker(extract(lineString, index, end), osmData, epsilon);
-            return merge(left, right);
+            douglasPeucker(lineString, first, index, osmData, epsilon, keptNodes);
+            douglasPeucker(lineString, index, last, osmData, epsilon, keptNodes);
+            return;
         }
 
-        T result;
-        result << lineString[0];
-        for (int i=1; i<end; ++i) {
-            bool const keepNode = touchesTileBorder(lineString[i]) || !osmData.nodeReference(lineString[i]).isEmpty();
+        for (int i = first + 1; i<last; ++i) {
+            bool const keepNode = touchesTileBorder(lineString[i]) || !osmData.nodeReference(i).isEmpty();
             if (keepNode) {
-                result << lineString[i];
+                keptNodes << i;
             }
         }
-        result << lineString[end];
-        return result;
+        keptNodes << last;
     }
 
     qint64 m_removedNodes;
@@ -26,19 +26,11 @@ TagsFilter::TagsFilter(GeoDataDocument *document, const Tags &tagsList, FilterFl
             bool acceptPlacemark = false;
             auto const & osmData = placemark->osmData();
 
-            if (filterFlag == FilterRailwayService &&
-                    osmData.containsTagKey(QStringLiteral("railway")) &&
-                    osmData.containsTagKey(QStringLiteral("service"))) {
+            if (filterFlag == FilterRailwayService && isRailwayService(osmData)) {
                 acceptPlacemark = false;
             } else {
                 for (auto const &tag: tagsList) {
-                    bool contains;
-                    if (tag.second == QLatin1String("*")) {
-                        contains = osmData.containsTagKey(tag.first);
-                    } else {
-                        contains = osmData.containsTag(tag.first, tag.second);
-                    }
-                    if (contains) {
+                    if (containsTag(osmData, tag)) {
                         acceptPlacemark = true;
                         break;
                     }
@@ -78,6 +70,19 @@ GeoDataDocument *TagsFilter::accepted()
     return m_accepted;
 }
 
+bool TagsFilter::containsTag(const OsmPlacemarkData &osmData, const Tag &tag)
+{
+    if (tag.second == QLatin1String("*")) {
+        return osmData.containsTagKey(tag.first);
+    }
+    return osmData.containsTag(tag.first, tag.second);
+}
+
+bool TagsFilter::isRailwayService(const OsmPlacemarkData &osmData)
+{
+    return osmData.containsTagKey(QStringLiteral("railway")) && osmData.containsTagKey(QStringLiteral("service"));
+}
+
 void TagsFilter::removeAnnotationTags(GeoDataDocument *document)
 {
     for (auto placemark: document->placemarkList()) {
@@ -44,6 +44,10 @@ public:
 
     static void removeAnnotationTags(GeoDataDocument* document);
 
+    /** Returns true if the OSM data has the tag, a value of * matches any value of the key */
+    static bool containsTag(const OsmPlacemarkData &osmData, const Tag &tag);
+    static bool isRailwayService(const OsmPlacemarkData &osmData);
+
 private:
     static void removeAnnotationTags(OsmPlacemarkData &osmData);
 
@@ -161,17 +161,25 @@ void TileDirectory::setInputFile(const QString &filename)
 }
 
 GeoDataDocument* TileDirectory::clip(int zoomLevel, int tileX, int tileY)
+{
+    auto const tileClipper = clipper(zoomLevel, tileX, tileY);
+    return tileClipper ? tileClipper->clipTo(zoomLevel, tileX, tileY) : nullptr;
+}
+
+QSharedPointer<const VectorClipper> TileDirectory::clipper(int zoomLevel, int tileX, int tileY)
 {
     QSharedPointer<GeoDataDocument> oldMap = m_landmass;
     load(zoomLevel, tileX, tileY);
     if (!m_clipper || oldMap != m_landmass || m_tagZoomLevel != zoomLevel) {
         setTagZoomLevel(zoomLevel);
         GeoDataDocument* input = m_tagsFilter ? m_tagsFilter->accepted() : m_landmass.data();
-        if (input) {
+        if (input && m_tileType == OpenStreetMap) {
+            m_clipper = QSharedPointer<VectorClipper>(new VectorClipper(input, m_maxZoomLevel, &TileDirectory::minimumZoomLevel));
+        } else if (input) {
             m_clipper = QSharedPointer<VectorClipper>(new VectorClipper(input, m_maxZoomLevel));
         }
     }
-    return m_clipper ? m_clipper->clipTo(zoomLevel, tileX, tileY) : nullptr;
+    return m_clipper;
 }
 
 QString TileDirectory::name() const
@@ -190,7 +198,7 @@ QSharedPointer<GeoDataDocument> TileDirectory::open(const QString &filename, Par
     return result;
 }
 
-TagsFilter::Tags TileDirectory::tagsFilteredIn(int zoomLevel) const
+const QMap<int, TagsFilter::Tags> &TileDirectory::tagLevels()
 {
     if (m_tags.isEmpty()) {
         QSet<GeoDataPlacemark::GeoDataVisualCategory> categories;
@@ -210,14 +218,37 @@ TagsFilter::Tags TileDirectory::tagsFilteredIn(int zoomLevel) const
             }
         }
     }
+    return m_tags;
+}
 
+TagsFilter::Tags TileDirectory::tagsFilteredIn(int zoomLevel) const
+{
+    auto const & tags = tagLevels();
     TagsFilter::Tags result;
-    for (auto iter = m_tags.begin(), end = m_tags.end(); iter != end && iter.key() <= zoomLevel+1; ++iter) {
+    for (auto iter = tags.begin(), end = tags.end(); iter != end && iter.key() <= zoomLevel+1; ++iter) {
         result << iter.value();
     }
     return result;
 }
 
+int TileDirectory::minimumZoomLevel(const GeoDataPlacemark *placemark)
+{
+    auto const & osmData = placemark->osmData();
+    if (!TagsFilter::isRailwayService(osmData)) {
+        auto const & tags = tagLevels();
+        for (auto iter = tags.begin(), end = tags.end(); iter != end; ++iter) {
+            for (auto const &tag: iter.value()) {
+                if (TagsFilter::containsTag(osmData, tag)) {
+                    // tagsFilteredIn() accepts the tags one zoom level early
+                    return qMax(0, iter.key() - 1);
+                }
+            }
+        }
+    }
+    // Tiles of level 17 and above are not filtered by tags
+    return 17;
+}
+
 void TileDirectory::setTagZoomLevel(int zoomLevel)
 {
     m_tagZoomLevel = zoomLevel;
@@ -71,6 +71,12 @@ public:
 
     TileId tileFor(int zoomLevel, int tileX, int tileY) const;
     GeoDataDocument *clip(int zoomLevel, int tileX, int tileY);
+    /** Loads the data needed for the given tile and returns the clipper that clip() would use.
+     *  The clipper can be shared by several threads to clip all tiles of the same or a lower zoom
+     *  level that lie in the same loaded tile, lower zoom levels leave out the placemarks their
+     *  tags filter rejects. It is only valid until clip() or clipper() is called again.
+     */
+    QSharedPointer<const VectorClipper> clipper(int zoomLevel, int tileX, int tileY);
     QString name() const;
 
     static QSharedPointer<GeoDataDocument> open(const QString &filename, ParsingRunnerManager &manager);
@@ -89,7 +95,9 @@ private Q_SLOTS:
     void handleFinishedDownload(const QString &filename, const QString &id);
 
 private:
+    static const QMap<int, TagsFilter::Tags> &tagLevels();
     TagsFilter::Tags tagsFilteredIn(int zoomLevel) const;
+    static int minimumZoomLevel(const GeoDataPlacemark *placemark);
     void setTagZoomLevel(int zoomLevel);
     void download(const QString &url, const QString &target);
     QString osmFileFor(const TileId &tileId) const;
@@ -0,0 +1,106 @@
+//
+// This file is part of the Marble Virtual Globe.
+//
+// This program is free software licensed under the GNU LGPL. You can
+// find a copy of this license in LICENSE.txt in the top directory of
+// the source code.
+//
+
+#ifndef MARBLE_TILEWORKERPOOL_H
+#define MARBLE_TILEWORKERPOOL_H
+
+#include <QAtomicInt>
+#include <QFuture>
+#include <QMutex>
+#include <QQueue>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+#include <QtConcurrentRun>
+
+namespace Marble {
+
+/**
+ * Calls @p produce for each of @p jobs on the threads of the global thread pool and
+ * hands the results to @p consume in the calling thread, in the order they are done.
+ *
+ * A worker takes the next job as soon as it finished the previous one, so a few
+ * expensive tiles do not hold up the others. At most @p queueSize results wait for
+ * the calling thread; workers pause when it falls behind, which bounds the memory
+ * needed for tiles that are not written yet.
+ *
+ * @p produce must be safe to call concurrently. @p consume can stop the processing
+ * by returning false, in which case false is returned once all workers are done.
+ */
+template<class Job, class Result, class Producer, class Consumer>
+bool processTiles(const QVector<Job> &jobs, Producer produce, Consumer consume, int queueSize = 0)
+{
+    if (jobs.isEmpty()) {
+        return true;
+    }
+
+    int const workerCount = qBound(1, QThreadPool::globalInstance()->maxThreadCount(), jobs.size());
+    queueSize = queueSize > 0 ? queueSize : 4 * workerCount;
+
+    QMutex mutex;
+    QWaitCondition resultAvailable;
+    QWaitCondition spaceAvailable;
+    QQueue<Result> results;
+    QAtomicInt nextJob(0);
+    QAtomicInt canceled(0);
+    int activeWorkers = workerCount;
+
+    auto worker = [&]() {
+        forever {
+            int const index = nextJob.fetchAndAddRelaxed(1);
+            if (index >= jobs.size() || canceled.loadAcquire()) {
+                break;
+            }
+            Result result = produce(jobs.at(index));
+            QMutexLocker locker(&mutex);
+            while (results.size() >= queueSize && !canceled.loadAcquire()) {
+                spaceAvailable.wait(&mutex);
+            }
+            results.enqueue(result);
+            resultAvailable.wakeOne();
+        }
+        QMutexLocker locker(&mutex);
+        --activeWorkers;
+        resultAvailable.wakeOne();
+    };
+
+    QVector<QFuture<void> > workers;
+    workers.reserve(workerCount);
+    for (int i = 0; i < workerCount; ++i) {
+        workers << QtConcurrent::run(worker);
+    }
+
+    forever {
+        QMutexLocker locker(&mutex);
+        while (results.isEmpty() && activeWorkers > 0) {
+            resultAvailable.wait(&mutex);
+        }
+        if (results.isEmpty()) {
+            break;
+        }
+        Result result = results.dequeue();
+        spaceAvailable.wakeOne();
+        locker.unlock();
+
+        if (!consume(result)) {
+            canceled.storeRelease(1);
+            locker.relock();
+            spaceAvailable.wakeAll();
+            break;
+        }
+    }
+
+    for (auto &future: workers) {
+        future.waitForFinished();
+    }
+    return !canceled.loadAcquire();
+}
+
+}
+
+#endif
@@ -25,25 +25,57 @@
 #include <QPair>
 #include <QStringBuilder>
 
+#include <algorithm>
+
 namespace Marble {
 
-VectorClipper::VectorClipper(GeoDataDocument* document, int maxZoomLevel) :
+namespace {
+
+bool filtersSmallAreas(int zoomLevel)
+{
+    return zoomLevel > 10 && zoomLevel < 17;
+}
+
+bool isInside(const TileId &tileId, const TileId &parent)
+{
+    int const levels = tileId.zoomLevel() - parent.zoomLevel();
+    return levels >= 0 && (tileId.x() >> levels) == parent.x() && (tileId.y() >> levels) == parent.y();
+}
+
+}
+
+VectorClipper::VectorClipper(GeoDataDocument* document, int maxZoomLevel, const ZoomLevelFilter &minimumZoomLevel) :
     m_maxZoomLevel(maxZoomLevel)
+{
+    addFeatures(document, nullptr, minimumZoomLevel);
+}
+
+VectorClipper::VectorClipper(GeoDataDocument* document, int maxZoomLevel, const Sources &sources, const QSet<GeoDataRelation*> &relations) :
+    m_maxZoomLevel(maxZoomLevel)
+{
+    addFeatures(document, &sources, ZoomLevelFilter());
+    // The relations of a clipped tile lack their members, keep using the original ones
+    m_relations = relations;
+}
+
+void VectorClipper::addFeatures(GeoDataDocument* document, const Sources *sources, const ZoomLevelFilter &minimumZoomLevel)
 {
     for (auto feature: document->featureList()) {
         if (const auto placemark = geodata_cast<GeoDataPlacemark>(feature)) {
             // Select zoom level such that the placemark fits in a single tile
             int zoomLevel;
             qreal north, south, east, west;
-            placemark->geometry()->latLonAltBox().boundaries(north, south, east, west);
-            for (zoomLevel = maxZoomLevel; zoomLevel >= 0; --zoomLevel) {
+            Item const item = { placemark, placemark->geometry()->latLonAltBox(),
+                                sources ? sources->value(placemark) : sourceOf(placemark, minimumZoomLevel) };
+            item.boundingBox.boundaries(north, south, east, west);
+            for (zoomLevel = m_maxZoomLevel; zoomLevel >= 0; --zoomLevel) {
                 if (TileId::fromCoordinates(GeoDataCoordinates(west, north), zoomLevel) ==
                         TileId::fromCoordinates(GeoDataCoordinates(east, south), zoomLevel)) {
                     break;
                 }
             }
             TileId const key = TileId::fromCoordinates(GeoDataCoordinates(west, north), zoomLevel);
-            m_items[key] << placemark;
+            m_items[key] << item;
         } else if (GeoDataRelation *relation = geodata_cast<GeoDataRelation>(feature)) {
             m_relations << relation;
         } else {
@@ -52,9 +84,28 @@ VectorClipper::VectorClipper(GeoDataDocument* document, int maxZoomLevel) :
     }
 }
 
-GeoDataDocument *VectorClipper::clipTo(const GeoDataLatLonBox &tileBoundary, int zoomLevel)
+VectorClipper::Source VectorClipper::sourceOf(const GeoDataPlacemark *placemark, const ZoomLevelFilter &minimumZoomLevel)
+{
+    Source source = { placemark->osmData().id(), minimumZoomLevel ? minimumZoomLevel(placemark) : 0, 0.0, QVector<qreal>() };
+    const GeoDataGeometry *geometry = placemark->geometry();
+    if (const auto building = geodata_cast<GeoDataBuilding>(geometry)) {
+        geometry = &static_cast<const GeoDataMultiGeometry*>(building->multiGeometry())->at(0);
+    }
+    if (const auto polygon = geodata_cast<GeoDataPolygon>(geometry)) {
+        source.area = area(polygon->outerBoundary());
+        for (auto const & innerBoundary: polygon->innerBoundaries()) {
+            source.innerAreas << area(innerBoundary);
+        }
+    } else if (const auto ring = geodata_cast<GeoDataLinearRing>(geometry)) {
+        source.area = area(*ring);
+    } else if (const auto lineString = geodata_cast<GeoDataLineString>(geometry)) {
+        source.area = area(*lineString);
+    }
+    return source;
+}
+
+GeoDataDocument *VectorClipper::clipTo(const GeoDataLatLonBox &tileBoundary, int zoomLevel, int featureZoomLevel, bool filterSmallAreas, Sources *sources) const
 {
-    bool const filterSmallAreas = zoomLevel > 10 && zoomLevel < 17;
     GeoDataDocument* tile = new GeoDataDocument();
     auto const clip = clipPath(tileBoundary, zoomLevel);
     GeoDataLinearRing ring;
@@ -64,24 +115,33 @@ GeoDataDocument *VectorClipper::clipTo(const GeoDataLatLonBox &tileBoundary, int
     ring << GeoDataCoordinates(tileBoundary.west(), tileBoundary.south());
     qreal const minArea = filterSmallAreas ? 0.01 * area(ring) : 0.0;
     QSet<qint64> osmIds;
-    for (GeoDataPlacemark const * placemark: potentialIntersections(tileBoundary)) {
+    for (auto const item: potentialIntersections(tileBoundary)) {
+        GeoDataPlacemark const * const placemark = item->placemark;
         GeoDataGeometry const * const geometry = placemark ? placemark->geometry() : nullptr;
-        if (geometry && tileBoundary.intersects(geometry->latLonAltBox())) {
+        Source const & source = item->source;
+        if (source.minZoomLevel > featureZoomLevel) {
+            continue;
+        }
+        if (geometry && tileBoundary.intersects(item->boundingBox)) {
             if (geodata_cast<GeoDataPolygon>(geometry)) {
-                clipPolygon(placemark, clip, minArea, tile, osmIds);
+                clipPolygon(placemark, source, clip, minArea, tile, osmIds, sources);
             } else if (geodata_cast<GeoDataLineString>(geometry)) {
-                clipString<GeoDataLineString>(placemark, clip, minArea, tile, osmIds);
+                clipString<GeoDataLineString>(placemark, source, clip, minArea, tile, osmIds, sources);
             } else if (geodata_cast<GeoDataLinearRing>(geometry)) {
-                clipString<GeoDataLinearRing>(placemark, clip, minArea, tile, osmIds);
+                clipString<GeoDataLinearRing>(placemark, source, clip, minArea, tile, osmIds, sources);
             } else if (const auto building = geodata_cast<GeoDataBuilding>(geometry)) {
                 if (geodata_cast<GeoDataPolygon>(&static_cast<const GeoDataMultiGeometry*>(building->multiGeometry())->at(0))) {
-                    clipPolygon(placemark, clip, minArea, tile, osmIds);
+                    clipPolygon(placemark, source, clip, minArea, tile, osmIds, sources);
                 } else if (geodata_cast<GeoDataLinearRing>(&static_cast<const GeoDataMultiGeometry*>(building->multiGeometry())->at(0))) {
-                    clipString<GeoDataLinearRing>(placemark, clip, minArea, tile, osmIds);
+                    clipString<GeoDataLinearRing>(placemark, source, clip, minArea, tile, osmIds, sources);
                 }
             } else {
-                tile->append(placemark->clone());
-                osmIds << placemark->osmData().id();
+                auto const copy = static_cast<GeoDataPlacemark*>(placemark->clone());
+                tile->append(copy);
+                osmIds << source.osmId;
+                if (sources) {
+                    sources->insert(copy, source);
+                }
             }
         }
     }
@@ -96,7 +156,7 @@ GeoDataDocument *VectorClipper::clipTo(const GeoDataLatLonBox &tileBoundary, int
     return tile;
 }
 
-QVector<GeoDataPlacemark *> VectorClipper::potentialIntersections(const GeoDataLatLonBox &box) const
+QVector<const VectorClipper::Item*> VectorClipper::potentialIntersections(const GeoDataLatLonBox &box) const
 {
     qreal north, south, east, west;
     box.boundaries(north, south, east, west);
@@ -107,30 +167,153 @@ QVector<GeoDataPlacemark *> VectorClipper::potentialIntersections(const GeoDataL
 
     TileCoordsPyramid pyramid(0, m_maxZoomLevel);
     pyramid.setBottomLevelCoords(rect);
-    QVector<GeoDataPlacemark *> result;
+    QVector<const Item*> result;
     for (int level = pyramid.topLevel(), maxLevel = pyramid.bottomLevel(); level <= maxLevel; ++level) {
         int x1, y1, x2, y2;
         pyramid.coords(level).getCoords(&x1, &y1, &x2, &y2);
         for (int x = x1; x <= x2; ++x) {
             for (int y = y1; y <= y2; ++y) {
-                result << m_items.value(TileId(0, level, x, y));
+                auto const iter = m_items.constFind(TileId(0, level, x, y));
+                if (iter != m_items.constEnd()) {
+                    for (auto const & item: iter.value()) {
+                        result << &item;
+                    }
+                }
             }
         }
     }
     return result;
 }
 
-GeoDataDocument *VectorClipper::clipTo(unsigned int zoomLevel, unsigned int tileX, unsigned int tileY)
+GeoDataDocument *VectorClipper::clipTo(unsigned int zoomLevel, unsigned int tileX, unsigned int tileY) const
 {
     const GeoDataLatLonBox tileBoundary = m_tileProjection.geoCoordinates(zoomLevel, tileX, tileY);
 
-    GeoDataDocument *tile = clipTo(tileBoundary, zoomLevel);
+    GeoDataDocument *tile = clipTo(tileBoundary, zoomLevel, zoomLevel, filtersSmallAreas(zoomLevel), nullptr);
     QString tileName = QString("%1/%2/%3").arg(zoomLevel).arg(tileX).arg(tileY);
     tile->setName(tileName);
 
     return tile;
 }
 
+void VectorClipper::clipRecursively(const TileId &tileId, const QVector<int> &zoomLevels, const TileHandler &handler) const
+{
+    TileSelection selection;
+    selection.zoomLevels = zoomLevels;
+    selection.maxZoomLevel = *std::max_element(zoomLevels.constBegin(), zoomLevels.constEnd());
+    clipRecursively(tileId, selection, handler);
+}
+
+void VectorClipper::clipRecursively(const TileId &tileId, const QSet<TileId> &tileIds, const TileHandler &handler) const
+{
+    TileSelection selection;
+    selection.maxZoomLevel = -1;
+    for (auto const & id: tileIds) {
+        if (!isInside(id, tileId)) {
+            continue;
+        }
+        selection.tileIds << id;
+        selection.maxZoomLevel = qMax(selection.maxZoomLevel, id.zoomLevel());
+        if (!selection.zoomLevels.contains(id.zoomLevel())) {
+            selection.zoomLevels << id.zoomLevel();
+        }
+        for (int level = id.zoomLevel() - 1; level >= tileId.zoomLevel(); --level) {
+            int const levels = id.zoomLevel() - level;
+            TileId const ancestor(0, level, id.x() >> levels, id.y() >> levels);
+            if (selection.ancestors.contains(ancestor)) {
+                break;
+            }
+            selection.ancestors << ancestor;
+        }
+    }
+    if (!selection.tileIds.isEmpty()) {
+        clipRecursively(tileId, selection, handler);
+    }
+}
+
+void VectorClipper::clipRecursively(const TileId &tileId, const TileSelection &selection, const TileHandler &handler) const
+{
+    int const zoomLevel = tileId.zoomLevel();
+    bool const isWanted = selection.contains(tileId);
+    if (!selection.hasTilesBelow(tileId)) {
+        if (isWanted) {
+            handler(clipTo(zoomLevel, tileId.x(), tileId.y()), tileId);
+        }
+        return;
+    }
+
+    // The input of the children, small areas and placemarks of deeper zoom levels are kept for them
+    Sources sources;
+    const GeoDataLatLonBox tileBoundary = m_tileProjection.geoCoordinates(zoomLevel, tileId.x(), tileId.y());
+    std::unique_ptr<GeoDataDocument> tile(clipTo(tileBoundary, zoomLevel, selection.maxZoomLevel, false, &sources));
+    tile->setName(QString("%1/%2/%3").arg(zoomLevel).arg(tileId.x()).arg(tileId.y()));
+    if (tile->isEmpty()) {
+        passEmptyTiles(tileId, selection, handler);
+        return;
+    }
+
+    {
+        VectorClipper const clipper(tile.get(), m_maxZoomLevel, sources, m_relations);
+        for (int i = 0; i < 4; ++i) {
+            TileId const child(0, zoomLevel + 1, 2 * tileId.x() + (i & 1), 2 * tileId.y() + (i >> 1));
+            if (selection.visits(child)) {
+                clipper.clipRecursively(child, selection, handler);
+            }
+        }
+    }
+
+    if (isWanted) {
+        bool const hasDeeperPlacemarks = std::any_of(sources.constBegin(), sources.constEnd(), [zoomLevel](const Source &source) {
+            return source.minZoomLevel > zoomLevel;
+        });
+        if (filtersSmallAreas(zoomLevel) || hasDeeperPlacemarks) {
+            handler(clipTo(zoomLevel, tileId.x(), tileId.y()), tileId);
+        } else {
+            // Without any filtering the input of the children is the tile itself
+            handler(tile.release(), tileId);
+        }
+    }
+}
+
+void VectorClipper::passEmptyTiles(const TileId &tileId, const TileSelection &selection, const TileHandler &handler) const
+{
+    if (!selection.tileIds.isEmpty()) {
+        for (auto const & id: selection.tileIds) {
+            if (isInside(id, tileId)) {
+                handler(nullptr, id);
+            }
+        }
+        return;
+    }
+
+    for (int zoomLevel: selection.zoomLevels) {
+        int const levels = zoomLevel - tileId.zoomLevel();
+        if (levels >= 0) {
+            int const size = 1 << levels;
+            for (int x = tileId.x() * size; x < (tileId.x() + 1) * size; ++x) {
+                for (int y = tileId.y() * size; y < (tileId.y() + 1) * size; ++y) {
+                    handler(nullptr, TileId(0, zoomLevel, x, y));
+                }
+            }
+        }
+    }
+}
+
+bool VectorClipper::TileSelection::contains(const TileId &tileId) const
+{
+    return tileIds.isEmpty() ? zoomLevels.contains(tileId.zoomLevel()) : tileIds.contains(tileId);
+}
+
+bool VectorClipper::TileSelection::visits(const TileId &tileId) const
+{
+    return tileIds.isEmpty() || tileIds.contains(tileId) || ancestors.contains(tileId);
+}
+
+bool VectorClipper::TileSelection::hasTilesBelow(const TileId &tileId) const
+{
+    return tileId.zoomLevel() < maxZoomLevel && (tileIds.isEmpty() || ancestors.contains(tileId));
+}
+
 ClipperLib::Path VectorClipper::clipPath(const GeoDataLatLonBox &box, int zoomLevel) const
 {
     using namespace ClipperLib;
@@ -182,7 +365,7 @@ bool VectorClipper::canBeArea(GeoDataPlacemark::GeoDataVisualCategory visualCate
     return true;
 }
 
-qreal VectorClipper::area(const GeoDataLinearRing &ring)
+qreal VectorClipper::area(const GeoDataLineString &ring)
 {
     int const n = ring.size();
     qreal area = 0;
@@ -218,29 +401,30 @@ void VectorClipper::getBounds(const ClipperLib::Path &path, ClipperLib::cInt &mi
     }
 }
 
-void VectorClipper::clipPolygon(const GeoDataPlacemark *placemark, const ClipperLib::Path &tileBoundary, qreal minArea,
-                                GeoDataDocument *document, QSet<qint64> &osmIds)
+void VectorClipper::clipPolygon(const GeoDataPlacemark *placemark, const Source &source, const ClipperLib::Path &tileBoundary, qreal minArea,
+                                GeoDataDocument *document, QSet<qint64> &osmIds, Sources *sources) const
 {
     bool isBuilding = false;
-    GeoDataPolygon* polygon;
+    const GeoDataPolygon* polygon;
     std::unique_ptr<GeoDataPlacemark> copyPlacemark;
     if (const auto building = geodata_cast<GeoDataBuilding>(placemark->geometry())) {
-        polygon = geodata_cast<GeoDataPolygon>(&static_cast<GeoDataMultiGeometry*>(building->multiGeometry())->at(0));
+        polygon = geodata_cast<GeoDataPolygon>(&static_cast<const GeoDataMultiGeometry*>(building->multiGeometry())->at(0));
         isBuilding = true;
     } else {
         copyPlacemark.reset(new GeoDataPlacemark(*placemark));
         polygon = geodata_cast<GeoDataPolygon>(copyPlacemark->geometry());
     }
 
-    if (minArea > 0.0 && area(polygon->outerBoundary()) < minArea) {
+    if (minArea > 0.0 && source.area < minArea) {
         return;
     }
     using namespace ClipperLib;
     Path path;
-    QHash<std::pair<cInt, cInt>, const GeoDataCoordinates*> coordMap;
-    for(auto const & node: qAsConst(polygon)->outerBoundary()) {
-        auto p = coordinateToPoint(node);
-        coordMap.insert(std::make_pair(p.X, p.Y), &node);
+    QHash<std::pair<cInt, cInt>, int> coordMap;
+    auto const & outerBoundary = polygon->outerBoundary();
+    for (int i = 0; i < outerBoundary.size(); ++i) {
+        auto p = coordinateToPoint(outerBoundary.at(i));
+        coordMap.insert(std::make_pair(p.X, p.Y), i);
         path.push_back(std::move(p));
     }
 
@@ -262,10 +446,11 @@ void VectorClipper::clipPolygon(const GeoDataPlacemark *placemark, const Clipper
         int index = -1;
         OsmPlacemarkData const & outerRingOsmData = placemarkOsmData.memberReference(index);
         OsmPlacemarkData & newOuterRingOsmData = newPlacemarkOsmData.memberReference(index);
-        pathToRing(path, &outerRing, outerRingOsmData, newOuterRingOsmData, coordMap);
+        pathToRing(path, &outerRing, outerBoundary, outerRingOsmData, newOuterRingOsmData, coordMap);
 
         GeoDataPolygon* newPolygon = new GeoDataPolygon;
         newPolygon->setOuterBoundary(outerRing);
+        Source newSource = { source.osmId, source.minZoomLevel, source.area, QVector<qreal>() };
         if (isBuilding) {
             const auto building = geodata_cast<GeoDataBuilding>(placemark->geometry());
             GeoDataBuilding* newBuilding = new GeoDataBuilding(*building);
@@ -284,10 +469,11 @@ void VectorClipper::clipPolygon(const GeoDataPlacemark *placemark, const Clipper
             newOuterRingOsmData.addTag(QStringLiteral("mx:oid"), QString::number(outerRingOsmData.id()));
         }
 
-        auto const & innerBoundaries = qAsConst(polygon)->innerBoundaries();
+        auto const & innerBoundaries = polygon->innerBoundaries();
         for (index = 0; index < innerBoundaries.size(); ++index) {
             auto const & innerBoundary = innerBoundaries.at(index);
-            if (minArea > 0.0 && area(innerBoundary) < minArea) {
+            qreal const innerArea = index < source.innerAreas.size() ? source.innerAreas[index] : area(innerBoundary);
+            if (minArea > 0.0 && innerArea < minArea) {
                 continue;
             }
 
@@ -296,9 +482,9 @@ void VectorClipper::clipPolygon(const GeoDataPlacemark *placemark, const Clipper
             clipper.AddPath(path, ptClip, true);
             Path innerPath;
             coordMap.clear();
-            for(auto const & node: innerBoundary) {
-                auto p = coordinateToPoint(node);
-                coordMap.insert(std::make_pair(p.X, p.Y), &node);
+            for (int i = 0; i < innerBoundary.size(); ++i) {
+                auto p = coordinateToPoint(innerBoundary.at(i));
+                coordMap.insert(std::make_pair(p.X, p.Y), i);
                 innerPath.push_back(std::move(p));
             }
             clipper.AddPath(innerPath, ptSubject, true);
@@ -308,8 +494,9 @@ void VectorClipper::clipPolygon(const GeoDataPlacemark *placemark, const Clipper
                 int const newIndex = newPolygon->innerBoundaries().size();
                 auto & newInnerRingOsmData = newPlacemarkOsmData.memberReference(newIndex);
                 GeoDataLinearRing innerRing;
-                pathToRing(innerPath, &innerRing, innerRingOsmData, newInnerRingOsmData, coordMap);
+                pathToRing(innerPath, &innerRing, innerBoundary, innerRingOsmData, newInnerRingOsmData, coordMap);
                 newPolygon->appendInnerBoundary(innerRing);
+                newSource.innerAreas << innerArea;
                 if (innerRingOsmData.id() > 0) {
                     newInnerRingOsmData.addTag(QStringLiteral("mx:oid"), QString::number(innerRingOsmData.id()));
                 }
@@ -319,7 +506,10 @@ void VectorClipper::clipPolygon(const GeoDataPlacemark *placemark, const Clipper
 
         OsmObjectManager::initializeOsmData(newPlacemark);
         document->append(newPlacemark);
-        osmIds << placemark->osmData().id();
+        osmIds << source.osmId;
+        if (sources) {
+            sources->insert(newPlacemark, newSource);
+        }
     }
 }
 
@@ -14,7 +14,7 @@
 
 #include "OsmPlacemarkData.h"
 
-#include <GeoDataLatLonBox.h>
+#include <GeoDataLatLonAltBox.h>
 #include "GeoDataPlacemark.h"
 #include "GeoDataLinearRing.h"
 #include "GeoDataBuilding.h"
@@ -25,9 +25,11 @@
 #include "GeoDataDocument.h"
 
 #include "clipper/clipper.hpp"
+#include <QHash>
 #include <QMap>
 #include <QSet>
 
+#include <functional>
 #include <memory>
 
 namespace Marble {
@@ -38,16 +40,89 @@ class GeoDataRelation;
 class VectorClipper
 {
 public:
-    VectorClipper(GeoDataDocument* document, int maxZoomLevel);
+    /** Returns the lowest zoom level whose tiles contain the given placemark */
+    using ZoomLevelFilter = std::function<int(const GeoDataPlacemark *placemark)>;
+
+    /**
+     * Without a @p minimumZoomLevel filter, all placemarks of the input document go into the
+     * tiles of every zoom level.
+     */
+    VectorClipper(GeoDataDocument* document, int maxZoomLevel, const ZoomLevelFilter &minimumZoomLevel = ZoomLevelFilter());
+
+    /**
+     * Returns a new document with the features of the input document clipped to the given tile.
+     * Placemarks whose minimum zoom level is above @p zoomLevel are left out.
+     * Only reads the input document, so tiles can be clipped from several threads at once as
+     * long as the input document stays unchanged and alive.
+     */
+    GeoDataDocument* clipTo(unsigned int zoomLevel, unsigned int tileX, unsigned int tileY) const;
+
+    /** Receives a clipped tile and takes ownership of it. Tiles known to be empty are passed as nullptr. */
+    using TileHandler = std::function<void(GeoDataDocument *tile, const TileId &tileId)>;
+
+    /**
+     * Clips @p tileId and all tiles below it at the given @p zoomLevels, with the same placemarks as
+     * calling clipTo() for each of them. Instead of clipping the whole input document to every
+     * tile, each tile is clipped from the already clipped features of its parent tile, so deep
+     * zoom levels no longer clip the same large geometries over and over again. Where the piece
+     * of a parent tile is cut again, its vertices can differ from clipTo() by the rounding to
+     * clipper coordinates. The tiles are visited depth-first, which bounds memory by the clipped
+     * tiles along a single path. Like clipTo(), this can be called from several threads at once.
+     */
+    void clipRecursively(const TileId &tileId, const QVector<int> &zoomLevels, const TileHandler &handler) const;
+
+    /**
+     * Like the above, but only clips the given @p tileIds that lie below or at @p tileId and
+     * only descends into tiles that contain some of them. Other tiles are not passed to @p handler.
+     */
+    void clipRecursively(const TileId &tileId, const QSet<TileId> &tileIds, const TileHandler &handler) const;
 
-    GeoDataDocument* clipTo(unsigned int zoomLevel, unsigned int tileX, unsigned int tileY);
     static bool canBeArea(GeoDataPlacemark::GeoDataVisualCategory visualCategory);
 
 private:
-    GeoDataDocument* clipTo(const GeoDataLatLonBox &box, int zoomLevel);
-    QVector<GeoDataPlacemark*> potentialIntersections(const GeoDataLatLonBox &box) const;
+    /** What a clipped placemark keeps of the input placemark it was cut out of */
+    struct Source
+    {
+        qint64 osmId;
+        int minZoomLevel;
+        // Small areas are filtered by the size of the rings before any clipping
+        qreal area;
+        QVector<qreal> innerAreas;
+    };
+    using Sources = QHash<const GeoDataPlacemark*, Source>;
+
+    struct Item
+    {
+        const GeoDataPlacemark *placemark;
+        // Computed up front, geometries determine their bounding box lazily
+        GeoDataLatLonAltBox boundingBox;
+        Source source;
+    };
+
+    /** The tiles clipRecursively() passes to its handler */
+    struct TileSelection
+    {
+        QVector<int> zoomLevels;
+        int maxZoomLevel;
+        // Restricts the selection to these tiles when not empty, then only their ancestors are visited
+        QSet<TileId> tileIds;
+        QSet<TileId> ancestors;
+
+        bool contains(const TileId &tileId) const;
+        bool visits(const TileId &tileId) const;
+        bool hasTilesBelow(const TileId &tileId) const;
+    };
+
+    VectorClipper(GeoDataDocument* document, int maxZoomLevel, const Sources &sources, const QSet<GeoDataRelation*> &relations);
+    void addFeatures(GeoDataDocument* document, const Sources *sources, const ZoomLevelFilter &minimumZoomLevel);
+    static Source sourceOf(const GeoDataPlacemark *placemark, const ZoomLevelFilter &minimumZoomLevel);
+
+    GeoDataDocument* clipTo(const GeoDataLatLonBox &box, int zoomLevel, int featureZoomLevel, bool filterSmallAreas, Sources *sources) const;
+    void clipRecursively(const TileId &tileId, const TileSelection &selection, const TileHandler &handler) const;
+    void passEmptyTiles(const TileId &tileId, const TileSelection &selection, const TileHandler &handler) const;
+    QVector<const Item*> potentialIntersections(const GeoDataLatLonBox &box) const;
     ClipperLib::Path clipPath(const GeoDataLatLonBox &box, int zoomLevel) const;
-    qreal area(const GeoDataLinearRing &ring);
+    static qreal area(const GeoDataLineString &ring);
     void getBounds(const ClipperLib::Path &path, ClipperLib::cInt &minX, ClipperLib::cInt &maxX, ClipperLib::cInt &minY, ClipperLib::cInt &maxY) const;
 
     // convert radian-based coordinates to 10^-7 degree (100 nanodegree) integer coordinates used by the clipper library
@@ -62,16 +137,16 @@ private:
     }
 
     template<class T>
-    static void pathToRing(const ClipperLib::Path &path, T *ring, const OsmPlacemarkData &originalOsmData, OsmPlacemarkData &newOsmData, const QHash<std::pair<ClipperLib::cInt, ClipperLib::cInt>, const GeoDataCoordinates*> &coordMap)
+    static void pathToRing(const ClipperLib::Path &path, T *ring, const GeoDataLineString &originalRing, const OsmPlacemarkData &originalOsmData, OsmPlacemarkData &newOsmData, const QHash<std::pair<ClipperLib::cInt, ClipperLib::cInt>, int> &coordMap)
     {
         int index = 0;
         for(const auto &point: path) {
             const auto it = coordMap.find(std::make_pair(point.X, point.Y));
             if (it != coordMap.end()) {
-                *ring << *it.value();
-                auto const data = originalOsmData.nodeReference(*it.value());
+                *ring << originalRing.at(it.value());
+                auto const data = originalOsmData.nodeReference(it.value());
                 if (data.id() > 0) {
-                    newOsmData.addNodeReference(*it.value(), data);
+                    newOsmData.addNodeReference(index, data);
                 }
             } else {
                 *ring << pointToCoordinate(point);
@@ -81,8 +156,8 @@ private:
     }
 
     template<class T>
-    void clipString(const GeoDataPlacemark *placemark, const ClipperLib::Path &tileBoundary, qreal minArea,
-                    GeoDataDocument* document, QSet<qint64> &osmIds)
+    void clipString(const GeoDataPlacemark *placemark, const Source &source, const ClipperLib::Path &tileBoundary, qreal minArea,
+                    GeoDataDocument* document, QSet<qint64> &osmIds, Sources *sources) const
     {
         bool isBuilding = false;
         const T* ring;
@@ -96,15 +171,15 @@ private:
         }
         auto const & osmData = placemark->osmData();
         bool const isClosed = ring->isClosed() && (canBeArea(placemark->visualCategory()) || osmData.tagValue(QStringLiteral("area")) == QLatin1String("yes"));
-        if (isClosed && minArea > 0.0 && area(*static_cast<const GeoDataLinearRing*>(ring)) < minArea) {
+        if (isClosed && minArea > 0.0 && source.area < minArea) {
             return;
         }
         using namespace ClipperLib;
         Path subject;
-        QHash<std::pair<cInt, cInt>, const GeoDataCoordinates*> coordMap;
-        for(auto const & node: *ring) {
-            auto p = coordinateToPoint(node);
-            coordMap.insert(std::make_pair(p.X, p.Y), &node);
+        QHash<std::pair<cInt, cInt>, int> coordMap;
+        for (int i = 0; i < ring->size(); ++i) {
+            auto p = coordinateToPoint(ring->at(i));
+            coordMap.insert(std::make_pair(p.X, p.Y), i);
             subject.push_back(std::move(p));
         }
         cInt minX, maxX, minY, maxY;
@@ -127,7 +202,7 @@ private:
             newPlacemark->setVisible(placemark->isVisible());
             newPlacemark->setVisualCategory(placemark->visualCategory());
             T* newRing = new T;
-            pathToRing(path, newRing, osmData, newPlacemark->osmData(), coordMap);
+            pathToRing(path, newRing, *ring, osmData, newPlacemark->osmData(), coordMap);
 
             if (isBuilding) {
                 const auto building = geodata_cast<GeoDataBuilding>(placemark->geometry());
@@ -144,17 +219,20 @@ private:
             copyTags(*placemark, *newPlacemark);
             OsmObjectManager::initializeOsmData(newPlacemark);
             document->append(newPlacemark);
-            osmIds << placemark->osmData().id();
+            osmIds << source.osmId;
+            if (sources) {
+                sources->insert(newPlacemark, source);
+            }
         }
     }
 
-    void clipPolygon(const GeoDataPlacemark *placemark, const ClipperLib::Path &tileBoundary, qreal minArea,
-                     GeoDataDocument* document, QSet<qint64> &osmIds);
+    void clipPolygon(const GeoDataPlacemark *placemark, const Source &source, const ClipperLib::Path &tileBoundary, qreal minArea,
+                     GeoDataDocument* document, QSet<qint64> &osmIds, Sources *sources) const;
 
     void copyTags(const GeoDataPlacemark &source, GeoDataPlacemark &target) const;
     void copyTags(const OsmPlacemarkData &originalPlacemarkData, OsmPlacemarkData& targetOsmData) const;
 
-    QMap<TileId, QVector<GeoDataPlacemark*> > m_items;
+    QMap<TileId, QVector<Item> > m_items;
     int m_maxZoomLevel;
     GeoSceneMercatorTileProjection m_tileProjection;
     QSet<GeoDataRelation*> m_relations;
@@ -13,6 +13,8 @@
 #include <QVector>
 #include <QDebug>
 
+#include <algorithm>
+
 #include "GeoDataCoordinates.h"
 #include "GeoDataLineString.h"
 #include "OsmPlacemarkData.h"
@@ -69,11 +71,20 @@ WayChunk::PlacemarkPtr WayChunk::merge()
 
     PlacemarkPtr placemark = PlacemarkPtr(new GeoDataPlacemark(*(m_wayList.first())));
     GeoDataLineString *line = static_cast<GeoDataLineString*>(placemark->geometry());
+    OsmPlacemarkData &osmData = placemark->osmData();
     QVector<PlacemarkPtr>::iterator itr = m_wayList.begin();
     QVector<PlacemarkPtr>::iterator itrEnd = m_wayList.end();
     ++itr;
     for (; itr != itrEnd; ++itr) {
         GeoDataLineString *currentLine = static_cast<GeoDataLineString*>( (*itr)->geometry() );
+        // The first node is shared with the end of the line
+        int const offset = line->size() - 1;
+        const OsmPlacemarkData &currentOsmData = (*itr)->osmData();
+        for (auto iter = currentOsmData.nodeReferencesBegin(); iter != currentOsmData.nodeReferencesEnd(); ++iter) {
+            if (iter.key() > 0) {
+                osmData.addNodeReference(offset + iter.key(), iter.value());
+            }
+        }
         currentLine->remove(0);
         (*line) << *currentLine;
     }
@@ -85,12 +96,22 @@ void WayChunk::reverse()
     std::reverse(m_wayList.begin(), m_wayList.end());
     QVector<PlacemarkPtr>::iterator itr = m_wayList.begin();
     for (; itr != m_wayList.end(); ++itr) {
-        GeoDataLineString *line = static_cast<GeoDataLineString*>((*itr)->geometry());
-        line->reverse();
+        reverseWay(itr->data());
     }
     qSwap(m_first, m_last);
 }
 
+void WayChunk::reverseWay(GeoDataPlacemark *placemark)
+{
+    GeoDataLineString *line = static_cast<GeoDataLineString*>(placemark->geometry());
+    line->reverse();
+    QVector<OsmPlacemarkData> &nodeReferences = placemark->osmData().nodeReferences();
+    if (!nodeReferences.isEmpty()) {
+        nodeReferences.resize(line->size());
+        std::reverse(nodeReferences.begin(), nodeReferences.end());
+    }
+}
+
 int WayChunk::size() const
 {
     return m_wayList.size();
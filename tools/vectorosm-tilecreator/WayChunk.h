@@ -46,6 +46,11 @@ public:
     int size() const;
     bool concatPossible(const GeoDataPlacemark &placemark) const;
 
+    /*
+     * Reverses the linestring of the placemark along with its node references
+     */
+    static void reverseWay(GeoDataPlacemark *placemark);
+
 private:
     bool isTunnel(const OsmPlacemarkData &osmData) const;
 
@@ -42,8 +42,8 @@ WayConcatenator::WayConcatenator(GeoDataDocument *document) :
                         osmData.containsTagKey("waterway");
                 if (isWay) {
                     GeoDataLineString *line = static_cast<GeoDataLineString*>(placemark->geometry());
-                    qint64 firstId = osmData.nodeReference(line->first()).oid();
-                    qint64 lastId = osmData.nodeReference(line->last()).oid();
+                    qint64 firstId = osmData.nodeReference(0).oid();
+                    qint64 lastId = osmData.nodeReference(line->size() - 1).oid();
                     if (firstId > 0 && lastId > 0) {
                         ++m_originalWays;
                         bool containsFirst = m_hash.contains(firstId);
@@ -162,8 +162,8 @@ WayChunk::Ptr WayConcatenator::wayChunk(const GeoDataPlacemark &placemark, qint6
 void WayConcatenator::concatFirst(const PlacemarkPtr &placemark, const WayChunk::Ptr &chunk)
 {
     GeoDataLineString *line = static_cast<GeoDataLineString*>(placemark->geometry());
-    qint64 firstId = placemark->osmData().nodeReference(line->first()).oid();
-    qint64 lastId = placemark->osmData().nodeReference(line->last()).oid();
+    qint64 firstId = placemark->osmData().nodeReference(0).oid();
+    qint64 lastId = placemark->osmData().nodeReference(line->size() - 1).oid();
 
     if (chunk->first() != chunk->last()) {
         int chunksRemoved = m_hash.remove(firstId, chunk);
@@ -177,7 +177,7 @@ void WayConcatenator::concatFirst(const PlacemarkPtr &placemark, const WayChunk:
     } else {
         //First node matches with an existing first node
         //Reverse the GeoDataLineString of the placemark
-        line->reverse();
+        WayChunk::reverseWay(placemark.data());
         chunk->prepend(placemark, lastId);
     }
 }
@@ -185,8 +185,8 @@ void WayConcatenator::concatFirst(const PlacemarkPtr &placemark, const WayChunk:
 void WayConcatenator::concatLast(const PlacemarkPtr &placemark, const WayChunk::Ptr &chunk)
 {
     GeoDataLineString *line = static_cast<GeoDataLineString*>(placemark->geometry());
-    qint64 firstId = placemark->osmData().nodeReference(line->first()).oid();
-    qint64 lastId = placemark->osmData().nodeReference(line->last()).oid();
+    qint64 firstId = placemark->osmData().nodeReference(0).oid();
+    qint64 lastId = placemark->osmData().nodeReference(line->size() - 1).oid();
 
     if (chunk->first() != chunk->last()) {
         int chunksRemoved = m_hash.remove(lastId, chunk);
@@ -197,7 +197,7 @@ void WayConcatenator::concatLast(const PlacemarkPtr &placemark, const WayChunk::
     if (lastId == chunk->first()) {
         chunk->prepend(placemark, firstId);
     } else {
-        line->reverse();
+        WayChunk::reverseWay(placemark.data());
         chunk->append(placemark, firstId);
     }
 }
@@ -205,8 +205,8 @@ void WayConcatenator::concatLast(const PlacemarkPtr &placemark, const WayChunk::
 void WayConcatenator::concatBoth(const PlacemarkPtr &placemark, const WayChunk::Ptr &chunk, const WayChunk::Ptr &otherChunk)
 {
     GeoDataLineString *line = static_cast<GeoDataLineString*>(placemark->geometry());
-    qint64 firstId = placemark->osmData().nodeReference(line->first()).oid();
-    qint64 lastId = placemark->osmData().nodeReference(line->last()).oid();
+    qint64 firstId = placemark->osmData().nodeReference(0).oid();
+    qint64 lastId = placemark->osmData().nodeReference(line->size() - 1).oid();
 
     int chunksRemoved;
     if (chunk->first() != chunk->last()) {
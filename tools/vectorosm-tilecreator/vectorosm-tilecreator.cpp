@@ -43,6 +43,8 @@
 #include "TileDirectory.h"
 #include "MbTileWriter.h"
 #include "SpellChecker.h"
+#include "TagsFilter.h"
+#include "TileWorkerPool.h"
 
 #ifdef STATIC_BUILD
 #include <QtPlugin>
@@ -51,6 +53,7 @@ Q_IMPORT_PLUGIN(ShpPlugin)
 #endif
 
 #include <iostream>
+#include <memory>
 
 using namespace Marble;
 
@@ -119,16 +122,129 @@ QSharedPointer<GeoDataDocument> mergeBoundaryTiles(const QSharedPointer<GeoDataD
     return QSharedPointer<GeoDataDocument>(mergedMap);
 }
 
-bool writeTile(GeoDataDocument* tile, const QString &outputFile)
+bool writeTile(const GeoDataDocument &tile, const QString &outputFile)
 {
     QDir().mkpath(QFileInfo(outputFile).path());
-    if (!GeoDataDocumentWriter::write(outputFile, *tile)) {
+    if (!GeoDataDocumentWriter::write(outputFile, tile)) {
         qWarning() << "Could not write the file " << outputFile;
         return false;
     }
     return true;
 }
 
+struct TileJob
+{
+    TileId tileId;
+    QString filename;
+};
+
+/** The tiles at the given zoom levels below and including the root tile, or just the given tiles if there are any */
+struct TileTree
+{
+    TileId root;
+    QVector<int> zoomLevels;
+    QSet<TileId> tileIds;
+};
+
+struct TileResult
+{
+    enum Status {
+        Empty,
+        Sea,
+        Stored,
+        NeedsMerge,
+        Failed
+    };
+
+    TileJob job;
+    Status status = Empty;
+    // The encoded tile if it goes into the mbtile database
+    QByteArray data;
+    QSharedPointer<GeoDataDocument> landmass;
+    double nodeReduction = 0.0;
+    int originalWays = 0;
+    int mergedWays = 0;
+};
+
+double nodeReduction(const NodeReducer &nodeReducer)
+{
+    return nodeReducer.removedNodes() / qMax(1.0, double(nodeReducer.remainingNodes() + nodeReducer.removedNodes()));
+}
+
+/** Writes the tile to its file, or encodes it into @p data if it is meant for the mbtile database */
+TileResult::Status storeTile(const GeoDataDocument &tile, const TileJob &job, const QString &extension, bool toMbTile, QByteArray &data)
+{
+    if (toMbTile) {
+        QBuffer buffer(&data);
+        buffer.open(QBuffer::WriteOnly);
+        if (!GeoDataDocumentWriter::write(&buffer, tile, extension)) {
+            qWarning() << "Could not write the tile " << tile.name();
+            data.clear();
+        }
+        return TileResult::Stored;
+    }
+    return writeTile(tile, job.filename) ? TileResult::Stored : TileResult::Failed;
+}
+
+class TileProgress
+{
+public:
+    explicit TileProgress(qint64 total) :
+        m_total(total)
+    {
+        m_timer.start();
+    }
+
+    /** Counts a tile that already exists */
+    void skip()
+    {
+        ++m_count;
+    }
+
+    void print(const TileResult &result)
+    {
+        ++m_count;
+        ++m_processed;
+        auto const & tileId = result.job.tileId;
+        TileDirectory::printProgress(m_count / double(m_total));
+        if (result.status == TileResult::Sea) {
+            std::cout << "  Skipping sea tile ";
+        } else if (result.status == TileResult::Empty) {
+            std::cout << "  Skipping empty tile ";
+        } else {
+            std::cout << "  Tile ";
+        }
+        std::cout << m_count << "/" << m_total << " (" << tileId.zoomLevel() << '/' << tileId.x() << '/' << tileId.y() << ").";
+        if (result.status == TileResult::Stored) {
+            std::cout << " Node reduction: " << qRound(result.nodeReduction * 100.0) << "%";
+            if (result.originalWays > 0) {
+                std::cout << " , " << result.originalWays << " ways merged to " << result.mergedWays;
+            }
+        }
+        std::cout << ", " << qRound(tilesPerSecond()) << " tiles/s";
+        std::cout << std::string(20, ' ') << '\r';
+        std::cout.flush();
+    }
+
+    void finish() const
+    {
+        TileDirectory::printProgress(1.0);
+        std::cout << "  Vector OSM tiles complete, " << m_processed << " tiles created at ";
+        std::cout << qRound(tilesPerSecond()) << " tiles/s." << std::string(30, ' ') << std::endl;
+    }
+
+private:
+    double tilesPerSecond() const
+    {
+        return m_processed * 1000.0 / qMax(qint64(1), m_timer.elapsed());
+    }
+
+    qint64 m_count = 0;
+    qint64 m_processed = 0;
+    qint64 const m_total;
+    QElapsedTimer m_timer;
+};
+
 int main(int argc, char *argv[])
 {
     QCoreApplication app(argc, argv);
@@ -169,7 +285,7 @@ int main(int argc, char *argv[])
     QString const extension = parser.value("extension");
     QString inputFileName = args.at(0);
     auto const levels = parser.value("zoom-level").split(',');
-    QVector<unsigned int> zoomLevels;
+    QVector<int> zoomLevels;
     int maxZoomLevel = 0;
     for(auto const &level: levels) {
         int const zoomLevel = level.toInt();
@@ -209,42 +325,93 @@ int main(int argc, char *argv[])
 
     if (*zoomLevels.cbegin() <= 9) {
         auto map = TileDirectory::open(inputFileName, manager);
-        VectorClipper processor(map.data(), maxZoomLevel);
+        VectorClipper const processor(map.data(), maxZoomLevel);
         GeoDataLatLonBox world(85.0, -85.0, 180.0, -180.0, GeoDataCoordinates::Degree);
         if (parser.isSet("spellcheck")) {
             SpellChecker spellChecker(parser.value("spellcheck"));
             spellChecker.setVerbose(parser.isSet("verbose"));
             spellChecker.correctPlaceLabels(map.data()->placemarkList());
         }
+        // Each job clips the tiles below a tile of the tree level from their parents,
+        // the few tiles of lower levels are clipped on their own
+        int const treeLevel = qMin(3, maxZoomLevel);
+        QVector<TileTree> jobs;
+        QVector<int> treeZoomLevels;
+        qint64 total = 0;
         for(auto zoomLevel: zoomLevels) {
             TileIterator iter(world, zoomLevel);
-            qint64 count = 0;
-            qint64 const total = iter.total();
-            for(auto const &tileId: iter) {
-                ++count;
-                QString const filename = tileFileName(parser, tileId.x(), tileId.y(), zoomLevel);
-                if (!overwriteTiles && QFileInfo(filename).exists()) {
-                    continue;
+            total += iter.total();
+            if (zoomLevel >= treeLevel) {
+                treeZoomLevels << zoomLevel;
+            } else {
+                for(auto const &tileId: iter) {
+                    jobs << TileTree{TileId(0, zoomLevel, tileId.x(), tileId.y()), QVector<int>() << zoomLevel, QSet<TileId>()};
                 }
-                GeoDataDocument* tile = processor.clipTo(zoomLevel, tileId.x(), tileId.y());
-                if (!tile->isEmpty()) {
-                    NodeReducer nodeReducer(tile, TileId(0, zoomLevel, tileId.x(), tileId.y()));
-                    if (!writeTile(tile, filename)) {
-                        return 4;
+            }
+        }
+        if (!treeZoomLevels.isEmpty()) {
+            TileIterator iter(world, treeLevel);
+            for(auto const &tileId: iter) {
+                jobs << TileTree{TileId(0, treeLevel, tileId.x(), tileId.y()), treeZoomLevels, QSet<TileId>()};
+            }
+        }
+
+        TileProgress progress(total);
+        if (!overwriteTiles) {
+            // Only the missing tiles are clipped, trees without any are left out
+            QVector<TileTree> missingJobs;
+            for (auto tree: jobs) {
+                for (int zoomLevel: tree.zoomLevels) {
+                    int const levels = zoomLevel - tree.root.zoomLevel();
+                    int const size = 1 << levels;
+                    for (int x = tree.root.x() * size; x < (tree.root.x() + 1) * size; ++x) {
+                        for (int y = tree.root.y() * size; y < (tree.root.y() + 1) * size; ++y) {
+                            if (QFileInfo(tileFileName(parser, x, y, zoomLevel)).exists()) {
+                                progress.skip();
+                            } else {
+                                tree.tileIds << TileId(0, zoomLevel, x, y);
+                            }
+                        }
                     }
-                    TileDirectory::printProgress(count / double(total));
-                    std::cout << " Tile " << count << "/" << total << " (" << tile->name().toStdString() << ") done.";
-                    double const reduction = nodeReducer.removedNodes() / qMax(1.0, double(nodeReducer.remainingNodes() + nodeReducer.removedNodes()));
-                    std::cout << " Node reduction: " << qRound(reduction * 100.0) << "%";
-                } else {
-                    TileDirectory::printProgress(count / double(total));
-                    std::cout << " Skipping empty tile " << count << "/" << total << " (" << tile->name().toStdString() << ").";
                 }
-                std::cout << std::string(20, ' ') << '\r';
-                std::cout.flush();
-                delete tile;
+                if (!tree.tileIds.isEmpty()) {
+                    missingJobs << tree;
+                }
             }
+            jobs = missingJobs;
         }
+
+        bool const success = processTiles<TileTree, QVector<TileResult> >(jobs, [&](const TileTree &tree) {
+            QVector<TileResult> results;
+            auto const handler = [&](GeoDataDocument *clipped, const TileId &tileId) {
+                std::unique_ptr<GeoDataDocument> tile(clipped);
+                TileResult result;
+                result.job = TileJob{tileId, tileFileName(parser, tileId.x(), tileId.y(), tileId.zoomLevel())};
+                if (tile && !tile->isEmpty()) {
+                    NodeReducer nodeReducer(tile.get(), tileId);
+                    result.nodeReduction = nodeReduction(nodeReducer);
+                    result.status = writeTile(*tile, result.job.filename) ? TileResult::Stored : TileResult::Failed;
+                }
+                results << result;
+            };
+            if (tree.tileIds.isEmpty()) {
+                processor.clipRecursively(tree.root, tree.zoomLevels, handler);
+            } else {
+                processor.clipRecursively(tree.root, tree.tileIds, handler);
+            }
+            return results;
+        }, [&](const QVector<TileResult> &results) {
+            bool success = true;
+            for (auto const &result: results) {
+                progress.print(result);
+                success = success && result.status != TileResult::Failed;
+            }
+            return success;
+        });
+        if (!success) {
+            return 4;
+        }
+        progress.finish();
     } else {
         QString const region = QFileInfo(inputFileName).fileName();
         QString const regionDir = QString("%1/%2").arg(cacheDirectory).arg(QFileInfo(inputFileName).baseName());
@@ -281,81 +448,133 @@ int main(int argc, char *argv[])
             }
         }
 
-        qint64 count = 0;
-        for (auto iter = tiles.begin(), end = tiles.end(); iter != end; ++iter) {
-            for(auto const &tileId: iter.value()) {
-                ++count;
+        TileProgress progress(total);
+        for (auto iter = tiles.constBegin(), end = tiles.constEnd(); iter != end; ++iter) {
+            bool const isBoundaryTile = writeBoundaries && boundaryTiles.contains(iter.key());
+            QVector<TileJob> jobs;
+            TileId deepestTile;
+            for (auto const & tileId: iter.value()) {
                 int const zoomLevel = tileId.zoomLevel();
                 QString const filename = tileFileName(parser, tileId.x(), tileId.y(), zoomLevel);
                 if (!overwriteTiles) {
                     if (zoomLevel > 13 && mbtileWriter && mbtileWriter->hasTile(tileId.x(), tileId.y(), zoomLevel)) {
+                        progress.skip();
                         continue;
                     } else if (QFileInfo(filename).exists()) {
+                        progress.skip();
                         continue;
                     }
                 }
+                jobs << TileJob{tileId, filename};
+                if (jobs.size() == 1 || zoomLevel > deepestTile.zoomLevel()) {
+                    deepestTile = tileId;
+                }
+            }
+            if (jobs.isEmpty()) {
+                continue;
+            }
 
-                using GeoDocPtr = QSharedPointer<GeoDataDocument>;
-                GeoDocPtr tile2 = GeoDocPtr(loader.clip(zoomLevel, tileId.x(), tileId.y()));
-                if (!tile2->isEmpty()) {
-                    GeoDocPtr tile1 = GeoDocPtr(mapTiles.clip(zoomLevel, tileId.x(), tileId.y()));
-                    TagsFilter::removeAnnotationTags(tile1.data());
-                    int originalWays = 0;
-                    int mergedWays = 0;
-                    if (zoomLevel < 17) {
-                        WayConcatenator concatenator(tile1.data());
-                        originalWays = concatenator.originalWays();
-                        mergedWays = concatenator.mergedWays();
-                    }
-                    NodeReducer nodeReducer(tile1.data(), tileId);
-                    if (!tile1->isEmpty() && !tile2->isEmpty()) {
-                        GeoDocPtr combined = GeoDocPtr(mergeDocuments(tile1.data(), tile2.data()));
-
-                        if (writeBoundaries && boundaryTiles.contains(iter.key())) {
-                            writeBoundaryTile(tile1.data(), region, parser, tileId.x(), tileId.y(), zoomLevel);
-                            if (mergeTiles) {
-                                combined = mergeBoundaryTiles(tile2, manager, parser, tileId.x(), tileId.y(), zoomLevel);
-                            }
-                        }
+            // The clippers of the deepest zoom level clip the lower zoom levels of the loaded tile as well
+            auto const landmassClipper = loader.clipper(deepestTile.zoomLevel(), deepestTile.x(), deepestTile.y());
+            auto const mapClipper = mapTiles.clipper(deepestTile.zoomLevel(), deepestTile.x(), deepestTile.y());
+            if (!mapClipper) {
+                for (auto const & job: jobs) {
+                    TileResult result;
+                    result.job = job;
+                    progress.print(result);
+                }
+                continue;
+            }
 
-                        if (zoomLevel > 13 && mbtileWriter) {
-                            QBuffer buffer;
-                            buffer.open(QBuffer::ReadWrite);
-                            if (GeoDataDocumentWriter::write(&buffer, *combined, extension)) {
-                                buffer.seek(0);
-                                mbtileWriter->addTile(&buffer, tileId.x(), tileId.y(), zoomLevel);
-                            } else {
-                                qWarning() << "Could not write the tile " << combined->name();
-                            }
-                        } else {
-                            if (!writeTile(combined.data(), filename)) {
-                                return 4;
-                            }
-                        }
+            // Tiles are clipped from their parent tiles, starting a few levels below the loaded tile.
+            // One tree per root covers the wanted tiles of all zoom levels below it.
+            int const loadLevel = mapTiles.tileFor(deepestTile.zoomLevel(), deepestTile.x(), deepestTile.y()).zoomLevel();
+            QHash<TileId, QString> filenames;
+            QHash<TileId, int> roots;
+            QVector<TileTree> trees;
+            for (auto const & job: jobs) {
+                filenames.insert(job.tileId, job.filename);
+                int const treeLevel = qMin(job.tileId.zoomLevel(), loadLevel + 3);
+                int const treeDepth = job.tileId.zoomLevel() - treeLevel;
+                TileId const root(0, treeLevel, job.tileId.x() >> treeDepth, job.tileId.y() >> treeDepth);
+                if (!roots.contains(root)) {
+                    roots.insert(root, trees.size());
+                    trees << TileTree{root, QVector<int>(), QSet<TileId>()};
+                }
+                trees[roots.value(root)].tileIds << job.tileId;
+            }
 
-                        TileDirectory::printProgress(count / double(total));
-                        std::cout << "  Tile " << count << "/" << total << " (";
-                        std::cout << combined->name().toStdString() << ").";
-                        double const reduction = nodeReducer.removedNodes() / qMax(1.0, double(nodeReducer.remainingNodes() + nodeReducer.removedNodes()));
-                        std::cout << " Node reduction: " << qRound(reduction * 100.0) << "%";
-                        if (originalWays > 0) {
-                            std::cout << " , " << originalWays << " ways merged to " << mergedWays;
-                        }
-                    } else {
-                        TileDirectory::printProgress(count / double(total));
-                        std::cout << "  Skipping empty tile " << count << "/" << total << " (" << tile1->name().toStdString() << ").";
-                    }
-                } else {
-                    TileDirectory::printProgress(count / double(total));
-                    std::cout << "  Skipping sea tile " << count << "/" << total << " (" << tile2->name().toStdString() << ").";
+            using GeoDocPtr = QSharedPointer<GeoDataDocument>;
+            auto const createTile = [&](const TileJob &job, const GeoDocPtr &tile1) {
+                TileResult result;
+                result.job = job;
+                auto const & tileId = job.tileId;
+                int const zoomLevel = tileId.zoomLevel();
+                GeoDocPtr tile2 = GeoDocPtr(landmassClipper ? landmassClipper->clipTo(zoomLevel, tileId.x(), tileId.y()) : nullptr);
+                if (!tile2 || tile2->isEmpty()) {
+                    result.status = TileResult::Sea;
+                    return result;
+                }
+                if (!tile1) {
+                    return result;
+                }
+                TagsFilter::removeAnnotationTags(tile1.data());
+                if (zoomLevel < 17) {
+                    WayConcatenator concatenator(tile1.data());
+                    result.originalWays = concatenator.originalWays();
+                    result.mergedWays = concatenator.mergedWays();
+                }
+                NodeReducer nodeReducer(tile1.data(), tileId);
+                result.nodeReduction = nodeReduction(nodeReducer);
+                if (tile1->isEmpty()) {
+                    return result;
                 }
 
-                std::cout << std::string(20, ' ') << '\r';
-                std::cout.flush();
+                if (isBoundaryTile) {
+                    writeBoundaryTile(tile1.data(), region, parser, tileId.x(), tileId.y(), zoomLevel);
+                    if (mergeTiles) {
+                        // Reads the boundary tiles of other regions, left to the calling thread
+                        result.status = TileResult::NeedsMerge;
+                        result.landmass = tile2;
+                        return result;
+                    }
+                }
+                bool const toMbTile = zoomLevel > 13 && mbtileWriter;
+                GeoDocPtr combined = GeoDocPtr(mergeDocuments(tile1.data(), tile2.data()));
+                result.status = storeTile(*combined, job, extension, toMbTile, result.data);
+                return result;
+            };
+
+            bool const success = processTiles<TileTree, QVector<TileResult> >(trees, [&](const TileTree &tree) {
+                QVector<TileResult> results;
+                // Only the tiles of the region that are still missing are clipped and passed on
+                mapClipper->clipRecursively(tree.root, tree.tileIds, [&](GeoDataDocument *clipped, const TileId &tileId) {
+                    GeoDocPtr const tile1 = GeoDocPtr(clipped);
+                    results << createTile(TileJob{tileId, filenames.value(tileId)}, tile1);
+                });
+                return results;
+            }, [&](QVector<TileResult> &results) {
+                bool success = true;
+                for (auto & result: results) {
+                    auto const & tileId = result.job.tileId;
+                    bool const toMbTile = tileId.zoomLevel() > 13 && mbtileWriter;
+                    if (result.status == TileResult::NeedsMerge) {
+                        auto const combined = mergeBoundaryTiles(result.landmass, manager, parser, tileId.x(), tileId.y(), tileId.zoomLevel());
+                        result.status = storeTile(*combined, result.job, extension, toMbTile, result.data);
+                    }
+                    if (toMbTile && !result.data.isEmpty()) {
+                        mbtileWriter->addTile(result.data, tileId.x(), tileId.y(), tileId.zoomLevel());
+                    }
+                    progress.print(result);
+                    success = success && result.status != TileResult::Failed;
+                }
+                return success;
+            });
+            if (!success) {
+                return 4;
             }
         }
-        TileDirectory::printProgress(1.0);
-        std::cout << "  Vector OSM tiles complete." << std::string(30, ' ') << std::endl;
+        progress.finish();
     }
 
     return 0;